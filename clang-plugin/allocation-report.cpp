@@ -0,0 +1,314 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+/**
+ * AllocationReporter:
+ *
+ * This estimates, without running the code, where heap churn is likely to
+ * come from. Each call in a function body is counted as an allocation if the
+ * callee returns a transfer-full or transfer-container value according to its
+ * GIR, or is one of a list of GLib allocating functions (g_strdup*(),
+ * g_malloc*() — and hence g_new*() —, g_variant_new*(), g_object_new*(), and
+ * so on). Each allocation is weighted by 10 to the power of its loop nesting
+ * depth, as a crude estimate of how often it runs.
+ *
+ * The functions defined in the main file are appended to the report file,
+ * ranked by their weighted count, one per line with tab-separated fields:
+ *     weight, number of allocating calls, function, file:line, hottest callee
+ * Appending allows one report to be built up over a whole build; use
+ * `sort -rn` on it to rank the functions across all translation units.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <girepository.h>
+
+#include <clang/Basic/SourceManager.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "allocation-report.h"
+#include "debug.h"
+
+namespace tartan {
+
+/* Loops nested deeper than this are weighted as if they were this deep, to
+ * avoid overflow. */
+static const unsigned int max_weighted_depth = 9;
+
+/* Prefixes of GLib functions which allocate. g_new*() and g_slice_new*() are
+ * macros for g_malloc*() and g_slice_alloc*(). */
+static const char *allocating_func_prefixes[] = {
+	"g_array_new",
+	"g_array_sized_new",
+	"g_build_filename",
+	"g_build_path",
+	"g_bytes_new",
+	"g_error_new",
+	"g_hash_table_new",
+	"g_list_append",
+	"g_list_copy",
+	"g_list_insert",
+	"g_list_prepend",
+	"g_malloc",
+	"g_memdup",
+	"g_object_new",
+	"g_ptr_array_new",
+	"g_ptr_array_sized_new",
+	"g_realloc",
+	"g_slice_alloc",
+	"g_slice_copy",
+	"g_slist_append",
+	"g_slist_copy",
+	"g_slist_insert",
+	"g_slist_prepend",
+	"g_strconcat",
+	"g_strdup",
+	"g_string_new",
+	"g_string_sized_new",
+	"g_strjoin",
+	"g_strndup",
+	"g_strsplit",
+	"g_try_malloc",
+	"g_try_realloc",
+	"g_variant_new",
+	NULL,
+};
+
+void
+AllocationReportVisitor::reset ()
+{
+	this->n_allocations = 0;
+	this->weight = 0;
+	this->callee_weights.clear ();
+	this->_loop_depth = 0;
+}
+
+/* Whether calls to @func allocate. This is cached per function, as it may
+ * need a GIR lookup. */
+bool
+AllocationReportVisitor::_is_allocating (const FunctionDecl &func)
+{
+	const FunctionDecl *canonical_decl = func.getCanonicalDecl ();
+	std::unordered_map<const FunctionDecl *, bool>::const_iterator it =
+		this->_allocating.find (canonical_decl);
+
+	if (it != this->_allocating.end ()) {
+		return it->second;
+	}
+
+	bool allocating = false;
+	const IdentifierInfo *identifier = func.getIdentifier ();
+
+	if (identifier != NULL) {
+		StringRef name = identifier->getName ();
+
+		for (const char **i = allocating_func_prefixes;
+		     *i != NULL && !allocating; i++) {
+			allocating = name.startswith (*i);
+		}
+	}
+
+	/* Static functions shouldn’t have any GIR data. */
+	StorageClass sc = func.getStorageClass ();
+
+	if (!allocating && identifier != NULL &&
+	    (sc == SC_None || sc == SC_Extern)) {
+		GIBaseInfo *info =
+			this->_gir_manager.get ()->find_function_info (func.getNameAsString ());
+
+		if (info != NULL) {
+			if (g_base_info_get_type (info) == GI_INFO_TYPE_FUNCTION) {
+				GITypeInfo return_type_info;
+				g_callable_info_load_return_type (info,
+				                                  &return_type_info);
+
+				allocating =
+					(g_type_info_is_pointer (&return_type_info) &&
+					 g_callable_info_get_caller_owns (info) !=
+					 GI_TRANSFER_NOTHING);
+			}
+
+			g_base_info_unref (info);
+		}
+	}
+
+	this->_allocating[canonical_decl] = allocating;
+
+	return allocating;
+}
+
+bool
+AllocationReportVisitor::TraverseForStmt (ForStmt *stmt)
+{
+	this->_loop_depth++;
+	bool retval =
+		RecursiveASTVisitor<AllocationReportVisitor>::TraverseForStmt (stmt);
+	this->_loop_depth--;
+
+	return retval;
+}
+
+bool
+AllocationReportVisitor::TraverseWhileStmt (WhileStmt *stmt)
+{
+	this->_loop_depth++;
+	bool retval =
+		RecursiveASTVisitor<AllocationReportVisitor>::TraverseWhileStmt (stmt);
+	this->_loop_depth--;
+
+	return retval;
+}
+
+bool
+AllocationReportVisitor::TraverseDoStmt (DoStmt *stmt)
+{
+	this->_loop_depth++;
+	bool retval =
+		RecursiveASTVisitor<AllocationReportVisitor>::TraverseDoStmt (stmt);
+	this->_loop_depth--;
+
+	return retval;
+}
+
+bool
+AllocationReportVisitor::VisitCallExpr (CallExpr *call)
+{
+	const FunctionDecl *callee = call->getDirectCallee ();
+
+	if (callee == NULL || !this->_is_allocating (*callee)) {
+		return true;
+	}
+
+	guint64 call_weight = 1;
+
+	for (unsigned int i = 0;
+	     i < std::min (this->_loop_depth, max_weighted_depth); i++) {
+		call_weight *= 10;
+	}
+
+	this->n_allocations++;
+	this->weight += call_weight;
+	this->callee_weights[callee->getNameAsString ()] += call_weight;
+
+	return true;
+}
+
+/* An entry in the report. */
+struct AllocationReportEntry {
+	guint64 weight;
+	unsigned int n_allocations;
+	std::string func_name;
+	std::string location;
+	std::string hottest_callee;
+
+	bool operator< (const AllocationReportEntry &other) const
+	{
+		return (this->weight > other.weight);
+	}
+};
+
+void
+AllocationReporter::HandleTranslationUnit (ASTContext& context)
+{
+	const std::string& filename =
+		this->_options.get ()->allocation_report_output;
+
+	if (filename.empty ()) {
+		return;
+	}
+
+	const SourceManager &sm = context.getSourceManager ();
+	const TranslationUnitDecl *tu = context.getTranslationUnitDecl ();
+	std::vector<AllocationReportEntry> entries;
+
+	for (DeclContext::decl_iterator it = tu->decls_begin (),
+	     ie = tu->decls_end (); it != ie; ++it) {
+		FunctionDecl *func = dyn_cast<FunctionDecl> (*it);
+
+		/* Functions defined in headers are reported by the translation
+		 * unit which defines them. */
+		if (func == NULL || !func->isThisDeclarationADefinition () ||
+		    !sm.isInMainFile (func->getLocation ())) {
+			continue;
+		}
+
+		this->_visitor.reset ();
+		this->_visitor.TraverseDecl (func);
+
+		if (this->_visitor.n_allocations == 0) {
+			continue;
+		}
+
+		AllocationReportEntry entry;
+		entry.weight = this->_visitor.weight;
+		entry.n_allocations = this->_visitor.n_allocations;
+		entry.func_name = func->getNameAsString ();
+
+		PresumedLoc loc = sm.getPresumedLoc (func->getLocation ());
+		entry.location = loc.isValid () ?
+			std::string (loc.getFilename ()) + ":" +
+			std::to_string (loc.getLine ()) : "";
+
+		guint64 hottest_weight = 0;
+
+		for (std::unordered_map<std::string, guint64>::const_iterator
+		     c = this->_visitor.callee_weights.begin (),
+		     ce = this->_visitor.callee_weights.end (); c != ce; ++c) {
+			if (c->second > hottest_weight) {
+				hottest_weight = c->second;
+				entry.hottest_callee = c->first;
+			}
+		}
+
+		entries.push_back (entry);
+	}
+
+	if (entries.empty ()) {
+		return;
+	}
+
+	std::stable_sort (entries.begin (), entries.end ());
+
+	std::string contents;
+	llvm::raw_string_ostream out (contents);
+
+	for (std::vector<AllocationReportEntry>::const_iterator it = entries.begin (),
+	     ie = entries.end (); it != ie; ++it) {
+		out << it->weight << "\t"
+		    << it->n_allocations << "\t"
+		    << it->func_name << "\t"
+		    << it->location << "\t"
+		    << it->hottest_callee << "\n";
+	}
+
+	out.flush ();
+
+	Debug::append_report (filename, contents,
+	                      "Failed to write allocation report ‘%0’: %1",
+	                      this->_compiler);
+}
+
+} /* namespace tartan */
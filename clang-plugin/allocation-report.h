@@ -0,0 +1,98 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_ALLOCATION_REPORT_H
+#define TARTAN_ALLOCATION_REPORT_H
+
+#include <string>
+#include <unordered_map>
+
+#include <clang/AST/AST.h>
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Frontend/CompilerInstance.h>
+
+#include "gir-manager.h"
+#include "plugin-options.h"
+
+namespace tartan {
+
+using namespace clang;
+
+/* Counts the heap allocations in a function body, weighting each by its loop
+ * nesting depth. */
+class AllocationReportVisitor :
+	public RecursiveASTVisitor<AllocationReportVisitor> {
+public:
+	explicit AllocationReportVisitor (
+		std::shared_ptr<const GirManager> gir_manager) :
+		_gir_manager (gir_manager), _loop_depth (0) {}
+
+	/* Results for the function most recently traversed: the number of
+	 * allocating call sites, their total weight, and the weight for each
+	 * allocating callee. */
+	unsigned int n_allocations;
+	guint64 weight;
+	std::unordered_map<std::string, guint64> callee_weights;
+
+	void reset ();
+
+private:
+	std::shared_ptr<const GirManager> _gir_manager;
+	unsigned int _loop_depth;
+
+	/* Whether each callee allocates, keyed by canonical declaration. */
+	std::unordered_map<const FunctionDecl *, bool> _allocating;
+
+	bool _is_allocating (const FunctionDecl &func);
+
+public:
+	bool TraverseForStmt (ForStmt *stmt);
+	bool TraverseWhileStmt (WhileStmt *stmt);
+	bool TraverseDoStmt (DoStmt *stmt);
+	bool VisitCallExpr (CallExpr *call);
+};
+
+/* Writes a report of the functions defined in the main file which allocate
+ * the most, as estimated by AllocationReportVisitor. Enabled by
+ * --allocation-report. */
+class AllocationReporter : public clang::ASTConsumer {
+public:
+	explicit AllocationReporter (
+		CompilerInstance& compiler,
+		std::shared_ptr<const GirManager> gir_manager,
+		std::shared_ptr<const PluginOptions> options) :
+		_compiler (compiler), _options (options),
+		_visitor (gir_manager) {}
+
+private:
+	CompilerInstance& _compiler;
+	std::shared_ptr<const PluginOptions> _options;
+	AllocationReportVisitor _visitor;
+
+public:
+	virtual void HandleTranslationUnit (ASTContext& context);
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_ALLOCATION_REPORT_H */
@@ -0,0 +1,166 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#include "config.h"
+
+#include <algorithm>
+
+#include <llvm/ADT/Statistic.h>
+#include <clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h>
+
+#include "analysis-budget.h"
+#include "checker.h"
+#include "debug.h"
+
+STATISTIC (NumBudgetsExhausted,
+           "The # of functions whose Tartan analysis budget was exhausted");
+
+namespace tartan {
+
+/* Get the top-level function which the analyser started from to reach the
+ * current node. */
+const Decl *
+get_entry_decl (CheckerContext &context)
+{
+	const LocationContext *location_context = context.getLocationContext ();
+
+	while (location_context->getParent () != NULL) {
+		location_context = location_context->getParent ();
+	}
+
+	return location_context->getDecl ();
+}
+
+/* Whether the checker needs to count the states it’s tracking for check(). */
+bool
+AnalysisBudget::limits_states () const
+{
+	return (global_plugin_options.get ()->max_analysis_states > 0);
+}
+
+/* Check whether the budget for the top-level function being analysed has been
+ * exhausted, given the number of states the checker is tracking on the current
+ * path (which is ignored unless limits_states() is true). Once this has
+ * returned true, it keeps doing so until the analysis of that function ends,
+ * so that tracking isn’t resumed part-way through. */
+bool
+AnalysisBudget::check (CheckerContext &context, unsigned int n_states)
+{
+	const PluginOptions *options = global_plugin_options.get ();
+
+	if (options->max_analysis_nodes == 0 &&
+	    options->max_analysis_states == 0 &&
+	    options->max_analysis_time == 0) {
+		return false;
+	}
+
+	const Decl *entry = get_entry_decl (context);
+
+	if (entry != this->_entry) {
+		this->_entry = entry;
+		this->_start_time = g_get_monotonic_time ();
+		this->_exhausted = EXHAUSTED_NONE;
+		this->_n_nodes = 0;
+		this->_n_states = 0;
+	}
+
+	if (this->_exhausted != EXHAUSTED_NONE) {
+		return true;
+	}
+
+	/* The ExprEngine is the only SubEngine. */
+	ExprEngine *engine =
+		static_cast<ExprEngine *> (context.getStateManager ().getOwningEngine ());
+
+	this->_n_nodes = std::max (this->_n_nodes,
+	                           (unsigned int) engine->getGraph ().size ());
+	this->_n_states = std::max (this->_n_states, n_states);
+
+	if (options->max_analysis_nodes > 0 &&
+	    this->_n_nodes >= options->max_analysis_nodes) {
+		this->_exhausted = EXHAUSTED_NODES;
+	} else if (options->max_analysis_states > 0 &&
+	           this->_n_states >= options->max_analysis_states) {
+		this->_exhausted = EXHAUSTED_STATES;
+	} else if (options->max_analysis_time > 0 &&
+	           g_get_monotonic_time () - this->_start_time >=
+	           options->max_analysis_time) {
+		this->_exhausted = EXHAUSTED_TIME;
+	}
+
+	if (this->_exhausted != EXHAUSTED_NONE) {
+		DEBUG ("Analysis budget exhausted after " << this->_n_nodes <<
+		       " nodes and " << this->_n_states << " states.");
+	}
+
+	return (this->_exhausted != EXHAUSTED_NONE);
+}
+
+/* Called at the end of the analysis of each top-level function: report the
+ * function if its budget was exhausted, with what it cost, and forget it. */
+void
+AnalysisBudget::end_analysis (ExplodedGraph &graph, BugReporter &reporter,
+                              const char *checker_name)
+{
+	if (this->_entry == NULL || this->_exhausted == EXHAUSTED_NONE) {
+		this->_entry = NULL;
+		return;
+	}
+
+	static const char * const budget_names[] = {
+		NULL,  /* EXHAUSTED_NONE */
+		"node",  /* EXHAUSTED_NODES */
+		"state",  /* EXHAUSTED_STATES */
+		"time",  /* EXHAUSTED_TIME */
+	};
+
+	const NamedDecl *named_decl = dyn_cast<NamedDecl> (this->_entry);
+	const std::string name = (named_decl != NULL) ?
+		named_decl->getNameAsString () : std::string ("(anonymous)");
+	const unsigned int elapsed_ms =
+		(g_get_monotonic_time () - this->_start_time) / 1000;
+
+	NumBudgetsExhausted++;
+
+	DiagnosticsEngine &engine = reporter.getDiagnostic ();
+#if (CLANG_VERSION_MAJOR > 3) || \
+    (CLANG_VERSION_MAJOR == 3 && CLANG_VERSION_MINOR > 4)
+	DiagnosticsEngine::Level level = DiagnosticsEngine::Remark;
+#else
+	DiagnosticsEngine::Level level = DiagnosticsEngine::Warning;
+#endif
+	unsigned int id = engine.getCustomDiagID (level,
+		"[tartan]: %0 stopped tracking in ‘%1’ after exhausting its "
+		"%2 budget: %3 nodes, %4 tracked states, %5ms");
+
+	engine.Report (this->_entry->getLocation (), id)
+		<< checker_name
+		<< name
+		<< budget_names[this->_exhausted]
+		<< std::max (this->_n_nodes, graph.size ())
+		<< this->_n_states
+		<< elapsed_ms;
+
+	this->_entry = NULL;
+}
+
+} /* namespace tartan */
@@ -0,0 +1,77 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_ANALYSIS_BUDGET_H
+#define TARTAN_ANALYSIS_BUDGET_H
+
+#include <clang/AST/AST.h>
+#include <clang/StaticAnalyzer/Core/BugReporter/BugReporter.h>
+#include <clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h>
+#include <clang/StaticAnalyzer/Core/PathSensitive/ExplodedGraph.h>
+
+#include <glib.h>
+
+namespace tartan {
+
+using namespace clang;
+using namespace ento;
+
+/* Per-function limits on the work a path-sensitive checker does, set using
+ * the --max-analysis-nodes, --max-analysis-states and --max-analysis-time
+ * options. Budgets are tracked for each top-level function the analyser
+ * starts from; once one is exhausted, the checker should stop its detailed
+ * tracking for the rest of that function. The exhausted functions, and their
+ * cost, are reported at the end of their analysis. */
+class AnalysisBudget {
+public:
+	AnalysisBudget () : _entry (NULL), _start_time (0),
+		_exhausted (EXHAUSTED_NONE), _n_nodes (0), _n_states (0) {}
+
+	bool limits_states () const;
+	bool check (CheckerContext &context, unsigned int n_states);
+	void end_analysis (ExplodedGraph &graph, BugReporter &reporter,
+	                   const char *checker_name);
+
+private:
+	enum Exhausted {
+		EXHAUSTED_NONE,
+		EXHAUSTED_NODES,
+		EXHAUSTED_STATES,
+		EXHAUSTED_TIME,
+	};
+
+	/* Top-level function currently being analysed, and when its analysis
+	 * started (monotonic time, in microseconds). */
+	const Decl *_entry;
+	gint64 _start_time;
+
+	/* Which budget ran out first, and the largest costs seen. */
+	Exhausted _exhausted;
+	unsigned int _n_nodes;
+	unsigned int _n_states;
+};
+
+const Decl *get_entry_decl (CheckerContext &context);
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_ANALYSIS_BUDGET_H */
@@ -0,0 +1,365 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "annotation-overrides.h"
+#include "debug.h"
+
+/* The compiled index is a GVariant of type (sua(s(aubbbybsss))): a magic
+ * string and format version, followed by the overrides sorted by symbol. Each
+ * override is (nonnull args, returns nonnull, throws, failure return, return
+ * transfer, deprecated, deprecation message, deprecation version, slow
+ * note). */
+#define INDEX_MAGIC "tartan-annotation-overrides"
+#define INDEX_VERSION 2
+#define INDEX_TYPE "(sua(s(aubbbybsss)))"
+
+AnnotationOverrides::~AnnotationOverrides ()
+{
+	if (this->_entries != NULL) {
+		g_variant_unref (this->_entries);
+	}
+}
+
+static bool
+_str_less (const gchar *a, const gchar *b)
+{
+	return (strcmp (a, b) < 0);
+}
+
+/* Parse the override file @filename and build its index. Returns a new
+ * reference to the index, or %NULL on error. */
+static GVariant *
+_compile_overrides (const std::string& filename, GError** error)
+{
+	GKeyFile *key_file = g_key_file_new ();
+
+	if (!g_key_file_load_from_file (key_file, filename.c_str (),
+	                                G_KEY_FILE_NONE, error)) {
+		g_key_file_free (key_file);
+		return NULL;
+	}
+
+	DEBUG ("Compiling annotation overrides " << filename);
+
+	gsize n_groups;
+	gchar **groups = g_key_file_get_groups (key_file, &n_groups);
+	std::sort (groups, groups + n_groups, _str_less);
+
+	GVariantBuilder builder;
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(s(aubbbybsss))"));
+
+	bool valid = true;
+
+	for (gsize i = 0; i < n_groups && valid; i++) {
+		const gchar *symbol = groups[i];
+
+		GVariantBuilder nonnull_builder;
+		g_variant_builder_init (&nonnull_builder, G_VARIANT_TYPE ("au"));
+
+		gsize n_nonnull = 0;
+		gint *nonnull = g_key_file_get_integer_list (key_file, symbol,
+		                                             "nonnull",
+		                                             &n_nonnull, NULL);
+
+		for (gsize j = 0; j < n_nonnull; j++) {
+			if (nonnull[j] < 1) {
+				g_set_error (error, G_KEY_FILE_ERROR,
+				             G_KEY_FILE_ERROR_INVALID_VALUE,
+				             "Invalid nonnull parameter position "
+				             "%d for %s.", nonnull[j], symbol);
+				valid = false;
+				break;
+			}
+
+			g_variant_builder_add (&nonnull_builder, "u",
+			                       (guint32) (nonnull[j] - 1));
+		}
+
+		g_free (nonnull);
+
+		gchar *transfer = g_key_file_get_string (key_file, symbol,
+		                                         "transfer", NULL);
+		guint8 return_transfer = GI_TRANSFER_NOTHING;
+
+		if (transfer == NULL || strcmp (transfer, "none") == 0) {
+			return_transfer = GI_TRANSFER_NOTHING;
+		} else if (strcmp (transfer, "container") == 0) {
+			return_transfer = GI_TRANSFER_CONTAINER;
+		} else if (strcmp (transfer, "full") == 0) {
+			return_transfer = GI_TRANSFER_EVERYTHING;
+		} else if (valid) {
+			g_set_error (error, G_KEY_FILE_ERROR,
+			             G_KEY_FILE_ERROR_INVALID_VALUE,
+			             "Invalid transfer ‘%s’ for %s.", transfer,
+			             symbol);
+			valid = false;
+		}
+
+		g_free (transfer);
+
+		gboolean returns_nonnull =
+			g_key_file_get_boolean (key_file, symbol,
+			                        "returns-nonnull", NULL);
+		gboolean throws = g_key_file_get_boolean (key_file, symbol,
+		                                          "throws", NULL);
+		gboolean failure_return =
+			g_key_file_get_boolean (key_file, symbol,
+			                        "failure-return", NULL);
+		gboolean deprecated = g_key_file_has_key (key_file, symbol,
+		                                          "deprecated", NULL);
+		gchar *message = g_key_file_get_string (key_file, symbol,
+		                                        "deprecated", NULL);
+		gchar *version = g_key_file_get_string (key_file, symbol,
+		                                        "deprecated-version",
+		                                        NULL);
+		gchar *slow = g_key_file_get_string (key_file, symbol, "slow",
+		                                     NULL);
+
+		g_variant_builder_add (&builder, "(s(aubbbybsss))", symbol,
+		                       &nonnull_builder, returns_nonnull,
+		                       throws, failure_return, return_transfer,
+		                       deprecated,
+		                       (message != NULL) ? message : "",
+		                       (version != NULL) ? version : "",
+		                       (slow != NULL) ? slow : "");
+
+		g_free (slow);
+		g_free (version);
+		g_free (message);
+	}
+
+	g_strfreev (groups);
+	g_key_file_free (key_file);
+
+	GVariant *entries = g_variant_builder_end (&builder);
+
+	if (!valid) {
+		g_variant_unref (g_variant_ref_sink (entries));
+		return NULL;
+	}
+
+	return g_variant_ref_sink (g_variant_new ("(su@a(s(aubbbybsss)))",
+	                                          INDEX_MAGIC, INDEX_VERSION,
+	                                          entries));
+}
+
+/* Map the compiled index @index_filename into memory and return a new
+ * reference to its entries, or %NULL if it can’t be loaded or was written by
+ * an incompatible version of Tartan. */
+static GVariant *
+_map_index (const std::string& index_filename)
+{
+	GMappedFile *mapped_file = g_mapped_file_new (index_filename.c_str (),
+	                                              FALSE, NULL);
+
+	if (mapped_file == NULL)
+		return NULL;
+
+	/* The variant holds the only reference to the mapped file. */
+	GVariant *index =
+		g_variant_new_from_data (G_VARIANT_TYPE (INDEX_TYPE),
+		                         g_mapped_file_get_contents (mapped_file),
+		                         g_mapped_file_get_length (mapped_file),
+		                         FALSE,
+		                         (GDestroyNotify) g_mapped_file_unref,
+		                         mapped_file);
+	g_variant_ref_sink (index);
+
+	const gchar *magic;
+	guint32 version;
+	GVariant *entries = NULL;
+
+	g_variant_get (index, "(&su@a(s(aubbbybsss)))", &magic, &version,
+	               &entries);
+
+	if (strcmp (magic, INDEX_MAGIC) != 0 || version != INDEX_VERSION) {
+		DEBUG ("Ignoring incompatible annotation override index " <<
+		       index_filename);
+		g_variant_unref (entries);
+		entries = NULL;
+	}
+
+	g_variant_unref (index);
+
+	return entries;
+}
+
+/* Returns %TRUE if @index_filename exists and is at least as new as
+ * @filename. */
+static bool
+_index_is_up_to_date (const std::string& filename,
+                      const std::string& index_filename)
+{
+	GStatBuf stat, index_stat;
+
+	return (g_stat (filename.c_str (), &stat) == 0 &&
+	        g_stat (index_filename.c_str (), &index_stat) == 0 &&
+	        index_stat.st_mtime >= stat.st_mtime);
+}
+
+/* Load the override file @filename, using its compiled index if that’s up to
+ * date, and compiling and caching the index otherwise. The index is cached in
+ * the user cache directory, keyed by the absolute path of @filename, so that
+ * nothing is written to source or build trees. Failure to write the cache
+ * isn’t an error: the freshly compiled index is used from memory instead. */
+bool
+AnnotationOverrides::load (const std::string& filename, GError** error)
+{
+	gchar *absolute_filename;
+
+	if (g_path_is_absolute (filename.c_str ())) {
+		absolute_filename = g_strdup (filename.c_str ());
+	} else {
+		gchar *cwd = g_get_current_dir ();
+		absolute_filename = g_build_filename (cwd, filename.c_str (),
+		                                      NULL);
+		g_free (cwd);
+	}
+
+	gchar *checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1,
+	                                                 absolute_filename,
+	                                                 -1);
+	std::string cached_basename = std::string (checksum) + ".compiled";
+	gchar *cache_dir = g_build_filename (g_get_user_cache_dir (),
+	                                     "tartan", NULL);
+	gchar *_cached_index = g_build_filename (cache_dir,
+	                                         cached_basename.c_str (),
+	                                         NULL);
+	std::string cached_index (_cached_index);
+
+	g_free (_cached_index);
+	g_free (checksum);
+	g_free (absolute_filename);
+
+	GVariant *entries = NULL;
+
+	if (_index_is_up_to_date (filename, cached_index)) {
+		entries = _map_index (cached_index);
+	}
+
+	if (entries == NULL) {
+		GVariant *index = _compile_overrides (filename, error);
+
+		if (index == NULL) {
+			g_free (cache_dir);
+			return false;
+		}
+
+		const gchar *data = (const gchar *) g_variant_get_data (index);
+		gsize length = g_variant_get_size (index);
+
+		if (g_mkdir_with_parents (cache_dir, 0755) != 0 ||
+		    !g_file_set_contents (cached_index.c_str (), data, length,
+		                          NULL)) {
+			DEBUG ("Could not cache annotation override index for " <<
+			       filename);
+		}
+
+		entries = g_variant_get_child_value (index, 2);
+		g_variant_unref (index);
+	}
+
+	g_free (cache_dir);
+
+	if (this->_entries != NULL) {
+		g_variant_unref (this->_entries);
+	}
+	this->_entries = entries;
+
+	return true;
+}
+
+/* Look up the overrides for the C function @symbol. Returns %false if there
+ * are none, in which case @annotations is left unchanged. */
+bool
+AnnotationOverrides::lookup (const std::string& symbol,
+                             AnnotationOverride& annotations) const
+{
+	if (this->_entries == NULL)
+		return false;
+
+	gsize lower = 0;
+	gsize upper = g_variant_n_children (this->_entries);
+
+	while (lower < upper) {
+		gsize mid = lower + (upper - lower) / 2;
+		GVariant *entry = g_variant_get_child_value (this->_entries,
+		                                             mid);
+		const gchar *entry_symbol;
+
+		g_variant_get_child (entry, 0, "&s", &entry_symbol);
+		int cmp = strcmp (symbol.c_str (), entry_symbol);
+
+		if (cmp < 0) {
+			upper = mid;
+		} else if (cmp > 0) {
+			lower = mid + 1;
+		} else {
+			GVariant *nonnull_args;
+			gboolean returns_nonnull, throws, failure_return;
+			gboolean deprecated;
+			guint8 return_transfer;
+			const gchar *message, *version, *slow;
+
+			g_variant_get_child (entry, 1, "(@aubbbyb&s&s&s)",
+			                     &nonnull_args, &returns_nonnull,
+			                     &throws, &failure_return,
+			                     &return_transfer,
+			                     &deprecated, &message, &version,
+			                     &slow);
+
+			gsize n_args;
+			const guint32 *args =
+				(const guint32 *)
+				g_variant_get_fixed_array (nonnull_args,
+				                           &n_args,
+				                           sizeof (guint32));
+
+			annotations.nonnull_args.assign (args, args + n_args);
+			annotations.returns_nonnull = returns_nonnull;
+			annotations.throws = throws;
+			annotations.failure_return = failure_return;
+			annotations.return_transfer =
+				(GITransfer) return_transfer;
+			annotations.deprecated = deprecated;
+			annotations.deprecation_message = message;
+			annotations.deprecation_version = version;
+			annotations.slow_note = slow;
+
+			g_variant_unref (nonnull_args);
+		}
+
+		g_variant_unref (entry);
+
+		if (cmp == 0)
+			return true;
+	}
+
+	return false;
+}
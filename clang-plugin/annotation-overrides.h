@@ -0,0 +1,81 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_ANNOTATION_OVERRIDES_H
+#define TARTAN_ANNOTATION_OVERRIDES_H
+
+#include <string>
+#include <vector>
+
+#include <girepository.h>
+
+/* Annotations for a single C function, taken from an override file rather
+ * than from GIR data. Parameter indices are 0-based indices of the C formal
+ * parameters. */
+typedef struct {
+	std::vector<unsigned int> nonnull_args;
+	bool returns_nonnull;
+	bool throws;
+	bool failure_return;  /* FALSE or NULL exactly when the error is set */
+	GITransfer return_transfer;
+	bool deprecated;
+	std::string deprecation_message;  /* may be empty */
+	std::string deprecation_version;  /* may be empty */
+	std::string slow_note;  /* empty unless the function is slow */
+} AnnotationOverride;
+
+/* A set of annotation overrides, for libraries which have no GIR data. Each
+ * override file is a key file with one group per C symbol, for example:
+ *
+ *     [foo_bar_new]
+ *     nonnull=1;3
+ *     returns-nonnull=true
+ *     transfer=full
+ *     throws=true
+ *     failure-return=true
+ *     deprecated=Use foo_bar_new_full() instead.
+ *     deprecated-version=1.2
+ *     slow=Performs synchronous network I/O.
+ *
+ * where nonnull lists 1-based parameter positions (as for GCC’s nonnull
+ * attribute), and failure-return says that the function’s gboolean or pointer
+ * return value is FALSE or NULL exactly when it sets its error. It is compiled
+ * once into a sorted GVariant index which is cached in the user cache
+ * directory, and which is mapped into memory and binary searched for
+ * lookups. */
+class AnnotationOverrides {
+private:
+	/* Owned; of type a(s(aubbbybsss)), sorted by symbol. */
+	GVariant* _entries;
+
+public:
+	AnnotationOverrides () : _entries (NULL) {}
+	~AnnotationOverrides ();
+
+	bool load (const std::string& filename, GError** error);
+
+	/* Lookups only read the mapped index, so are thread-safe. */
+	bool lookup (const std::string& symbol,
+	             AnnotationOverride& annotations) const;
+};
+
+#endif /* !TARTAN_ANNOTATION_OVERRIDES_H */
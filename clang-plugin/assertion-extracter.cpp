@@ -21,12 +21,24 @@
  */
 
 #include <unordered_set>
+#include <vector>
 
 #include <clang/AST/Attr.h>
+#include <clang/Basic/Builtins.h>
 #include <clang/Lex/Lexer.h>
+#include <llvm/ADT/DenseMap.h>
 
 #include "assertion-extracter.h"
+#include "boolean-formula.h"
 #include "debug.h"
+#include "formula-bdd.h"
+#include "type-manager.h"
+
+/* Budget for canonicalising each function’s assertion conditions using an
+ * ROBDD. Typical functions need a few tens of nodes; if a function needs more
+ * than this, the cheaper structural analysis is used instead. */
+#define BDD_MAX_NODES 4096
+#define BDD_MAX_STEPS 65536
 
 static bool
 _is_assertion_name (const std::string& name)
@@ -63,36 +75,253 @@ _is_assertion_fail_func_name (const std::string& name)
 	        name == "__assert_perror_fail");
 }
 
-/* Return the negation of the given expression. */
-static Expr*
-_negation_expr (Expr* e, const ASTContext& context)
+/* Calculate whether a statement expression is a standard GObject type check,
+ * e.g. NSPACE_IS_OBJ(x), and return the variable being checked if so, or %NULL
+ * otherwise.
+ *
+ * This is complicated by the fact that type checking is done by macros, which
+ * expand to something like:
+ * (((__extension__ ({
+ *    GTypeInstance *__inst = (GTypeInstance *)((x));
+ *    GType __t = ((nspace_obj_get_type()));
+ *    gboolean __r;
+ *    if (!__inst)
+ *        __r = (0);
+ *    else if (__inst->g_class && __inst->g_class->g_type == __t)
+ *        __r = (!(0));
+ *    else
+ *        __r = g_type_check_instance_is_a(__inst, __t);
+ *    __r;
+ * }))))
+ *
+ * This is a particularly shoddy way of checking for a GObject type check (we
+ * should really check for a g_type_check_instance_is_a() call) but this will do
+ * for now. */
+static const ValueDecl*
+_stmt_expr_is_gobject_type_check (StmtExpr& stmt_expr)
 {
-	return new (context)
-		UnaryOperator (e, UnaryOperatorKind::UO_LNot,
-		               context.getLogicalOperationType (),
-		               VK_RValue, OK_Ordinary, SourceLocation ());
+	CompoundStmt* compound_stmt = stmt_expr.getSubStmt ();
+	if (compound_stmt == NULL || compound_stmt->body_empty ())
+		return NULL;
+
+	const Stmt* first_stmt = *(compound_stmt->body_begin ());
+	if (first_stmt->getStmtClass () != Expr::DeclStmtClass)
+		return NULL;
+
+	const DeclStmt& decl_stmt = cast<DeclStmt> (*first_stmt);
+	if (!decl_stmt.isSingleDecl ())
+		return NULL;
+
+	const VarDecl* decl = dyn_cast<VarDecl> (decl_stmt.getSingleDecl ());
+	if (decl == NULL || decl->getNameAsString () != "__inst" ||
+	    decl->getAnyInitializer () == NULL)
+		return NULL;
+
+	const Expr* init = decl->getAnyInitializer ()->IgnoreParenCasts ();
+	const DeclRefExpr* decl_expr = dyn_cast<DeclRefExpr> (init);
+	if (decl_expr == NULL)
+		return NULL;
+
+	return decl_expr->getDecl ();
 }
 
-/* Combine expressions A and B to give (A && B). */
+/* Calculate whether a statement expression is GLib’s _G_BOOLEAN_EXPR() macro
+ * (used by G_LIKELY() when optimising), and return the condition it wraps if
+ * so, or %NULL otherwise. It expands to something like:
+ * ({
+ *    int _g_boolean_var_;
+ *    if (expr)
+ *       _g_boolean_var_ = 1;
+ *    else
+ *       _g_boolean_var_ = 0;
+ *    _g_boolean_var_;
+ * }) */
 static Expr*
-_conjunction_expr (Expr* lhs, Expr* rhs, const ASTContext& context)
+_stmt_expr_is_boolean_expr (StmtExpr& stmt_expr)
 {
-	return new (context)
-		BinaryOperator (lhs, rhs, BinaryOperatorKind::BO_LAnd,
-		                context.getLogicalOperationType (),
-		                VK_RValue, OK_Ordinary, SourceLocation (),
-		                false);
+	CompoundStmt* compound_stmt = stmt_expr.getSubStmt ();
+	if (compound_stmt == NULL || compound_stmt->size () < 2)
+		return NULL;
+
+	CompoundStmt::body_iterator it = compound_stmt->body_begin ();
+	const DeclStmt* decl_stmt = dyn_cast<DeclStmt> (*it);
+	if (decl_stmt == NULL || !decl_stmt->isSingleDecl ())
+		return NULL;
+
+	const VarDecl* decl = dyn_cast<VarDecl> (decl_stmt->getSingleDecl ());
+	if (decl == NULL ||
+	    decl->getNameAsString ().compare (0, 15, "_g_boolean_var_") != 0)
+		return NULL;
+
+	IfStmt* if_stmt = dyn_cast<IfStmt> (*(++it));
+	if (if_stmt == NULL)
+		return NULL;
+
+	return if_stmt->getCond ();
 }
 
-/* Combine expressions A and B to give (A || B). */
-static Expr*
-_disjunction_expr (Expr* lhs, Expr* rhs, const ASTContext& context)
+/* Convert a condition from the code (for example, the condition of an if
+ * statement) to a boolean formula in @arena. Non-NULL checks of variables,
+ * such as (x), (x != NULL) or !(x == NULL), and GObject type checks become
+ * semantic atoms; boolean operators become formula operators; and anything
+ * else becomes an opaque atom. */
+static const FormulaNode*
+_condition_formula (Expr& expr, const ASTContext& context,
+                    FormulaArena& arena)
 {
-	return new (context)
-		BinaryOperator (lhs, rhs, BinaryOperatorKind::BO_LOr,
-		                context.getLogicalOperationType (),
-		                VK_RValue, OK_Ordinary, SourceLocation (),
-		                false);
+	Expr* e = expr.IgnoreParens ();
+	llvm::APSInt bool_expr;
+
+	if (!e->isValueDependent () &&
+	    e->isIntegerConstantExpr (bool_expr, context)) {
+		/* Transformations:
+		 *     0 ↦ FALSE
+		 *     I ↦ TRUE */
+		return bool_expr.getBoolValue () ?
+			arena.get_true () : arena.get_false ();
+	}
+
+	switch ((int) e->getStmtClass ()) {
+	case Expr::UnaryOperatorClass: {
+		UnaryOperator& op_expr = cast<UnaryOperator> (*e);
+
+		/* ! S ↦ ¬calc(S) */
+		if (op_expr.getOpcode () == UnaryOperatorKind::UO_LNot) {
+			return arena.get_negation (
+				_condition_formula (*op_expr.getSubExpr (),
+				                    context, arena));
+		}
+
+		return arena.get_opaque (e);
+	}
+	case Expr::BinaryOperatorClass: {
+		BinaryOperator& op_expr = cast<BinaryOperator> (*e);
+		BinaryOperatorKind opcode = op_expr.getOpcode ();
+
+		if (opcode == BinaryOperatorKind::BO_LAnd ||
+		    opcode == BinaryOperatorKind::BO_LOr) {
+			/* S1 && S2 ↦ calc(S1) ∧ calc(S2)
+			 * S1 || S2 ↦ calc(S1) ∨ calc(S2) */
+			const FormulaNode* lhs =
+				_condition_formula (*op_expr.getLHS (),
+				                    context, arena);
+			const FormulaNode* rhs =
+				_condition_formula (*op_expr.getRHS (),
+				                    context, arena);
+
+			return (opcode == BinaryOperatorKind::BO_LAnd) ?
+				arena.get_conjunction (lhs, rhs) :
+				arena.get_disjunction (lhs, rhs);
+		} else if (opcode == BinaryOperatorKind::BO_NE ||
+		           opcode == BinaryOperatorKind::BO_EQ) {
+			/* x != NULL ↦ NONNULL(x)
+			 * x == NULL ↦ ¬NONNULL(x)
+			 * and commuted equivalents. */
+			Expr* lhs = op_expr.getLHS ();
+			Expr* rhs = op_expr.getRHS ();
+			ASTContext& _context = const_cast<ASTContext&> (context);
+
+			if (lhs->isNullPointerConstant (_context,
+			                                Expr::NullPointerConstantValueDependence::NPC_ValueDependentIsNotNull) !=
+			    Expr::NullPointerConstantKind::NPCK_NotNull) {
+				Expr* tmp = lhs;
+				lhs = rhs;
+				rhs = tmp;
+			}
+
+			DeclRefExpr* decl_expr =
+				dyn_cast<DeclRefExpr> (lhs->IgnoreParenCasts ());
+
+			if (decl_expr != NULL &&
+			    rhs->isNullPointerConstant (_context,
+			                                Expr::NullPointerConstantValueDependence::NPC_ValueDependentIsNotNull) !=
+			    Expr::NullPointerConstantKind::NPCK_NotNull) {
+				DEBUG ("Found non-NULL check.");
+				const FormulaNode* atom =
+					arena.get_nonnull (decl_expr->getDecl (),
+					                   e);
+
+				return (opcode == BinaryOperatorKind::BO_NE) ?
+					atom : arena.get_negation (atom);
+			}
+		}
+
+		return arena.get_opaque (e);
+	}
+	case Expr::ConditionalOperatorClass: {
+		/* C ? S1 : S2 ↦ (calc(C) ∧ calc(S1)) ∨ (¬calc(C) ∧ calc(S2)) */
+		ConditionalOperator& op_expr = cast<ConditionalOperator> (*e);
+
+		const FormulaNode* cond =
+			_condition_formula (*op_expr.getCond (), context, arena);
+		const FormulaNode* true_formula =
+			_condition_formula (*op_expr.getTrueExpr (), context,
+			                    arena);
+		const FormulaNode* false_formula =
+			_condition_formula (*op_expr.getFalseExpr (), context,
+			                    arena);
+
+		return arena.get_disjunction (
+			arena.get_conjunction (cond, true_formula),
+			arena.get_conjunction (arena.get_negation (cond),
+			                       false_formula));
+	}
+	case Expr::CStyleCastExprClass:
+	case Expr::ImplicitCastExprClass: {
+		/* (T) S ↦ calc(S)
+		 * This covers both explicit casts to gboolean, and implicit
+		 * pointer-to-boolean conversions such as (my_var). */
+		CastExpr& cast_expr = cast<CastExpr> (*e);
+
+		return _condition_formula (*cast_expr.getSubExpr (), context,
+		                           arena);
+	}
+	case Expr::DeclRefExprClass: {
+		/* A variable reference, which will implicitly become a non-NULL
+		 * check.
+		 *     x ↦ NONNULL(x) */
+		DEBUG ("Found non-NULL check.");
+		DeclRefExpr& decl_ref_expr = cast<DeclRefExpr> (*e);
+
+		return arena.get_nonnull (decl_ref_expr.getDecl (), e);
+	}
+	case Expr::StmtExprClass: {
+		/* NSPACE_IS_OBJ (x) ↦ GTYPE_CHECK(x)
+		 * _G_BOOLEAN_EXPR (S) ↦ calc(S) */
+		StmtExpr& stmt_expr = cast<StmtExpr> (*e);
+
+		const ValueDecl* checked_decl =
+			_stmt_expr_is_gobject_type_check (stmt_expr);
+		if (checked_decl != NULL) {
+			DEBUG ("Found GObject type check.");
+			return arena.get_gtype_check (checked_decl, e);
+		}
+
+		Expr* wrapped_expr = _stmt_expr_is_boolean_expr (stmt_expr);
+		if (wrapped_expr != NULL) {
+			return _condition_formula (*wrapped_expr, context,
+			                           arena);
+		}
+
+		return arena.get_opaque (e);
+	}
+	case Expr::CallExprClass: {
+		/* __builtin_expect (S, N) ↦ calc(S)
+		 * Other function calls are opaque. */
+		CallExpr& call_expr = cast<CallExpr> (*e);
+		FunctionDecl* func = call_expr.getDirectCallee ();
+
+		if (func != NULL && call_expr.getNumArgs () > 0 &&
+		    func->getBuiltinID () == Builtin::BI__builtin_expect) {
+			return _condition_formula (*call_expr.getArg (0),
+			                           context, arena);
+		}
+
+		return arena.get_opaque (e);
+	}
+	default:
+		return arena.get_opaque (e);
+	}
 }
 
 /* Does the given statement look like:
@@ -109,8 +338,9 @@ _disjunction_expr (Expr* lhs, Expr* rhs, const ASTContext& context)
  * If the statement changes program state at all, return NULL. Otherwise, return
  * the condition which holds for the assertion to be bypassed (i.e. for the
  * assertion to succeed). This function is built recursively, building a boolean
- * expression for the condition based on avoiding branches which call
- * abort()-like functions.
+ * formula for the condition in @arena based on avoiding branches which call
+ * abort()-like functions. Conditions in the code are converted to formulae
+ * using _condition_formula().
  *
  * This function is based on a transformation of the AST to an augmented boolean
  * expression, using rules documented in each switch case. In this
@@ -122,8 +352,9 @@ _disjunction_expr (Expr* lhs, Expr* rhs, const ASTContext& context)
  *     B ∨ NULL ≡ NULL
  *     ¬NULL ≡ NULL
  */
-Expr*
-AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
+static const FormulaNode*
+_assertion_formula (Stmt& stmt, const ASTContext& context,
+                    FormulaArena& arena)
 {
 	DEBUG ("Checking " << stmt.getStmtClassName () << " for assertions.");
 
@@ -159,7 +390,8 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 			 *
 			 * TODO: May need to fix up the condition for macros
 			 * like g_assert_null(). */
-			return call_expr.getArg (0);
+			return _condition_formula (*call_expr.getArg (0),
+			                           context, arena);
 		} else if (_is_assertion_fail_func_name (func_name)) {
 			/* Assertion path where the assertion macro has been
 			 * expanded and we're on the assertion failure branch.
@@ -167,10 +399,7 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 			 * In this case, the assertion condition has been
 			 * grabbed from an if statement already, so negate it
 			 * (to avoid the failure condition) and return. */
-			return new (context)
-				IntegerLiteral (context, context.MakeIntValue (0, context.getLogicalOperationType ()),
-				                context.getLogicalOperationType (),
-				                SourceLocation ());
+			return arena.get_false ();
 		}
 
 		/* Not an assertion path. */
@@ -194,7 +423,7 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		    expr != NULL &&
 		    expr->isIntegerConstantExpr (bool_expr, context) &&
 		    !bool_expr.getBoolValue ()) {
-			return is_assertion_stmt (*body, context);
+			return _assertion_formula (*body, context, arena);
 		}
 
 		return NULL;
@@ -211,31 +440,31 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		IfStmt& if_stmt = cast<IfStmt> (stmt);
 		assert (if_stmt.getThen () != NULL);
 
-		Expr* neg_cond = _negation_expr (if_stmt.getCond (), context);
+		const FormulaNode* cond =
+			_condition_formula (*if_stmt.getCond (), context, arena);
+		const FormulaNode* neg_cond = arena.get_negation (cond);
 
-		Expr* then_assertion =
-			is_assertion_stmt (*(if_stmt.getThen ()), context);
+		const FormulaNode* then_assertion =
+			_assertion_formula (*(if_stmt.getThen ()), context,
+			                    arena);
 		if (then_assertion == NULL)
 			return NULL;
 
-		then_assertion =
-			_conjunction_expr (if_stmt.getCond (), then_assertion,
-			                   context);
+		then_assertion = arena.get_conjunction (cond, then_assertion);
 
 		if (if_stmt.getElse () == NULL)
-			return _disjunction_expr (then_assertion, neg_cond,
-			                          context);
+			return arena.get_disjunction (then_assertion, neg_cond);
 
-		Expr* else_assertion =
-			is_assertion_stmt (*(if_stmt.getElse ()), context);
+		const FormulaNode* else_assertion =
+			_assertion_formula (*(if_stmt.getElse ()), context,
+			                    arena);
 		if (else_assertion == NULL)
 			return NULL;
 
-		else_assertion =
-			_conjunction_expr (neg_cond, else_assertion, context);
+		else_assertion = arena.get_conjunction (neg_cond,
+		                                        else_assertion);
 
-		return _disjunction_expr (then_assertion, else_assertion,
-		                          context);
+		return arena.get_disjunction (then_assertion, else_assertion);
 	}
 	case Stmt::StmtClass::ConditionalOperatorClass: {
 		/* Handle a ternary operator.
@@ -246,28 +475,28 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		assert (op_expr.getTrueExpr () != NULL);
 		assert (op_expr.getFalseExpr () != NULL);
 
-		Expr* neg_cond = _negation_expr (op_expr.getCond (), context);
+		const FormulaNode* cond =
+			_condition_formula (*op_expr.getCond (), context, arena);
+		const FormulaNode* neg_cond = arena.get_negation (cond);
 
-		Expr* then_assertion =
-			is_assertion_stmt (*(op_expr.getTrueExpr ()), context);
+		const FormulaNode* then_assertion =
+			_assertion_formula (*(op_expr.getTrueExpr ()), context,
+			                    arena);
 		if (then_assertion == NULL)
 			return NULL;
 
-		then_assertion =
-			_conjunction_expr (op_expr.getCond (), then_assertion,
-			                   context);
+		then_assertion = arena.get_conjunction (cond, then_assertion);
 
-		Expr* else_assertion =
-			is_assertion_stmt (*(op_expr.getFalseExpr ()),
-			                   context);
+		const FormulaNode* else_assertion =
+			_assertion_formula (*(op_expr.getFalseExpr ()),
+			                    context, arena);
 		if (else_assertion == NULL)
 			return NULL;
 
-		else_assertion =
-			_conjunction_expr (neg_cond, else_assertion, context);
+		else_assertion = arena.get_conjunction (neg_cond,
+		                                        else_assertion);
 
-		return _disjunction_expr (then_assertion, else_assertion,
-		                          context);
+		return arena.get_disjunction (then_assertion, else_assertion);
 	}
 	case Stmt::StmtClass::SwitchStmtClass: {
 		/* Handle a switch statement.
@@ -286,7 +515,7 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		if (sub_stmt == NULL)
 			return NULL;
 
-		return is_assertion_stmt (*sub_stmt, context);
+		return _assertion_formula (*sub_stmt, context, arena);
 	}
 	case Stmt::StmtClass::CompoundStmtClass: {
 		/* Handle a compound statement, e.g. { stmt1; stmt2; }.
@@ -300,22 +529,17 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		 * compound.
 		 *
 		 * If the compound is empty, the compound_condition will be
-		 * TRUE. Otherwise, it will be (TRUE ∧ …), which will be
-		 * simplified later. */
+		 * TRUE. The arena simplifies away the TRUE otherwise. */
 		CompoundStmt& compound_stmt = cast<CompoundStmt> (stmt);
-		Expr* compound_condition =
-			new (context)
-				IntegerLiteral (context,
-				                context.MakeIntValue (1, context.getLogicalOperationType ()),
-				                context.getLogicalOperationType (),
-				                SourceLocation ());
+		const FormulaNode* compound_condition = arena.get_true ();
 
 		for (CompoundStmt::const_body_iterator it =
 		     compound_stmt.body_begin (),
 		     ie = compound_stmt.body_end (); it != ie; ++it) {
 			Stmt* body_stmt = *it;
-			Expr* body_assertion =
-				is_assertion_stmt (*body_stmt, context);
+			const FormulaNode* body_assertion =
+				_assertion_formula (*body_stmt, context,
+				                    arena);
 
 			if (body_assertion == NULL) {
 				/* Reached a program state mutation. */
@@ -324,10 +548,8 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 
 			/* Update the compound condition. */
 			compound_condition =
-				_conjunction_expr (compound_condition,
-				                   body_assertion, context);
-
-			DEBUG_EXPR ("Compound condition: ", *compound_condition);
+				arena.get_conjunction (compound_condition,
+				                       body_assertion);
 		}
 
 		return compound_condition;
@@ -340,11 +562,7 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		/* Handle a return statement.
 		 * Transformations:
 		 *     return ↦ FALSE */
-		return new (context)
-			IntegerLiteral (context,
-			                context.MakeIntValue (0, context.getLogicalOperationType ()),
-			                context.getLogicalOperationType (),
-			                SourceLocation ());
+		return arena.get_false ();
 	}
 	case Stmt::StmtClass::NullStmtClass:
 		/* Handle a null statement.
@@ -363,11 +581,7 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		 * Transformations:
 		 *     T S1 ↦ TRUE
 		 *     T S1 = S2 ↦ TRUE */
-		return new (context)
-			IntegerLiteral (context,
-			                context.MakeIntValue (1, context.getLogicalOperationType ()),
-			                context.getLogicalOperationType (),
-			                SourceLocation ());
+		return arena.get_true ();
 	}
 	case Stmt::StmtClass::IntegerLiteralClass: {
 		/* Handle an integer literal. This doesn’t modify program state,
@@ -375,7 +589,7 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		 * Transformations:
 		 *     0 ↦ FALSE
 		 *     I ↦ TRUE */
-		return dyn_cast<Expr> (&stmt);
+		return _condition_formula (cast<Expr> (stmt), context, arena);
 	}
 	case Stmt::StmtClass::ParenExprClass: {
 		/* Handle a parenthesised expression.
@@ -387,7 +601,7 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		if (sub_expr == NULL)
 			return NULL;
 
-		return is_assertion_stmt (*sub_expr, context);
+		return _assertion_formula (*sub_expr, context, arena);
 	}
 	case Stmt::StmtClass::LabelStmtClass: {
 		/* Handle a label statement.
@@ -399,7 +613,7 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		if (sub_stmt == NULL)
 			return NULL;
 
-		return is_assertion_stmt (*sub_stmt, context);
+		return _assertion_formula (*sub_stmt, context, arena);
 	}
 	case Stmt::StmtClass::ImplicitCastExprClass:
 	case Stmt::StmtClass::CStyleCastExprClass: {
@@ -412,7 +626,7 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		if (sub_expr == NULL)
 			return NULL;
 
-		return is_assertion_stmt (*sub_expr, context);
+		return _assertion_formula (*sub_expr, context, arena);
 	}
 	case Stmt::StmtClass::GCCAsmStmtClass:
 	case Stmt::StmtClass::MSAsmStmtClass:
@@ -461,389 +675,278 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 	}
 }
 
-/* Simplify a logical expression. Currently this eliminates extra parens and
- * casts, and performs basic boolean simplification according to common
- * identities.
+/* Calculate which variables the formula @f implies are non-NULL, and which it
+ * implies are GObject type checked, adding them to @nonnull_decls and
+ * @gtype_checked_decls respectively, using a structural approximation. A
+ * variable is implied by a conjunction if it’s implied by either side, and by
+ * a disjunction if it’s implied by both sides. Negations and opaque atoms
+ * imply nothing. This is the fallback for when _formula_checked_decls_bdd()
+ * exceeds its budget: it’s sound, but misses implications which need
+ * reasoning across sub-formulae, such as (x ∨ y) ∧ ¬y.
  *
- * FIXME: Ideally, this should should be a full boolean expression minimiser,
- * returning in disjunctive normal form. */
-static Expr*
-_simplify_boolean_expr (Expr* expr, const ASTContext& context)
+ * Returns the number of insertions made (which may be an over-estimate of the
+ * number of new elements in the sets, as it doesn’t account for duplicates). */
+static unsigned int
+_formula_checked_decls (const FormulaNode* f,
+                        std::unordered_set<const ValueDecl*>& nonnull_decls,
+                        std::unordered_set<const ValueDecl*>& gtype_checked_decls)
 {
-	expr = expr->IgnoreParens ();
-
-	DEBUG ("Simplifying boolean expression of type " <<
-	       expr->getStmtClassName ());
-
-	if (expr->getStmtClass () == Expr::UnaryOperatorClass) {
-		UnaryOperator& op_expr = cast<UnaryOperator> (*expr);
-		Expr* sub_expr =
-			_simplify_boolean_expr (op_expr.getSubExpr (), context);
-
-		if (op_expr.getOpcode () != UnaryOperatorKind::UO_LNot) {
-			/* op S ↦ op simplify(S) */
-			op_expr.setSubExpr (sub_expr);
-			return expr;
-		}
-
-		if (sub_expr->getStmtClass () == Expr::UnaryOperatorClass) {
-			UnaryOperator& op_sub_expr =
-				cast<UnaryOperator> (*sub_expr);
-			Expr* sub_sub_expr =
-				_simplify_boolean_expr (
-					op_sub_expr.getSubExpr (), context);
-
-			if (op_sub_expr.getOpcode () ==
-			    UnaryOperatorKind::UO_LNot) {
-				/* ! ! S ↦ simplify(S) */
-				return sub_sub_expr;
+	switch (f->kind) {
+	case FormulaNode::KIND_NONNULL:
+		nonnull_decls.insert (f->decl);
+		return 1;
+	case FormulaNode::KIND_GTYPE_CHECK:
+		gtype_checked_decls.insert (f->decl);
+		return 1;
+	case FormulaNode::KIND_AND:
+		return _formula_checked_decls (f->lhs, nonnull_decls,
+		                               gtype_checked_decls) +
+		       _formula_checked_decls (f->rhs, nonnull_decls,
+		                               gtype_checked_decls);
+	case FormulaNode::KIND_OR: {
+		std::unordered_set<const ValueDecl*> lhs_nonnull, lhs_gtype;
+		std::unordered_set<const ValueDecl*> rhs_nonnull, rhs_gtype;
+		unsigned int count = 0;
+
+		_formula_checked_decls (f->lhs, lhs_nonnull, lhs_gtype);
+		_formula_checked_decls (f->rhs, rhs_nonnull, rhs_gtype);
+
+		/* A GType check implies a non-NULL check. */
+		lhs_nonnull.insert (lhs_gtype.begin (), lhs_gtype.end ());
+		rhs_nonnull.insert (rhs_gtype.begin (), rhs_gtype.end ());
+
+		for (std::unordered_set<const ValueDecl*>::const_iterator it = lhs_gtype.begin (),
+		     ie = lhs_gtype.end (); it != ie; ++it) {
+			if (rhs_gtype.count (*it) > 0) {
+				gtype_checked_decls.insert (*it);
+				count++;
 			}
+		}
 
-			/* ! op S ↦ ! op simplify(S) */
-			op_sub_expr.setSubExpr (sub_sub_expr);
-			return expr;
-		} else if (sub_expr->getStmtClass () ==
-		           Expr::BinaryOperatorClass) {
-			BinaryOperator& op_sub_expr =
-				cast<BinaryOperator> (*sub_expr);
-			Expr* lhs =
-				_simplify_boolean_expr (
-					op_sub_expr.getLHS (), context);
-			Expr* rhs =
-				_simplify_boolean_expr (
-					op_sub_expr.getRHS (), context);
-
-			if (op_sub_expr.getOpcode () ==
-			    BinaryOperatorKind::BO_EQ ||
-			    op_sub_expr.getOpcode () ==
-			    BinaryOperatorKind::BO_NE) {
-				/* ! (S1 == S2) ↦
-				 *     simplify(S1) != simplify(S2)
-				 * or
-				 * ! (S1 != S2) ↦
-				 *     simplify(S1) == simplify(S2) */
-				BinaryOperatorKind opcode =
-					(op_sub_expr.getOpcode () ==
-					 BinaryOperatorKind::BO_EQ) ?
-						BinaryOperatorKind::BO_NE :
-						BinaryOperatorKind::BO_EQ;
-
-				return new (context)
-					BinaryOperator (lhs, rhs, opcode,
-					                context.getLogicalOperationType (),
-					                VK_RValue, OK_Ordinary, SourceLocation (),
-					                false);
+		for (std::unordered_set<const ValueDecl*>::const_iterator it = lhs_nonnull.begin (),
+		     ie = lhs_nonnull.end (); it != ie; ++it) {
+			if (rhs_nonnull.count (*it) > 0) {
+				nonnull_decls.insert (*it);
+				count++;
 			}
-
-			/* ! (S1 op S2) ↦ ! (simplify(S1) op simplify(S2)) */
-			op_sub_expr.setLHS (lhs);
-			op_sub_expr.setRHS (rhs);
-			return expr;
-		}
-	} else if (expr->getStmtClass () == Expr::BinaryOperatorClass) {
-		BinaryOperator& op_expr = cast<BinaryOperator> (*expr);
-		Expr* lhs = _simplify_boolean_expr (op_expr.getLHS (), context);
-		Expr* rhs = _simplify_boolean_expr (op_expr.getRHS (), context);
-
-		/* Guaranteed one-hot. */
-		bool is_and =
-			op_expr.getOpcode () == BinaryOperatorKind::BO_LAnd;
-		bool is_or =
-			op_expr.getOpcode () == BinaryOperatorKind::BO_LOr;
-
-		if (!is_and && !is_or) {
-			/* S1 op S2 ↦ simplify(S1) op simplify(S2) */
-			op_expr.setLHS (lhs);
-			op_expr.setRHS (rhs);
-			return expr;
 		}
 
-		llvm::APSInt bool_expr;
+		return count;
+	}
+	case FormulaNode::KIND_TRUE:
+	case FormulaNode::KIND_FALSE:
+	case FormulaNode::KIND_OPAQUE:
+	case FormulaNode::KIND_NOT:
+	default:
+		return 0;
+	}
+}
 
-		if (lhs->isIntegerConstantExpr (bool_expr, context)) {
-			if (is_or && bool_expr.getBoolValue ()) {
-				/* 1 || S2 ↦ 1 */
-				return new (context)
-					IntegerLiteral (context,
-					                context.MakeIntValue (1, context.getLogicalOperationType ()),
-					                context.getLogicalOperationType (),
-					                SourceLocation ());
-			} else if (is_and && !bool_expr.getBoolValue ()) {
-				/* 0 && S2 ↦ 0 */
-				return new (context)
-					IntegerLiteral (context,
-					                context.MakeIntValue (0, context.getLogicalOperationType ()),
-					                context.getLogicalOperationType (),
-					                SourceLocation ());
-			} else {
-				/* 1 && S2 ↦ simplify(S2)
-				 * or
-				 * 0 || S2 ↦ simplify(S2) */
-				return rhs;
-			}
-		} else if (rhs->isIntegerConstantExpr (bool_expr, context)) {
-			if (is_or && bool_expr.getBoolValue ()) {
-				/* S1 || 1 ↦ 1 */
-				return new (context)
-					IntegerLiteral (context,
-					                context.MakeIntValue (1, context.getLogicalOperationType ()),
-					                context.getLogicalOperationType (),
-					                SourceLocation ());
-			} else if (is_and && !bool_expr.getBoolValue ()) {
-				/* S2 && 0 ↦ 0 */
-				return new (context)
-					IntegerLiteral (context,
-					                context.MakeIntValue (0, context.getLogicalOperationType ()),
-					                context.getLogicalOperationType (),
-					                SourceLocation ());
-			} else {
-				/* S1 && 1 ↦ simplify(S1)
-				 * or
-				 * S1 || 0 ↦ simplify(S1) */
-				return lhs;
-			}
+/* The semantic atoms for a single variable in a formula. Either may be
+ * %NULL. */
+typedef struct {
+	const FormulaNode* nonnull;
+	const FormulaNode* gtype_check;
+} CheckedDeclAtoms;
+
+static void
+_collect_checked_decl_atoms (const FormulaNode* f,
+                             llvm::DenseMap<const ValueDecl*, CheckedDeclAtoms>& atoms,
+                             llvm::DenseMap<const FormulaNode*, bool>& visited)
+{
+	if (!visited.insert (std::make_pair (f, true)).second)
+		return;
+
+	switch (f->kind) {
+	case FormulaNode::KIND_NONNULL:
+	case FormulaNode::KIND_GTYPE_CHECK: {
+		llvm::DenseMap<const ValueDecl*, CheckedDeclAtoms>::iterator it =
+			atoms.find (f->decl);
+
+		if (it == atoms.end ()) {
+			CheckedDeclAtoms a = { NULL, NULL };
+			it = atoms.insert (std::make_pair (f->decl, a)).first;
 		}
 
-		/* S1 op S2 ↦ simplify(S1) op simplify(S2) */
-		op_expr.setLHS (lhs);
-		op_expr.setRHS (rhs);
-		return expr;
-	}
+		if (f->kind == FormulaNode::KIND_NONNULL)
+			(*it).second.nonnull = f;
+		else
+			(*it).second.gtype_check = f;
 
-	return expr;
+		break;
+	}
+	case FormulaNode::KIND_NOT:
+		_collect_checked_decl_atoms (f->lhs, atoms, visited);
+		break;
+	case FormulaNode::KIND_AND:
+	case FormulaNode::KIND_OR:
+		_collect_checked_decl_atoms (f->lhs, atoms, visited);
+		_collect_checked_decl_atoms (f->rhs, atoms, visited);
+		break;
+	case FormulaNode::KIND_TRUE:
+	case FormulaNode::KIND_FALSE:
+	case FormulaNode::KIND_OPAQUE:
+	default:
+		break;
+	}
 }
 
-/* Calculate whether an assertion is a standard GObject type check.
- * .e.g. NSPACE_IS_OBJ(x).
- *
- * This is complicated by the fact that type checking is done by macros, which
- * expand to something like:
- * (((__extension__ ({
- *    GTypeInstance *__inst = (GTypeInstance *)((x));
- *    GType __t = ((nspace_obj_get_type()));
- *    gboolean __r;
- *    if (!__inst)
- *        __r = (0);
- *    else if (__inst->g_class && __inst->g_class->g_type == __t)
- *        __r = (!(0));
- *    else
- *        __r = g_type_check_instance_is_a(__inst, __t);
- *    __r;
- * }))))
- *
- * Insert the ValueDecls of the variables being checked into the provided
- * unordered_set, and return the number of such insertions (this will be 0 if no
- * variables are type checked). The returned number may be an over-estimate
- * of the number of elements in the set, as it doesn’t account for
- * duplicates. */
-static unsigned int
-_assertion_is_gobject_type_check (Expr& assertion_expr,
-                                  const ASTContext& context,
-                                  std::unordered_set<const ValueDecl*>& ret)
+/* As _formula_checked_decls(), but exact: a variable is non-NULL checked iff
+ * @f implies (NONNULL(x) ∨ GTYPE_CHECK(x)), and GObject type checked iff @f
+ * implies GTYPE_CHECK(x). Each query is a single ROBDD operation. Returns
+ * %false, having added nothing, if the ROBDD budget is exceeded. */
+static bool
+_formula_checked_decls_bdd (const FormulaNode* f,
+                            std::unordered_set<const ValueDecl*>& nonnull_decls,
+                            std::unordered_set<const ValueDecl*>& gtype_checked_decls)
 {
-	DEBUG_EXPR (__func__ << ": ", assertion_expr);
-
-	switch ((int) assertion_expr.getStmtClass ()) {
-	case Expr::StmtExprClass: {
-		/* Parse all the way through the statement expression, checking
-		 * if the first statement is an assignment to the __inst
-		 * variable, as in the macro expansion given above.
-		 *
-		 * This is a particularly shoddy way of checking for a GObject
-		 * type check (we should really check for a
-		 * g_type_check_instance_is_a() call) but this will do for
-		 * now. */
-		StmtExpr& stmt_expr = cast<StmtExpr> (assertion_expr);
-		CompoundStmt* compound_stmt = stmt_expr.getSubStmt ();
-		const Stmt* first_stmt = *(compound_stmt->body_begin ());
-
-		if (first_stmt->getStmtClass () != Expr::DeclStmtClass)
-			return 0;
-
-		const DeclStmt& decl_stmt = cast<DeclStmt> (*first_stmt);
-		const VarDecl* decl =
-			dyn_cast<VarDecl> (decl_stmt.getSingleDecl ());
-
-		if (decl == NULL)
-			return 0;
-
-		if (decl->getNameAsString () != "__inst")
-			return 0;
-
-		const Expr* init =
-			decl->getAnyInitializer ()->IgnoreParenCasts ();
-		const DeclRefExpr* decl_expr = dyn_cast<DeclRefExpr> (init);
-		if (decl_expr != NULL) {
-			ret.insert (decl_expr->getDecl ());
-			return 1;
+	FormulaBdd bdd (BDD_MAX_NODES, BDD_MAX_STEPS);
+	FormulaBdd::Ref f_bdd = bdd.from_formula (f);
+
+	if (f_bdd == FormulaBdd::OVERFLOW_REF)
+		return false;
+
+	llvm::DenseMap<const ValueDecl*, CheckedDeclAtoms> atoms;
+	llvm::DenseMap<const FormulaNode*, bool> visited;
+	_collect_checked_decl_atoms (f, atoms, visited);
+
+	std::vector<const ValueDecl*> nonnull, gtype_checked;
+
+	for (llvm::DenseMap<const ValueDecl*, CheckedDeclAtoms>::const_iterator it = atoms.begin (),
+	     ie = atoms.end (); it != ie; ++it) {
+		const CheckedDeclAtoms& a = (*it).second;
+		FormulaBdd::Ref nonnull_bdd = (a.nonnull != NULL) ?
+			bdd.from_formula (a.nonnull) : FormulaBdd::FALSE_REF;
+		FormulaBdd::Ref gtype_bdd = (a.gtype_check != NULL) ?
+			bdd.from_formula (a.gtype_check) : FormulaBdd::FALSE_REF;
+
+		/* A GType check implies a non-NULL check. */
+		if (bdd.implies (f_bdd, bdd.get_disjunction (nonnull_bdd,
+		                                             gtype_bdd))) {
+			nonnull.push_back ((*it).first);
 		}
 
-		return 0;
-	}
-	case Expr::IntegerLiteralClass:
-	case Expr::BinaryOperatorClass:
-	case Expr::UnaryOperatorClass:
-	case Expr::ConditionalOperatorClass:
-	case Expr::CallExprClass:
-	case Expr::ImplicitCastExprClass: {
-		/* These can’t be type checks. */
-		return 0;
+		if (a.gtype_check != NULL && bdd.implies (f_bdd, gtype_bdd)) {
+			gtype_checked.push_back ((*it).first);
+		}
 	}
-	case Stmt::StmtClass::NoStmtClass:
-	default:
-		WARN_EXPR (__func__ << "() can’t handle expressions of type " <<
-		           assertion_expr.getStmtClassName (), assertion_expr);
-		return 0;
+
+	if (bdd.has_overflowed ())
+		return false;
+
+	nonnull_decls.insert (nonnull.begin (), nonnull.end ());
+	gtype_checked_decls.insert (gtype_checked.begin (),
+	                            gtype_checked.end ());
+
+	return true;
+}
+
+/* Find the variables which @f implies are non-NULL and GObject type checked,
+ * exactly if possible and approximately otherwise. */
+static void
+_get_checked_decls (const FormulaNode* f,
+                    std::unordered_set<const ValueDecl*>& nonnull_decls,
+                    std::unordered_set<const ValueDecl*>& gtype_checked_decls)
+{
+	if (!_formula_checked_decls_bdd (f, nonnull_decls,
+	                                 gtype_checked_decls)) {
+		DEBUG ("ROBDD budget exceeded; using structural analysis.");
+		_formula_checked_decls (f, nonnull_decls, gtype_checked_decls);
 	}
 }
 
-/* Calculate whether an assertion is a standard non-NULL check.
- * e.g. (x != NULL), (x), (x != NULL && …) or (x && …).
+/* Extract the preconditions from the assertion statements at the top of
+ * @body. Iteration stops at the first non-assertion and non-declaration
+ * statement. Specifically, it stops before the first assignment, as that could
+ * affect the outcome of any subsequent assertions.
  *
- * Insert the ValueDecls of the variables being checked into the provided
- * unordered_set, and return the number of such insertions (this will be 0 if no
- * variables are non-NULL checked). The returned number may be an over-estimate
- * of the number of elements in the set, as it doesn’t account for
- * duplicates. */
-static unsigned int
-_assertion_is_explicit_nonnull_check (Expr& assertion_expr,
-                                      const ASTContext& context,
-                                      std::unordered_set<const ValueDecl*>& ret)
+ * The conditions of all the assertions are conjoined and queried together, so
+ * that implications spanning several assertions are found. They are only ever
+ * held in a formula arena local to this call, so nothing is allocated in the
+ * ASTContext. */
+void
+AssertionExtracter::extract_preconditions (CompoundStmt& body,
+                                           const ASTContext& context,
+                                           Preconditions& preconditions)
 {
-	DEBUG_EXPR (__func__ << ": ", assertion_expr);
+	FormulaArena arena;
+	const FormulaNode* precondition = arena.get_true ();
 
-	switch ((int) assertion_expr.getStmtClass ()) {
-	case Expr::BinaryOperatorClass: {
-		BinaryOperator& bin_expr =
-			cast<BinaryOperator> (assertion_expr);
-		BinaryOperatorKind opcode = bin_expr.getOpcode ();
-
-		if (opcode == BinaryOperatorKind::BO_LAnd) {
-			/* LHS && RHS */
-			unsigned int lhs_count =
-				AssertionExtracter::assertion_is_nonnull_check (*(bin_expr.getLHS ()), context, ret);
-			unsigned int rhs_count =
-				AssertionExtracter::assertion_is_nonnull_check (*(bin_expr.getRHS ()), context, ret);
-
-			return lhs_count + rhs_count;
-		} else if (opcode == BinaryOperatorKind::BO_LOr) {
-			/* LHS || RHS */
-			std::unordered_set<const ValueDecl*> lhs_vars, rhs_vars;
-
-			unsigned int lhs_count =
-				AssertionExtracter::assertion_is_nonnull_check (*(bin_expr.getLHS ()), context, lhs_vars);
-			unsigned int rhs_count =
-				AssertionExtracter::assertion_is_nonnull_check (*(bin_expr.getRHS ()), context, rhs_vars);
-
-			std::set_intersection (lhs_vars.begin (),
-			                       lhs_vars.end (),
-			                       rhs_vars.begin (),
-			                       rhs_vars.end (),
-			                       std::inserter (ret, ret.end ()));
-
-			return lhs_count + rhs_count;
-		} else if (opcode == BinaryOperatorKind::BO_NE) {
-			/* LHS != RHS */
-			Expr* rhs = bin_expr.getRHS ();
-			Expr::NullPointerConstantKind k =
-				rhs->isNullPointerConstant (const_cast<ASTContext&> (context),
-				                            Expr::NullPointerConstantValueDependence::NPC_ValueDependentIsNotNull);
-			if (k != Expr::NullPointerConstantKind::NPCK_NotNull &&
-			    bin_expr.getLHS ()->IgnoreParenCasts ()->getStmtClass () == Expr::DeclRefExprClass) {
-				DEBUG ("Found non-NULL check.");
-				ret.insert (cast<DeclRefExpr> (bin_expr.getLHS ()->IgnoreParenCasts ())->getDecl ());
-				return 1;
-			}
+	for (CompoundStmt::const_body_iterator it = body.body_begin (),
+	     ie = body.body_end (); it != ie; ++it) {
+		Stmt* body_stmt = *it;
 
-			/* Either not a comparison to NULL, or the expr being
-			 * compared is not a DeclRefExpr. */
-			return 0;
-		}
+		const FormulaNode* f =
+			_assertion_formula (*body_stmt, context, arena);
 
-		return 0;
-	}
-	case Expr::UnaryOperatorClass: {
-		/* A unary operator. For the moment, assume this isn't a
-		 * non-null check.
-		 *
-		 * FIXME: In the future, define a proper program transformation
-		 * to check for non-null checks, since we could have expressions
-		 * like:
-		 *     !(my_var == NULL)
-		 * or (more weirdly):
-		 *     ~(my_var == NULL)
-		 */
-		return 0;
-	}
-	case Expr::ConditionalOperatorClass: {
-		/* A conditional operator. For the moment, assume this isn’t a
-		 * non-null check.
-		 *
-		 * FIXME: In the future, define a proper program transformation
-		 * to check for non-null checks, since we could have expressions
-		 * like:
-		 *     (x == NULL) ? TRUE : FALSE
-		 */
-		return 0;
-	}
-	case Expr::CStyleCastExprClass:
-	case Expr::ImplicitCastExprClass: {
-		/* A (explicit or implicit) cast. This can either be:
-		 *     (void*)0
-		 * or
-		 *     (bool)my_var */
-		CastExpr& cast_expr = cast<CastExpr> (assertion_expr);
-		Expr* sub_expr = cast_expr.getSubExpr ()->IgnoreParenCasts ();
-
-		if (sub_expr->getStmtClass () == Expr::DeclRefExprClass) {
-			DEBUG ("Found non-NULL check.");
-			ret.insert (cast<DeclRefExpr> (sub_expr)->getDecl ());
-			return 1;
+		if (f == NULL) {
+			/* Potential program state mutation reached, so run
+			 * away. */
+			break;
 		}
 
-		/* Not a cast to NULL, or the expr being casted is not a
-		 * DeclRefExpr. */
-		return 0;
-	}
-	case Expr::DeclRefExprClass: {
-		/* A variable reference, which will implicitly become a non-NULL
-		 * check. */
-		DEBUG ("Found non-NULL check.");
-		DeclRefExpr& decl_ref_expr = cast<DeclRefExpr> (assertion_expr);
-		ret.insert (decl_ref_expr.getDecl ());
-		return 1;
-	}
-	case Expr::StmtExprClass:
-		/* FIXME: Statement expressions can be nonnull checks, but
-		 * detecting them requires a formal program transformation which
-		 * has not been implemented yet. */
-	case Expr::CallExprClass:
-		/* Function calls can’t be nonnull checks. */
-	case Expr::IntegerLiteralClass: {
-		/* Integer literals can’t be nonnull checks. */
-		return 0;
-	}
-	case Stmt::StmtClass::NoStmtClass:
-	default:
-		WARN_EXPR (__func__ << "() can’t handle expressions of type " <<
-		           assertion_expr.getStmtClassName (), assertion_expr);
-		return 0;
+		precondition = arena.get_conjunction (precondition, f);
 	}
+
+	_get_checked_decls (precondition, preconditions.nonnull_decls,
+	                    preconditions.gtype_checked_decls);
+
+	DEBUG ("Extracted preconditions using " << arena.get_n_nodes () <<
+	       " formula nodes.");
+
+	preconditions.nonnull_decls.insert (
+		preconditions.gtype_checked_decls.begin (),
+		preconditions.gtype_checked_decls.end ());
 }
 
-unsigned int
-AssertionExtracter::assertion_is_nonnull_check (Expr& assertion_expr,
-                                                const ASTContext& context,
-                                                std::unordered_set<const ValueDecl*>& param_decls)
+/* Get the preconditions of @func, extracting them if this is the first time
+ * they’ve been requested. Returns %NULL if @func has no body, or if its body
+ * isn’t a compound statement. The returned pointer remains valid for the
+ * lifetime of the cache. */
+const AssertionExtracter::Preconditions*
+PreconditionCache::get_preconditions (const FunctionDecl& func)
 {
-	/* After this call, assume expr is in boolean disjunctive normal
-	 * form. */
-	Expr* expr = _simplify_boolean_expr (&assertion_expr, context);
+	const FunctionDecl* definition = NULL;
+	Stmt* func_body = func.getBody (definition);
+
+	if (func_body == NULL || definition == NULL)
+		return NULL;
+
+	/* The body should be a compound statement, e.g.
+	 * { stmt; stmt; } */
+	CompoundStmt* body_stmt = dyn_cast<CompoundStmt> (func_body);
+	if (body_stmt == NULL) {
+		DEBUG ("Ignoring function " << func.getNameAsString () <<
+		       " due to having a non-compound statement body.");
+		return NULL;
+	}
+
+	const AssertionExtracter::Preconditions* preconditions;
+
+	/* Extraction of a function’s preconditions isn’t thread-safe (it
+	 * evaluates constant expressions and allocates nodes in the
+	 * ASTContext), so must not run concurrently with itself, or with any
+	 * other modification of the ASTContext by the checkers on other
+	 * threads. */
+	g_mutex_lock (&this->_lock);
+
+	std::unordered_map<const FunctionDecl*,
+	                   AssertionExtracter::Preconditions>::iterator it =
+		this->_preconditions.find (definition);
+
+	if (it != this->_preconditions.end ()) {
+		preconditions = &(*it).second;
+	} else {
+		AssertionExtracter::Preconditions& p =
+			this->_preconditions[definition];
+		tartan::TypeManager::lock_context ();
+		AssertionExtracter::extract_preconditions (
+			*body_stmt, func.getASTContext (), p);
+		tartan::TypeManager::unlock_context ();
+		preconditions = &p;
+	}
 
-	unsigned int explicit_nonnull_count =
-		_assertion_is_explicit_nonnull_check (*expr, context, param_decls);
-	unsigned int type_check_count =
-		_assertion_is_gobject_type_check (*expr, context, param_decls);
+	g_mutex_unlock (&this->_lock);
 
-	return explicit_nonnull_count + type_check_count;
+	return preconditions;
 }
@@ -23,19 +23,53 @@
 #ifndef TARTAN_ASSERTION_EXTRACTER_H
 #define TARTAN_ASSERTION_EXTRACTER_H
 
+#include <unordered_map>
 #include <unordered_set>
 
 #include <clang/AST/AST.h>
 #include <clang/AST/ASTContext.h>
 
+#include <glib.h>
+
 using namespace clang;
 
 namespace AssertionExtracter {
-	Expr* is_assertion_stmt (Stmt& stmt, const ASTContext& context);
+	/* The preconditions asserted by the assertion statements at the top
+	 * of a function body. GType-checked variables are also included in
+	 * @nonnull_decls, as a GType check implies a non-NULL check. */
+	typedef struct {
+		std::unordered_set<const ValueDecl*> nonnull_decls;
+		std::unordered_set<const ValueDecl*> gtype_checked_decls;
+	} Preconditions;
 
-	unsigned int assertion_is_nonnull_check (
-		Expr& assertion_expr, const ASTContext& context,
-		std::unordered_set<const ValueDecl*>& param_decls);
+	void extract_preconditions (CompoundStmt& body,
+	                            const ASTContext& context,
+	                            Preconditions& preconditions);
 }
 
+/* Per-translation-unit cache of the preconditions of each function, so that
+ * the assertion statements at the top of a function body are only extracted
+ * once, however many consumers need them. Functions are keyed by their
+ * definition. This may be used from several threads at once. */
+class PreconditionCache {
+public:
+	PreconditionCache ()
+	{
+		g_mutex_init (&this->_lock);
+	}
+
+	~PreconditionCache ()
+	{
+		g_mutex_clear (&this->_lock);
+	}
+
+	const AssertionExtracter::Preconditions*
+	get_preconditions (const FunctionDecl& func);
+
+private:
+	GMutex _lock;
+	std::unordered_map<const FunctionDecl*,
+	                   AssertionExtracter::Preconditions> _preconditions;
+};
+
 #endif /* !TARTAN_ASSERTION_EXTRACTER_H */
@@ -0,0 +1,211 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#include "config.h"
+
+#include <new>
+
+#include "boolean-formula.h"
+
+void
+FormulaNode::profile (llvm::FoldingSetNodeID& node_id, Kind kind,
+                      const ValueDecl* decl, const Expr* expr,
+                      const FormulaNode* lhs, const FormulaNode* rhs)
+{
+	node_id.AddInteger ((unsigned int) kind);
+
+	switch (kind) {
+	case KIND_TRUE:
+	case KIND_FALSE:
+		break;
+	case KIND_NONNULL:
+	case KIND_GTYPE_CHECK:
+		/* Semantic atoms are identified by their variable, so the
+		 * same check written differently gives the same atom. */
+		node_id.AddPointer (decl);
+		break;
+	case KIND_OPAQUE:
+		node_id.AddPointer (expr);
+		break;
+	case KIND_NOT:
+		node_id.AddPointer (lhs);
+		break;
+	case KIND_AND:
+	case KIND_OR:
+		node_id.AddPointer (lhs);
+		node_id.AddPointer (rhs);
+		break;
+	}
+}
+
+void
+FormulaNode::Profile (llvm::FoldingSetNodeID& node_id) const
+{
+	FormulaNode::profile (node_id, this->kind, this->decl, this->expr,
+	                      this->lhs, this->rhs);
+}
+
+FormulaArena::FormulaArena () : _n_nodes (0)
+{
+	/* Nothing to see here. */
+}
+
+/* Find the existing node with the given structure, or create it. */
+const FormulaNode*
+FormulaArena::_get (FormulaNode::Kind kind, const ValueDecl* decl,
+                    const Expr* expr, const FormulaNode* lhs,
+                    const FormulaNode* rhs)
+{
+	llvm::FoldingSetNodeID node_id;
+	void* insert_pos = NULL;
+
+	FormulaNode::profile (node_id, kind, decl, expr, lhs, rhs);
+
+	FormulaNode* node = this->_nodes.FindNodeOrInsertPos (node_id,
+	                                                      insert_pos);
+	if (node != NULL)
+		return node;
+
+	node = new (this->_allocator.Allocate<FormulaNode> ())
+		FormulaNode (kind, this->_n_nodes++, decl, expr, lhs, rhs);
+	this->_nodes.InsertNode (node, insert_pos);
+
+	return node;
+}
+
+const FormulaNode*
+FormulaArena::get_true ()
+{
+	return this->_get (FormulaNode::KIND_TRUE, NULL, NULL, NULL, NULL);
+}
+
+const FormulaNode*
+FormulaArena::get_false ()
+{
+	return this->_get (FormulaNode::KIND_FALSE, NULL, NULL, NULL, NULL);
+}
+
+const FormulaNode*
+FormulaArena::get_nonnull (const ValueDecl* decl, const Expr* expr)
+{
+	return this->_get (FormulaNode::KIND_NONNULL, decl, expr, NULL, NULL);
+}
+
+const FormulaNode*
+FormulaArena::get_gtype_check (const ValueDecl* decl, const Expr* expr)
+{
+	return this->_get (FormulaNode::KIND_GTYPE_CHECK, decl, expr, NULL,
+	                   NULL);
+}
+
+const FormulaNode*
+FormulaArena::get_opaque (const Expr* expr)
+{
+	return this->_get (FormulaNode::KIND_OPAQUE, NULL, expr, NULL, NULL);
+}
+
+/* Transformations:
+ *     ¬TRUE ↦ FALSE
+ *     ¬FALSE ↦ TRUE
+ *     ¬¬S ↦ S */
+const FormulaNode*
+FormulaArena::get_negation (const FormulaNode* f)
+{
+	switch (f->kind) {
+	case FormulaNode::KIND_TRUE:
+		return this->get_false ();
+	case FormulaNode::KIND_FALSE:
+		return this->get_true ();
+	case FormulaNode::KIND_NOT:
+		return f->lhs;
+	case FormulaNode::KIND_NONNULL:
+	case FormulaNode::KIND_GTYPE_CHECK:
+	case FormulaNode::KIND_OPAQUE:
+	case FormulaNode::KIND_AND:
+	case FormulaNode::KIND_OR:
+	default:
+		return this->_get (FormulaNode::KIND_NOT, NULL, NULL, f, NULL);
+	}
+}
+
+/* Operands of commutative operators are ordered by node ID, so that S1 ∧ S2
+ * and S2 ∧ S1 are the same node. */
+const FormulaNode*
+FormulaArena::_get_binary (FormulaNode::Kind kind, const FormulaNode* lhs,
+                           const FormulaNode* rhs)
+{
+	if (rhs->id < lhs->id) {
+		const FormulaNode* tmp = lhs;
+		lhs = rhs;
+		rhs = tmp;
+	}
+
+	return this->_get (kind, NULL, NULL, lhs, rhs);
+}
+
+/* Transformations:
+ *     FALSE ∧ S ↦ FALSE
+ *     TRUE ∧ S ↦ S
+ *     S ∧ S ↦ S
+ *     S ∧ ¬S ↦ FALSE
+ * and commuted equivalents. */
+const FormulaNode*
+FormulaArena::get_conjunction (const FormulaNode* lhs, const FormulaNode* rhs)
+{
+	if (lhs->kind == FormulaNode::KIND_FALSE ||
+	    rhs->kind == FormulaNode::KIND_FALSE) {
+		return this->get_false ();
+	} else if (lhs->kind == FormulaNode::KIND_TRUE) {
+		return rhs;
+	} else if (rhs->kind == FormulaNode::KIND_TRUE || lhs == rhs) {
+		return lhs;
+	} else if ((lhs->kind == FormulaNode::KIND_NOT && lhs->lhs == rhs) ||
+	           (rhs->kind == FormulaNode::KIND_NOT && rhs->lhs == lhs)) {
+		return this->get_false ();
+	}
+
+	return this->_get_binary (FormulaNode::KIND_AND, lhs, rhs);
+}
+
+/* Transformations:
+ *     TRUE ∨ S ↦ TRUE
+ *     FALSE ∨ S ↦ S
+ *     S ∨ S ↦ S
+ *     S ∨ ¬S ↦ TRUE
+ * and commuted equivalents. */
+const FormulaNode*
+FormulaArena::get_disjunction (const FormulaNode* lhs, const FormulaNode* rhs)
+{
+	if (lhs->kind == FormulaNode::KIND_TRUE ||
+	    rhs->kind == FormulaNode::KIND_TRUE) {
+		return this->get_true ();
+	} else if (lhs->kind == FormulaNode::KIND_FALSE) {
+		return rhs;
+	} else if (rhs->kind == FormulaNode::KIND_FALSE || lhs == rhs) {
+		return lhs;
+	} else if ((lhs->kind == FormulaNode::KIND_NOT && lhs->lhs == rhs) ||
+	           (rhs->kind == FormulaNode::KIND_NOT && rhs->lhs == lhs)) {
+		return this->get_true ();
+	}
+
+	return this->_get_binary (FormulaNode::KIND_OR, lhs, rhs);
+}
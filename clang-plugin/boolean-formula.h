@@ -0,0 +1,124 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_BOOLEAN_FORMULA_H
+#define TARTAN_BOOLEAN_FORMULA_H
+
+#include <clang/AST/AST.h>
+#include <llvm/ADT/FoldingSet.h>
+#include <llvm/Support/Allocator.h>
+
+using namespace clang;
+
+/* A node in a boolean formula DAG, as built by #FormulaArena. Atoms are either
+ * semantic (a non-NULL check or a GType check of a variable) or opaque (any
+ * other condition, identified by its expression). Nodes are hash-consed, so
+ * structurally equal formulae are pointer-equal. */
+class FormulaNode : public llvm::FoldingSetNode {
+public:
+	enum Kind {
+		KIND_TRUE,
+		KIND_FALSE,
+		KIND_NONNULL,  /* decl != NULL */
+		KIND_GTYPE_CHECK,  /* G_TYPE_CHECK_INSTANCE_TYPE (decl, …) */
+		KIND_OPAQUE,  /* expr */
+		KIND_NOT,  /* ¬lhs */
+		KIND_AND,  /* lhs ∧ rhs */
+		KIND_OR,  /* lhs ∨ rhs */
+	};
+
+	FormulaNode (Kind _kind, unsigned int _id, const ValueDecl* _decl,
+	             const Expr* _expr, const FormulaNode* _lhs,
+	             const FormulaNode* _rhs) :
+		kind (_kind), id (_id), decl (_decl), expr (_expr), lhs (_lhs),
+		rhs (_rhs) {}
+
+	const Kind kind;
+	const unsigned int id;  /* unique within the arena, in creation order */
+
+	/* For atoms: the variable being checked (%NULL for opaque atoms), and
+	 * the condition the atom was first built from. */
+	const ValueDecl* const decl;
+	const Expr* const expr;
+
+	/* For operators. @rhs is %NULL for negations. */
+	const FormulaNode* const lhs;
+	const FormulaNode* const rhs;
+
+	bool is_atom () const
+	{
+		return (this->kind == KIND_NONNULL ||
+		        this->kind == KIND_GTYPE_CHECK ||
+		        this->kind == KIND_OPAQUE);
+	}
+
+	void Profile (llvm::FoldingSetNodeID& node_id) const;
+	static void profile (llvm::FoldingSetNodeID& node_id, Kind kind,
+	                     const ValueDecl* decl, const Expr* expr,
+	                     const FormulaNode* lhs, const FormulaNode* rhs);
+};
+
+/* Owner of a set of #FormulaNodes. All nodes are allocated from a bump
+ * allocator owned by the arena, and are freed together when it’s destroyed,
+ * so an arena should be scoped to the analysis of a single function.
+ *
+ * The constructors apply local simplifications (constant folding, double
+ * negation, idempotence and complementation), so the DAG never contains
+ * trivially redundant nodes. */
+class FormulaArena {
+public:
+	FormulaArena ();
+
+	const FormulaNode* get_true ();
+	const FormulaNode* get_false ();
+	const FormulaNode* get_nonnull (const ValueDecl* decl,
+	                                const Expr* expr);
+	const FormulaNode* get_gtype_check (const ValueDecl* decl,
+	                                    const Expr* expr);
+	const FormulaNode* get_opaque (const Expr* expr);
+
+	const FormulaNode* get_negation (const FormulaNode* f);
+	const FormulaNode* get_conjunction (const FormulaNode* lhs,
+	                                    const FormulaNode* rhs);
+	const FormulaNode* get_disjunction (const FormulaNode* lhs,
+	                                    const FormulaNode* rhs);
+
+	unsigned int get_n_nodes () const { return this->_n_nodes; }
+
+private:
+	llvm::BumpPtrAllocator _allocator;
+	llvm::FoldingSet<FormulaNode> _nodes;
+	unsigned int _n_nodes;
+
+	const FormulaNode* _get (FormulaNode::Kind kind,
+	                         const ValueDecl* decl, const Expr* expr,
+	                         const FormulaNode* lhs,
+	                         const FormulaNode* rhs);
+	const FormulaNode* _get_binary (FormulaNode::Kind kind,
+	                                const FormulaNode* lhs,
+	                                const FormulaNode* rhs);
+
+	FormulaArena (const FormulaArena&);
+	FormulaArena& operator= (const FormulaArena&);
+};
+
+#endif /* !TARTAN_BOOLEAN_FORMULA_H */
@@ -23,7 +23,10 @@
 #ifndef TARTAN_CHECKER_H
 #define TARTAN_CHECKER_H
 
+#include <functional>
+#include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include <clang/AST/AST.h>
 #include <clang/AST/ASTConsumer.h>
@@ -32,12 +35,15 @@
 #include <girepository.h>
 
 #include "gir-manager.h"
+#include "parallel-traversal.h"
+#include "plugin-options.h"
 
 namespace tartan {
 
 using namespace clang;
 
 extern std::shared_ptr<GirManager> global_gir_manager;
+extern std::shared_ptr<PluginOptions> global_plugin_options;
 
 class Checker {
 public:
@@ -51,14 +57,92 @@ public:
 	explicit ASTChecker (
 		CompilerInstance& compiler,
 		std::shared_ptr<const GirManager> gir_manager,
-		std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins) :
+		std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins,
+		std::shared_ptr<const PluginOptions> options) :
 		_compiler (compiler), _gir_manager (gir_manager),
-		_disabled_plugins (disabled_plugins) {}
+		_disabled_plugins (disabled_plugins), _options (options) {}
 
 protected:
 	CompilerInstance& _compiler;
 	std::shared_ptr<const GirManager> _gir_manager;
 	std::shared_ptr<const std::unordered_set<std::string>> _disabled_plugins;
+	std::shared_ptr<const PluginOptions> _options;
+
+	/* In editor mode, check each declaration in @decl_group which is in
+	 * scope as soon as it’s been parsed, using @visitor. Call this from
+	 * HandleTopLevelDecl(). */
+	template <typename Visitor> void
+	_traverse_top_level_decls (DeclGroupRef decl_group, Visitor &visitor)
+	{
+		DeclGroupRef::iterator i, e;
+
+		/* Run away if the plugin is disabled. */
+		if (!this->is_enabled () ||
+		    !this->_options.get ()->editor_mode) {
+			return;
+		}
+
+		for (i = decl_group.begin (), e = decl_group.end (); i != e;
+		     i++) {
+			if (this->_options.get ()->decl_is_in_scope (**i)) {
+				visitor.TraverseDecl (*i);
+			}
+		}
+	}
+
+	/* Otherwise, check the whole translation unit once it’s been parsed.
+	 * Call this from HandleTranslationUnit(). It is checked using
+	 * @visitor, unless the declarations are to be split between several
+	 * threads (--jobs) or filtered (--changed-lines). In that case
+	 * @new_visitor is called to create a visitor for each worker, as
+	 * visitors are not thread-safe, and those visitors are returned in
+	 * @workers (if non-%NULL) so that their results can be collected.
+	 *
+	 * Returns false if nothing was checked, because the checker is
+	 * disabled or everything was already checked by
+	 * _traverse_top_level_decls(). */
+	template <typename Visitor> bool
+	_traverse_translation_unit (ASTContext &context, Visitor &visitor,
+	                            std::function<Visitor *()> new_visitor,
+	                            std::vector<std::unique_ptr<Visitor>> *workers = NULL)
+	{
+		/* Run away if the plugin is disabled, or if everything has
+		 * already been checked in HandleTopLevelDecl(). */
+		if (!this->is_enabled () || this->_options.get ()->editor_mode) {
+			return false;
+		}
+
+		const PluginOptions *options = this->_options.get ();
+		unsigned int n_jobs = options->n_jobs;
+
+		if (n_jobs <= 1 && !options->restrict_to_changed_lines) {
+			visitor.TraverseDecl (context.getTranslationUnitDecl ());
+			return true;
+		}
+
+		std::vector<std::unique_ptr<Visitor>> local_workers;
+		if (workers == NULL) {
+			workers = &local_workers;
+		}
+
+		for (unsigned int i = 0; i < n_jobs; i++) {
+			workers->push_back (std::unique_ptr<Visitor> (
+				new_visitor ()));
+		}
+
+		/* The --changed-lines are looked up on this thread, as the
+		 * SourceManager isn’t thread-safe. */
+		traverse_decls_in_parallel (*context.getTranslationUnitDecl (),
+		                            n_jobs,
+			[workers] (unsigned int worker, Decl *decl) {
+				(*workers)[worker]->TraverseDecl (decl);
+			},
+			[options] (const Decl &decl) {
+				return options->decl_is_changed (decl);
+			});
+
+		return true;
+	}
 
 public:
 	bool is_enabled () const;
@@ -22,6 +22,11 @@
 
 #include "config.h"
 
+#include <cerrno>
+#include <cstdio>
+
+#include <glib/gstdio.h>
+
 #include <clang/Basic/Diagnostic.h>
 #include <clang/Basic/Version.h>
 #include <clang/Frontend/CompilerInstance.h>
@@ -44,13 +49,135 @@ Debug::emit_bug_report (std::unique_ptr<BugReport> report,
 	#endif
 }
 
+/* The buffer which diagnostics emitted on the current thread are appended to,
+ * or %NULL to emit them immediately. */
+static thread_local Debug::DiagnosticBuffer *current_diagnostic_buffer = NULL;
+
+void
+Debug::set_diagnostic_buffer (Debug::DiagnosticBuffer *buffer)
+{
+	current_diagnostic_buffer = buffer;
+}
+
+void
+Debug::DiagnosticBuffer::append (Debug::PendingDiagnostic::Data&& data)
+{
+	this->_diagnostics.push_back (std::move (data));
+}
+
+/* Emit all the buffered diagnostics, in the order they were built, and clear
+ * the buffer. This must be called from the thread which owns the
+ * #DiagnosticsEngine. */
+void
+Debug::DiagnosticBuffer::flush ()
+{
+	for (std::vector<PendingDiagnostic::Data>::const_iterator it = this->_diagnostics.begin (),
+	     ie = this->_diagnostics.end (); it != ie; ++it) {
+		PendingDiagnostic::emit (*it);
+	}
+
+	this->_diagnostics.clear ();
+}
+
+Debug::PendingDiagnostic::PendingDiagnostic (DiagnosticsEngine::Level level,
+                                             const char *format_string,
+                                             CompilerInstance& compiler,
+                                             SourceLocation location) :
+	_active (true)
+{
+	this->_data.level = level;
+	this->_data.format_string = format_string;
+	this->_data.compiler = &compiler;
+	this->_data.location = location;
+}
+
+Debug::PendingDiagnostic::PendingDiagnostic (PendingDiagnostic&& other) :
+	_data (std::move (other._data)), _active (other._active)
+{
+	other._active = false;
+}
+
+Debug::PendingDiagnostic::~PendingDiagnostic ()
+{
+	if (!this->_active) {
+		return;
+	}
+
+	if (current_diagnostic_buffer != NULL) {
+		current_diagnostic_buffer->append (std::move (this->_data));
+	} else {
+		PendingDiagnostic::emit (this->_data);
+	}
+}
+
+Debug::PendingDiagnostic&
+Debug::PendingDiagnostic::operator<< (const std::string& arg)
+{
+	Argument a;
+	a.kind = Argument::ARGUMENT_STRING;
+	a.string_value = arg;
+	this->_data.arguments.push_back (a);
+
+	return *this;
+}
+
+Debug::PendingDiagnostic&
+Debug::PendingDiagnostic::operator<< (const char *arg)
+{
+	return *this << std::string ((arg != NULL) ? arg : "(null)");
+}
+
+Debug::PendingDiagnostic&
+Debug::PendingDiagnostic::operator<< (int arg)
+{
+	Argument a;
+	a.kind = Argument::ARGUMENT_SINT;
+	a.sint_value = arg;
+	this->_data.arguments.push_back (a);
+
+	return *this;
+}
+
+Debug::PendingDiagnostic&
+Debug::PendingDiagnostic::operator<< (unsigned int arg)
+{
+	Argument a;
+	a.kind = Argument::ARGUMENT_UINT;
+	a.uint_value = arg;
+	this->_data.arguments.push_back (a);
+
+	return *this;
+}
+
+Debug::PendingDiagnostic&
+Debug::PendingDiagnostic::operator<< (QualType arg)
+{
+	Argument a;
+	a.kind = Argument::ARGUMENT_QUAL_TYPE;
+	a.qual_type_value = arg;
+	this->_data.arguments.push_back (a);
+
+	return *this;
+}
+
+Debug::PendingDiagnostic&
+Debug::PendingDiagnostic::operator<< (SourceRange arg)
+{
+	Argument a;
+	a.kind = Argument::ARGUMENT_RANGE;
+	a.range_value = arg;
+	this->_data.arguments.push_back (a);
+
+	return *this;
+}
+
 /* Build and emit a warning or error report about the user’s code. */
-DiagnosticBuilder
-Debug::emit_report (DiagnosticsEngine::Level level, const char *format_string,
-                    CompilerInstance& compiler, SourceLocation location)
+void
+Debug::PendingDiagnostic::emit (const Data& data)
 {
-	DiagnosticsEngine& engine = compiler.getDiagnostics ();
+	DiagnosticsEngine& engine = data.compiler->getDiagnostics ();
 	DiagnosticIDs& ids = *engine.getDiagnosticIDs ();
+	DiagnosticsEngine::Level level = data.level;
 
 	/* Fix up the message levels according to command line
 	 * options. */
@@ -63,20 +190,46 @@ Debug::emit_report (DiagnosticsEngine::Level level, const char *format_string,
 
 	/* Add a prefix. */
 	std::string prefixed_format_string =
-		"[tartan]: " + std::string (format_string);
+		"[tartan]: " + data.format_string;
 
 	unsigned diag_id = ids.getCustomDiagID ((DiagnosticIDs::Level) level,
 	                                        prefixed_format_string);
 
-	if (!location.isValid ()) {
-		return engine.Report (diag_id);
+	DiagnosticBuilder builder = (data.location.isValid ()) ?
+		engine.Report (data.location, diag_id) :
+		engine.Report (diag_id);
+
+	for (std::vector<Argument>::const_iterator it = data.arguments.begin (),
+	     ie = data.arguments.end (); it != ie; ++it) {
+		switch (it->kind) {
+		case Argument::ARGUMENT_STRING:
+			builder << it->string_value;
+			break;
+		case Argument::ARGUMENT_SINT:
+			builder << it->sint_value;
+			break;
+		case Argument::ARGUMENT_UINT:
+			builder << it->uint_value;
+			break;
+		case Argument::ARGUMENT_QUAL_TYPE:
+			builder << it->qual_type_value;
+			break;
+		case Argument::ARGUMENT_RANGE:
+			builder << it->range_value;
+			break;
+		}
 	}
+}
 
-	return engine.Report (location, diag_id);
+Debug::PendingDiagnostic
+Debug::emit_report (DiagnosticsEngine::Level level, const char *format_string,
+                    CompilerInstance& compiler, SourceLocation location)
+{
+	return PendingDiagnostic (level, format_string, compiler, location);
 }
 
 /* Convenience wrappers. */
-DiagnosticBuilder
+Debug::PendingDiagnostic
 Debug::emit_error (const char *format_string, CompilerInstance& compiler,
                    SourceLocation location)
 {
@@ -88,7 +241,7 @@ Debug::emit_error (const char *format_string, CompilerInstance& compiler,
 	                           compiler, location);
 }
 
-DiagnosticBuilder
+Debug::PendingDiagnostic
 Debug::emit_warning (const char *format_string, CompilerInstance& compiler,
                      SourceLocation location)
 {
@@ -96,7 +249,7 @@ Debug::emit_warning (const char *format_string, CompilerInstance& compiler,
 	                           compiler, location);
 }
 
-DiagnosticBuilder
+Debug::PendingDiagnostic
 Debug::emit_remark (const char *format_string, CompilerInstance& compiler,
                     SourceLocation location)
 {
@@ -110,6 +263,32 @@ Debug::emit_remark (const char *format_string, CompilerInstance& compiler,
 #endif
 }
 
+void
+Debug::append_report (const std::string& filename, const std::string& contents,
+                      const char *error_format_string,
+                      CompilerInstance& compiler)
+{
+	FILE *report = g_fopen (filename.c_str (), "a");
+
+	/* Unbuffered, so the contents are written by a single write(). */
+	if (report != NULL) {
+		setvbuf (report, NULL, _IONBF, 0);
+	}
+
+	if (report == NULL ||
+	    fwrite (contents.data (), 1, contents.size (), report) !=
+	    contents.size ()) {
+		Debug::emit_error (error_format_string, compiler,
+		                   SourceLocation ())
+			<< filename
+			<< g_strerror (errno);
+	}
+
+	if (report != NULL) {
+		fclose (report);
+	}
+}
+
 /* Well-known strings used for the category of Tartan static analysis issues. */
 namespace Debug { namespace Categories {
 	const char * const GError = "GError API";
@@ -25,6 +25,9 @@
 
 #include "config.h"
 
+#include <string>
+#include <vector>
+
 #include <llvm/Support/Debug.h>
 #include <clang/Basic/Diagnostic.h>
 #include <clang/Frontend/CompilerInstance.h>
@@ -68,20 +71,102 @@ namespace Debug {
 	void emit_bug_report (std::unique_ptr<BugReport> report,
 	                      CheckerContext &context);
 
-	DiagnosticBuilder emit_report (DiagnosticsEngine::Level level,
+	/* A diagnostic about the user’s code which is being built. Arguments are
+	 * appended using operator<<, as with a #DiagnosticBuilder, and the
+	 * diagnostic is emitted when the #PendingDiagnostic is destroyed.
+	 *
+	 * If the current thread has a #DiagnosticBuffer set, the diagnostic is
+	 * appended to that instead of being emitted, so that checkers may be
+	 * run on worker threads without touching the (non-thread-safe)
+	 * #DiagnosticsEngine. */
+	class PendingDiagnostic {
+	public:
+		PendingDiagnostic (DiagnosticsEngine::Level level,
+		                   const char *format_string,
+		                   CompilerInstance& compiler,
+		                   SourceLocation location);
+		PendingDiagnostic (PendingDiagnostic&& other);
+		~PendingDiagnostic ();
+
+		PendingDiagnostic& operator<< (const std::string& arg);
+		PendingDiagnostic& operator<< (const char *arg);
+		PendingDiagnostic& operator<< (int arg);
+		PendingDiagnostic& operator<< (unsigned int arg);
+		PendingDiagnostic& operator<< (QualType arg);
+		PendingDiagnostic& operator<< (SourceRange arg);
+
+		/* A single argument to the diagnostic. */
+		struct Argument {
+			enum {
+				ARGUMENT_STRING,
+				ARGUMENT_SINT,
+				ARGUMENT_UINT,
+				ARGUMENT_QUAL_TYPE,
+				ARGUMENT_RANGE,
+			} kind;
+			std::string string_value;
+			int sint_value;
+			unsigned int uint_value;
+			QualType qual_type_value;
+			SourceRange range_value;
+		};
+
+		/* Everything needed to emit the diagnostic later. */
+		struct Data {
+			DiagnosticsEngine::Level level;
+			std::string format_string;
+			CompilerInstance *compiler;
+			SourceLocation location;
+			std::vector<Argument> arguments;
+		};
+
+		static void emit (const Data& data);
+
+	private:
+		PendingDiagnostic (const PendingDiagnostic& other) = delete;
+
+		Data _data;
+		bool _active;
+	};
+
+	/* A list of diagnostics which have been built but not yet emitted. Set
+	 * one as the current thread’s buffer using set_diagnostic_buffer() to
+	 * collect all diagnostics emitted by that thread, then emit them later
+	 * (and from the main thread) using flush(). */
+	class DiagnosticBuffer {
+	public:
+		void append (PendingDiagnostic::Data&& data);
+		void flush ();
+
+	private:
+		std::vector<PendingDiagnostic::Data> _diagnostics;
+	};
+
+	void set_diagnostic_buffer (DiagnosticBuffer *buffer);
+
+	PendingDiagnostic emit_report (DiagnosticsEngine::Level level,
 	                               const char *format_string,
 	                               CompilerInstance& compiler,
 	                               SourceLocation location);
-	DiagnosticBuilder emit_error (const char *format_string,
+	PendingDiagnostic emit_error (const char *format_string,
 	                              CompilerInstance& compiler,
 	                              SourceLocation location);
-	DiagnosticBuilder emit_warning (const char *format_string,
+	PendingDiagnostic emit_warning (const char *format_string,
 	                                CompilerInstance& compiler,
 	                                SourceLocation location);
-	DiagnosticBuilder emit_remark (const char *format_string,
+	PendingDiagnostic emit_remark (const char *format_string,
 	                               CompilerInstance& compiler,
 	                               SourceLocation location);
 
+	/* Append @contents to the report file @filename in a single write, so
+	 * that reports appended by parallel compilations don’t interleave. On
+	 * failure, @error_format_string is emitted as an error, with the
+	 * filename and the reason as its arguments. */
+	void append_report (const std::string& filename,
+	                    const std::string& contents,
+	                    const char *error_format_string,
+	                    CompilerInstance& compiler);
+
 	/* Well-known strings used for the category of Tartan static analysis
 	 * issues. */
 	namespace Categories {
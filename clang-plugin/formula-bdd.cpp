@@ -0,0 +1,267 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#include "config.h"
+
+#include <algorithm>
+
+#include "formula-bdd.h"
+
+FormulaBdd::FormulaBdd (unsigned int max_nodes, unsigned int max_steps) :
+	_max_nodes (max_nodes), _max_steps (max_steps), _n_steps (0),
+	_overflowed (false)
+{
+	/* The two terminals. */
+	Node terminal = { ~0U, FALSE_REF, FALSE_REF };
+	this->_nodes.push_back (terminal);
+	terminal.low = terminal.high = TRUE_REF;
+	this->_nodes.push_back (terminal);
+}
+
+/* Find or create the node (var ? high : low), applying the reduction rule
+ * that a node with identical children is redundant. */
+FormulaBdd::Ref
+FormulaBdd::_make (unsigned int var, Ref low, Ref high)
+{
+	if (low == OVERFLOW_REF || high == OVERFLOW_REF)
+		return OVERFLOW_REF;
+	if (low == high)
+		return low;
+
+	Key key (var, std::make_pair (low, high));
+	llvm::DenseMap<Key, Ref>::iterator it = this->_unique.find (key);
+
+	if (it != this->_unique.end ())
+		return (*it).second;
+
+	if (this->_nodes.size () >= this->_max_nodes) {
+		this->_overflowed = true;
+		return OVERFLOW_REF;
+	}
+
+	Node node = { var, low, high };
+	Ref r = this->_nodes.size ();
+
+	this->_nodes.push_back (node);
+	this->_unique[key] = r;
+
+	return r;
+}
+
+/* Apply a boolean operator using Shannon expansion on the lowest variable of
+ * the operands. @b is ignored for %OP_NOT. */
+FormulaBdd::Ref
+FormulaBdd::_apply (Op op, Ref a, Ref b)
+{
+	if (this->_overflowed || a == OVERFLOW_REF || b == OVERFLOW_REF)
+		return OVERFLOW_REF;
+
+	/* Terminal cases. */
+	switch (op) {
+	case OP_NOT:
+		if (a == FALSE_REF)
+			return TRUE_REF;
+		if (a == TRUE_REF)
+			return FALSE_REF;
+		b = FALSE_REF;
+		break;
+	case OP_AND:
+		if (a == FALSE_REF || b == FALSE_REF)
+			return FALSE_REF;
+		if (a == TRUE_REF)
+			return b;
+		if (b == TRUE_REF || a == b)
+			return a;
+		break;
+	case OP_OR:
+		if (a == TRUE_REF || b == TRUE_REF)
+			return TRUE_REF;
+		if (a == FALSE_REF)
+			return b;
+		if (b == FALSE_REF || a == b)
+			return a;
+		break;
+	}
+
+	/* Both binary operators are commutative. */
+	if (op != OP_NOT && b < a) {
+		Ref tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	Key key (op, std::make_pair (a, b));
+	llvm::DenseMap<Key, Ref>::iterator it = this->_computed.find (key);
+
+	if (it != this->_computed.end ())
+		return (*it).second;
+
+	if (++this->_n_steps > this->_max_steps) {
+		this->_overflowed = true;
+		return OVERFLOW_REF;
+	}
+
+	/* Copy the nodes, as recursion may reallocate the node vector. */
+	Node a_node = this->_nodes[a];
+	Node b_node = this->_nodes[b];
+	unsigned int var = std::min (a_node.var, b_node.var);
+
+	Ref a_low = (a_node.var == var) ? a_node.low : a;
+	Ref a_high = (a_node.var == var) ? a_node.high : a;
+	Ref b_low = (b_node.var == var) ? b_node.low : b;
+	Ref b_high = (b_node.var == var) ? b_node.high : b;
+
+	Ref low = this->_apply (op, a_low, b_low);
+	Ref high = this->_apply (op, a_high, b_high);
+	Ref r = this->_make (var, low, high);
+
+	if (r != OVERFLOW_REF)
+		this->_computed[key] = r;
+
+	return r;
+}
+
+FormulaBdd::Ref
+FormulaBdd::get_negation (Ref a)
+{
+	return this->_apply (OP_NOT, a, FALSE_REF);
+}
+
+FormulaBdd::Ref
+FormulaBdd::get_conjunction (Ref a, Ref b)
+{
+	return this->_apply (OP_AND, a, b);
+}
+
+FormulaBdd::Ref
+FormulaBdd::get_disjunction (Ref a, Ref b)
+{
+	return this->_apply (OP_OR, a, b);
+}
+
+/* Build the ROBDD for @f. Each distinct atom becomes a variable, so the
+ * semantic atoms for the same variable compare equal, but no relationship
+ * between different atoms is assumed. */
+FormulaBdd::Ref
+FormulaBdd::from_formula (const FormulaNode* f)
+{
+	llvm::DenseMap<const FormulaNode*, Ref>::iterator it =
+		this->_formulae.find (f);
+	if (it != this->_formulae.end ())
+		return (*it).second;
+
+	Ref r;
+
+	switch (f->kind) {
+	case FormulaNode::KIND_TRUE:
+		r = TRUE_REF;
+		break;
+	case FormulaNode::KIND_FALSE:
+		r = FALSE_REF;
+		break;
+	case FormulaNode::KIND_NONNULL:
+	case FormulaNode::KIND_GTYPE_CHECK:
+	case FormulaNode::KIND_OPAQUE: {
+		llvm::DenseMap<const FormulaNode*, unsigned int>::iterator vi =
+			this->_atom_vars.find (f);
+		unsigned int var;
+
+		if (vi != this->_atom_vars.end ()) {
+			var = (*vi).second;
+		} else {
+			var = this->_vars.size ();
+			this->_vars.push_back (f);
+			this->_atom_vars[f] = var;
+		}
+
+		r = this->_make (var, FALSE_REF, TRUE_REF);
+		break;
+	}
+	case FormulaNode::KIND_NOT:
+		r = this->get_negation (this->from_formula (f->lhs));
+		break;
+	case FormulaNode::KIND_AND:
+		r = this->get_conjunction (this->from_formula (f->lhs),
+		                           this->from_formula (f->rhs));
+		break;
+	case FormulaNode::KIND_OR:
+	default:
+		r = this->get_disjunction (this->from_formula (f->lhs),
+		                           this->from_formula (f->rhs));
+		break;
+	}
+
+	if (r != OVERFLOW_REF)
+		this->_formulae[f] = r;
+
+	return r;
+}
+
+const FormulaNode*
+FormulaBdd::_to_formula (Ref r, FormulaArena& arena,
+                         llvm::DenseMap<Ref, const FormulaNode*>& formulae)
+{
+	if (r == FALSE_REF)
+		return arena.get_false ();
+	if (r == TRUE_REF)
+		return arena.get_true ();
+
+	llvm::DenseMap<Ref, const FormulaNode*>::iterator it = formulae.find (r);
+	if (it != formulae.end ())
+		return (*it).second;
+
+	/* (var ∧ high) ∨ (¬var ∧ low), which the arena simplifies to var,
+	 * ¬var, (var ∧ high), etc. as appropriate. */
+	Node node = this->_nodes[r];
+	const FormulaNode* atom = this->_vars[node.var];
+	const FormulaNode* high = this->_to_formula (node.high, arena, formulae);
+	const FormulaNode* low = this->_to_formula (node.low, arena, formulae);
+	const FormulaNode* f =
+		arena.get_disjunction (
+			arena.get_conjunction (atom, high),
+			arena.get_conjunction (arena.get_negation (atom), low));
+
+	formulae[r] = f;
+
+	return f;
+}
+
+/* Convert the ROBDD @r back to a canonical formula in @arena, which must be
+ * the arena the atoms came from. Returns %NULL if @r is %OVERFLOW_REF. */
+const FormulaNode*
+FormulaBdd::to_formula (Ref r, FormulaArena& arena)
+{
+	if (r == OVERFLOW_REF)
+		return NULL;
+
+	llvm::DenseMap<Ref, const FormulaNode*> formulae;
+
+	return this->_to_formula (r, arena, formulae);
+}
+
+/* Whether @a implies @b, i.e. (@a ∧ ¬@b) is unsatisfiable. Returns %false if
+ * the budget is exceeded, as that’s the conservative answer. */
+bool
+FormulaBdd::implies (Ref a, Ref b)
+{
+	return (this->get_conjunction (a, this->get_negation (b)) == FALSE_REF);
+}
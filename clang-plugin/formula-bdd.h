@@ -0,0 +1,98 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_FORMULA_BDD_H
+#define TARTAN_FORMULA_BDD_H
+
+#include <utility>
+#include <vector>
+
+#include <llvm/ADT/DenseMap.h>
+
+#include "boolean-formula.h"
+
+/* A reduced ordered binary decision diagram (ROBDD) over the atoms of
+ * #FormulaNode formulae. ROBDDs are canonical: two formulae are equivalent
+ * iff their ROBDDs are the same node, which makes implication queries
+ * cheap once the ROBDD has been built.
+ *
+ * Building an ROBDD can take time and space exponential in the number of
+ * atoms, so every manager has a hard budget on the number of nodes it may
+ * create and the number of apply steps it may take. Once either is exceeded,
+ * all operations return %OVERFLOW_REF and callers must fall back to a cheaper
+ * structural analysis. Variables are ordered by first use. */
+class FormulaBdd {
+public:
+	typedef unsigned int Ref;
+
+	static const Ref FALSE_REF = 0;
+	static const Ref TRUE_REF = 1;
+	static const Ref OVERFLOW_REF = ~0U;
+
+	FormulaBdd (unsigned int max_nodes, unsigned int max_steps);
+
+	Ref from_formula (const FormulaNode* f);
+	const FormulaNode* to_formula (Ref r, FormulaArena& arena);
+
+	Ref get_negation (Ref a);
+	Ref get_conjunction (Ref a, Ref b);
+	Ref get_disjunction (Ref a, Ref b);
+
+	bool implies (Ref a, Ref b);
+
+	bool has_overflowed () const { return this->_overflowed; }
+	unsigned int get_n_nodes () const { return this->_nodes.size (); }
+
+private:
+	enum Op {
+		OP_NOT,
+		OP_AND,
+		OP_OR,
+	};
+
+	typedef struct {
+		unsigned int var;  /* ~0U for terminals */
+		Ref low;  /* var = FALSE */
+		Ref high;  /* var = TRUE */
+	} Node;
+
+	typedef std::pair<unsigned int, std::pair<Ref, Ref>> Key;
+
+	std::vector<Node> _nodes;
+	std::vector<const FormulaNode*> _vars;  /* var index → atom */
+	llvm::DenseMap<const FormulaNode*, unsigned int> _atom_vars;
+	llvm::DenseMap<Key, Ref> _unique;
+	llvm::DenseMap<Key, Ref> _computed;
+	llvm::DenseMap<const FormulaNode*, Ref> _formulae;
+
+	unsigned int _max_nodes;
+	unsigned int _max_steps;
+	unsigned int _n_steps;
+	bool _overflowed;
+
+	Ref _make (unsigned int var, Ref low, Ref high);
+	Ref _apply (Op op, Ref a, Ref b);
+	const FormulaNode* _to_formula (Ref r, FormulaArena& arena,
+	                                llvm::DenseMap<Ref, const FormulaNode*>& formulae);
+};
+
+#endif /* !TARTAN_FORMULA_BDD_H */
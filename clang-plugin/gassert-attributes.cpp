@@ -22,7 +22,9 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <unordered_set>
+#include <vector>
 
 #include <clang/AST/Attr.h>
 #include <clang/Lex/Lexer.h>
@@ -33,7 +35,10 @@
 
 namespace tartan {
 
-GAssertAttributesConsumer::GAssertAttributesConsumer ()
+GAssertAttributesConsumer::GAssertAttributesConsumer (
+	std::shared_ptr<const PluginOptions> options,
+	std::shared_ptr<PreconditionCache> preconditions) :
+	_options (options), _preconditions (preconditions)
 {
 	/* Nothing to see here. */
 }
@@ -43,27 +48,21 @@ GAssertAttributesConsumer::~GAssertAttributesConsumer ()
 	/* Nothing to see here. */
 }
 
-/* Given an expression which is asserted to be true by an assertion statement,
- * work out what type of assertion it is (e.g. GObject type check, non-NULL
- * check, etc.) and modify the FunctionDecl as appropriate. For example, for
- * non-NULL checks this involves adding a nonnull attribute on the function.
- *
- * assertion_expr may be modified in-place to simplify its boolean form. */
-static void
-_handle_assertion (FunctionDecl& func, Expr& assertion_expr,
-                   const ASTContext& context)
+/* Work out what the assertion statements at the top of @func’s body imply
+ * about it, and modify the FunctionDecl as appropriate. For non-NULL checks
+ * (including GObject type checks) this involves adding a nonnull attribute on
+ * the function. */
+void
+GAssertAttributesConsumer::_handle_function_decl (FunctionDecl& func)
 {
-	DEBUG_EXPR ("Handling assertion: ", assertion_expr);
+	const AssertionExtracter::Preconditions* preconditions =
+		this->_preconditions.get ()->get_preconditions (func);
 
-	/* If the assertion is a non-NULL check, add nonnull attributes to the
-	 * function’s parameters accordingly. */
-	std::unordered_set<const ValueDecl*> ret;
-	AssertionExtracter::assertion_is_nonnull_check (assertion_expr,
-	                                                context, ret);
-
-	if (ret.size () == 0)
+	if (preconditions == NULL || preconditions->nonnull_decls.empty ())
 		return;
 
+	DEBUG ("Examining " << func.getNameAsString());
+
 	/* TODO: Factor out the code to augment a nonnull attribute. */
 	std::vector<unsigned int> non_null_args;
 
@@ -76,8 +75,10 @@ _handle_assertion (FunctionDecl& func, Expr& assertion_expr,
 		                      nonnull_attr->args_end ());
 	}
 
-	for (std::unordered_set<const ValueDecl*>::iterator si = ret.begin (),
-	     se = ret.end (); si != se; ++si) {
+	size_t n_existing_args = non_null_args.size ();
+
+	for (std::unordered_set<const ValueDecl*>::const_iterator si = preconditions->nonnull_decls.begin (),
+	     se = preconditions->nonnull_decls.end (); si != se; ++si) {
 		const ValueDecl* val_decl = *si;
 
 		const ParmVarDecl* parm_decl = dyn_cast<ParmVarDecl> (val_decl);
@@ -95,70 +96,30 @@ _handle_assertion (FunctionDecl& func, Expr& assertion_expr,
 		non_null_args.push_back (j);
 	}
 
-	if (non_null_args.size () > 0) {
-#ifdef HAVE_LLVM_3_5
-		nonnull_attr = ::new (func.getASTContext ())
-			NonNullAttr (func.getSourceRange (),
-			             func.getASTContext (),
-			             non_null_args.data (),
-			             non_null_args.size (), 0);
-#else /* if !HAVE_LLVM_3_5 */
-		nonnull_attr = ::new (func.getASTContext ())
-			NonNullAttr (func.getSourceRange (),
-			             func.getASTContext (),
-			             non_null_args.data (),
-			             non_null_args.size ());
-#endif /* !HAVE_LLVM_3_5 */
-		func.addAttr (nonnull_attr);
-	}
-}
-
-void
-GAssertAttributesConsumer::_handle_function_decl (FunctionDecl& func)
-{
-	/* Can only handle functions which have a body defined. */
-	Stmt* func_body = func.getBody ();
-	if (func_body == NULL) {
+	if (non_null_args.size () == n_existing_args)
 		return;
-	}
 
-	/* The body should be a compound statement, e.g.
-	 * { stmt; stmt; } */
-	CompoundStmt* stmt = dyn_cast<CompoundStmt> (func_body);
-	if (stmt == NULL) {
-		DEBUG ("Ignoring function " << func.getNameAsString () <<
-		       " due to having a non-compound statement body.");
-		return;
-	}
-
-	DEBUG ("Examining " << func.getNameAsString());
-
-	ASTContext& context = func.getASTContext ();
-
-	/* Iterate through the function body until the first non-assertion and
-	 * non-declaration statement is reached. Specifically stop before the
-	 * first assignment, as that could affect the outcome of any subsequent
-	 * assertions. */
-	for (CompoundStmt::const_body_iterator it = stmt->body_begin (),
-	     ie = stmt->body_end (); it != ie; ++it) {
-		Stmt* body_stmt = *it;
-
-		Expr* assertion_expr =
-			AssertionExtracter::is_assertion_stmt (*body_stmt,
-			                                       context);
-
-		if (assertion_expr == NULL) {
-			/* Potential program state mutation reached, so run
-			 * away. */
-			break;
-		}
-
-		/* Modify the FunctionDecl to take advantage of the extracted
-		 * assertion expression. */
-		_handle_assertion (func, *assertion_expr, context);
-	}
+	/* Add a single attribute covering all the assertions, with its
+	 * arguments in a stable order. */
+	std::sort (non_null_args.begin (), non_null_args.end ());
+	non_null_args.erase (std::unique (non_null_args.begin (),
+	                                  non_null_args.end ()),
+	                     non_null_args.end ());
 
-	DEBUG ("");
+#ifdef HAVE_LLVM_3_5
+	nonnull_attr = ::new (func.getASTContext ())
+		NonNullAttr (func.getSourceRange (),
+		             func.getASTContext (),
+		             non_null_args.data (),
+		             non_null_args.size (), 0);
+#else /* if !HAVE_LLVM_3_5 */
+	nonnull_attr = ::new (func.getASTContext ())
+		NonNullAttr (func.getSourceRange (),
+		             func.getASTContext (),
+		             non_null_args.data (),
+		             non_null_args.size ());
+#endif /* !HAVE_LLVM_3_5 */
+	func.addAttr (nonnull_attr);
 }
 
 bool
@@ -174,6 +135,9 @@ GAssertAttributesConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
 		if (func == NULL)
 			continue;
 
+		if (!this->_options.get ()->decl_is_in_scope (*func))
+			continue;
+
 		this->_handle_function_decl (*func);
 	}
 
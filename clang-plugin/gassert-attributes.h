@@ -27,16 +27,24 @@
 #include <clang/AST/ASTConsumer.h>
 #include <clang/Frontend/CompilerInstance.h>
 
+#include "assertion-extracter.h"
+#include "plugin-options.h"
+
 namespace tartan {
 
 using namespace clang;
 
 class GAssertAttributesConsumer : public clang::ASTConsumer {
 public:
-	GAssertAttributesConsumer ();
+	GAssertAttributesConsumer (
+		std::shared_ptr<const PluginOptions> options,
+		std::shared_ptr<PreconditionCache> preconditions);
 	~GAssertAttributesConsumer ();
 
 private:
+	std::shared_ptr<const PluginOptions> _options;
+	std::shared_ptr<PreconditionCache> _preconditions;
+
 	void _handle_function_decl (FunctionDecl& func);
 public:
 	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
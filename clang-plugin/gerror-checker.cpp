@@ -54,8 +54,17 @@
  *         Returns a set of error codes which are valid for the given domain,
  *         as defined by the enum associated with that error domain.
  *
+ * The work done per top-level function can be limited using the
+ * --max-analysis-* options (see AnalysisBudget), after which GErrors are no
+ * longer tracked in that function.
+ *
+ * Other functions which take a GError** as their final parameter are modelled
+ * using a summary of their effect on the error (see GErrorSummaryCache), which
+ * is computed once per function and applied at each call site, rather than
+ * having the analyser inline them at every call. Functions whose use of the
+ * error can’t be summarised are still inlined.
+ *
  * FIXME: Future work could be to implement:
- *  • Support for user-defined functions which take GError** parameters.
  *  • Add support for g_error_copy()
  *  • Add support for g_error_matches()
  *  • Add support for g_prefix_error()
@@ -461,40 +470,199 @@ GErrorChecker::_handle_eval_g_propagate_error (CheckerContext &context,
 	return (not_null_state != NULL) ? not_null_state : null_state;
 }
 
+/**
+ * Just before a call to a summarised function whose final parameter is
+ * error_ptr, check that:
+ *     (error_ptr = NULL) ∨ (*error_ptr = NULL)
+ */
+ProgramStateRef
+GErrorChecker::_handle_pre_throws (CheckerContext &context,
+                                   const CallEvent &call_event,
+                                   unsigned int error_index) const
+{
+	if (!this->_assert_gerror_ptr_clear (call_event.getArgSVal (error_index),
+	                                     context.getState (), context,
+	                                     call_event.getArgSourceRange (error_index))) {
+		return NULL;
+	}
+
+	return context.getState ();
+}
+
+/* Constrain the @return_value of a summarised function according to its
+ * @correlation with the error, and whether the call @failed. Returns %NULL if
+ * that’s infeasible. */
+static ProgramStateRef
+_assume_return_value (ProgramStateRef state,
+                      DefinedOrUnknownSVal return_value,
+                      GErrorSummary::ReturnCorrelation correlation,
+                      bool failed)
+{
+	if (correlation == GErrorSummary::RETURN_NONE) {
+		return state;
+	}
+
+	/* FALSE and NULL are both zero. */
+	return state->assume (return_value, !failed);
+}
+
+/**
+ * Instead of inlining a call to a summarised function whose final parameter is
+ * error_ptr, change the state to:
+ *  • Invalidate everything the call could modify, and conjure its return
+ *    value.
+ *  • On success, restore (*error_ptr) and constrain the return value to be
+ *    non-FALSE or non-NULL, if the summary correlates it with the error.
+ *  • If the function may set its error, also branch to failure: constrain the
+ *    return value to be FALSE or NULL, and if (error_ptr ≠ NULL), set
+ *    (*error_ptr) to a new GError as g_set_error() would.
+ */
+ProgramStateRef
+GErrorChecker::_handle_eval_throws (CheckerContext &context,
+                                    const CallExpr &call_expr,
+                                    unsigned int error_index,
+                                    const GErrorSummary &summary) const
+{
+	ProgramStateRef state = context.getState ();
+	const LocationContext *location_context = context.getLocationContext ();
+	SValBuilder &sval_builder = context.getSValBuilder ();
+	unsigned int count = context.blockCount ();
+
+	SVal ptr_error_location = state->getSVal (call_expr.getArg (error_index),
+	                                          location_context);
+	SVal old_error_location = UnknownVal ();
+
+	if (ptr_error_location.getAs<Loc> ()) {
+		old_error_location =
+			this->_error_from_error_ptr (ptr_error_location, context);
+	}
+
+	/* The call could modify anything reachable from its arguments, or any
+	 * global. */
+	CallEventRef<> call_event =
+		context.getStateManager ().getCallEventManager ().getSimpleCall (&call_expr,
+		                                                                 state,
+		                                                                 location_context);
+	state = call_event->invalidateRegions (count, state);
+
+	DefinedOrUnknownSVal return_value = UnknownVal ();
+	QualType return_type = call_event->getResultType ();
+
+	if (!return_type->isVoidType ()) {
+		/* Tagged to distinguish it from a GError conjured for the same
+		 * call by _gerror_new(). */
+		return_value = sval_builder.conjureSymbolVal (this, &call_expr,
+		                                              location_context,
+		                                              return_type,
+		                                              count);
+		state = state->BindExpr (&call_expr, location_context,
+		                         return_value);
+	}
+
+	/* Success. */
+	ProgramStateRef success_state =
+		_assume_return_value (state, return_value, summary.correlation,
+		                      false);
+
+	if (success_state != NULL && ptr_error_location.getAs<Loc> () &&
+	    !old_error_location.isUnknown ()) {
+		success_state = success_state->bindLoc (ptr_error_location,
+		                                        old_error_location);
+	}
+
+	/* Failure. */
+	ProgramStateRef failure_state = NULL;
+
+	if (summary.may_set_error) {
+		failure_state = _assume_return_value (state, return_value,
+		                                      summary.correlation,
+		                                      true);
+	}
+
+	if (failure_state != NULL &&
+	    ptr_error_location.getAs<DefinedOrUnknownSVal> ()) {
+		ProgramStateRef ptr_not_null_state, ptr_null_state;
+		std::tie (ptr_not_null_state, ptr_null_state) =
+			failure_state->assume (ptr_error_location.castAs<DefinedOrUnknownSVal> ());
+
+		if (ptr_not_null_state != NULL) {
+			DefinedSVal *allocated_sval = NULL;
+			ptr_not_null_state =
+				this->_gerror_new (&call_expr, false,
+				                   &allocated_sval,
+				                   ptr_not_null_state, context,
+				                   call_expr.getSourceRange ());
+			ptr_not_null_state =
+				this->_set_gerror (ptr_error_location,
+				                   *allocated_sval,
+				                   ptr_not_null_state, context,
+				                   call_expr.getArg (error_index)->getSourceRange ());
+			delete allocated_sval;
+		}
+
+		if (ptr_not_null_state != NULL && ptr_null_state != NULL) {
+			context.addTransition (ptr_null_state);
+		}
+
+		failure_state = (ptr_not_null_state != NULL) ?
+			ptr_not_null_state : ptr_null_state;
+	}
+
+	if (success_state != NULL && failure_state != NULL) {
+		context.addTransition (failure_state);
+	}
+
+	return (success_state != NULL) ? success_state : failure_state;
+}
+
 /* Dispatch pre-call events to the different per-function handlers. */
 void
 GErrorChecker::checkPreCall (const CallEvent &call,
                              CheckerContext &context) const
 {
-	if (!call.isGlobalCFunction ()) {
-		return;
-	}
+	const FunctionDecl *func_decl =
+		dyn_cast_or_null<FunctionDecl> (call.getDecl ());
 
-	ASTContext &ast_context = context.getASTContext ();
-	if (!this->_initialise_identifiers (ast_context)) {
+	if (func_decl == NULL ||
+	    !this->_initialise_types (context.getASTContext ()) ||
+	    !this->_is_in_changed_code (context) ||
+	    this->_check_budget (context, true)) {
 		return;
 	}
 
-	const IdentifierInfo *call_ident = call.getCalleeIdentifier ();
-
 	ProgramStateRef new_state;
 
-	if (call_ident == this->_identifier_g_set_error ||
-	    call_ident == this->_identifier_g_set_error_literal) {
+	switch (this->_get_operation (*func_decl)) {
+	case GERROR_OP_SET_ERROR:
 		new_state = this->_handle_pre_g_set_error (context, call);
-	} else if (call_ident == this->_identifier_g_error_new ||
-	           call_ident == this->_identifier_g_error_new_literal ||
-	           call_ident == this->_identifier_g_error_new_valist) {
+		break;
+	case GERROR_OP_ERROR_NEW:
 		new_state = this->_handle_pre_g_error_new (context, call);
-	} else if (call_ident == this->_identifier_g_error_free) {
+		break;
+	case GERROR_OP_ERROR_FREE:
 		new_state = this->_handle_pre_g_error_free (context, call);
-	} else if (call_ident == this->_identifier_g_clear_error) {
+		break;
+	case GERROR_OP_CLEAR_ERROR:
 		new_state = this->_handle_pre_g_clear_error (context, call);
-	} else if (call_ident == this->_identifier_g_propagate_error ||
-	           call_ident == this->_identifier_g_propagate_prefixed_error) {
+		break;
+	case GERROR_OP_PROPAGATE_ERROR:
 		new_state = this->_handle_pre_g_propagate_error (context, call);
-	} else {
+		break;
+	case GERROR_OP_THROWS:
+		/* Functions without an exact summary are checked by the
+		 * analyser inlining them. */
+		if (this->_summaries.get_summary (*func_decl) != NULL &&
+		    func_decl->getNumParams () <= call.getNumArgs ()) {
+			new_state = this->_handle_pre_throws (context, call,
+			                                      func_decl->getNumParams () - 1);
+		} else {
+			new_state = NULL;
+		}
+		break;
+	case GERROR_OP_NONE:
+	default:
 		new_state = NULL;
+		break;
 	}
 
 	if (new_state != NULL) {
@@ -510,38 +678,54 @@ GErrorChecker::evalCall (const CallExpr *call,
 {
 	const FunctionDecl *func_decl = context.getCalleeDecl (call);
 
+	/* Once the budget is exhausted, leave everything to the analyser. The
+	 * tracked GErrors have already been dropped in checkPreCall(). */
 	if (func_decl == NULL ||
-	    func_decl->getKind() != Decl::Function ||
-	    !CheckerContext::isCLibraryFunction (func_decl)) {
-		return false;
-	}
-
-	ASTContext &ast_context = context.getASTContext ();
-	if (!this->_initialise_identifiers (ast_context)) {
+	    !this->_initialise_types (context.getASTContext ()) ||
+	    !this->_is_in_changed_code (context) ||
+	    this->_check_budget (context, false)) {
 		return false;
 	}
 
-	const IdentifierInfo *call_ident = func_decl->getIdentifier ();
-
 	ProgramStateRef new_state;
 
-	if (call_ident == this->_identifier_g_set_error ||
-	    call_ident == this->_identifier_g_set_error_literal) {
+	switch (this->_get_operation (*func_decl)) {
+	case GERROR_OP_SET_ERROR:
 		new_state = this->_handle_eval_g_set_error (context, *call);
-	} else if (call_ident == this->_identifier_g_error_new ||
-	           call_ident == this->_identifier_g_error_new_literal ||
-	           call_ident == this->_identifier_g_error_new_valist) {
+		break;
+	case GERROR_OP_ERROR_NEW:
 		new_state = this->_handle_eval_g_error_new (context, *call);
-	} else if (call_ident == this->_identifier_g_error_free) {
+		break;
+	case GERROR_OP_ERROR_FREE:
 		new_state = this->_handle_eval_g_error_free (context, *call);
-	} else if (call_ident == this->_identifier_g_clear_error) {
+		break;
+	case GERROR_OP_CLEAR_ERROR:
 		new_state = this->_handle_eval_g_clear_error (context, *call);
-	} else if (call_ident == this->_identifier_g_propagate_error ||
-	           call_ident == this->_identifier_g_propagate_prefixed_error) {
+		break;
+	case GERROR_OP_PROPAGATE_ERROR:
 		new_state = this->_handle_eval_g_propagate_error (context,
 		                                                  *call);
-	} else {
+		break;
+	case GERROR_OP_THROWS: {
+		/* Functions without an exact summary are left to the analyser
+		 * to inline or invalidate. */
+		const GErrorSummary *summary =
+			this->_summaries.get_summary (*func_decl);
+
+		if (summary != NULL &&
+		    func_decl->getNumParams () <= call->getNumArgs ()) {
+			new_state = this->_handle_eval_throws (context, *call,
+			                                       func_decl->getNumParams () - 1,
+			                                       *summary);
+		} else {
+			new_state = NULL;
+		}
+		break;
+	}
+	case GERROR_OP_NONE:
+	default:
 		new_state = NULL;
+		break;
 	}
 
 	if (new_state != NULL) {
@@ -569,14 +753,13 @@ GErrorChecker::checkBind (SVal loc, SVal val, const Stmt *stmt,
 		return;
 	}
 
-	const ASTContext &ast_context = context.getASTContext ();
-	if (!this->_initialise_identifiers (ast_context)) {
-		return;
-	}
-
-	QualType error_type = ast_context.getPointerType (this->_gerror_type);
-	QualType value_type = region->getValueType ();
-	if (!context.getASTContext ().hasSameType (error_type, value_type)) {
+	/* This is called for every store in the program, so bail out as
+	 * cheaply as possible: the cached GError* type is canonical, so this
+	 * is equivalent to hasSameType(). */
+	if (!this->_initialise_types (context.getASTContext ()) ||
+	    region->getValueType ().getCanonicalType () != this->_gerror_ptr_type ||
+	    !this->_is_in_changed_code (context) ||
+	    this->_check_budget (context, true)) {
 		return;
 	}
 
@@ -634,6 +817,88 @@ GErrorChecker::checkDeadSymbols (SymbolReaper &symbol_reaper,
 	}
 }
 
+/* Report the top-level function just analysed if it exhausted its budget. */
+void
+GErrorChecker::checkEndAnalysis (ExplodedGraph &graph, BugReporter &reporter,
+                                 ExprEngine &engine) const
+{
+	this->_budget.end_analysis (graph, reporter, "GError checker");
+}
+
+/* When restricted to the --changed-lines, only model GErrors in the changed
+ * functions: those the analyser starts from, and any they call which it
+ * inlines. Changed functions which are only reached by inlining from an
+ * unchanged one are still checked, as the analyser won’t start from them
+ * separately. Returns true iff any function on the current stack is
+ * changed. */
+bool
+GErrorChecker::_is_in_changed_code (CheckerContext &context) const
+{
+	const PluginOptions *options = global_plugin_options.get ();
+
+	if (!options->restrict_to_changed_lines) {
+		return true;
+	}
+
+	for (const LocationContext *location_context = context.getLocationContext ();
+	     location_context != NULL;
+	     location_context = location_context->getParent ()) {
+		const Decl *decl = location_context->getDecl ();
+		llvm::DenseMap<const Decl *, bool>::const_iterator it =
+			this->_changed_decls.find (decl);
+		bool changed;
+
+		if (it != this->_changed_decls.end ()) {
+			changed = it->second;
+		} else {
+			changed = options->decl_is_changed (*decl);
+			this->_changed_decls[decl] = changed;
+		}
+
+		if (changed) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Check the analysis budget for the top-level function being analysed. Once
+ * it’s exhausted, GErrors are no longer tracked for the rest of the function;
+ * if @drop_tracking is true, any tracked on the current path are forgotten, so
+ * that they can’t give rise to spurious reports later on. Returns true iff the
+ * budget is exhausted. */
+bool
+GErrorChecker::_check_budget (CheckerContext &context,
+                              bool drop_tracking) const
+{
+	ProgramStateRef state = context.getState ();
+	ErrorMapTy error_map = state->get<ErrorMap> ();
+	unsigned int n_errors = 0;
+
+	if (this->_budget.limits_states ()) {
+		for (ErrorMapTy::iterator i = error_map.begin (),
+		     e = error_map.end (); i != e; ++i) {
+			n_errors++;
+		}
+	}
+
+	if (!this->_budget.check (context, n_errors)) {
+		return false;
+	}
+
+	if (drop_tracking && !error_map.isEmpty ()) {
+		for (ErrorMapTy::iterator i = error_map.begin (),
+		     e = error_map.end (); i != e; ++i) {
+			state = _error_map_remove (state, i->first);
+		}
+
+		context.addTransition (state);
+	}
+
+	return true;
+}
+
 /* Conjure a new symbol to represent a newly allocated GError*.
  * @call_expr may be %NULL if no expression corresponds to the allocation.
  * If non-%NULL, @allocated_sval_out will be filled with the address of an
@@ -690,7 +955,7 @@ GErrorChecker::_gerror_new (const Expr *call_expr,
 
 	if (symbolic_allocated_region != NULL) {
 		/* Should have been initialised on entry to the checker. */
-		assert (this->_initialise_identifiers (ast_context));
+		assert (this->_initialise_types (ast_context));
 
 		DefinedOrUnknownSVal extent =
 			symbolic_allocated_region->getExtent (sval_builder);
@@ -1108,38 +1373,136 @@ GErrorChecker::_clear_gerror (SVal error_location,
 /* Initialisation may fail if glib.h has not been included.
  * Return true iff initialisation succeeded. */
 bool
-GErrorChecker::_initialise_identifiers (const ASTContext &context) const
+GErrorChecker::_initialise_types (const ASTContext &context) const
 {
-	if (!this->_gerror_type.isNull ()) {
-		return true;
+	if (this->_context == &context) {
+		return (!this->_gerror_type.isNull ());
 	}
 
+	/* A new translation unit: forget everything cached for the old one. */
+	this->_context = &context;
+	this->_operations.clear ();
+	this->_changed_decls.clear ();
+
 	TypeManager manager = TypeManager (context);
 
-	/* Types. */
 	this->_gerror_type = manager.find_type_by_name ("GError");
 
-	/* Functions. */
-	this->_identifier_g_set_error =
-		&context.Idents.get ("g_set_error");
-	this->_identifier_g_set_error_literal =
-		&context.Idents.get ("g_set_error_literal");
-	this->_identifier_g_error_new =
-		&context.Idents.get ("g_error_new");
-	this->_identifier_g_error_new_literal =
-		&context.Idents.get ("g_error_new_literal");
-	this->_identifier_g_error_new_valist =
-		&context.Idents.get ("g_error_new_valist");
-	this->_identifier_g_error_free =
-		&context.Idents.get ("g_error_free");
-	this->_identifier_g_clear_error =
-		&context.Idents.get ("g_clear_error");
-	this->_identifier_g_propagate_error =
-		&context.Idents.get ("g_propagate_error");
-	this->_identifier_g_propagate_prefixed_error =
-		&context.Idents.get ("g_propagate_prefixed_error");
-
-	return (!this->_gerror_type.isNull ());
+	if (this->_gerror_type.isNull ()) {
+		this->_gerror_ptr_type = QualType ();
+		this->_gerror_ptr_ptr_type = QualType ();
+
+		return false;
+	}
+
+	QualType gerror_ptr_type = context.getPointerType (this->_gerror_type);
+
+	this->_gerror_ptr_type = context.getCanonicalType (gerror_ptr_type);
+	this->_gerror_ptr_ptr_type =
+		context.getCanonicalType (context.getPointerType (gerror_ptr_type));
+	this->_summaries.reset (this->_gerror_ptr_ptr_type,
+	                        global_gir_manager.get ());
+
+	return true;
+}
+
+/* Return true iff @func takes a GError** as its final parameter, either
+ * according to its declaration or to its GIR (or annotation override)
+ * information. */
+bool
+GErrorChecker::_function_throws (const FunctionDecl &func) const
+{
+	if (func.getNumParams () == 0) {
+		return false;
+	}
+
+	QualType last_type =
+		func.getParamDecl (func.getNumParams () - 1)->getType ();
+
+	if (last_type.getCanonicalType () == this->_gerror_ptr_ptr_type) {
+		return true;
+	}
+
+	/* The declaration might use a typedef or a void**, so check whether
+	 * it’s been annotated as throwing. */
+	if (!last_type->isPointerType () ||
+	    !last_type->getPointeeType ()->isPointerType ()) {
+		return false;
+	}
+
+	const std::string func_name = func.getNameAsString ();
+	const GirManager *gir_manager = global_gir_manager.get ();
+	GIBaseInfo *info = gir_manager->find_function_info (func_name);
+	bool throws = false;
+
+	if (info != NULL) {
+		throws = (g_base_info_get_type (info) == GI_INFO_TYPE_FUNCTION &&
+		          g_callable_info_can_throw_gerror ((GICallableInfo *) info));
+		g_base_info_unref (info);
+	} else {
+		AnnotationOverride annotations;
+
+		throws = (gir_manager->find_override (func_name, annotations) &&
+		          annotations.throws);
+	}
+
+	return throws;
+}
+
+/* Classify @func by the #GError operation it performs. This is done once per
+ * function declaration, rather than comparing each callee against all the
+ * functions of interest on every call the analyser evaluates. */
+GErrorChecker::GErrorOperation
+GErrorChecker::_get_operation (const FunctionDecl &func) const
+{
+	const FunctionDecl *canonical_decl = func.getCanonicalDecl ();
+	llvm::DenseMap<const FunctionDecl *, GErrorOperation>::const_iterator it =
+		this->_operations.find (canonical_decl);
+
+	if (it != this->_operations.end ()) {
+		return it->second;
+	}
+
+	/* The GLib functions which this checker models directly. */
+	static const struct {
+		const char *func_name;
+		GErrorOperation operation;
+	} gerror_funcs[] = {
+		{ "g_set_error", GERROR_OP_SET_ERROR },
+		{ "g_set_error_literal", GERROR_OP_SET_ERROR },
+		{ "g_error_new", GERROR_OP_ERROR_NEW },
+		{ "g_error_new_literal", GERROR_OP_ERROR_NEW },
+		{ "g_error_new_valist", GERROR_OP_ERROR_NEW },
+		{ "g_error_free", GERROR_OP_ERROR_FREE },
+		{ "g_clear_error", GERROR_OP_CLEAR_ERROR },
+		{ "g_propagate_error", GERROR_OP_PROPAGATE_ERROR },
+		{ "g_propagate_prefixed_error", GERROR_OP_PROPAGATE_ERROR },
+	};
+
+	GErrorOperation operation = GERROR_OP_NONE;
+
+	if (func.getKind () == Decl::Function &&
+	    func.getIdentifier () != NULL) {
+		if (CheckerContext::isCLibraryFunction (&func)) {
+			StringRef func_name = func.getName ();
+
+			for (guint i = 0; i < G_N_ELEMENTS (gerror_funcs); i++) {
+				if (func_name == gerror_funcs[i].func_name) {
+					operation = gerror_funcs[i].operation;
+					break;
+				}
+			}
+		}
+
+		if (operation == GERROR_OP_NONE &&
+		    this->_function_throws (func)) {
+			operation = GERROR_OP_THROWS;
+		}
+	}
+
+	this->_operations[canonical_decl] = operation;
+
+	return operation;
 }
 
 void
@@ -24,12 +24,15 @@
 #define TARTAN_GERROR_CHECKER_H
 
 #include <clang/AST/AST.h>
+#include <llvm/ADT/DenseMap.h>
 #include <clang/StaticAnalyzer/Core/BugReporter/BugType.h>
 #include <clang/StaticAnalyzer/Core/Checker.h>
 #include <clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h>
 #include <clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h>
 
+#include "analysis-budget.h"
 #include "checker.h"
+#include "gerror-summary.h"
 #include "gir-manager.h"
 
 namespace tartan {
@@ -40,10 +43,11 @@ using namespace ento;
 class GErrorChecker : public ento::Checker<check::PreCall,
                                            eval::Call,
                                            check::Bind,
-                                           check::DeadSymbols>,
+                                           check::DeadSymbols,
+                                           check::EndAnalysis>,
                       public tartan::Checker {
 public:
-	explicit GErrorChecker () {};
+	explicit GErrorChecker () : _context (NULL) {};
 
 	struct GErrorChecksFilter {
 		DefaultBool check_overwrite_set;
@@ -64,21 +68,48 @@ public:
 	GErrorChecksFilter filter;
 
 private:
-	/* Cached type identifiers. */
+	/* The kind of #GError operation a function performs. */
+	enum GErrorOperation {
+		GERROR_OP_NONE,
+		GERROR_OP_SET_ERROR,  /* g_set_error(), g_set_error_literal() */
+		GERROR_OP_ERROR_NEW,  /* g_error_new() and variants */
+		GERROR_OP_ERROR_FREE,
+		GERROR_OP_CLEAR_ERROR,
+		GERROR_OP_PROPAGATE_ERROR,  /* g_propagate[_prefixed]_error() */
+		GERROR_OP_THROWS,  /* any other function with a trailing GError** */
+	};
+
+	/* The #ASTContext which the cached types and operations below belong
+	 * to; they are reset if it changes. @_gerror_ptr_type and
+	 * @_gerror_ptr_ptr_type are canonical. */
+	mutable const ASTContext *_context;
 	mutable QualType _gerror_type;
+	mutable QualType _gerror_ptr_type;
+	mutable QualType _gerror_ptr_ptr_type;
+
+	/* Cached classification of each called function, keyed by its
+	 * canonical declaration. */
+	mutable llvm::DenseMap<const FunctionDecl *, GErrorOperation> _operations;
+
+	/* Summaries of the GERROR_OP_THROWS functions, applied in evalCall()
+	 * instead of inlining the functions at each call site. */
+	mutable GErrorSummaryCache _summaries;
+
+	/* Budget for the top-level function being analysed. */
+	mutable AnalysisBudget _budget;
+
+	bool _check_budget (CheckerContext &context,
+	                    bool drop_tracking) const;
+
+	/* Whether each function is within the --changed-lines, keyed by its
+	 * declaration. */
+	mutable llvm::DenseMap<const Decl *, bool> _changed_decls;
 
-	/* Cached function identifiers. */
-	mutable IdentifierInfo *_identifier_g_set_error;
-	mutable IdentifierInfo *_identifier_g_set_error_literal;
-	mutable IdentifierInfo *_identifier_g_error_new;
-	mutable IdentifierInfo *_identifier_g_error_new_literal;
-	mutable IdentifierInfo *_identifier_g_error_new_valist;
-	mutable IdentifierInfo *_identifier_g_error_free;
-	mutable IdentifierInfo *_identifier_g_clear_error;
-	mutable IdentifierInfo *_identifier_g_propagate_error;
-	mutable IdentifierInfo *_identifier_g_propagate_prefixed_error;
+	bool _is_in_changed_code (CheckerContext &context) const;
 
-	bool _initialise_identifiers (const ASTContext &context) const;
+	bool _initialise_types (const ASTContext &context) const;
+	GErrorOperation _get_operation (const FunctionDecl &func) const;
+	bool _function_throws (const FunctionDecl &func) const;
 
 	/* Cached bug reports. */
 	mutable std::unique_ptr<BuiltinBug> _overwrite_set;
@@ -100,6 +131,9 @@ private:
 	                                           const CallEvent &call_event) const;
 	ProgramStateRef _handle_pre_g_propagate_error (CheckerContext &context,
 	                                               const CallEvent &call_event) const;
+	ProgramStateRef _handle_pre_throws (CheckerContext &context,
+	                                    const CallEvent &call_event,
+	                                    unsigned int error_index) const;
 
 	ProgramStateRef _handle_eval_g_set_error (CheckerContext &context,
 	                                          const CallExpr &call_expr) const;
@@ -111,6 +145,10 @@ private:
 	                                            const CallExpr &call_expr) const;
 	ProgramStateRef _handle_eval_g_propagate_error (CheckerContext &context,
 	                                                const CallExpr &call_expr) const;
+	ProgramStateRef _handle_eval_throws (CheckerContext &context,
+	                                     const CallExpr &call_expr,
+	                                     unsigned int error_index,
+	                                     const GErrorSummary &summary) const;
 
 	bool _assert_gerror_set (SVal error_location,
 	                         bool null_allowed,
@@ -165,6 +203,8 @@ public:
 	                CheckerContext &context) const;
 	void checkDeadSymbols (SymbolReaper &symbol_reaper,
 	                       CheckerContext &context) const;
+	void checkEndAnalysis (ExplodedGraph &graph, BugReporter &reporter,
+	                       ExprEngine &engine) const;
 
 	const std::string get_name () const { return "gerror"; }
 };
@@ -0,0 +1,655 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+/**
+ * GErrorSummaryCache:
+ *
+ * Syntactic summaries of functions which take a GError** as their final
+ * parameter, for use by the GErrorChecker. A summary is only exact if every use
+ * of the error parameter in the function’s body is one of:
+ *  • passing it to g_set_error() or g_set_error_literal();
+ *  • passing it as the error parameter of another function which has an exact
+ *    summary (or which has no body in this translation unit);
+ *  • comparing it, or the GError* it points to, against %NULL.
+ * Anything else (propagating, clearing or assigning through the error, for
+ * example) means the checker has to leave the function to the analyser, which
+ * will inline it.
+ *
+ * The return value is only correlated with the error (a gboolean being %FALSE,
+ * or a pointer %NULL, iff the error is set) where the function is known to
+ * follow GLib’s convention. Plenty of functions don’t: g_key_file_get_boolean()
+ * returns %FALSE for a key set to false, and g_file_enumerator_next_file()
+ * returns %NULL at the end of the enumeration, without setting their errors.
+ * For functions with a body, the convention is checked against each of its
+ * return statements. For other functions it must be confirmed by GIR data (a
+ * non-nullable pointer return) or an annotation override. Other return types
+ * say nothing about the error.
+ */
+
+#include "config.h"
+
+#include <clang/AST/Attr.h>
+
+#include "gerror-summary.h"
+#include "debug.h"
+
+namespace tartan {
+
+/* Return true iff @type is (a typedef of) gboolean. */
+static bool
+_is_gboolean (QualType type)
+{
+	const TypedefType *typedef_type;
+
+	while ((typedef_type = type->getAs<TypedefType> ()) != NULL) {
+		if (typedef_type->getDecl ()->getName () == "gboolean") {
+			return true;
+		}
+
+		type = typedef_type->desugar ();
+	}
+
+	return false;
+}
+
+/* Return true iff @expr refers to @param, ignoring parentheses and casts.
+ * If @allow_deref is true, a dereference of @param also counts. */
+static bool
+_refers_to_param (const Expr *expr, const ParmVarDecl *param,
+                  bool allow_deref)
+{
+	expr = expr->IgnoreParenImpCasts ();
+
+	const UnaryOperator *deref = dyn_cast<UnaryOperator> (expr);
+
+	if (allow_deref && deref != NULL && deref->getOpcode () == UO_Deref) {
+		expr = deref->getSubExpr ()->IgnoreParenImpCasts ();
+	}
+
+	const DeclRefExpr *ref = dyn_cast<DeclRefExpr> (expr);
+
+	return (ref != NULL && ref->getDecl () == param);
+}
+
+static bool
+_is_null (const Expr *expr, ASTContext &context)
+{
+	return (expr->isNullPointerConstant (context,
+	                                     Expr::NPC_ValueDependentIsNotNull) !=
+	        Expr::NPCK_NotNull);
+}
+
+/* Return true iff @stmt passes @error_param to a function. In an exact summary,
+ * that means it may set the error. */
+static bool
+_may_set_error (const Stmt *stmt, const ParmVarDecl *error_param)
+{
+	if (stmt == NULL) {
+		return false;
+	}
+
+	if (const CallExpr *call = dyn_cast<CallExpr> (stmt)) {
+		for (unsigned int i = 0; i < call->getNumArgs (); i++) {
+			if (_refers_to_param (call->getArg (i), error_param,
+			                      false)) {
+				return true;
+			}
+		}
+	}
+
+	for (Stmt::const_child_iterator it = stmt->child_begin (),
+	     ie = stmt->child_end (); it != ie; ++it) {
+		if (_may_set_error (*it, error_param)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Return true iff @stmt is a call to @func_name, which is passed @error_param
+ * as its first argument if that’s non-%NULL. */
+static bool
+_is_call_to (const Stmt *stmt, const char *func_name,
+             const ParmVarDecl *error_param)
+{
+	const CallExpr *call = dyn_cast<CallExpr> (stmt);
+	const FunctionDecl *callee =
+		(call != NULL) ? call->getDirectCallee () : NULL;
+
+	return (callee != NULL && callee->getIdentifier () != NULL &&
+	        callee->getName () == func_name &&
+	        (error_param == NULL ||
+	         (call->getNumArgs () > 0 &&
+	          _refers_to_param (call->getArg (0), error_param, false))));
+}
+
+/* Work out whether returning @value means failure (FALSE or NULL) or success,
+ * setting @failure accordingly, for a function whose return type has the given
+ * @correlation. Returns false if that can’t be determined syntactically. */
+static bool
+_classify_return_value (const Expr *value,
+                        GErrorSummary::ReturnCorrelation correlation,
+                        ASTContext &context, bool &failure)
+{
+	if (_is_null (value, context)) {
+		failure = true;
+		return true;
+	}
+
+	value = value->IgnoreParenCasts ();
+
+	if (correlation == GErrorSummary::RETURN_FALSE_ON_ERROR) {
+		llvm::APSInt int_value;
+
+		if (value->isIntegerConstantExpr (int_value, context)) {
+			failure = !int_value.getBoolValue ();
+			return true;
+		}
+
+		return false;
+	}
+
+	/* Pointers which can’t be NULL. */
+	const UnaryOperator *op = dyn_cast<UnaryOperator> (value);
+
+	if (isa<StringLiteral> (value) ||
+	    (op != NULL && op->getOpcode () == UO_AddrOf)) {
+		failure = false;
+		return true;
+	}
+
+#ifdef HAVE_LLVM_3_5
+	const CallExpr *call = dyn_cast<CallExpr> (value);
+	const FunctionDecl *callee =
+		(call != NULL) ? call->getDirectCallee () : NULL;
+
+	if (callee != NULL && callee->hasAttr<ReturnsNonNullAttr> ()) {
+		failure = false;
+		return true;
+	}
+#endif /* HAVE_LLVM_3_5 */
+
+	return false;
+}
+
+/* Return true iff GIR data or an annotation override confirms that @func
+ * returns FALSE or NULL exactly when it sets its error. GIR data can only do
+ * so for a pointer return, by it not being nullable. */
+static bool
+_convention_is_confirmed (const FunctionDecl &func,
+                          const GirManager *gir_manager,
+                          bool pointer_return)
+{
+	if (gir_manager == NULL || func.getIdentifier () == NULL) {
+		return false;
+	}
+
+	const std::string func_name = func.getNameAsString ();
+	GIBaseInfo *info = gir_manager->find_function_info (func_name);
+
+	if (info != NULL) {
+		bool confirmed =
+			(pointer_return &&
+			 g_base_info_get_type (info) == GI_INFO_TYPE_FUNCTION &&
+			 g_callable_info_can_throw_gerror ((GICallableInfo *) info) &&
+			 !g_callable_info_may_return_null ((GICallableInfo *) info));
+		g_base_info_unref (info);
+
+		if (confirmed) {
+			return true;
+		}
+	}
+
+	AnnotationOverride annotations;
+
+	return (gir_manager->find_override (func_name, annotations) &&
+	        (annotations.failure_return ||
+	         (pointer_return && annotations.throws &&
+	          annotations.returns_nonnull)));
+}
+
+/* Record the error domain passed to g_set_error(), by the name of the quark
+ * function it calls (G_IO_ERROR expands to g_io_error_quark(), for example)
+ * or of the variable it refers to. */
+static void
+_add_domain (const Expr *domain, GErrorSummary &summary)
+{
+	domain = domain->IgnoreParenImpCasts ();
+
+	if (const CallExpr *call = dyn_cast<CallExpr> (domain)) {
+		const FunctionDecl *quark_func = call->getDirectCallee ();
+
+		if (quark_func != NULL && quark_func->getIdentifier () != NULL) {
+			summary.domains.insert (quark_func->getNameAsString ());
+		}
+	} else if (const DeclRefExpr *ref = dyn_cast<DeclRefExpr> (domain)) {
+		summary.domains.insert (ref->getDecl ()->getNameAsString ());
+	}
+}
+
+/* Forget all summaries, as the translation unit has changed. */
+void
+GErrorSummaryCache::reset (QualType gerror_ptr_ptr_type,
+                           const GirManager *gir_manager)
+{
+	this->_gerror_ptr_ptr_type = gerror_ptr_ptr_type;
+	this->_gir_manager = gir_manager;
+	this->_summaries.clear ();
+}
+
+/* Get the summary for @func, computing it if this is the first time it’s been
+ * needed. Returns %NULL if the summary is not exact. The returned pointer is
+ * only valid until the next call. */
+const GErrorSummary *
+GErrorSummaryCache::get_summary (const FunctionDecl &func)
+{
+	const FunctionDecl *canonical_decl = func.getCanonicalDecl ();
+	llvm::DenseMap<const FunctionDecl *, GErrorSummary>::const_iterator it =
+		this->_summaries.find (canonical_decl);
+
+	if (it == this->_summaries.end ()) {
+		/* Insert an inexact placeholder while summarising, so that
+		 * recursive functions are left to the analyser rather than
+		 * recursing here. */
+		this->_summaries[canonical_decl] = GErrorSummary ();
+
+		GErrorSummary summary;
+		this->_summarise_function (func, summary);
+
+		DEBUG ("GError summary for " << func.getNameAsString () <<
+		       ": exact: " << summary.is_exact <<
+		       ", may set error: " << summary.may_set_error <<
+		       ", correlation: " << summary.correlation <<
+		       ", domains: " << summary.domains.size ());
+
+		this->_summaries[canonical_decl] = summary;
+		it = this->_summaries.find (canonical_decl);
+	}
+
+	return (it->second.is_exact) ? &it->second : NULL;
+}
+
+void
+GErrorSummaryCache::_summarise_function (const FunctionDecl &func,
+                                         GErrorSummary &summary)
+{
+	if (func.getNumParams () == 0) {
+		return;
+	}
+
+#ifdef HAVE_LLVM_3_5
+	QualType return_type = func.getReturnType ();
+#else /* if !HAVE_LLVM_3_5 */
+	QualType return_type = func.getResultType ();
+#endif /* !HAVE_LLVM_3_5 */
+
+	if (return_type->isPointerType ()) {
+		summary.correlation = GErrorSummary::RETURN_NULL_ON_ERROR;
+	} else if (_is_gboolean (return_type)) {
+		summary.correlation = GErrorSummary::RETURN_FALSE_ON_ERROR;
+	}
+
+	const FunctionDecl *definition = NULL;
+	const Stmt *body = func.getBody (definition);
+
+	if (body == NULL) {
+		/* Defined elsewhere, so all that can be assumed is that it
+		 * may fail. Its return value only says whether it did if
+		 * that’s confirmed. */
+		summary.may_set_error = true;
+		summary.is_exact = true;
+
+		if (summary.correlation != GErrorSummary::RETURN_NONE &&
+		    !_convention_is_confirmed (func, this->_gir_manager,
+		                               return_type->isPointerType ())) {
+			summary.correlation = GErrorSummary::RETURN_NONE;
+		}
+
+		return;
+	}
+
+	const ParmVarDecl *error_param =
+		definition->getParamDecl (definition->getNumParams () - 1);
+	ASTContext &context = definition->getASTContext ();
+
+	summary.is_exact = this->_summarise_stmt (body, error_param, context,
+	                                          summary);
+
+	ErrorState state = ERROR_UNSET;
+
+	if (summary.is_exact &&
+	    summary.correlation != GErrorSummary::RETURN_NONE &&
+	    !this->_returns_follow_convention (body, error_param, context,
+	                                       summary.correlation, state)) {
+		summary.correlation = GErrorSummary::RETURN_NONE;
+	}
+}
+
+/* Walk @stmt, recording what it does with @error_param in @summary. Returns
+ * false if it uses @error_param in a way the summary can’t describe. */
+bool
+GErrorSummaryCache::_summarise_stmt (const Stmt *stmt,
+                                     const ParmVarDecl *error_param,
+                                     ASTContext &context,
+                                     GErrorSummary &summary)
+{
+	if (stmt == NULL) {
+		return true;
+	}
+
+	if (const BinaryOperator *op = dyn_cast<BinaryOperator> (stmt)) {
+		/* Comparisons against NULL only read the error, as in
+		 * g_return_val_if_fail (error == NULL || *error == NULL, …). */
+		if (op->isEqualityOp () &&
+		    ((_refers_to_param (op->getLHS (), error_param, true) &&
+		      _is_null (op->getRHS (), context)) ||
+		     (_refers_to_param (op->getRHS (), error_param, true) &&
+		      _is_null (op->getLHS (), context)))) {
+			return true;
+		}
+	} else if (const CallExpr *call = dyn_cast<CallExpr> (stmt)) {
+		return this->_summarise_call (*call, error_param, context,
+		                              summary);
+	} else if (const DeclRefExpr *ref = dyn_cast<DeclRefExpr> (stmt)) {
+		/* Any other use of the error could modify it. */
+		return (ref->getDecl () != error_param);
+	}
+
+	for (Stmt::const_child_iterator it = stmt->child_begin (),
+	     ie = stmt->child_end (); it != ie; ++it) {
+		if (!this->_summarise_stmt (*it, error_param, context,
+		                            summary)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+GErrorSummaryCache::_summarise_call (const CallExpr &call,
+                                     const ParmVarDecl *error_param,
+                                     ASTContext &context,
+                                     GErrorSummary &summary)
+{
+	const FunctionDecl *callee = call.getDirectCallee ();
+
+	for (unsigned int i = 0; i < call.getNumArgs (); i++) {
+		const Expr *arg = call.getArg (i);
+
+		if (!_refers_to_param (arg, error_param, false)) {
+			if (!this->_summarise_stmt (arg, error_param, context,
+			                            summary)) {
+				return false;
+			}
+
+			continue;
+		}
+
+		if (callee == NULL || callee->getIdentifier () == NULL) {
+			return false;
+		}
+
+		StringRef callee_name = callee->getName ();
+
+		if (i == 0 && (callee_name == "g_set_error" ||
+		               callee_name == "g_set_error_literal")) {
+			summary.may_set_error = true;
+
+			if (call.getNumArgs () > 1) {
+				_add_domain (call.getArg (1), summary);
+			}
+
+			continue;
+		}
+
+		/* Forwarded as another function’s error parameter. */
+		if (i + 1 == callee->getNumParams () &&
+		    callee->getParamDecl (i)->getType ().getCanonicalType () ==
+		    this->_gerror_ptr_ptr_type) {
+			const GErrorSummary *callee_summary =
+				this->get_summary (*callee);
+
+			if (callee_summary == NULL) {
+				return false;
+			}
+
+			summary.may_set_error |= callee_summary->may_set_error;
+			summary.domains.insert (callee_summary->domains.begin (),
+			                        callee_summary->domains.end ());
+
+			continue;
+		}
+
+		return false;
+	}
+
+	return true;
+}
+
+/* If @expr is a call which forwards @error_param as the error parameter of a
+ * function with an exact summary, return that function’s correlation. */
+GErrorSummary::ReturnCorrelation
+GErrorSummaryCache::_forwarded_correlation (const Expr *expr,
+                                            const ParmVarDecl *error_param)
+{
+	const CallExpr *call = dyn_cast<CallExpr> (expr->IgnoreParenCasts ());
+
+	if (call == NULL || call->getNumArgs () == 0) {
+		return GErrorSummary::RETURN_NONE;
+	}
+
+	const FunctionDecl *callee = call->getDirectCallee ();
+	unsigned int error_index = call->getNumArgs () - 1;
+
+	if (callee == NULL || callee->getNumParams () != call->getNumArgs () ||
+	    !_refers_to_param (call->getArg (error_index), error_param,
+	                       false) ||
+	    callee->getParamDecl (error_index)->getType ().getCanonicalType () !=
+	    this->_gerror_ptr_ptr_type) {
+		return GErrorSummary::RETURN_NONE;
+	}
+
+	const GErrorSummary *callee_summary = this->get_summary (*callee);
+
+	return (callee_summary != NULL) ?
+		callee_summary->correlation : GErrorSummary::RETURN_NONE;
+}
+
+/* Return true iff @cond holds exactly when a call in it which forwards
+ * @error_param fails, as in (!some_func (…, error)) or
+ * (some_func (…, error) == NULL). */
+bool
+GErrorSummaryCache::_is_failure_test (const Expr *cond,
+                                      const ParmVarDecl *error_param,
+                                      ASTContext &context)
+{
+	cond = cond->IgnoreParenImpCasts ();
+
+	if (const UnaryOperator *not_op = dyn_cast<UnaryOperator> (cond)) {
+		return (not_op->getOpcode () == UO_LNot &&
+		        this->_forwarded_correlation (not_op->getSubExpr (),
+		                                      error_param) !=
+		        GErrorSummary::RETURN_NONE);
+	} else if (const BinaryOperator *eq_op = dyn_cast<BinaryOperator> (cond)) {
+		if (eq_op->getOpcode () != BO_EQ) {
+			return false;
+		}
+
+		const Expr *lhs = eq_op->getLHS ();
+		const Expr *rhs = eq_op->getRHS ();
+
+		if (_is_null (lhs, context)) {
+			std::swap (lhs, rhs);
+		}
+
+		return (_is_null (rhs, context) &&
+		        this->_forwarded_correlation (lhs, error_param) !=
+		        GErrorSummary::RETURN_NONE);
+	}
+
+	return false;
+}
+
+GErrorSummaryCache::ErrorState
+GErrorSummaryCache::_merge_error_states (ErrorState a, ErrorState b)
+{
+	if (a == ERROR_UNREACHABLE || a == b) {
+		return b;
+	} else if (b == ERROR_UNREACHABLE) {
+		return a;
+	} else if (a == ERROR_IRRELEVANT) {
+		return b;
+	} else if (b == ERROR_IRRELEVANT) {
+		return a;
+	}
+
+	return ERROR_MAYBE_SET;
+}
+
+/* Check that every return statement in @stmt follows GLib’s convention for
+ * @correlation: a failure value (FALSE or NULL) is only returned once the error
+ * has definitely been set, and a success value only while it definitely hasn’t
+ * been. Returns after a precondition failure (in g_return_val_if_fail(), for
+ * example) are ignored, as are those which forward the error to a function
+ * with the same correlation.
+ *
+ * @state gives the state of the error on entry to @stmt, and is updated to its
+ * state once @stmt completes normally. This is a syntactic approximation, so
+ * anything it can’t follow (such as a label) makes the error’s state
+ * unknown. */
+bool
+GErrorSummaryCache::_returns_follow_convention (const Stmt *stmt,
+                                                const ParmVarDecl *error_param,
+                                                ASTContext &context,
+                                                GErrorSummary::ReturnCorrelation correlation,
+                                                ErrorState &state)
+{
+	if (stmt == NULL) {
+		return true;
+	}
+
+	if (const ReturnStmt *ret = dyn_cast<ReturnStmt> (stmt)) {
+		const Expr *value = ret->getRetValue ();
+		ErrorState entry_state = state;
+		bool failure;
+
+		state = ERROR_UNREACHABLE;
+
+		if (entry_state == ERROR_IRRELEVANT ||
+		    entry_state == ERROR_UNREACHABLE) {
+			return true;
+		} else if (value == NULL) {
+			return false;
+		} else if (this->_forwarded_correlation (value, error_param) ==
+		           correlation) {
+			return (entry_state == ERROR_UNSET);
+		} else if (_classify_return_value (value, correlation, context,
+		                                   failure)) {
+			return (entry_state ==
+			        (failure ? ERROR_SET : ERROR_UNSET));
+		}
+
+		return false;
+	} else if (const CompoundStmt *compound = dyn_cast<CompoundStmt> (stmt)) {
+		for (CompoundStmt::const_body_iterator it = compound->body_begin (),
+		     ie = compound->body_end (); it != ie; ++it) {
+			if (!this->_returns_follow_convention (*it,
+			                                       error_param,
+			                                       context,
+			                                       correlation,
+			                                       state)) {
+				return false;
+			}
+		}
+
+		return true;
+	} else if (const IfStmt *if_stmt = dyn_cast<IfStmt> (stmt)) {
+		const Expr *cond = if_stmt->getCond ();
+		ErrorState then_state = state, else_state = state;
+
+		if (state == ERROR_UNSET &&
+		    this->_is_failure_test (cond, error_param, context)) {
+			then_state = ERROR_SET;
+		} else if (state == ERROR_UNSET &&
+		           _may_set_error (cond, error_param)) {
+			then_state = else_state = ERROR_MAYBE_SET;
+		}
+
+		if (!this->_returns_follow_convention (if_stmt->getThen (),
+		                                       error_param, context,
+		                                       correlation,
+		                                       then_state) ||
+		    !this->_returns_follow_convention (if_stmt->getElse (),
+		                                       error_param, context,
+		                                       correlation,
+		                                       else_state)) {
+			return false;
+		}
+
+		state = _merge_error_states (then_state, else_state);
+
+		return true;
+	} else if (isa<LabelStmt> (stmt)) {
+		/* Reachable from anywhere. */
+		state = ERROR_MAYBE_SET;
+	} else if (isa<GotoStmt> (stmt) || isa<BreakStmt> (stmt) ||
+	           isa<ContinueStmt> (stmt)) {
+		state = ERROR_UNREACHABLE;
+
+		return true;
+	} else if (_is_call_to (stmt, "g_return_if_fail_warning", NULL)) {
+		state = ERROR_IRRELEVANT;
+
+		return true;
+	} else if (_is_call_to (stmt, "g_set_error", error_param) ||
+	           _is_call_to (stmt, "g_set_error_literal", error_param)) {
+		if (state == ERROR_UNSET || state == ERROR_MAYBE_SET) {
+			state = ERROR_SET;
+		}
+
+		return true;
+	}
+
+	/* Anything else, including loops: a set error stays set, but
+	 * otherwise the error may be set by any call in @stmt, and that may
+	 * happen before any return statement in it. */
+	if (state == ERROR_UNSET && _may_set_error (stmt, error_param)) {
+		state = ERROR_MAYBE_SET;
+	}
+
+	for (Stmt::const_child_iterator it = stmt->child_begin (),
+	     ie = stmt->child_end (); it != ie; ++it) {
+		ErrorState child_state = state;
+
+		if (!this->_returns_follow_convention (*it, error_param,
+		                                       context, correlation,
+		                                       child_state)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} /* namespace tartan */
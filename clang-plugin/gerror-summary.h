@@ -0,0 +1,120 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_GERROR_SUMMARY_H
+#define TARTAN_GERROR_SUMMARY_H
+
+#include <set>
+#include <string>
+
+#include <clang/AST/AST.h>
+#include <llvm/ADT/DenseMap.h>
+
+#include "gir-manager.h"
+
+namespace tartan {
+
+using namespace clang;
+
+/* A summary of what a function taking a trailing GError** parameter does with
+ * it, computed once per function so that the GErrorChecker can apply it at
+ * each call site rather than having the analyser inline the function’s body
+ * again.
+ *
+ * @may_set_error is true iff the function may set its error.
+ * @correlation gives what the return value says about the error, where the
+ * function is known to follow GLib’s convention for its return type.
+ * @domains contains the error domains (as the name of their quark function or
+ * macro) the function may set its error in, where known.
+ * @is_exact is false if the function uses its error in ways the summary can’t
+ * describe (for example, propagating or clearing it), in which case the
+ * summary must not be applied. */
+struct GErrorSummary {
+	enum ReturnCorrelation {
+		RETURN_NONE,  /* return value unrelated to the error */
+		RETURN_FALSE_ON_ERROR,  /* gboolean: FALSE iff error set */
+		RETURN_NULL_ON_ERROR,  /* pointer: NULL iff error set */
+	};
+
+	GErrorSummary () : may_set_error (false), correlation (RETURN_NONE),
+		is_exact (false) {}
+
+	bool may_set_error;
+	ReturnCorrelation correlation;
+	std::set<std::string> domains;
+	bool is_exact;
+};
+
+/* Lazily computed summaries for the functions in a translation unit, keyed by
+ * canonical declaration. This must be reset if the #ASTContext changes. */
+class GErrorSummaryCache {
+public:
+	GErrorSummaryCache () : _gir_manager (NULL) {}
+
+	void reset (QualType gerror_ptr_ptr_type,
+	            const GirManager *gir_manager);
+
+	const GErrorSummary *get_summary (const FunctionDecl &func);
+
+private:
+	/* What is known about the error at a point in a function body, for
+	 * checking its return statements against the convention. */
+	enum ErrorState {
+		ERROR_UNSET,
+		ERROR_SET,
+		ERROR_MAYBE_SET,
+		ERROR_IRRELEVANT,  /* after a precondition failure */
+		ERROR_UNREACHABLE,  /* after a return or jump */
+	};
+
+	/* Canonical. */
+	QualType _gerror_ptr_ptr_type;
+	const GirManager *_gir_manager;
+	llvm::DenseMap<const FunctionDecl *, GErrorSummary> _summaries;
+
+	void _summarise_function (const FunctionDecl &func,
+	                          GErrorSummary &summary);
+	bool _summarise_stmt (const Stmt *stmt,
+	                      const ParmVarDecl *error_param,
+	                      ASTContext &context,
+	                      GErrorSummary &summary);
+	bool _summarise_call (const CallExpr &call,
+	                      const ParmVarDecl *error_param,
+	                      ASTContext &context,
+	                      GErrorSummary &summary);
+	GErrorSummary::ReturnCorrelation
+	_forwarded_correlation (const Expr *expr,
+	                        const ParmVarDecl *error_param);
+	bool _is_failure_test (const Expr *cond,
+	                       const ParmVarDecl *error_param,
+	                       ASTContext &context);
+	static ErrorState _merge_error_states (ErrorState a, ErrorState b);
+	bool _returns_follow_convention (const Stmt *stmt,
+	                                 const ParmVarDecl *error_param,
+	                                 ASTContext &context,
+	                                 GErrorSummary::ReturnCorrelation correlation,
+	                                 ErrorState &state);
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_GERROR_SUMMARY_H */
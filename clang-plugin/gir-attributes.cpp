@@ -22,15 +22,22 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <cstring>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #include <girepository.h>
 #include <gitypes.h>
 
 #include <clang/AST/Attr.h>
+#include <clang/Basic/SourceManager.h>
+#include <llvm/Support/raw_ostream.h>
 
 #include "debug.h"
 #include "gir-attributes.h"
+#include "type-manager.h"
 
 namespace tartan {
 
@@ -178,52 +185,216 @@ _ignore_glib_internal_func (const std::string func_name)
 	return false;
 }
 
-void
-GirAttributesConsumer::_handle_function_decl (FunctionDecl& func)
+/* Attributes implied by the GIR data for a single function. Parameter indices
+ * are 0-based indices of the C formal parameters. */
+typedef struct {
+	std::vector<unsigned int> nonnull_args;
+	std::vector<unsigned int> const_args;  /* only if not already const */
+	bool constify_return;
+	bool returns_nonnull;
+	bool warn_unused_result;
+	bool malloc;
+	bool pure;
+	bool deprecated;
+	std::string deprecation_message;  /* only known from .gir files */
+} GirFunctionAttributes;
+
+/* Work out which attributes the GIR data in @info implies for @func. Returns
+ * %false if @info doesn’t describe a function matching @func, in which case
+ * @attrs is undefined.
+ *
+ * returns_nonnull is only derived for constructors, and pure only for getters
+ * with non-owned const return values, as the GIR’s nullability annotations on
+ * return values (and its lack of any side-effect information) aren’t reliable
+ * enough to apply them more widely. */
+static bool
+_get_function_attributes (FunctionDecl& func, GIBaseInfo *info,
+                          GirFunctionAttributes& attrs)
 {
-	/* Ignore static functions immediately; they shouldn’t have any
-	 * GIR data, and searching for it massively slows down
-	 * compilation. */
-	StorageClass sc = func.getStorageClass ();
-	if (sc != SC_None && sc != SC_Extern)
-		return;
+	const std::string func_name = func.getNameAsString ();
+	GICallableInfo *callable_info = (GICallableInfo *) info;
+	GIFunctionInfoFlags flags = g_function_info_get_flags (info);
+
+	/* GError formal parameters aren’t included in the number of
+	 * callable arguments. */
+	unsigned int k = g_callable_info_get_n_args (callable_info);
+	unsigned int err_params = (flags & GI_FUNCTION_THROWS) ? 1 : 0;
+	unsigned int obj_params =
+		(g_base_info_get_container (info) != NULL &&
+		 flags & GI_FUNCTION_IS_METHOD) ? 1 : 0;
+	bool all_args_in = true;
+
+	/* Sanity check. */
+	if (obj_params + k + err_params != func.getNumParams ()) {
+		WARN ("Number of GIR callable parameters (" <<
+		      obj_params + k + err_params << ") "
+		      "differs from number of C formal parameters (" <<
+		      func.getNumParams () << "). Ignoring function " <<
+		      func_name << "().");
+		return false;
+	}
 
-	/* Try to find typelib information about the function. */
-	const std::string func_name = func.getNameAsString ();  /* TODO: expensive? */
-	GIBaseInfo *info = this->_gir_manager.get ()->find_function_info (func_name);
+	for (unsigned int j = 0; j < k; j++) {
+		GIArgInfo arg;
+		GITypeInfo type_info;
+		GITransfer transfer;
+		GITypeTag type_tag;
+
+		g_callable_info_load_arg (callable_info, j, &arg);
+		g_arg_info_load_type (&arg, &type_info);
+		transfer = g_arg_info_get_ownership_transfer (&arg);
+		type_tag = g_type_info_get_tag (&type_info);
+
+		DEBUG_CODE (int array_type =
+			(g_type_info_get_tag (&type_info) ==
+			 GI_TYPE_TAG_ARRAY) ?
+				g_type_info_get_array_type (&type_info) :
+				-1);
+		DEBUG ("GirAttributes: " << func_name << "(" << j <<
+		       ")\n"
+		       "\tTransfer: " << transfer << "\n"
+		       "\tDirection: " <<
+		       g_arg_info_get_direction (&arg) << "\n"
+		       "\tNullable: " <<
+		       g_arg_info_may_be_null (&arg) << "\n"
+		       "\tOptional: " <<
+		       g_arg_info_is_optional (&arg) << "\n"
+		       "\tIs pointer: " <<
+		       g_type_info_is_pointer (&type_info) << "\n"
+		       "\tType tag: " <<
+		       g_type_tag_to_string (
+		           g_type_info_get_tag (&type_info)) << "\n"
+		       "\tArray type: " <<
+		       array_type << "\n"
+		       "\tArray length: " <<
+		       g_type_info_get_array_length (&type_info) << "\n"
+		       "\tArray fixed size: " <<
+		       g_type_info_get_array_fixed_size (&type_info));
+
+		if (g_arg_info_get_direction (&arg) != GI_DIRECTION_IN) {
+			all_args_in = false;
+		}
 
-	if (info == NULL)
-		return;
+		if (_arg_is_nonnull (arg, type_info) &&
+		    !_ignore_glib_internal_func (func_name)) {
+			DEBUG ("Got nonnull arg " << obj_params + j <<
+			       " from GIR.");
+			attrs.nonnull_args.push_back (obj_params + j);
+		}
 
-	/* Extract information from the GIBaseInfo and add AST attributes
-	 * accordingly. */
-	switch (g_base_info_get_type (info)) {
-	case GI_INFO_TYPE_FUNCTION: {
-		GICallableInfo *callable_info = (GICallableInfo *) info;
+		if (_type_should_be_const (transfer, type_tag)) {
+			ParmVarDecl *parm = func.getParamDecl (obj_params + j);
 
-		/* GError formal parameters aren’t included in the number of
-		 * callable arguments. */
-		unsigned int k = g_callable_info_get_n_args (callable_info);
-		unsigned int err_params =
-			(g_function_info_get_flags (callable_info) &
-			 GI_FUNCTION_THROWS) ? 1 : 0;
-		unsigned int obj_params =
-			(g_base_info_get_container (info) != NULL &&
-			 g_function_info_get_flags (callable_info) &
-			 GI_FUNCTION_IS_METHOD) ? 1 : 0;
+			if (!parm->getType ().isConstant (parm->getASTContext ()))
+				attrs.const_args.push_back (obj_params + j);
+		}
+	}
 
-		/* Sanity check. */
-		if (obj_params + k + err_params != func.getNumParams ()) {
-			WARN ("Number of GIR callable parameters (" <<
-			      obj_params + k + err_params << ") "
-			      "differs from number of C formal parameters (" <<
-			      func.getNumParams () << "). Ignoring function " <<
-			      func_name << "().");
-			break;
+	/* Process the function’s return type. */
+	GITypeInfo return_type_info;
+	GITransfer return_transfer;
+	GITypeTag return_type_tag;
+
+	g_callable_info_load_return_type (info, &return_type_info);
+	return_transfer = g_callable_info_get_caller_owns (info);
+	return_type_tag = g_type_info_get_tag (&return_type_info);
+
+	attrs.warn_unused_result = (return_transfer != GI_TRANSFER_NOTHING);
+	attrs.constify_return = _type_should_be_const (return_transfer,
+	                                               return_type_tag);
+	attrs.deprecated = g_base_info_is_deprecated (info);
+	attrs.malloc = (flags & GI_FUNCTION_IS_CONSTRUCTOR);
+	attrs.returns_nonnull =
+		((flags & GI_FUNCTION_IS_CONSTRUCTOR) &&
+		 !(flags & GI_FUNCTION_THROWS) &&
+		 g_type_info_is_pointer (&return_type_info) &&
+		 !g_callable_info_may_return_null (callable_info));
+	attrs.pure =
+		(attrs.constify_return && all_args_in &&
+		 !(flags & GI_FUNCTION_THROWS) &&
+		 !func.isVariadic () &&
+		 func_name.find ("_get_") != std::string::npos);
+
+	return true;
+}
+
+static std::string
+_format_deprecation_message (const std::string& message,
+                             const std::string& version)
+{
+	if (!version.empty () && !message.empty ()) {
+		return "Deprecated since " + version + ": " + message;
+	} else if (!version.empty ()) {
+		return "Deprecated since " + version + ".";
+	} else {
+		return message;
+	}
+}
+
+/* Fill in the deprecation message for @func_name in @attrs, if it’s deprecated
+ * and @gir_manager has a message or version for it from a .gir file. */
+static void
+_get_deprecation_message (const GirManager& gir_manager,
+                          const std::string& func_name,
+                          GirFunctionAttributes& attrs)
+{
+	std::string message, version;
+
+	if (!attrs.deprecated ||
+	    !gir_manager.get_deprecation (func_name, message, version))
+		return;
+
+	attrs.deprecation_message =
+		_format_deprecation_message (message, version);
+}
+
+/* Work out which attributes the annotation overrides for @func_name imply for
+ * @func, for functions with no GIR data. Returns %false if there are no
+ * overrides, or they don’t match @func, in which case @attrs is undefined. */
+static bool
+_get_override_attributes (FunctionDecl& func, const std::string& func_name,
+                          const GirManager& gir_manager,
+                          GirFunctionAttributes& attrs)
+{
+	AnnotationOverride annotations;
+
+	if (!gir_manager.find_override (func_name, annotations))
+		return false;
+
+	for (std::vector<unsigned int>::const_iterator it = annotations.nonnull_args.begin (),
+	     ie = annotations.nonnull_args.end (); it != ie; ++it) {
+		if (*it >= func.getNumParams ()) {
+			WARN ("Annotation override nonnull parameter (" <<
+			      *it + 1 << ") is out of range for function " <<
+			      func_name << "(). Ignoring it.");
+			return false;
 		}
+	}
+
+	attrs.nonnull_args = annotations.nonnull_args;
+	attrs.constify_return = false;
+	attrs.returns_nonnull = annotations.returns_nonnull;
+	attrs.warn_unused_result =
+		(annotations.return_transfer != GI_TRANSFER_NOTHING);
+	attrs.malloc = false;
+	attrs.pure = false;
+	attrs.deprecated = annotations.deprecated;
+	attrs.deprecation_message =
+		_format_deprecation_message (annotations.deprecation_message,
+		                             annotations.deprecation_version);
 
+	return true;
+}
+
+/* Add the attributes in @attrs to @func’s AST. */
+static void
+_apply_function_attributes (FunctionDecl& func,
+                            const GirFunctionAttributes& attrs)
+{
+	ASTContext& context = func.getASTContext ();
+
+	if (attrs.nonnull_args.size () > 0) {
 		std::vector<unsigned int> non_null_args;
-		unsigned int j;
 
 		NonNullAttr* nonnull_attr = func.getAttr<NonNullAttr> ();
 		if (nonnull_attr != NULL) {
@@ -234,167 +405,159 @@ GirAttributesConsumer::_handle_function_decl (FunctionDecl& func)
 			                      nonnull_attr->args_end ());
 		}
 
-		for (j = 0; j < k; j++) {
-			GIArgInfo arg;
-			GITypeInfo type_info;
-			GITransfer transfer;
-			GITypeTag type_tag;
-
-			g_callable_info_load_arg (callable_info, j, &arg);
-			g_arg_info_load_type (&arg, &type_info);
-			transfer = g_arg_info_get_ownership_transfer (&arg);
-			type_tag = g_type_info_get_tag (&type_info);
-
-			DEBUG_CODE (int array_type =
-				(g_type_info_get_tag (&type_info) ==
-				 GI_TYPE_TAG_ARRAY) ?
-					g_type_info_get_array_type (&type_info) :
-					-1);
-			DEBUG ("GirAttributes: " << func_name << "(" << j <<
-			       ")\n"
-			       "\tTransfer: " << transfer << "\n"
-			       "\tDirection: " <<
-			       g_arg_info_get_direction (&arg) << "\n"
-			       "\tNullable: " <<
-			       g_arg_info_may_be_null (&arg) << "\n"
-			       "\tOptional: " <<
-			       g_arg_info_is_optional (&arg) << "\n"
-			       "\tIs pointer: " <<
-			       g_type_info_is_pointer (&type_info) << "\n"
-			       "\tType tag: " <<
-			       g_type_tag_to_string (
-			           g_type_info_get_tag (&type_info)) << "\n"
-			       "\tArray type: " <<
-			       array_type << "\n"
-			       "\tArray length: " <<
-			       g_type_info_get_array_length (&type_info) << "\n"
-			       "\tArray fixed size: " <<
-			       g_type_info_get_array_fixed_size (&type_info));
-
-			if (_arg_is_nonnull (arg, type_info)) {
-				DEBUG ("Got nonnull arg " << obj_params + j <<
-				       " from GIR.");
-				non_null_args.push_back (obj_params + j);
-			}
-
-			if (_type_should_be_const (transfer, type_tag)) {
-				ParmVarDecl *parm = func.getParamDecl (obj_params + j);
-				QualType t = parm->getType ();
-
-				if (!t.isConstant (parm->getASTContext ()))
-					parm->setType (t.withConst ());
-			}
-		}
+		non_null_args.insert (non_null_args.end (),
+		                      attrs.nonnull_args.begin (),
+		                      attrs.nonnull_args.end ());
 
-		if (non_null_args.size () > 0 &&
-		    !_ignore_glib_internal_func (func_name)) {
 #ifdef HAVE_LLVM_3_5
-			nonnull_attr = ::new (func.getASTContext ())
-				NonNullAttr (func.getSourceRange (),
-				             func.getASTContext (),
-				             non_null_args.data (),
-				             non_null_args.size (), 0);
+		nonnull_attr = ::new (context)
+			NonNullAttr (func.getSourceRange (), context,
+			             non_null_args.data (),
+			             non_null_args.size (), 0);
 #else /* if !HAVE_LLVM_3_5 */
-			nonnull_attr = ::new (func.getASTContext ())
-				NonNullAttr (func.getSourceRange (),
-				             func.getASTContext (),
-				             non_null_args.data (),
-				             non_null_args.size ());
+		nonnull_attr = ::new (context)
+			NonNullAttr (func.getSourceRange (), context,
+			             non_null_args.data (),
+			             non_null_args.size ());
 #endif /* !HAVE_LLVM_3_5 */
-			func.addAttr (nonnull_attr);
-		}
-
-		/* Process the function’s return type. */
-		/* FIXME: Support returns_nonnull when Clang supports it.
-		 * http://llvm.org/bugs/show_bug.cgi?id=4832 */
-		GITypeInfo return_type_info;
-		GITransfer return_transfer;
-		GITypeTag return_type_tag;
+		func.addAttr (nonnull_attr);
+	}
 
-		g_callable_info_load_return_type (info, &return_type_info);
-		return_transfer = g_callable_info_get_caller_owns (info);
-		return_type_tag = g_type_info_get_tag (&return_type_info);
+	for (std::vector<unsigned int>::const_iterator it = attrs.const_args.begin (),
+	     ie = attrs.const_args.end (); it != ie; ++it) {
+		ParmVarDecl *parm = func.getParamDecl (*it);
+		parm->setType (parm->getType ().withConst ());
+	}
 
-		if (return_transfer != GI_TRANSFER_NOTHING) {
+	if (attrs.warn_unused_result) {
 #ifdef HAVE_LLVM_3_5
-			WarnUnusedAttr* warn_unused_attr =
-				::new (func.getASTContext ())
-				WarnUnusedAttr (func.getSourceRange (),
-				                func.getASTContext (), 0);
+		WarnUnusedAttr* warn_unused_attr =
+			::new (context)
+			WarnUnusedAttr (func.getSourceRange (), context, 0);
 #else /* if !HAVE_LLVM_3_5 */
-			WarnUnusedAttr* warn_unused_attr =
-				::new (func.getASTContext ())
-				WarnUnusedAttr (func.getSourceRange (),
-				                func.getASTContext ());
+		WarnUnusedAttr* warn_unused_attr =
+			::new (context)
+			WarnUnusedAttr (func.getSourceRange (), context);
 #endif /* !HAVE_LLVM_3_5 */
-			func.addAttr (warn_unused_attr);
-		} else if (_type_should_be_const (return_transfer,
-		                                  return_type_tag)) {
-			_constify_function_return_type (func);
-		}
+		func.addAttr (warn_unused_attr);
+	} else if (attrs.constify_return) {
+		_constify_function_return_type (func);
+	}
+
+#ifdef HAVE_LLVM_3_5
+	if (attrs.returns_nonnull && !func.hasAttr<ReturnsNonNullAttr> ()) {
+		ReturnsNonNullAttr* returns_nonnull_attr =
+			::new (context)
+			ReturnsNonNullAttr (func.getSourceRange (), context, 0);
+		func.addAttr (returns_nonnull_attr);
+	}
+#endif /* HAVE_LLVM_3_5 */
+
+	/* Mark the function as deprecated if it wasn’t already. Typelib
+	 * files don’t contain a deprecation message, version, or replacement
+	 * function, so a message is only available if the namespace was
+	 * loaded from a .gir file. */
+	if (attrs.deprecated && !func.hasAttr<DeprecatedAttr> ()) {
+		const std::string message =
+			attrs.deprecation_message.empty () ?
+			"Deprecated using the gtk-doc attribute." :
+			attrs.deprecation_message;
 
-		/* Mark the function as deprecated if it wasn’t already. The
-		 * typelib file doesn’t contain a deprecation message, version,
-		 * or replacement function so we can’t make use of them. */
-		if (g_base_info_is_deprecated (info) &&
-		    !func.hasAttr<DeprecatedAttr> ()) {
 #ifdef HAVE_LLVM_3_8
-			DeprecatedAttr* deprecated_attr =
-				::new (func.getASTContext ())
-				DeprecatedAttr (func.getSourceRange (),
-				                func.getASTContext (),
-				                0);
+		DeprecatedAttr* deprecated_attr =
+			attrs.deprecation_message.empty () ?
+			::new (context)
+			DeprecatedAttr (func.getSourceRange (), context, 0) :
+			::new (context)
+			DeprecatedAttr (func.getSourceRange (), context,
+			                message, "", 0);
 #elif HAVE_LLVM_3_5
-			DeprecatedAttr* deprecated_attr =
-				::new (func.getASTContext ())
-				DeprecatedAttr (func.getSourceRange (),
-				                func.getASTContext (),
-				                "Deprecated using the gtk-doc "
-				                "attribute.", 0);
+		DeprecatedAttr* deprecated_attr =
+			::new (context)
+			DeprecatedAttr (func.getSourceRange (), context,
+			                message, 0);
 #else /* if !HAVE_LLVM_3_5 */
-			DeprecatedAttr* deprecated_attr =
-				::new (func.getASTContext ())
-				DeprecatedAttr (func.getSourceRange (),
-				                func.getASTContext (),
-				                "Deprecated using the gtk-doc "
-				                "attribute.");
+		DeprecatedAttr* deprecated_attr =
+			::new (context)
+			DeprecatedAttr (func.getSourceRange (), context,
+			                message);
 #endif /* !HAVE_LLVM_3_5 */
-			func.addAttr (deprecated_attr);
-		}
+		func.addAttr (deprecated_attr);
+	}
 
-		/* Mark the function as allocating memory if it’s a
-		 * constructor. */
+	/* Mark the function as allocating memory if it’s a
+	 * constructor. */
 #if defined(HAVE_LLVM_3_7)
-		if (g_function_info_get_flags (info) &
-		    GI_FUNCTION_IS_CONSTRUCTOR &&
-		    !func.hasAttr<RestrictAttr> ()) {
-			RestrictAttr* malloc_attr =
-				::new (func.getASTContext ())
-				RestrictAttr (func.getSourceRange (),
-				              func.getASTContext (), 0);
-			func.addAttr (malloc_attr);
-		}
+	if (attrs.malloc && !func.hasAttr<RestrictAttr> ()) {
+		RestrictAttr* malloc_attr =
+			::new (context)
+			RestrictAttr (func.getSourceRange (), context, 0);
+		func.addAttr (malloc_attr);
+	}
 #elif defined(HAVE_LLVM_3_6)
-		if (g_function_info_get_flags (info) &
-		    GI_FUNCTION_IS_CONSTRUCTOR &&
-		    !func.hasAttr<MallocAttr> ()) {
-			MallocAttr* malloc_attr =
-				::new (func.getASTContext ())
-				MallocAttr (func.getSourceRange (),
-				            func.getASTContext (), 0);
-			func.addAttr (malloc_attr);
-		}
+	if (attrs.malloc && !func.hasAttr<MallocAttr> ()) {
+		MallocAttr* malloc_attr =
+			::new (context)
+			MallocAttr (func.getSourceRange (), context, 0);
+		func.addAttr (malloc_attr);
+	}
 #else
-		if (g_function_info_get_flags (info) &
-		    GI_FUNCTION_IS_CONSTRUCTOR &&
-		    !func.hasAttr<MallocAttr> ()) {
-			MallocAttr* malloc_attr =
-				::new (func.getASTContext ())
-				MallocAttr (func.getSourceRange (),
-				            func.getASTContext ());
-			func.addAttr (malloc_attr);
-		}
+	if (attrs.malloc && !func.hasAttr<MallocAttr> ()) {
+		MallocAttr* malloc_attr =
+			::new (context)
+			MallocAttr (func.getSourceRange (), context);
+		func.addAttr (malloc_attr);
+	}
 #endif
+}
+
+void
+GirAttributesConsumer::_handle_function_decl (FunctionDecl& func)
+{
+	/* Ignore static functions immediately; they shouldn’t have any
+	 * GIR data, and searching for it massively slows down
+	 * compilation. */
+	StorageClass sc = func.getStorageClass ();
+	if (sc != SC_None && sc != SC_Extern)
+		return;
+
+	const std::string func_name = func.getNameAsString ();  /* TODO: expensive? */
+
+	/* Skip functions whose attributes are already provided by a
+	 * force-included header generated with
+	 * --generate-attributes-header. */
+	const std::unordered_set<std::string>& covered_symbols =
+		this->_options.get ()->attributes_header_symbols;
+	if (covered_symbols.find (func_name) != covered_symbols.end ())
+		return;
+
+	/* Try to find typelib information about the function, falling back
+	 * to any annotation overrides for it. */
+	GIBaseInfo *info = this->_gir_manager.get ()->find_function_info (func_name);
+
+	if (info == NULL) {
+		GirFunctionAttributes attrs;
+
+		if (_get_override_attributes (func, func_name,
+		                              *this->_gir_manager.get (),
+		                              attrs)) {
+			_apply_function_attributes (func, attrs);
+		}
+
+		return;
+	}
+
+	/* Extract information from the GIBaseInfo and add AST attributes
+	 * accordingly. */
+	switch (g_base_info_get_type (info)) {
+	case GI_INFO_TYPE_FUNCTION: {
+		GirFunctionAttributes attrs;
+
+		if (_get_function_attributes (func, info, attrs)) {
+			_get_deprecation_message (*this->_gir_manager.get (),
+			                          func_name, attrs);
+			_apply_function_attributes (func, attrs);
+		}
 
 		break;
 	}
@@ -431,6 +594,161 @@ GirAttributesConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
 {
 	DeclGroupRef::iterator i, e;
 
+	for (i = decl_group.begin (), e = decl_group.end (); i != e; i++) {
+		Decl *decl = *i;
+		FunctionDecl *func = dyn_cast<FunctionDecl> (decl);
+
+		/* We’re only interested in function declarations. */
+		if (func == NULL)
+			continue;
+
+		if (!this->_options.get ()->decl_is_in_scope (*func))
+			continue;
+
+		this->_handle_function_decl (*func);
+	}
+
+	return true;
+}
+
+
+/* Find the header, directly included by the main file, through which @loc was
+ * included. Returns an empty string if @loc isn’t in a header. */
+static std::string
+_get_top_level_header (const SourceManager& sm, SourceLocation loc)
+{
+	FileID file_id = sm.getFileID (sm.getExpansionLoc (loc));
+	SourceLocation include_loc = sm.getIncludeLoc (file_id);
+
+	while (include_loc.isValid () &&
+	       sm.getFileID (include_loc) != sm.getMainFileID ()) {
+		file_id = sm.getFileID (include_loc);
+		include_loc = sm.getIncludeLoc (file_id);
+	}
+
+	if (include_loc.isInvalid ()) {
+		return "";
+	}
+
+	const FileEntry *entry = sm.getFileEntryForID (file_id);
+	if (entry == NULL) {
+		return "";
+	}
+
+	return std::string (entry->getName ());
+}
+
+void
+GirAttributesHeaderGenerator::_handle_function_decl (FunctionDecl& func)
+{
+	StorageClass sc = func.getStorageClass ();
+	if (sc != SC_None && sc != SC_Extern)
+		return;
+
+	const std::string func_name = func.getNameAsString ();
+
+	if (this->_seen_functions.find (func_name) !=
+	    this->_seen_functions.end ())
+		return;
+	this->_seen_functions.insert (func_name);
+
+	/* Only functions declared in headers can be redeclared in the
+	 * generated header. */
+	ASTContext& context = func.getASTContext ();
+	std::string header =
+		_get_top_level_header (context.getSourceManager (),
+		                       func.getLocation ());
+	if (header.empty ())
+		return;
+
+	GIBaseInfo *info = this->_gir_manager.get ()->find_function_info (func_name);
+	GirFunctionAttributes attrs;
+	bool valid;
+
+	if (info != NULL) {
+		valid = (g_base_info_get_type (info) == GI_INFO_TYPE_FUNCTION &&
+		         _get_function_attributes (func, info, attrs));
+		g_base_info_unref (info);
+	} else {
+		valid = _get_override_attributes (func, func_name,
+		                                  *this->_gir_manager.get (),
+		                                  attrs);
+	}
+
+	if (!valid)
+		return;
+
+	std::string attributes;
+
+	if (attrs.nonnull_args.size () > 0) {
+		attributes += "__nonnull__ (";
+
+		for (std::vector<unsigned int>::const_iterator it = attrs.nonnull_args.begin (),
+		     ie = attrs.nonnull_args.end (); it != ie; ++it) {
+			if (it != attrs.nonnull_args.begin ())
+				attributes += ", ";
+			attributes += std::to_string (*it + 1);
+		}
+
+		attributes += "), ";
+	}
+	if (attrs.malloc)
+		attributes += "__malloc__, ";
+	if (attrs.pure)
+		attributes += "__pure__, ";
+	if (attrs.warn_unused_result)
+		attributes += "__warn_unused_result__, ";
+
+	if (attributes.empty () && !attrs.returns_nonnull)
+		return;
+
+	/* Print the prototype as written, rather than as modified by
+	 * GirAttributesConsumer, so it’s compatible with the original
+	 * declaration. */
+	QualType type = (func.getTypeSourceInfo () != NULL) ?
+		func.getTypeSourceInfo ()->getType () : func.getType ();
+	std::string declaration;
+	llvm::raw_string_ostream out (declaration);
+
+	out << "extern ";
+	type.print (out, context.getPrintingPolicy (), func_name);
+
+	if (!attributes.empty ()) {
+		attributes.resize (attributes.size () - 2);
+		out << " __attribute__ ((" << attributes << "))";
+	}
+	if (attrs.returns_nonnull)
+		out << " TARTAN_RETURNS_NONNULL";
+
+	out << ";";
+	out.flush ();
+
+	if (this->_seen_headers.find (header) == this->_seen_headers.end ()) {
+		this->_seen_headers.insert (header);
+		this->_headers.push_back (header);
+	}
+
+	this->_declarations.push_back (declaration);
+
+	/* GirAttributesConsumer can skip functions whose annotations are
+	 * entirely expressed by the header; but not those whose types it would
+	 * change, or which it would mark as deprecated. */
+	if (attrs.const_args.empty () &&
+	    (!attrs.constify_return || _function_return_type_is_const (func)) &&
+	    (!attrs.deprecated || func.hasAttr<DeprecatedAttr> ())) {
+		this->_covered_symbols.push_back (func_name);
+	}
+}
+
+bool
+GirAttributesHeaderGenerator::HandleTopLevelDecl (DeclGroupRef decl_group)
+{
+	DeclGroupRef::iterator i, e;
+
+	if (this->_options.get ()->attributes_header_output.empty ()) {
+		return true;
+	}
+
 	for (i = decl_group.begin (), e = decl_group.end (); i != e; i++) {
 		Decl *decl = *i;
 		FunctionDecl *func = dyn_cast<FunctionDecl> (decl);
@@ -445,6 +763,86 @@ GirAttributesConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
 	return true;
 }
 
+void
+GirAttributesHeaderGenerator::HandleTranslationUnit (ASTContext& context)
+{
+	const std::string& filename =
+		this->_options.get ()->attributes_header_output;
+
+	if (filename.empty ()) {
+		return;
+	}
+
+	std::string contents;
+	llvm::raw_string_ostream out (contents);
+
+	out << "/* Generated by Tartan " << VERSION << " from GIR data. "
+	       "Do not edit.\n"
+	       " *\n"
+	       " * Force-include this header (for example, using "
+	       "‘-include’) to make the\n"
+	       " * attributes implied by the GIR available to the compiler "
+	       "in normal builds.\n"
+	       " * It includes the headers the functions were originally "
+	       "declared in, and\n"
+	       " * redeclares each function with its attributes.\n"
+	       " *\n"
+	       " * Pass it to Tartan using ‘--attributes-header’ to skip GIR "
+	       "lookups for the\n"
+	       " * following symbols, whose annotations it fully expresses:\n";
+
+	for (std::vector<std::string>::const_iterator it = this->_covered_symbols.begin (),
+	     ie = this->_covered_symbols.end (); it != ie; ++it) {
+		out << " * tartan-covered: " << *it << "\n";
+	}
+
+	out << " */\n"
+	       "\n"
+	       "#ifndef TARTAN_GIR_ATTRIBUTES_GENERATED_H\n"
+	       "#define TARTAN_GIR_ATTRIBUTES_GENERATED_H\n"
+	       "\n"
+	       "#if defined(__GNUC__) || defined(__clang__)\n"
+	       "\n";
+
+	for (std::vector<std::string>::const_iterator it = this->_headers.begin (),
+	     ie = this->_headers.end (); it != ie; ++it) {
+		out << "#include \"" << *it << "\"\n";
+	}
+
+	out << "\n"
+	       "#if defined(__clang__) || __GNUC__ > 4 || "
+	       "(__GNUC__ == 4 && __GNUC_MINOR__ >= 9)\n"
+	       "#define TARTAN_RETURNS_NONNULL "
+	       "__attribute__ ((__returns_nonnull__))\n"
+	       "#else\n"
+	       "#define TARTAN_RETURNS_NONNULL\n"
+	       "#endif\n"
+	       "\n";
+
+	for (std::vector<std::string>::const_iterator it = this->_declarations.begin (),
+	     ie = this->_declarations.end (); it != ie; ++it) {
+		out << *it << "\n";
+	}
+
+	out << "\n"
+	       "#undef TARTAN_RETURNS_NONNULL\n"
+	       "\n"
+	       "#endif /* __GNUC__ || __clang__ */\n"
+	       "\n"
+	       "#endif /* !TARTAN_GIR_ATTRIBUTES_GENERATED_H */\n";
+	out.flush ();
+
+	GError *error = NULL;
+
+	if (!g_file_set_contents (filename.c_str (), contents.c_str (),
+	                          contents.size (), &error)) {
+		Debug::emit_error ("Failed to write GIR attributes header "
+		                   "‘%0’: %1", this->_compiler, SourceLocation ())
+			<< filename
+			<< error->message;
+		g_error_free (error);
+	}
+}
 
 void
 GirAttributesChecker::_handle_function_decl (FunctionDecl& func)
@@ -464,6 +862,17 @@ GirAttributesChecker::_handle_function_decl (FunctionDecl& func)
 	if (info == NULL)
 		return;
 
+	this->_check_function (func, info);
+
+	g_base_info_unref (info);
+}
+
+/* Check the declaration of @func is consistent with its GIR @info. */
+void
+GirAttributesChecker::_check_function (FunctionDecl& func, GIBaseInfo *info)
+{
+	const std::string func_name = func.getNameAsString ();
+
 	/* Extract information from the GIBaseInfo and check AST attributes
 	 * accordingly. */
 	switch (g_base_info_get_type (info)) {
@@ -553,8 +962,6 @@ GirAttributesChecker::_handle_function_decl (FunctionDecl& func)
 		      g_base_info_get_type (info) << " in introspection info "
 		      "for function ‘" << func_name << "’.");
 	}
-
-	g_base_info_unref (info);
 }
 
 bool
@@ -567,6 +974,8 @@ GirAttributesChecker::HandleTopLevelDecl (DeclGroupRef decl_group)
 		return true;
 	}
 
+	bool batch_mode = !this->_options.get ()->check_gir_namespace.empty ();
+
 	for (i = decl_group.begin (), e = decl_group.end (); i != e; i++) {
 		Decl *decl = *i;
 		FunctionDecl *func = dyn_cast<FunctionDecl> (decl);
@@ -575,10 +984,325 @@ GirAttributesChecker::HandleTopLevelDecl (DeclGroupRef decl_group)
 		if (func == NULL)
 			continue;
 
+		/* In batch mode, everything is checked at the end, from the
+		 * GIR side. */
+		if (batch_mode) {
+			if (func->getIdentifier () != NULL) {
+				this->_function_decls.insert (std::make_pair (
+					func->getNameAsString (), func));
+			}
+
+			continue;
+		}
+
+		if (!this->_options.get ()->decl_is_in_scope (*func))
+			continue;
+
 		this->_handle_function_decl (*func);
 	}
 
 	return true;
 }
 
+/* In batch mode, check a function from the GIR namespace against its
+ * declaration. Returns false if it isn’t declared in the translation unit. */
+bool
+GirAttributesChecker::_check_gir_function (GIFunctionInfo *info)
+{
+	const char *symbol = g_function_info_get_symbol (info);
+	std::unordered_map<std::string, FunctionDecl *>::const_iterator it =
+		this->_function_decls.find (symbol);
+
+	if (it == this->_function_decls.end ()) {
+		Debug::emit_warning (
+			"Function %0() is in GIR namespace ‘%1’ but is not "
+			"declared in its headers.",
+			this->_compiler,
+			SourceLocation ())
+		<< symbol
+		<< this->_options.get ()->check_gir_namespace;
+
+		return false;
+	}
+
+	this->_check_function (*it->second, info);
+
+	return true;
+}
+
+/* Find the definition of the class (or interface) structure of @info, an
+ * object or interface, in the translation unit. Returns %NULL if it has none,
+ * or it isn’t defined. */
+const RecordDecl*
+GirAttributesChecker::_find_class_struct (GIBaseInfo *info,
+                                          ASTContext& context)
+{
+	GIStructInfo *struct_info;
+
+	if (g_base_info_get_type (info) == GI_INFO_TYPE_OBJECT) {
+		struct_info = g_object_info_get_class_struct (info);
+	} else {
+		struct_info = g_interface_info_get_iface_struct (info);
+	}
+
+	if (struct_info == NULL) {
+		return NULL;
+	}
+
+	const std::string struct_name =
+		this->_gir_manager.get ()->get_c_name_for_type (struct_info);
+	g_base_info_unref (struct_info);
+
+	TypeManager manager = TypeManager (context);
+	QualType struct_type = manager.find_type_by_name (struct_name);
+
+	if (struct_type.isNull ()) {
+		return NULL;
+	}
+
+	const RecordType *record_type = struct_type->getAsStructureType ();
+
+	return (record_type != NULL) ?
+		record_type->getDecl ()->getDefinition () : NULL;
+}
+
+/* In batch mode, check that the default handler for @signal_info in the
+ * @class_struct of the object or interface emitting it takes the instance and
+ * the signal’s arguments, and returns a value iff the signal does. Signals
+ * without a default handler field are skipped. */
+void
+GirAttributesChecker::_check_gir_signal (GISignalInfo *signal_info,
+                                         const RecordDecl& class_struct)
+{
+	std::string field_name (g_base_info_get_name (signal_info));
+	std::replace (field_name.begin (), field_name.end (), '-', '_');
+
+	for (RecordDecl::field_iterator it = class_struct.field_begin (),
+	     ie = class_struct.field_end (); it != ie; ++it) {
+		if ((*it)->getName () != field_name) {
+			continue;
+		}
+
+		QualType field_type = (*it)->getType ();
+		const FunctionProtoType *handler_type = NULL;
+
+		if (field_type->isPointerType ()) {
+			handler_type =
+				field_type->getPointeeType ()->getAs<FunctionProtoType> ();
+		}
+
+		if (handler_type == NULL) {
+			/* Not a default handler. */
+			return;
+		}
+
+#ifdef HAVE_LLVM_3_5
+		unsigned int n_handler_params = handler_type->getNumParams ();
+		QualType handler_return_type = handler_type->getReturnType ();
+#else /* if !HAVE_LLVM_3_5 */
+		unsigned int n_handler_params = handler_type->getNumArgs ();
+		QualType handler_return_type = handler_type->getResultType ();
+#endif /* !HAVE_LLVM_3_5 */
+
+		/* Including the instance. */
+		unsigned int n_signal_params =
+			g_callable_info_get_n_args (signal_info) + 1;
+
+		GITypeInfo return_type_info;
+		g_callable_info_load_return_type (signal_info,
+		                                  &return_type_info);
+		bool signal_returns_void =
+			(g_type_info_get_tag (&return_type_info) ==
+			 GI_TYPE_TAG_VOID &&
+			 !g_type_info_is_pointer (&return_type_info));
+
+		if (n_handler_params != n_signal_params) {
+			Debug::emit_error (
+				"Default handler %0 in %1 takes %2 parameters, "
+				"but signal ‘%3’ has %4 (including the "
+				"instance) in the GIR.",
+				this->_compiler,
+				(*it)->getLocStart ())
+			<< field_name
+			<< class_struct.getNameAsString ()
+			<< n_handler_params
+			<< g_base_info_get_name (signal_info)
+			<< n_signal_params;
+		} else if (handler_return_type->isVoidType () !=
+		           signal_returns_void) {
+			Debug::emit_error (
+				"Default handler %0 in %1 %2, but signal ‘%3’ "
+				"%4 in the GIR.",
+				this->_compiler,
+				(*it)->getLocStart ())
+			<< field_name
+			<< class_struct.getNameAsString ()
+			<< (signal_returns_void ? "returns a value" :
+			                          "returns void")
+			<< g_base_info_get_name (signal_info)
+			<< (signal_returns_void ? "returns void" :
+			                          "returns a value");
+		}
+
+		return;
+	}
+}
+
+/* In batch mode, check that the getter for @property_info of @info (an object
+ * or interface), if one is declared, returns a pointer iff the property’s type
+ * is a pointer. */
+void
+GirAttributesChecker::_check_gir_property (GIBaseInfo *info,
+                                           GIPropertyInfo *property_info)
+{
+	std::string getter_name =
+		"get_" + std::string (g_base_info_get_name (property_info));
+	std::replace (getter_name.begin (), getter_name.end (), '-', '_');
+
+	GIFunctionInfo *getter_info;
+
+	if (g_base_info_get_type (info) == GI_INFO_TYPE_OBJECT) {
+		getter_info = g_object_info_find_method (info,
+		                                         getter_name.c_str ());
+	} else {
+		getter_info = g_interface_info_find_method (info,
+		                                            getter_name.c_str ());
+	}
+
+	if (getter_info == NULL) {
+		return;
+	}
+
+	std::unordered_map<std::string, FunctionDecl *>::const_iterator it =
+		this->_function_decls.find (g_function_info_get_symbol (getter_info));
+	g_base_info_unref (getter_info);
+
+	/* The getter must take only the instance. */
+	if (it == this->_function_decls.end () ||
+	    it->second->getNumParams () != 1) {
+		return;
+	}
+
+	FunctionDecl& getter = *it->second;
+	GITypeInfo *property_type_info = g_property_info_get_type (property_info);
+	bool property_is_pointer = g_type_info_is_pointer (property_type_info);
+	g_base_info_unref (property_type_info);
+
+#ifdef HAVE_LLVM_3_5
+	QualType return_type = getter.getReturnType ();
+#else /* if !HAVE_LLVM_3_5 */
+	QualType return_type = getter.getResultType ();
+#endif /* !HAVE_LLVM_3_5 */
+
+	if (return_type->isPointerType () != property_is_pointer) {
+		Debug::emit_error (
+			"Return type of %0() does not match property ‘%1’, "
+			"which it gets: %2 is a pointer.",
+			this->_compiler,
+			getter.getLocStart ())
+		<< getter.getNameAsString ()
+		<< g_base_info_get_name (property_info)
+		<< (property_is_pointer ? "only the property" :
+		                          "only the return type");
+	}
+}
+
+/* In batch mode, check every function, method, signal and property in the
+ * GIR namespace against the declarations in the translation unit, which should
+ * include all the library’s public headers. Each header is therefore checked
+ * once, rather than by every translation unit which includes it, and symbols
+ * in headers which no translation unit includes are checked too. */
+void
+GirAttributesChecker::HandleTranslationUnit (ASTContext& context)
+{
+	const std::string& nspace = this->_options.get ()->check_gir_namespace;
+
+	if (!this->is_enabled () || nspace.empty ()) {
+		return;
+	}
+
+	const GirManager *gir_manager = this->_gir_manager.get ();
+	unsigned int n_infos = gir_manager->get_n_infos (nspace);
+	unsigned int n_functions = 0, n_signals = 0, n_properties = 0;
+	unsigned int n_undeclared = 0;
+
+	if (n_infos == 0) {
+		Debug::emit_error ("GIR namespace ‘%0’ is not loaded, or is "
+		                   "empty.", this->_compiler, SourceLocation ())
+		<< nspace;
+		return;
+	}
+
+	for (unsigned int i = 0; i < n_infos; i++) {
+		GIBaseInfo *info = gir_manager->get_info (nspace, i);
+		GIInfoType type = g_base_info_get_type (info);
+
+		if (type == GI_INFO_TYPE_FUNCTION) {
+			n_functions++;
+			n_undeclared += this->_check_gir_function (info) ? 0 : 1;
+		}
+
+		gint n_methods = GirManager::get_n_methods (info);
+
+		for (gint j = 0; j < n_methods; j++) {
+			GIFunctionInfo *method = GirManager::get_method (info, j);
+
+			n_functions++;
+			n_undeclared += this->_check_gir_function (method) ? 0 : 1;
+			g_base_info_unref (method);
+		}
+
+		if (type != GI_INFO_TYPE_OBJECT &&
+		    type != GI_INFO_TYPE_INTERFACE) {
+			g_base_info_unref (info);
+			continue;
+		}
+
+		bool is_object = (type == GI_INFO_TYPE_OBJECT);
+		const RecordDecl *class_struct =
+			this->_find_class_struct (info, context);
+		gint n = is_object ? g_object_info_get_n_signals (info) :
+		                     g_interface_info_get_n_signals (info);
+
+		for (gint j = 0; j < n; j++) {
+			GISignalInfo *signal_info = is_object ?
+				g_object_info_get_signal (info, j) :
+				g_interface_info_get_signal (info, j);
+
+			n_signals++;
+
+			if (class_struct != NULL) {
+				this->_check_gir_signal (signal_info,
+				                         *class_struct);
+			}
+
+			g_base_info_unref (signal_info);
+		}
+
+		n = is_object ? g_object_info_get_n_properties (info) :
+		                g_interface_info_get_n_properties (info);
+
+		for (gint j = 0; j < n; j++) {
+			GIPropertyInfo *property_info = is_object ?
+				g_object_info_get_property (info, j) :
+				g_interface_info_get_property (info, j);
+
+			n_properties++;
+			this->_check_gir_property (info, property_info);
+			g_base_info_unref (property_info);
+		}
+
+		g_base_info_unref (info);
+	}
+
+	Debug::emit_remark ("Checked %0 functions (%1 not declared), %2 "
+	                    "signals and %3 properties in GIR namespace "
+	                    "‘%4’.", this->_compiler, SourceLocation ())
+	<< n_functions
+	<< n_undeclared
+	<< n_signals
+	<< n_properties
+	<< nspace;
+}
+
 } /* namespace tartan */
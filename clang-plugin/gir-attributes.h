@@ -23,7 +23,10 @@
 #ifndef TARTAN_GIR_ATTRIBUTES_H
 #define TARTAN_GIR_ATTRIBUTES_H
 
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <clang/AST/AST.h>
 #include <clang/AST/ASTConsumer.h>
@@ -33,6 +36,7 @@
 
 #include "checker.h"
 #include "gir-manager.h"
+#include "plugin-options.h"
 
 namespace tartan {
 
@@ -42,17 +46,57 @@ class GirAttributesConsumer : public clang::ASTConsumer {
 
 public:
 	explicit GirAttributesConsumer (
-		std::shared_ptr<const GirManager> gir_manager) :
-		_gir_manager (gir_manager) {}
+		std::shared_ptr<const GirManager> gir_manager,
+		std::shared_ptr<const PluginOptions> options) :
+		_gir_manager (gir_manager), _options (options) {}
 
 private:
 	std::shared_ptr<const GirManager> _gir_manager;
+	std::shared_ptr<const PluginOptions> _options;
 
 	void _handle_function_decl (FunctionDecl& func);
 public:
 	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
 };
 
+/* Generates a header of redeclarations of the functions declared in the
+ * translation unit, carrying the attributes which GirAttributesConsumer would
+ * add. Enabled by --generate-attributes-header.
+ *
+ * The header only covers a single translation unit, and is overwritten by the
+ * next one, so it is not meant to be generated during a normal build.
+ * Instead, as for --check-gir-namespace, run Tartan once on a translation unit
+ * which includes all the headers of interest (such as a library’s public
+ * headers), and force-include the result in later builds. */
+class GirAttributesHeaderGenerator : public clang::ASTConsumer {
+
+public:
+	explicit GirAttributesHeaderGenerator (
+		CompilerInstance& compiler,
+		std::shared_ptr<const GirManager> gir_manager,
+		std::shared_ptr<const PluginOptions> options) :
+		_compiler (compiler), _gir_manager (gir_manager),
+		_options (options) {}
+
+private:
+	CompilerInstance& _compiler;
+	std::shared_ptr<const GirManager> _gir_manager;
+	std::shared_ptr<const PluginOptions> _options;
+
+	/* Headers directly included by the main file, in order of first use;
+	 * and the redeclarations to emit. */
+	std::vector<std::string> _headers;
+	std::unordered_set<std::string> _seen_headers;
+	std::unordered_set<std::string> _seen_functions;
+	std::vector<std::string> _declarations;
+	std::vector<std::string> _covered_symbols;
+
+	void _handle_function_decl (FunctionDecl& func);
+public:
+	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
+	virtual void HandleTranslationUnit (ASTContext& context);
+};
+
 
 class GirAttributesChecker : public tartan::ASTChecker {
 
@@ -60,13 +104,27 @@ public:
 	explicit GirAttributesChecker (
 		CompilerInstance& compiler,
 		std::shared_ptr<const GirManager> gir_manager,
-		std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins) :
-		ASTChecker (compiler, gir_manager, disabled_plugins) {}
+		std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins,
+		std::shared_ptr<const PluginOptions> options) :
+		ASTChecker (compiler, gir_manager, disabled_plugins, options) {}
 
 private:
+	/* In batch mode (--check-gir-namespace), the function declarations
+	 * in the translation unit, keyed by symbol. */
+	std::unordered_map<std::string, FunctionDecl *> _function_decls;
+
 	void _handle_function_decl (FunctionDecl& func);
+	void _check_function (FunctionDecl& func, GIBaseInfo *info);
+	bool _check_gir_function (GIFunctionInfo *info);
+	void _check_gir_signal (GISignalInfo *signal_info,
+	                        const RecordDecl& class_struct);
+	void _check_gir_property (GIBaseInfo *info,
+	                          GIPropertyInfo *property_info);
+	const RecordDecl* _find_class_struct (GIBaseInfo *info,
+	                                      ASTContext& context);
 public:
 	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
+	virtual void HandleTranslationUnit (ASTContext& context);
 	const std::string get_name () const { return "gir-attributes"; }
 };
 
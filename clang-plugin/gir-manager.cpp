@@ -20,6 +20,13 @@
  *     Philip Withnall <philip.withnall@collabora.co.uk>
  */
 
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
 #include <girepository.h>
 #include <gitypes.h>
 
@@ -38,6 +45,14 @@ GirManager::load_namespace (const std::string& gi_namespace,
                             const std::string& gi_version,
                             GError** error)
 {
+	/* Namespaces loaded from a .gir file using load_gir_file() take
+	 * precedence over installed typelibs. */
+	for (std::vector<Nspace>::const_iterator it = this->_typelibs.begin (),
+	     ie = this->_typelibs.end (); it != ie; ++it) {
+		if ((*it).nspace == gi_namespace)
+			return;
+	}
+
 	/* Load the GIR typelib. */
 	GITypelib* typelib = g_irepository_require (this->_repo,
 	                                            gi_namespace.c_str (),
@@ -48,6 +63,14 @@ GirManager::load_namespace (const std::string& gi_namespace,
 	if (typelib == NULL)
 		return;
 
+	this->_add_typelib (gi_namespace, gi_version, typelib);
+}
+
+void
+GirManager::_add_typelib (const std::string& gi_namespace,
+                          const std::string& gi_version,
+                          GITypelib* typelib)
+{
 	/* Get the C prefix from the repository and convert it to lower case. */
 	const char *c_prefix =
 		g_irepository_get_c_prefix (this->_repo,
@@ -62,6 +85,7 @@ GirManager::load_namespace (const std::string& gi_namespace,
 	r.c_prefix = std::string (c_prefix);
 	r.c_prefix_lower = std::string (c_prefix);
 	r.typelib = typelib;
+	r.index = std::make_shared<SymbolIndex> ();
 
 	std::transform (r.c_prefix_lower.begin (), r.c_prefix_lower.end (),
 	                r.c_prefix_lower.begin (), ::tolower);
@@ -69,95 +93,526 @@ GirManager::load_namespace (const std::string& gi_namespace,
 	this->_typelibs.push_back (r);
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_function (GIFunctionInfo *info, const std::string &func_name)
+/* State for the streaming parse of a .gir file. Only the namespace name and
+ * version, and the deprecation details which g-ir-compiler drops, are
+ * extracted; everything else comes from the compiled typelib. */
+typedef struct {
+	std::string nspace;
+	std::string version;
+
+	/* The callable currently being parsed (any element with a
+	 * c:identifier), or empty. */
+	std::string element_name;
+	std::string symbol;
+	bool deprecated;
+	bool in_doc_deprecated;
+	std::string message;
+	std::string deprecated_version;
+
+	std::unordered_map<std::string, GirManager::Deprecation>* deprecations;
+} GirParseData;
+
+static const gchar *
+_get_attribute (const gchar **attribute_names,
+                const gchar **attribute_values,
+                const gchar *name)
 {
-	if (g_function_info_get_symbol (info) == func_name) {
-		return g_base_info_ref (info);
+	for (guint i = 0; attribute_names[i] != NULL; i++) {
+		if (strcmp (attribute_names[i], name) == 0)
+			return attribute_values[i];
 	}
 
 	return NULL;
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_struct (GIStructInfo *info, const std::string &func_name)
+static void
+_gir_start_element (GMarkupParseContext *context,
+                    const gchar *element_name,
+                    const gchar **attribute_names,
+                    const gchar **attribute_values,
+                    gpointer user_data,
+                    GError **error)
 {
-	GIFunctionInfo *f_info = NULL;
-	gint n_methods = g_struct_info_get_n_methods (info);
+	GirParseData *data = (GirParseData *) user_data;
 
-	for (gint i = 0; i < n_methods && f_info == NULL; i++) {
-		GIFunctionInfo *_info = g_struct_info_get_method (info, i);
-		f_info = _find_function_in_function (_info, func_name);
-		g_base_info_unref (_info);
+	if (strcmp (element_name, "namespace") == 0) {
+		const gchar *name = _get_attribute (attribute_names,
+		                                    attribute_values, "name");
+		const gchar *version = _get_attribute (attribute_names,
+		                                       attribute_values,
+		                                       "version");
+
+		if (name != NULL && data->nspace.empty ())
+			data->nspace = name;
+		if (version != NULL && data->version.empty ())
+			data->version = version;
+
+		return;
 	}
 
-	return f_info;
+	if (strcmp (element_name, "doc-deprecated") == 0) {
+		data->in_doc_deprecated = !data->symbol.empty ();
+		return;
+	}
+
+	const gchar *symbol = _get_attribute (attribute_names,
+	                                      attribute_values,
+	                                      "c:identifier");
+	if (symbol == NULL || !data->symbol.empty ())
+		return;
+
+	const gchar *deprecated = _get_attribute (attribute_names,
+	                                          attribute_values,
+	                                          "deprecated");
+	const gchar *deprecated_version = _get_attribute (attribute_names,
+	                                                  attribute_values,
+	                                                  "deprecated-version");
+
+	data->element_name = element_name;
+	data->symbol = symbol;
+	data->deprecated = (deprecated != NULL &&
+	                    strcmp (deprecated, "0") != 0);
+	data->message.clear ();
+	data->deprecated_version = (deprecated_version != NULL) ?
+		deprecated_version : "";
+
+	/* Older GIR files put the deprecation message in the attribute. */
+	if (data->deprecated && strcmp (deprecated, "1") != 0)
+		data->message = deprecated;
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_enum (GIEnumInfo *info, const std::string &func_name)
+static void
+_gir_end_element (GMarkupParseContext *context,
+                  const gchar *element_name,
+                  gpointer user_data,
+                  GError **error)
 {
-	GIFunctionInfo *f_info = NULL;
-	gint n_methods = g_enum_info_get_n_methods (info);
+	GirParseData *data = (GirParseData *) user_data;
+
+	if (strcmp (element_name, "doc-deprecated") == 0) {
+		data->in_doc_deprecated = false;
+		return;
+	}
+
+	if (data->symbol.empty () || data->element_name != element_name)
+		return;
+
+	if (data->deprecated) {
+		/* Strip surrounding whitespace from the message. */
+		gchar *message = g_strdup (data->message.c_str ());
+		g_strstrip (message);
 
-	for (gint i = 0; i < n_methods && f_info == NULL; i++) {
-		GIFunctionInfo *_info = g_enum_info_get_method (info, i);
-		f_info = _find_function_in_function (_info, func_name);
-		g_base_info_unref (_info);
+		GirManager::Deprecation d;
+		d.message = message;
+		d.version = data->deprecated_version;
+		(*data->deprecations)[data->symbol] = d;
+
+		g_free (message);
 	}
 
-	return f_info;
+	data->element_name.clear ();
+	data->symbol.clear ();
+}
+
+static void
+_gir_text (GMarkupParseContext *context,
+           const gchar *text,
+           gsize text_len,
+           gpointer user_data,
+           GError **error)
+{
+	GirParseData *data = (GirParseData *) user_data;
+
+	if (data->in_doc_deprecated)
+		data->message.append (text, text_len);
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_object (GIObjectInfo *info, const std::string &func_name)
+static const GMarkupParser _gir_parser = {
+	_gir_start_element,
+	_gir_end_element,
+	_gir_text,
+	NULL,
+	NULL,
+};
+
+/* Returns %TRUE if @typelib_filename exists and is at least as new as
+ * @gir_filename. */
+static bool
+_typelib_is_up_to_date (const std::string& gir_filename,
+                        const std::string& typelib_filename)
 {
-	GIFunctionInfo *f_info = NULL;
-	gint n_methods = g_object_info_get_n_methods (info);
+	GStatBuf gir_stat, typelib_stat;
 
-	for (gint i = 0; i < n_methods && f_info == NULL; i++) {
-		GIFunctionInfo *_info = g_object_info_get_method (info, i);
-		f_info = _find_function_in_function (_info, func_name);
-		g_base_info_unref (_info);
+	return (g_stat (gir_filename.c_str (), &gir_stat) == 0 &&
+	        g_stat (typelib_filename.c_str (), &typelib_stat) == 0 &&
+	        typelib_stat.st_mtime >= gir_stat.st_mtime);
+}
+
+/* Compile @gir_filename to @typelib_filename using g-ir-compiler. Included
+ * GIR files are looked up in the same directory as @gir_filename, as well as
+ * in the system GIR directories, so uninstalled namespaces can include each
+ * other.
+ *
+ * The typelib is compiled to a temporary file which is then renamed into
+ * place, so that parallel builds compiling the same typelib never see (or
+ * load) a partially written one. */
+static bool
+_compile_gir (const std::string& gir_filename,
+              const std::string& typelib_filename,
+              GError** error)
+{
+	gchar *compiler = g_find_program_in_path (G_IR_COMPILER);
+
+	if (compiler == NULL) {
+		g_set_error (error, G_SPAWN_ERROR, G_SPAWN_ERROR_NOENT,
+		             "Could not find %s.", G_IR_COMPILER);
+		return false;
 	}
 
-	return f_info;
+	gchar *tmp_filename = g_strconcat (typelib_filename.c_str (),
+	                                   ".XXXXXX", NULL);
+	gint fd = g_mkstemp (tmp_filename);
+
+	if (fd < 0) {
+		int errsv = errno;
+
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "Failed to create ‘%s’: %s", tmp_filename,
+		             g_strerror (errsv));
+		g_free (tmp_filename);
+		g_free (compiler);
+
+		return false;
+	}
+
+	g_close (fd, NULL);
+
+	gchar *include_dir = g_path_get_dirname (gir_filename.c_str ());
+	const gchar *argv[] = {
+		compiler,
+		"--includedir", include_dir,
+		"--output", tmp_filename,
+		gir_filename.c_str (),
+		NULL,
+	};
+	gchar *error_output = NULL;
+	gint exit_status;
+	bool retval;
+
+	DEBUG ("Compiling " << gir_filename << " to " << typelib_filename);
+
+	retval = (g_spawn_sync (NULL, (gchar **) argv, NULL,
+	                        G_SPAWN_STDOUT_TO_DEV_NULL, NULL, NULL, NULL,
+	                        &error_output, &exit_status, error) &&
+	          g_spawn_check_exit_status (exit_status, error));
+
+	if (!retval && error_output != NULL && *error_output != '\0') {
+		g_prefix_error (error, "%s", error_output);
+	}
+
+	/* g_mkstemp() creates the file readable only by the user. */
+	if (retval &&
+	    (g_chmod (tmp_filename, 0644) != 0 ||
+	     g_rename (tmp_filename, typelib_filename.c_str ()) != 0)) {
+		int errsv = errno;
+
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "Failed to rename ‘%s’ to ‘%s’: %s", tmp_filename,
+		             typelib_filename.c_str (), g_strerror (errsv));
+		retval = false;
+	}
+
+	if (!retval) {
+		g_unlink (tmp_filename);
+	}
+
+	g_free (error_output);
+	g_free (include_dir);
+	g_free (tmp_filename);
+	g_free (compiler);
+
+	return retval;
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_interface (GIInterfaceInfo *info, const std::string &func_name)
+/* Parse @gir_filename into @data. The file is read and fed to the parser in
+ * chunks, rather than being loaded into memory all at once, and its contents
+ * are added to @checksum as they’re read. */
+static bool
+_parse_gir_file (const std::string& gir_filename, GirParseData *data,
+                 GChecksum *checksum, GError** error)
 {
-	GIFunctionInfo *f_info = NULL;
-	gint n_methods = g_interface_info_get_n_methods (info);
+	FILE *file = g_fopen (gir_filename.c_str (), "rb");
+
+	if (file == NULL) {
+		int errsv = errno;
 
-	for (gint i = 0; i < n_methods && f_info == NULL; i++) {
-		GIFunctionInfo *_info = g_interface_info_get_method (info, i);
-		f_info = _find_function_in_function (_info, func_name);
-		g_base_info_unref (_info);
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "Failed to open ‘%s’: %s", gir_filename.c_str (),
+		             g_strerror (errsv));
+		return false;
 	}
 
-	return f_info;
+	GMarkupParseContext *context =
+		g_markup_parse_context_new (&_gir_parser,
+		                            (GMarkupParseFlags) 0, data,
+		                            NULL);
+	gchar buffer[16384];
+	size_t n_read;
+	bool parsed = true;
+
+	while (parsed &&
+	       (n_read = fread (buffer, 1, sizeof (buffer), file)) > 0) {
+		g_checksum_update (checksum, (const guchar *) buffer, n_read);
+		parsed = g_markup_parse_context_parse (context, buffer, n_read,
+		                                       error);
+	}
+
+	if (parsed && ferror (file)) {
+		g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_IO,
+		             "Failed to read ‘%s’.", gir_filename.c_str ());
+		parsed = false;
+	}
+
+	parsed = parsed && g_markup_parse_context_end_parse (context, error);
+
+	g_markup_parse_context_free (context);
+	fclose (file);
+
+	return parsed;
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_union (GIUnionInfo *info, const std::string &func_name)
+/* Load a namespace from a .gir file, such as one generated earlier in the same
+ * build for a library which hasn’t yet been installed. The file is compiled
+ * to a typelib, which is cached next to it (or in the user cache directory if
+ * that isn’t writeable) and then looked up exactly like an installed typelib.
+ * The .gir file itself is only parsed for the deprecation messages and
+ * versions which typelibs don’t contain.
+ *
+ * The user cache directory is shared between projects, so typelibs there are
+ * keyed on a checksum of the .gir file’s absolute path and contents, rather
+ * than only on its namespace and version.
+ *
+ * This must be called before any other version of the same namespace is
+ * loaded using load_namespace(). */
+void
+GirManager::load_gir_file (const std::string& gir_filename,
+                           GError** error)
 {
-	GIFunctionInfo *f_info = NULL;
-	gint n_methods = g_union_info_get_n_methods (info);
+	GirParseData data;
+	data.deprecated = false;
+	data.in_doc_deprecated = false;
+	data.deprecations = &this->_deprecations;
 
-	for (gint i = 0; i < n_methods && f_info == NULL; i++) {
-		GIFunctionInfo *_info = g_union_info_get_method (info, i);
-		f_info = _find_function_in_function (_info, func_name);
-		g_base_info_unref (_info);
+	gchar *absolute_filename;
+
+	if (g_path_is_absolute (gir_filename.c_str ())) {
+		absolute_filename = g_strdup (gir_filename.c_str ());
+	} else {
+		gchar *cwd = g_get_current_dir ();
+		absolute_filename = g_build_filename (cwd,
+		                                      gir_filename.c_str (),
+		                                      NULL);
+		g_free (cwd);
+	}
+
+	/* Include the nul terminator to separate the path from the
+	 * contents. */
+	GChecksum *checksum = g_checksum_new (G_CHECKSUM_SHA1);
+	g_checksum_update (checksum, (const guchar *) absolute_filename,
+	                   strlen (absolute_filename) + 1);
+	g_free (absolute_filename);
+
+	bool parsed = _parse_gir_file (gir_filename, &data, checksum, error);
+	std::string gir_checksum = g_checksum_get_string (checksum);
+
+	g_checksum_free (checksum);
+
+	if (!parsed)
+		return;
+
+	if (data.nspace.empty () || data.version.empty ()) {
+		g_set_error (error, G_MARKUP_ERROR,
+		             G_MARKUP_ERROR_MISSING_ATTRIBUTE,
+		             "No namespace name or version in GIR file.");
+		return;
+	}
+
+	/* Find or build the compiled typelib. A cached typelib with the right
+	 * checksum can’t be stale. */
+	std::string typelib_basename =
+		data.nspace + "-" + data.version + ".typelib";
+	std::string cached_typelib_basename =
+		data.nspace + "-" + data.version + "-" + gir_checksum +
+		".typelib";
+	gchar *gir_dir = g_path_get_dirname (gir_filename.c_str ());
+	gchar *cache_dir = g_build_filename (g_get_user_cache_dir (),
+	                                     "tartan", NULL);
+	gchar *local_typelib = g_build_filename (gir_dir,
+	                                         typelib_basename.c_str (),
+	                                         NULL);
+	gchar *cached_typelib = g_build_filename (cache_dir,
+	                                          cached_typelib_basename.c_str (),
+	                                          NULL);
+	std::string typelib_filename;
+
+	if (_typelib_is_up_to_date (gir_filename, local_typelib)) {
+		typelib_filename = local_typelib;
+	} else if (g_file_test (cached_typelib, G_FILE_TEST_EXISTS)) {
+		typelib_filename = cached_typelib;
+	} else if (_compile_gir (gir_filename, local_typelib, NULL)) {
+		typelib_filename = local_typelib;
+	} else if (g_mkdir_with_parents (cache_dir, 0755) == 0 &&
+	           _compile_gir (gir_filename, cached_typelib, error)) {
+		typelib_filename = cached_typelib;
+	}
+
+	g_free (cached_typelib);
+	g_free (local_typelib);
+	g_free (cache_dir);
+	g_free (gir_dir);
+
+	if (typelib_filename.empty ()) {
+		if (error != NULL && *error == NULL) {
+			g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+			             "Could not create typelib cache "
+			             "directory.");
+		}
+
+		return;
 	}
 
-	return f_info;
+	/* Load it into the repository. The typelib takes its own reference
+	 * to the mapped file. */
+	GMappedFile *mapped_file = g_mapped_file_new (typelib_filename.c_str (),
+	                                              FALSE, error);
+	if (mapped_file == NULL)
+		return;
+
+	GITypelib *typelib = g_typelib_new_from_mapped_file (mapped_file,
+	                                                     error);
+	g_mapped_file_unref (mapped_file);
+
+	if (typelib == NULL)
+		return;
+
+	if (g_irepository_load_typelib (this->_repo, typelib,
+	                                (GIRepositoryLoadFlags) 0,
+	                                error) == NULL) {
+		g_typelib_free (typelib);
+		return;
+	}
+
+	this->_add_typelib (data.nspace, data.version, typelib);
+}
+
+/* Number of methods of @info, which may be any type of info. */
+gint
+GirManager::get_n_methods (GIBaseInfo *info)
+{
+	switch (g_base_info_get_type (info)) {
+	case GI_INFO_TYPE_STRUCT:
+		return g_struct_info_get_n_methods (info);
+	case GI_INFO_TYPE_ENUM:
+		return g_enum_info_get_n_methods (info);
+	case GI_INFO_TYPE_OBJECT:
+		return g_object_info_get_n_methods (info);
+	case GI_INFO_TYPE_INTERFACE:
+		return g_interface_info_get_n_methods (info);
+	case GI_INFO_TYPE_UNION:
+		return g_union_info_get_n_methods (info);
+	case GI_INFO_TYPE_INVALID:
+	case GI_INFO_TYPE_FUNCTION:
+	case GI_INFO_TYPE_CALLBACK:
+	case GI_INFO_TYPE_BOXED:
+	case GI_INFO_TYPE_FLAGS:
+	case GI_INFO_TYPE_CONSTANT:
+	case GI_INFO_TYPE_INVALID_0:
+	case GI_INFO_TYPE_VALUE:
+	case GI_INFO_TYPE_SIGNAL:
+	case GI_INFO_TYPE_VFUNC:
+	case GI_INFO_TYPE_PROPERTY:
+	case GI_INFO_TYPE_FIELD:
+	case GI_INFO_TYPE_ARG:
+	case GI_INFO_TYPE_TYPE:
+	case GI_INFO_TYPE_UNRESOLVED:
+	default:
+		/* Doesn’t have methods. */
+		return 0;
+	}
+}
+
+/* Returns a reference to method @n of @info, which must have been counted by
+ * get_n_methods(). */
+GIFunctionInfo *
+GirManager::get_method (GIBaseInfo *info, gint n)
+{
+	switch (g_base_info_get_type (info)) {
+	case GI_INFO_TYPE_STRUCT:
+		return g_struct_info_get_method (info, n);
+	case GI_INFO_TYPE_ENUM:
+		return g_enum_info_get_method (info, n);
+	case GI_INFO_TYPE_OBJECT:
+		return g_object_info_get_method (info, n);
+	case GI_INFO_TYPE_INTERFACE:
+		return g_interface_info_get_method (info, n);
+	case GI_INFO_TYPE_UNION:
+		return g_union_info_get_method (info, n);
+	default:
+		g_assert_not_reached ();
+		return NULL;
+	}
+}
+
+/* Get the symbol index for namespace @r, building it if this is the first
+ * lookup in the namespace. This walks every info in the namespace once;
+ * previously every lookup did, constructing (and freeing) an info for each
+ * entry and each of its methods. The first function in the namespace with a
+ * given symbol wins, as it did then. */
+const GirManager::SymbolIndex*
+GirManager::_get_symbol_index (const Nspace& r) const
+{
+	SymbolIndex *index = r.index.get ();
+
+	if (!g_once_init_enter (&index->built)) {
+		return index;
+	}
+
+	guint n_infos = g_irepository_get_n_infos (this->_repo,
+	                                           r.nspace.c_str ());
+
+	for (guint i = 0; i < n_infos; i++) {
+		GIBaseInfo *info = g_irepository_get_info (this->_repo,
+		                                           r.nspace.c_str (),
+		                                           i);
+
+		if (g_base_info_get_type (info) == GI_INFO_TYPE_FUNCTION) {
+			SymbolIndex::Location location = { i, -1 };
+			index->functions.insert (std::make_pair (
+				std::string (g_function_info_get_symbol (info)),
+				location));
+		}
+
+		gint n_methods = GirManager::get_n_methods (info);
+
+		for (gint j = 0; j < n_methods; j++) {
+			GIFunctionInfo *method = GirManager::get_method (info, j);
+			SymbolIndex::Location location = { i, j };
+
+			index->functions.insert (std::make_pair (
+				std::string (g_function_info_get_symbol (method)),
+				location));
+			g_base_info_unref (method);
+		}
+
+		g_base_info_unref (info);
+	}
+
+	DEBUG ("Indexed " << index->functions.size () << " functions in " <<
+	       r.nspace);
+
+	g_once_init_leave (&index->built, 1);
+
+	return index;
 }
 
 /* Try to find typelib information about the function.
@@ -170,7 +625,7 @@ GirManager::find_function_info (const std::string& func_name) const
 
 	for (std::vector<Nspace>::const_iterator it = this->_typelibs.begin (),
 	     ie = this->_typelibs.end (); it != ie && info == NULL; ++it) {
-		const Nspace r = *it;
+		const Nspace &r = *it;
 
 		/* Check the function matches this namespace.
 		 * e.g. g_irepository_find_by_name →
@@ -183,69 +638,31 @@ GirManager::find_function_info (const std::string& func_name) const
 			continue;
 		}
 
-		/* Iterate through every info in the namespace, trying to match
-		 * the entire @func_name against the info, or one of the methods
-		 * it contains. */
-		guint n_infos = g_irepository_get_n_infos (this->_repo,
-		                                           r.nspace.c_str ());
-
-		for (guint i = 0; i < n_infos && info == NULL; i++) {
-			GIBaseInfo *_info;
-
-			_info = g_irepository_get_info (this->_repo,
-			                                r.nspace.c_str (), i);
-
-			switch (g_base_info_get_type (_info)) {
-			case GI_INFO_TYPE_FUNCTION:
-				info = _find_function_in_function (_info,
-				                                   func_name);
-				break;
-			case GI_INFO_TYPE_STRUCT:
-				info = _find_function_in_struct (_info,
-				                                 func_name);
-				break;
-			case GI_INFO_TYPE_ENUM:
-				info = _find_function_in_enum (_info,
-				                               func_name);
-				break;
-			case GI_INFO_TYPE_OBJECT:
-				info = _find_function_in_object (_info,
-				                                 func_name);
-				break;
-			case GI_INFO_TYPE_INTERFACE:
-				info = _find_function_in_interface (_info,
-				                                    func_name);
-				break;
-			case GI_INFO_TYPE_UNION:
-				info = _find_function_in_union (_info,
-				                                func_name);
-				break;
-			case GI_INFO_TYPE_INVALID:
-			case GI_INFO_TYPE_CALLBACK:
-			case GI_INFO_TYPE_BOXED:
-			case GI_INFO_TYPE_FLAGS:
-			case GI_INFO_TYPE_CONSTANT:
-			case GI_INFO_TYPE_INVALID_0:
-			case GI_INFO_TYPE_VALUE:
-			case GI_INFO_TYPE_SIGNAL:
-			case GI_INFO_TYPE_VFUNC:
-			case GI_INFO_TYPE_PROPERTY:
-			case GI_INFO_TYPE_FIELD:
-			case GI_INFO_TYPE_ARG:
-			case GI_INFO_TYPE_TYPE:
-			case GI_INFO_TYPE_UNRESOLVED:
-			default:
-				/* Doesn’t have methods — ignore. */
-				break;
-			}
-
-			g_base_info_unref (_info);
+		const SymbolIndex *index = this->_get_symbol_index (r);
+		std::unordered_map<std::string, SymbolIndex::Location>::const_iterator location =
+			index->functions.find (func_name);
+
+		if (location == index->functions.end ()) {
+			continue;
+		}
+
+		/* Construct only the info being returned (and the info
+		 * containing it, for a method). */
+		info = g_irepository_get_info (this->_repo, r.nspace.c_str (),
+		                               location->second.info_index);
+
+		if (location->second.method_index >= 0) {
+			GIBaseInfo *container = info;
+
+			info = GirManager::get_method (container,
+			                               location->second.method_index);
+			g_base_info_unref (container);
 		}
 	}
 
 	/* Double-check that this isn’t a shadowed function, since the parameter
 	 * information from shadowed functions doesn’t match up with what Clang
-	 * has parsed. */
+	 * has parsed. This also validates the index against libgirepository. */
 	assert (info == NULL ||
 	        (g_base_info_get_type (info) == GI_INFO_TYPE_FUNCTION &&
 	         func_name == g_function_info_get_symbol (info)));
@@ -253,6 +670,33 @@ GirManager::find_function_info (const std::string& func_name) const
 	return info;
 }
 
+/* Number of top-level infos in the loaded namespace @gi_namespace, for
+ * iterating over all of it using get_info(). Returns 0 if the namespace
+ * isn’t loaded. */
+unsigned int
+GirManager::get_n_infos (const std::string& gi_namespace) const
+{
+	for (std::vector<Nspace>::const_iterator it = this->_typelibs.begin (),
+	     ie = this->_typelibs.end (); it != ie; ++it) {
+		if ((*it).nspace == gi_namespace) {
+			return g_irepository_get_n_infos (this->_repo,
+			                                  gi_namespace.c_str ());
+		}
+	}
+
+	return 0;
+}
+
+/* Note: This returns a reference which needs freeing using
+ * g_base_info_unref(). */
+GIBaseInfo*
+GirManager::get_info (const std::string& gi_namespace,
+                      unsigned int index) const
+{
+	return g_irepository_get_info (this->_repo, gi_namespace.c_str (),
+	                               index);
+}
+
 /* Try to find typelib information about the type. The type could be a GObject
  * or a GInterface.
  *
@@ -322,3 +766,55 @@ GirManager::get_c_name_for_type (GIBaseInfo *base_info) const
 		return std::string (c_prefix) + symbol_name;
 	}
 }
+
+/* Look up the deprecation message and version for the function with C symbol
+ * @symbol. These are only available for namespaces loaded using
+ * load_gir_file(). Returns %false if none are known, in which case @message
+ * and @version are left unchanged. */
+bool
+GirManager::get_deprecation (const std::string& symbol,
+                             std::string& message,
+                             std::string& version) const
+{
+	std::unordered_map<std::string, Deprecation>::const_iterator it =
+		this->_deprecations.find (symbol);
+
+	if (it == this->_deprecations.end ())
+		return false;
+
+	message = (*it).second.message;
+	version = (*it).second.version;
+
+	return true;
+}
+
+/* Load a file of annotation overrides, for functions in libraries which have
+ * no GIR data. See #AnnotationOverrides for the format. */
+void
+GirManager::load_overrides (const std::string& filename,
+                            GError** error)
+{
+	std::shared_ptr<AnnotationOverrides> overrides =
+		std::make_shared<AnnotationOverrides> ();
+
+	if (overrides.get ()->load (filename, error)) {
+		this->_overrides.push_back (overrides);
+	}
+}
+
+/* Look up the annotation overrides for the function with C symbol @symbol,
+ * searching the override files in the order they were loaded. These should
+ * only be used if find_function_info() finds no GIR data. Returns %false if
+ * there are none, in which case @annotations is left unchanged. */
+bool
+GirManager::find_override (const std::string& symbol,
+                           AnnotationOverride& annotations) const
+{
+	for (std::vector<std::shared_ptr<AnnotationOverrides>>::const_iterator it = this->_overrides.begin (),
+	     ie = this->_overrides.end (); it != ie; ++it) {
+		if ((*it).get ()->lookup (symbol, annotations))
+			return true;
+	}
+
+	return false;
+}
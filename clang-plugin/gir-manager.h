@@ -23,13 +23,42 @@
 #ifndef TARTAN_GIR_MANAGER_H
 #define TARTAN_GIR_MANAGER_H
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <girepository.h>
 
+#include "annotation-overrides.h"
+
 class GirManager {
+public:
+	/* Deprecation details which typelibs don’t store, so are only
+	 * available for namespaces loaded from .gir files. Both may be
+	 * empty. */
+	struct Deprecation {
+		std::string message;
+		std::string version;
+	};
+
 private:
+	/* The C symbols of the functions and methods in a namespace, mapped
+	 * to where their infos are in the namespace, so that a lookup
+	 * constructs only the infos it returns. Built on the first lookup in
+	 * the namespace (guarded by @built), and only read afterwards. */
+	struct SymbolIndex {
+		struct Location {
+			guint info_index;
+			gint method_index;  /* −1 if the info is the function */
+		};
+
+		SymbolIndex () : built (0) {}
+
+		volatile gsize built;
+		std::unordered_map<std::string, Location> functions;
+	};
+
 	struct Nspace {
 		/* All non-NULL. */
 		std::string nspace;
@@ -38,10 +67,18 @@ private:
 		std::string c_prefix;
 
 		GITypelib* typelib;  /* unowned */
+		std::shared_ptr<SymbolIndex> index;
 	};
 
 	GIRepository* _repo;  /* unowned */
 	std::vector<Nspace> _typelibs;
+	std::unordered_map<std::string, Deprecation> _deprecations;  /* keyed by C symbol */
+	std::vector<std::shared_ptr<AnnotationOverrides>> _overrides;
+
+	void _add_typelib (const std::string& gi_namespace,
+	                   const std::string& gi_version,
+	                   GITypelib* typelib);
+	const SymbolIndex* _get_symbol_index (const Nspace& r) const;
 
 public:
 	GirManager ();
@@ -49,10 +86,27 @@ public:
 	void load_namespace (const std::string& gi_namespace,
 	                     const std::string& gi_version,
 	                     GError** error);
+	void load_gir_file (const std::string& gir_filename,
+	                    GError** error);
+	void load_overrides (const std::string& filename,
+	                     GError** error);
 
+	/* Lookups only read the loaded typelibs, so may be made from several
+	 * threads at once once all namespaces have been loaded. */
 	GIBaseInfo* find_function_info (const std::string& func_name) const;
+	unsigned int get_n_infos (const std::string& gi_namespace) const;
+	GIBaseInfo* get_info (const std::string& gi_namespace,
+	                      unsigned int index) const;
 	GIBaseInfo* find_object_info (const std::string& type_name) const;
 	std::string get_c_name_for_type (GIBaseInfo *base_info) const;
+	bool get_deprecation (const std::string& symbol,
+	                      std::string& message,
+	                      std::string& version) const;
+	bool find_override (const std::string& symbol,
+	                    AnnotationOverride& annotations) const;
+
+	static gint get_n_methods (GIBaseInfo *info);
+	static GIFunctionInfo* get_method (GIBaseInfo *info, gint n);
 };
 
 #endif /* !TARTAN_GIR_MANAGER_H */
@@ -0,0 +1,370 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+/**
+ * GirModeller:
+ *
+ * Without a model of a function, the analyser either inlines it (if its body
+ * is available) or conservatively assumes the call could modify any memory
+ * reachable from its arguments or from globals. For the many small GLib and
+ * library functions called from typical GObject code, that invalidation loses
+ * the values the other checkers (including #GErrorChecker) are tracking, and
+ * the fresh unknown values it introduces multiply the number of paths
+ * explored.
+ *
+ * This checker evaluates calls to functions which are known not to modify
+ * memory visible to the caller, binding a new symbol for their return value
+ * and leaving everything else untouched:
+ *  • A curated list of pure GLib functions (hashing, comparison, type
+ *    checks, etc.), plus every *_get_type() function.
+ *  • g_type_check_instance_cast() and g_type_check_class_cast(), which return
+ *    their first argument, so pointer identity survives the G_OBJECT() family
+ *    of casts.
+ *  • Accessor methods from the GIR: methods which return a transfer-none value,
+ *    take only (in) arguments and no callbacks, don’t throw, and either take
+ *    a const instance or are named as accessors (*_get_*, *_is_*, etc.). If
+ *    the GIR says they can’t return %NULL, that is assumed too.
+ *
+ * It also treats the g_assertion_message*() and g_return_if_fail_warning()
+ * functions as not returning, since the paths following a failed assertion or
+ * precondition are programmer errors which aren’t worth exploring.
+ *
+ * Functions with a body in the translation unit (such as a *_get_type()
+ * function defined by G_DEFINE_TYPE()) are left to be inlined, as are functions
+ * which take a #GError**, which #GErrorChecker models.
+ */
+
+#include "config.h"
+
+#include <cstring>
+
+#include <girepository.h>
+
+#include <llvm/ADT/Statistic.h>
+#include <clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h>
+
+#include "debug.h"
+#include "gir-modeller.h"
+
+STATISTIC (NumCallsModelled,
+           "The # of calls evaluated by the Tartan GIR modeller");
+
+namespace tartan {
+
+/* Functions which only compute a value from their arguments (or from global
+ * state the caller can’t see). */
+static const char *pure_funcs[] = {
+	"g_ascii_strcasecmp",
+	"g_ascii_strncasecmp",
+	"g_direct_equal",
+	"g_direct_hash",
+	"g_double_equal",
+	"g_double_hash",
+	"g_int64_equal",
+	"g_int64_hash",
+	"g_int_equal",
+	"g_int_hash",
+	"g_quark_from_static_string",
+	"g_quark_from_string",
+	"g_quark_to_string",
+	"g_quark_try_string",
+	"g_str_equal",
+	"g_str_has_prefix",
+	"g_str_has_suffix",
+	"g_str_hash",
+	"g_strcmp0",
+	"g_type_check_class_is_a",
+	"g_type_check_instance_is_a",
+	"g_type_check_instance_is_fundamentally_a",
+	"g_type_check_value",
+	"g_type_check_value_holds",
+	"g_type_from_name",
+	"g_type_fundamental",
+	"g_type_is_a",
+	"g_type_name",
+	"g_type_parent",
+	"g_type_qname",
+	"g_unichar_isalnum",
+	"g_unichar_isalpha",
+	"g_unichar_isdigit",
+	"g_unichar_isspace",
+	"g_unichar_tolower",
+	"g_unichar_toupper",
+	"g_utf8_get_char",
+	"g_utf8_strlen",
+	"g_variant_is_of_type",
+	"g_variant_type_equal",
+	NULL,
+};
+
+/* Functions which return their first argument. */
+static const char *cast_funcs[] = {
+	"g_type_check_class_cast",
+	"g_type_check_instance_cast",
+	NULL,
+};
+
+/* Assertion and precondition failure functions. g_assertion_message_expr() is
+ * already declared G_GNUC_NORETURN, but the others return if non-fatal
+ * assertions or criticals are enabled. */
+static const char *noreturn_funcs[] = {
+	"g_assert_warning",
+	"g_assertion_message",
+	"g_assertion_message_cmpnum",
+	"g_assertion_message_cmpstr",
+	"g_assertion_message_error",
+	"g_assertion_message_expr",
+	"g_return_if_fail_warning",
+	NULL,
+};
+
+static bool
+_name_in_list (const char *name, const char **list)
+{
+	for (const char **i = list; *i != NULL; i++) {
+		if (strcmp (name, *i) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Whether @symbol is named like an accessor method. */
+static bool
+_is_accessor_name (const char *symbol)
+{
+	return (strstr (symbol, "_get_") != NULL ||
+	        strstr (symbol, "_is_") != NULL ||
+	        strstr (symbol, "_has_") != NULL ||
+	        strstr (symbol, "_peek") != NULL ||
+	        strstr (symbol, "_lookup") != NULL);
+}
+
+/* Evaluate calls to the modelled functions. Return true iff the call was
+ * evaluated. */
+bool
+GirModeller::evalCall (const CallExpr *call, CheckerContext &context) const
+{
+	const FunctionDecl *func_decl = context.getCalleeDecl (call);
+
+	if (func_decl == NULL) {
+		return false;
+	}
+
+	/* A new translation unit: forget everything cached for the old one. */
+	if (this->_context != &context.getASTContext ()) {
+		this->_context = &context.getASTContext ();
+		this->_models.clear ();
+		this->_returns_non_null.clear ();
+	}
+
+	CallModel model = this->_get_model (*func_decl);
+	ProgramStateRef state = context.getState ();
+	const LocationContext *location_context = context.getLocationContext ();
+
+	switch (model) {
+	case MODEL_NORETURN:
+		context.generateSink (state, context.getPredecessor ());
+		NumCallsModelled++;
+
+		return true;
+	case MODEL_CAST:
+		if (call->getNumArgs () < 1) {
+			return false;
+		}
+
+		state = state->BindExpr (call, location_context,
+		                         state->getSVal (call->getArg (0),
+		                                         location_context));
+		break;
+	case MODEL_PURE:
+	case MODEL_ACCESSOR: {
+#ifdef HAVE_LLVM_3_5
+		QualType return_type = func_decl->getReturnType ();
+#else /* if !HAVE_LLVM_3_5 */
+		QualType return_type = func_decl->getResultType ();
+#endif /* !HAVE_LLVM_3_5 */
+
+		DefinedOrUnknownSVal return_value =
+			context.getSValBuilder ().conjureSymbolVal (this, call,
+			                                            location_context,
+			                                            return_type,
+			                                            context.blockCount ());
+		state = state->BindExpr (call, location_context, return_value);
+
+		if (return_type->isPointerType () &&
+		    this->_returns_non_null.lookup (func_decl->getCanonicalDecl ())) {
+			ProgramStateRef non_null_state =
+				state->assume (return_value, true);
+
+			if (non_null_state != NULL) {
+				state = non_null_state;
+			}
+		}
+
+		break;
+	}
+	case MODEL_NONE:
+	default:
+		return false;
+	}
+
+	context.addTransition (state);
+	NumCallsModelled++;
+
+	return true;
+}
+
+/* Work out how to model calls to @func. This is done once per function
+ * declaration, as it may involve a GIR lookup. */
+GirModeller::CallModel
+GirModeller::_get_model (const FunctionDecl &func) const
+{
+	const FunctionDecl *canonical_decl = func.getCanonicalDecl ();
+	llvm::DenseMap<const FunctionDecl *, CallModel>::const_iterator it =
+		this->_models.find (canonical_decl);
+
+	if (it != this->_models.end ()) {
+		return it->second;
+	}
+
+	CallModel model = MODEL_NONE;
+	const IdentifierInfo *identifier = func.getIdentifier ();
+
+	if (identifier != NULL) {
+		const char *name = identifier->getNameStart ();
+		StringRef name_ref = identifier->getName ();
+
+		if (_name_in_list (name, noreturn_funcs)) {
+			model = MODEL_NORETURN;
+		} else if (func.hasBody ()) {
+			/* Let the analyser inline functions it has the body
+			 * of. */
+			model = MODEL_NONE;
+		} else if (_name_in_list (name, cast_funcs)) {
+			model = MODEL_CAST;
+		} else if (_name_in_list (name, pure_funcs) ||
+		           (name_ref.endswith ("_get_type") &&
+		            func.getNumParams () == 0)) {
+			/* *_get_type() functions register their type on the
+			 * first call, which isn’t visible to the caller. */
+			model = MODEL_PURE;
+		} else {
+			model = this->_get_gir_model (func);
+		}
+	}
+
+	this->_models[canonical_decl] = model;
+
+	return model;
+}
+
+/* Whether @info describes an accessor method which @func is declared as:
+ * one which returns a transfer-none value, takes only (in) arguments and no
+ * callbacks (which could have arbitrary effects), and doesn’t throw (so is
+ * left to GErrorChecker). */
+static bool
+_is_accessor_info (GIBaseInfo *info, const FunctionDecl &func)
+{
+	if (g_base_info_get_type (info) != GI_INFO_TYPE_FUNCTION) {
+		return false;
+	}
+
+	GIFunctionInfoFlags flags = g_function_info_get_flags (info);
+	gint n_args = g_callable_info_get_n_args (info);
+
+	if (!(flags & GI_FUNCTION_IS_METHOD) ||
+	    (flags & GI_FUNCTION_IS_CONSTRUCTOR) ||
+	    g_callable_info_can_throw_gerror (info) ||
+	    func.getNumParams () != (unsigned int) n_args + 1) {
+		return false;
+	}
+
+	GITypeInfo return_type_info;
+	g_callable_info_load_return_type (info, &return_type_info);
+
+	if ((g_type_info_get_tag (&return_type_info) == GI_TYPE_TAG_VOID &&
+	     !g_type_info_is_pointer (&return_type_info)) ||
+	    g_callable_info_get_caller_owns (info) != GI_TRANSFER_NOTHING) {
+		return false;
+	}
+
+	for (gint i = 0; i < n_args; i++) {
+		GIArgInfo arg_info;
+		GITypeInfo type_info;
+
+		g_callable_info_load_arg (info, i, &arg_info);
+		g_arg_info_load_type (&arg_info, &type_info);
+
+		if (g_arg_info_get_direction (&arg_info) != GI_DIRECTION_IN) {
+			return false;
+		}
+
+		if (g_type_info_get_tag (&type_info) == GI_TYPE_TAG_INTERFACE) {
+			GIBaseInfo *interface_info =
+				g_type_info_get_interface (&type_info);
+			bool is_callback =
+				(g_base_info_get_type (interface_info) ==
+				 GI_INFO_TYPE_CALLBACK);
+			g_base_info_unref (interface_info);
+
+			if (is_callback) {
+				return false;
+			}
+		}
+	}
+
+	/* Finally, the method must look like it doesn’t modify its instance. */
+	QualType instance_type = func.getParamDecl (0)->getType ();
+
+	return ((instance_type->isPointerType () &&
+	         instance_type->getPointeeType ().isConstQualified ()) ||
+	        _is_accessor_name (g_function_info_get_symbol (info)));
+}
+
+/* Check whether @func, which has no body, is an accessor method according to
+ * its GIR, returning MODEL_ACCESSOR if so. */
+GirModeller::CallModel
+GirModeller::_get_gir_model (const FunctionDecl &func) const
+{
+	GIBaseInfo *info =
+		global_gir_manager.get ()->find_function_info (func.getNameAsString ());
+
+	if (info == NULL) {
+		return MODEL_NONE;
+	}
+
+	CallModel model = MODEL_NONE;
+
+	if (_is_accessor_info (info, func)) {
+		model = MODEL_ACCESSOR;
+		this->_returns_non_null[func.getCanonicalDecl ()] =
+			!g_callable_info_may_return_null (info);
+	}
+
+	g_base_info_unref (info);
+
+	return model;
+}
+
+} /* namespace tartan */
@@ -0,0 +1,78 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_GIR_MODELLER_H
+#define TARTAN_GIR_MODELLER_H
+
+#include <clang/AST/AST.h>
+#include <llvm/ADT/DenseMap.h>
+#include <clang/StaticAnalyzer/Core/Checker.h>
+#include <clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h>
+
+#include "checker.h"
+#include "gir-manager.h"
+
+namespace tartan {
+
+using namespace clang;
+using namespace ento;
+
+class GirModeller : public ento::Checker<eval::Call>,
+                    public tartan::Checker {
+public:
+	explicit GirModeller () : _context (NULL) {};
+
+private:
+	/* How a call to a function is modelled. */
+	enum CallModel {
+		MODEL_NONE,  /* left to the analyser */
+		MODEL_PURE,  /* only computes its return value */
+		MODEL_CAST,  /* returns its first argument */
+		MODEL_ACCESSOR,  /* transfer-none getter, from the GIR */
+		MODEL_NORETURN,  /* assertion failure */
+	};
+
+	/* The #ASTContext which @_models belongs to; it is reset if this
+	 * changes. */
+	mutable const ASTContext *_context;
+
+	/* Cached model for each called function, keyed by its canonical
+	 * declaration. */
+	mutable llvm::DenseMap<const FunctionDecl *, CallModel> _models;
+
+	/* Whether each MODEL_ACCESSOR function is annotated as never
+	 * returning %NULL, keyed as for @_models. */
+	mutable llvm::DenseMap<const FunctionDecl *, bool> _returns_non_null;
+
+	CallModel _get_model (const FunctionDecl &func) const;
+	CallModel _get_gir_model (const FunctionDecl &func) const;
+
+public:
+	bool evalCall (const CallExpr *call,
+	               CheckerContext &context) const;
+
+	const std::string get_name () const { return "gir-modeller"; }
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_GIR_MODELLER_H */
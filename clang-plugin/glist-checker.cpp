@@ -0,0 +1,377 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+/**
+ * GListVisitor:
+ *
+ * This is a checker for uses of the O(n) #GList and #GSList functions which
+ * make loops quadratic: appending to, indexing into, measuring or searching a
+ * list which persists across iterations of the loop, or doing so in the loop’s
+ * condition. For example:
+ *     for (l = items; l != NULL; l = l->next)
+ *             result = g_list_append (result, l->data);
+ * or:
+ *     for (i = 0; i < g_list_length (list); i++)
+ *             do_something (g_list_nth_data (list, i));
+ *
+ * A list is considered to persist across iterations if it’s a structure member,
+ * or a variable declared before the innermost enclosing loop which the loop
+ * either doesn’t reassign from a fresh value (as in ‘l = get_list ()’), or
+ * also assigns from its own previous value (as in
+ * ‘l = g_list_append (l, …)’). Lists declared inside the loop, or fetched
+ * afresh on each iteration, are ignored. A warning is emitted for each such
+ * call, suggesting an alternative which avoids the repeated traversal.
+ */
+
+#include "config.h"
+
+#include <memory>
+#include <vector>
+
+#include <glib.h>
+
+#include "debug.h"
+#include "glist-checker.h"
+
+namespace tartan {
+
+static const char *append_advice_list =
+	"Build the list with g_list_prepend() and reverse it with "
+	"g_list_reverse() after the loop, keep a pointer to its tail, or use "
+	"a GQueue or GPtrArray.";
+static const char *append_advice_slist =
+	"Build the list with g_slist_prepend() and reverse it with "
+	"g_slist_reverse() after the loop, keep a pointer to its tail, or use "
+	"a GQueue or GPtrArray.";
+static const char *last_advice =
+	"Keep a pointer to the tail of the list, or use a GQueue.";
+static const char *nth_advice =
+	"Iterate over the list using its ‘next’ pointers instead, or use a "
+	"GPtrArray for indexed access.";
+static const char *length_advice =
+	"Compute the length once before the loop, or use a GQueue, which "
+	"stores its length.";
+static const char *find_advice =
+	"Use a GHashTable to look up elements.";
+
+/* Information about the O(n) list functions we’re interested in. */
+typedef struct {
+	/* C name of the function */
+	const char *func_name;
+	/* Suggested alternative */
+	const char *advice;
+} LinearListFuncInfo;
+
+static const LinearListFuncInfo linear_list_funcs[] = {
+	{ "g_list_append", append_advice_list },
+	{ "g_list_find", find_advice },
+	{ "g_list_find_custom", find_advice },
+	{ "g_list_index", find_advice },
+	{ "g_list_last", last_advice },
+	{ "g_list_length", length_advice },
+	{ "g_list_nth", nth_advice },
+	{ "g_list_nth_data", nth_advice },
+	{ "g_slist_append", append_advice_slist },
+	{ "g_slist_find", find_advice },
+	{ "g_slist_find_custom", find_advice },
+	{ "g_slist_index", find_advice },
+	{ "g_slist_last", last_advice },
+	{ "g_slist_length", length_advice },
+	{ "g_slist_nth", nth_advice },
+	{ "g_slist_nth_data", nth_advice },
+};
+
+static const LinearListFuncInfo *
+_func_is_linear_list_func (const FunctionDecl& func)
+{
+	const IdentifierInfo *func_ident = func.getIdentifier ();
+	guint i;
+
+	if (func_ident == NULL)
+		return NULL;
+
+	StringRef func_name = func_ident->getName ();
+
+	/* Fast path elimination of irrelevant functions. */
+	if (!func_name.startswith ("g_list_") &&
+	    !func_name.startswith ("g_slist_"))
+		return NULL;
+
+	for (i = 0; i < G_N_ELEMENTS (linear_list_funcs); i++) {
+		if (func_name == linear_list_funcs[i].func_name) {
+			return &linear_list_funcs[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Return true iff @stmt refers to @var. */
+static bool
+_stmt_refers_to_var (const Stmt *stmt, const VarDecl *var)
+{
+	if (stmt == NULL)
+		return false;
+
+	const DeclRefExpr *decl_ref = dyn_cast<DeclRefExpr> (stmt);
+	if (decl_ref != NULL && decl_ref->getDecl () == var)
+		return true;
+
+	for (Stmt::const_child_iterator it = stmt->child_begin (),
+	     ie = stmt->child_end (); it != ie; ++it) {
+		if (_stmt_refers_to_var (*it, var))
+			return true;
+	}
+
+	return false;
+}
+
+/* Return true iff @stmt, or any statement nested in it, declares @var. This
+ * works on the AST alone, so is safe to call from a worker thread, unlike
+ * comparing source locations through the SourceManager. */
+static bool
+_stmt_declares_var (const Stmt *stmt, const VarDecl *var)
+{
+	if (stmt == NULL)
+		return false;
+
+	const DeclStmt *decl_stmt = dyn_cast<DeclStmt> (stmt);
+	if (decl_stmt != NULL) {
+		for (DeclStmt::const_decl_iterator it = decl_stmt->decl_begin (),
+		     ie = decl_stmt->decl_end (); it != ie; ++it) {
+			if (*it == var)
+				return true;
+		}
+	}
+
+	for (Stmt::const_child_iterator it = stmt->child_begin (),
+	     ie = stmt->child_end (); it != ie; ++it) {
+		if (_stmt_declares_var (*it, var))
+			return true;
+	}
+
+	return false;
+}
+
+/* Return true iff @var is declared afresh on each iteration of @loop. A for
+ * loop’s initialiser is only evaluated once, so a variable declared there
+ * persists across iterations. */
+static bool
+_loop_declares_var (const Stmt *loop, const VarDecl *var)
+{
+	if (const ForStmt *for_stmt = dyn_cast<ForStmt> (loop)) {
+		return (_stmt_declares_var (for_stmt->getCond (), var) ||
+		        _stmt_declares_var (for_stmt->getInc (), var) ||
+		        _stmt_declares_var (for_stmt->getBody (), var));
+	}
+
+	return _stmt_declares_var (loop, var);
+}
+
+/* Find the assignments to @var in @stmt, noting whether any assign it a value
+ * computed from its previous one, and whether any assign it a fresh value. */
+static void
+_find_var_assignments (const Stmt *stmt, const VarDecl *var,
+                       bool &self_assigned, bool &fresh_assigned)
+{
+	if (stmt == NULL)
+		return;
+
+	const BinaryOperator *op = dyn_cast<BinaryOperator> (stmt);
+
+	if (op != NULL && op->isAssignmentOp ()) {
+		const DeclRefExpr *lhs =
+			dyn_cast<DeclRefExpr> (op->getLHS ()->IgnoreParenCasts ());
+
+		if (lhs != NULL && lhs->getDecl () == var) {
+			if (op->isCompoundAssignmentOp () ||
+			    _stmt_refers_to_var (op->getRHS (), var)) {
+				self_assigned = true;
+			} else {
+				fresh_assigned = true;
+			}
+		}
+	}
+
+	for (Stmt::const_child_iterator it = stmt->child_begin (),
+	     ie = stmt->child_end (); it != ie; ++it) {
+		_find_var_assignments (*it, var, self_assigned, fresh_assigned);
+	}
+}
+
+/* Return true iff @var holds the same list from one iteration of @loop to the
+ * next. It doesn’t if the loop reassigns it from a fresh value, unless the
+ * loop also builds on its previous value. A for loop’s initialiser is only
+ * evaluated once, so is ignored. */
+static bool
+_var_is_loop_carried (const Stmt *loop, const VarDecl *var)
+{
+	bool self_assigned = false, fresh_assigned = false;
+
+	if (const ForStmt *for_stmt = dyn_cast<ForStmt> (loop)) {
+		_find_var_assignments (for_stmt->getCond (), var,
+		                       self_assigned, fresh_assigned);
+		_find_var_assignments (for_stmt->getInc (), var,
+		                       self_assigned, fresh_assigned);
+		_find_var_assignments (for_stmt->getBody (), var,
+		                       self_assigned, fresh_assigned);
+	} else {
+		_find_var_assignments (loop, var, self_assigned,
+		                       fresh_assigned);
+	}
+
+	return (self_assigned || !fresh_assigned);
+}
+
+bool
+GListConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
+{
+	this->_traverse_top_level_decls (decl_group, this->_visitor);
+
+	return true;
+}
+
+void
+GListConsumer::HandleTranslationUnit (ASTContext& context)
+{
+	this->_traverse_translation_unit<GListVisitor> (context, this->_visitor,
+		[this] () {
+			return new GListVisitor (this->_compiler);
+		});
+}
+
+/* Traverse a loop, tracking which of its parts are evaluated on every
+ * iteration. @init is evaluated once, outside the loop; any of the parts may
+ * be %NULL. */
+bool
+GListVisitor::_traverse_loop (Stmt *loop, Stmt *init, Stmt *cond, Stmt *inc,
+                              Stmt *body)
+{
+	bool in_condition = this->_in_condition;
+	bool retval;
+
+	this->_in_condition = false;
+	retval = this->TraverseStmt (init);
+
+	this->_loops.push_back (loop);
+	this->_in_condition = true;
+	retval = retval && this->TraverseStmt (cond);
+	this->_in_condition = false;
+	retval = retval && this->TraverseStmt (inc) &&
+	         this->TraverseStmt (body);
+	this->_loops.pop_back ();
+
+	this->_in_condition = in_condition;
+
+	return retval;
+}
+
+/* Note: Specifically overriding the Traverse* methods here to re-implement
+ * recursion to child nodes. */
+bool
+GListVisitor::TraverseForStmt (ForStmt *stmt)
+{
+	return this->_traverse_loop (stmt, stmt->getInit (), stmt->getCond (),
+	                             stmt->getInc (), stmt->getBody ());
+}
+
+bool
+GListVisitor::TraverseWhileStmt (WhileStmt *stmt)
+{
+	return this->_traverse_loop (stmt, NULL, stmt->getCond (), NULL,
+	                             stmt->getBody ());
+}
+
+bool
+GListVisitor::TraverseDoStmt (DoStmt *stmt)
+{
+	return this->_traverse_loop (stmt, NULL, stmt->getCond (), NULL,
+	                             stmt->getBody ());
+}
+
+bool
+GListVisitor::VisitCallExpr (CallExpr *call)
+{
+	/* Only calls inside loops are interesting. */
+	if (this->_loops.empty ())
+		return true;
+
+	/* Can only handle direct function calls (i.e. not calling dereferenced
+	 * function pointers). */
+	const FunctionDecl *func = call->getDirectCallee ();
+	if (func == NULL || call->getNumArgs () < 1)
+		return true;
+
+	const LinearListFuncInfo *func_info = _func_is_linear_list_func (*func);
+	if (func_info == NULL)
+		return true;
+
+	/* The condition is evaluated on every iteration, whichever list it’s
+	 * operating on. */
+	if (this->_in_condition) {
+		Debug::emit_warning ("%0() is O(n), and is called on every "
+		                     "evaluation of the loop condition, making "
+		                     "the loop quadratic. %1",
+		                     this->_compiler, call->getLocStart ())
+		<< func_info->func_name
+		<< func_info->advice;
+
+		return true;
+	}
+
+	/* Otherwise, only warn if the list persists across iterations of the
+	 * innermost loop. */
+	const Expr *list_arg = call->getArg (0)->IgnoreParenCasts ();
+	std::string list_name;
+
+	if (const DeclRefExpr *decl_ref = dyn_cast<DeclRefExpr> (list_arg)) {
+		const VarDecl *var_decl = dyn_cast<VarDecl> (decl_ref->getDecl ());
+		if (var_decl == NULL)
+			return true;
+
+		/* Lists declared inside the loop are new on each iteration. */
+		if (_loop_declares_var (this->_loops.back (), var_decl))
+			return true;
+
+		/* As are lists fetched afresh on each iteration. */
+		if (!_var_is_loop_carried (this->_loops.back (), var_decl))
+			return true;
+
+		list_name = var_decl->getNameAsString ();
+	} else if (const MemberExpr *member = dyn_cast<MemberExpr> (list_arg)) {
+		list_name = member->getMemberDecl ()->getNameAsString ();
+	} else {
+		return true;
+	}
+
+	Debug::emit_warning ("%0() is O(n) in the length of ‘%1’, which is "
+	                     "carried across iterations of the enclosing "
+	                     "loop, making the loop quadratic. %2",
+	                     this->_compiler, call->getLocStart ())
+	<< func_info->func_name
+	<< list_name
+	<< func_info->advice;
+
+	return true;
+}
+
+} /* namespace tartan */
@@ -0,0 +1,83 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_GLIST_CHECKER_H
+#define TARTAN_GLIST_CHECKER_H
+
+#include <vector>
+
+#include <clang/AST/AST.h>
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Frontend/CompilerInstance.h>
+
+#include "checker.h"
+#include "gir-manager.h"
+
+namespace tartan {
+
+using namespace clang;
+
+class GListVisitor : public RecursiveASTVisitor<GListVisitor> {
+public:
+	explicit GListVisitor (CompilerInstance& compiler) :
+		_compiler (compiler), _in_condition (false) {}
+
+private:
+	CompilerInstance& _compiler;
+
+	/* The loops enclosing the current node, innermost last; and whether
+	 * the current node is in the condition of the innermost one. */
+	std::vector<const Stmt *> _loops;
+	bool _in_condition;
+
+	bool _traverse_loop (Stmt *loop, Stmt *init, Stmt *cond, Stmt *inc,
+	                     Stmt *body);
+
+public:
+	bool TraverseForStmt (ForStmt *stmt);
+	bool TraverseWhileStmt (WhileStmt *stmt);
+	bool TraverseDoStmt (DoStmt *stmt);
+	bool VisitCallExpr (CallExpr *call);
+};
+
+class GListConsumer : public tartan::ASTChecker {
+public:
+	GListConsumer (CompilerInstance& compiler,
+	               std::shared_ptr<const GirManager> gir_manager,
+	               std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins,
+	               std::shared_ptr<const PluginOptions> options) :
+		ASTChecker (compiler, gir_manager, disabled_plugins, options),
+		_visitor (compiler) {}
+
+private:
+	GListVisitor _visitor;
+
+public:
+	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
+	virtual void HandleTranslationUnit (ASTContext& context);
+	const std::string get_name () const { return "glist"; }
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_GLIST_CHECKER_H */
@@ -0,0 +1,153 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+/**
+ * GObjectNotifyVisitor:
+ *
+ * This is a checker for g_object_notify() calls with a string literal property
+ * name. g_object_notify() looks the #GParamSpec up in the global pool by name
+ * on every call, which is measurable on hot update paths; the checker emits a
+ * remark for each call suggesting g_object_notify_by_pspec() instead, using the
+ * #GParamSpec saved when the property was installed (conventionally in a
+ * class-level ‘properties[]’ array).
+ *
+ * If the class of the object can be resolved from the GIR, it also checks that
+ * the property exists on it (or on one of its ancestors or interfaces), as
+ * g_object_notify() only emits a critical warning at runtime otherwise. The
+ * object is normally passed through G_OBJECT(), so that cast is looked through
+ * to find the most specific type.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <girepository.h>
+
+#include "debug.h"
+#include "gobject-notify-checker.h"
+
+namespace tartan {
+
+/* Strip any casts (including G_OBJECT() and similar, which expand to a
+ * g_type_check_instance_cast() call unless G_DISABLE_CAST_CHECKS is defined)
+ * from an instance expression, to find the most specific type of the
+ * instance. */
+static const Expr *
+_strip_gobject_casts (const Expr *expr)
+{
+	expr = expr->IgnoreParenCasts ();
+
+	const CallExpr *call = dyn_cast<CallExpr> (expr);
+	if (call == NULL || call->getNumArgs () < 1)
+		return expr;
+
+	const FunctionDecl *func = call->getDirectCallee ();
+	if (func == NULL || func->getIdentifier () == NULL ||
+	    func->getName () != "g_type_check_instance_cast")
+		return expr;
+
+	return call->getArg (0)->IgnoreParenCasts ();
+}
+
+bool
+GObjectNotifyConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
+{
+	this->_traverse_top_level_decls (decl_group, this->_visitor);
+
+	return true;
+}
+
+void
+GObjectNotifyConsumer::HandleTranslationUnit (ASTContext& context)
+{
+	this->_traverse_translation_unit<GObjectNotifyVisitor> (context, this->_visitor,
+		[this] () {
+			return new GObjectNotifyVisitor (this->_compiler,
+			                                 this->_gir_manager);
+		});
+}
+
+bool
+GObjectNotifyVisitor::VisitCallExpr (CallExpr* call)
+{
+	/* Can only handle direct function calls (i.e. not calling dereferenced
+	 * function pointers). */
+	const FunctionDecl *func = call->getDirectCallee ();
+	if (func == NULL || func->getIdentifier () == NULL ||
+	    func->getName () != "g_object_notify" || call->getNumArgs () != 2)
+		return true;
+
+	/* Names which aren’t string literals are presumably computed, so
+	 * there’s no single GParamSpec to suggest. */
+	const Expr *property_name_arg = call->getArg (1);
+	const StringLiteral *property_name_str =
+		dyn_cast<StringLiteral> (property_name_arg->IgnoreParenImpCasts ());
+	if (property_name_str == NULL)
+		return true;
+
+	/* Property names are canonicalised to use hyphens. */
+	std::string property_name = property_name_str->getString ().str ();
+	std::replace (property_name.begin (), property_name.end (), '_', '-');
+
+	/* Check the property exists, if the class is known. */
+	const Expr *instance_arg = _strip_gobject_casts (call->getArg (0));
+	GIBaseInfo *instance_info =
+		this->_gtype_cache.get_object_info (instance_arg->getType ());
+
+	if (instance_info != NULL) {
+		GIBaseInfo *static_instance_info = NULL;
+		GIPropertyInfo *property_info =
+			this->_gtype_cache.look_up_property (instance_info,
+			                                     property_name,
+			                                     &static_instance_info);
+
+		if (property_info == NULL) {
+			Debug::emit_warning ("No property named ‘%0’ on class "
+			                     "‘%1’ or its ancestors, so "
+			                     "g_object_notify() will fail at "
+			                     "runtime.",
+			                     this->_compiler,
+			                     property_name_arg->getLocStart ())
+			<< property_name
+			<< this->_gir_manager.get ()->get_c_name_for_type (instance_info)
+			<< property_name_arg->getSourceRange ();
+
+			return true;
+		}
+	}
+
+	Debug::emit_remark ("g_object_notify() looks up property ‘%0’ by "
+	                    "name on every call. Use "
+	                    "g_object_notify_by_pspec() with the GParamSpec "
+	                    "saved when the property was installed, for "
+	                    "example in a class-level ‘properties[]’ array.",
+	                    this->_compiler, call->getLocStart ())
+	<< property_name;
+
+	return true;
+}
+
+} /* namespace tartan */
@@ -0,0 +1,75 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_GOBJECT_NOTIFY_CHECKER_H
+#define TARTAN_GOBJECT_NOTIFY_CHECKER_H
+
+#include <clang/AST/AST.h>
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Frontend/CompilerInstance.h>
+
+#include "checker.h"
+#include "gir-manager.h"
+#include "gtype-cache.h"
+
+namespace tartan {
+
+using namespace clang;
+
+class GObjectNotifyVisitor : public RecursiveASTVisitor<GObjectNotifyVisitor> {
+public:
+	explicit GObjectNotifyVisitor (CompilerInstance& compiler,
+	                               std::shared_ptr<const GirManager> gir_manager) :
+		_compiler (compiler), _gir_manager (gir_manager),
+		_gtype_cache (gir_manager) {}
+
+private:
+	CompilerInstance& _compiler;
+	std::shared_ptr<const GirManager> _gir_manager;
+	GTypeCache _gtype_cache;
+
+public:
+	bool VisitCallExpr (CallExpr* call);
+};
+
+class GObjectNotifyConsumer : public tartan::ASTChecker {
+public:
+	GObjectNotifyConsumer (CompilerInstance& compiler,
+	                       std::shared_ptr<const GirManager> gir_manager,
+	                       std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins,
+	                       std::shared_ptr<const PluginOptions> options) :
+		ASTChecker (compiler, gir_manager, disabled_plugins, options),
+		_visitor (compiler, gir_manager) {}
+
+private:
+	GObjectNotifyVisitor _visitor;
+
+public:
+	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
+	virtual void HandleTranslationUnit (ASTContext& context);
+	const std::string get_name () const { return "gobject-notify"; }
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_GOBJECT_NOTIFY_CHECKER_H */
@@ -67,13 +67,34 @@
  *     R callback (U_2, …, A)
  * and a new optional relationship:
  *     A = gpointer
+ *
+ * Calls to g_signal_emit_by_name() are checked in the same way: the variadic
+ * arguments must match the signal’s parameters, followed by a pointer to the
+ * return value location if the signal returns a value. As the detailed signal
+ * name is parsed and looked up on every emission, a warning is also emitted
+ * for emitting a signal by name inside a loop, suggesting that the signal ID be
+ * looked up once, or saved when the signal is created, and g_signal_emit() used
+ * instead.
+ *
+ * With --signal-graph, each connection whose signal could be resolved is also
+ * appended to a file as a line of JSON, giving the connection site and its
+ * enclosing function, the instance type, the signal (qualified by the type
+ * which defines it), the handler function and its location, and the connection
+ * flags. Collected over a whole build, this gives the static signal graph, so
+ * time spent in g_signal_emit() can be attributed to handlers and connection
+ * sites, and signals with a large fan-out can be found.
  */
 
 #include "config.h"
 
+#include <algorithm>
 #include <cstring>
+#include <memory>
+#include <vector>
 
 #include <clang/AST/Attr.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
 
 #include <glib.h>
 
@@ -136,113 +157,13 @@ _func_is_gsignal_connect (const FunctionDecl& func)
 
 /* If an expression is a reference to a GObject (or subclass, or a GInterface),
  * return the most specific type information we can for that object (or
- * interface). This must be freed with g_base_info_unref().
+ * interface). This is owned by @gtype_cache.
  *
  * If the expression is not a GObject, return NULL. */
 static GIObjectInfo*
-_expr_to_gtype (const Expr *expr,
-                const ASTContext &context,
-                const GirManager &gir_manager)
+_expr_to_gtype (const Expr *expr, GTypeCache &gtype_cache)
 {
-	QualType gobject_type = expr->getType ();
-
-	while (gobject_type->isPointerType ()) {
-		gobject_type = gobject_type->getPointeeType ();
-	}
-
-	/* We have the GObject pointee type, so try and resolve it. */
-	std::string gobject_type_str =
-		gobject_type.getUnqualifiedType ().getAsString ();
-	return gir_manager.find_object_info (gobject_type_str);
-}
-
-/* Look up a named signal in a #GIObjectInfo or #GIInterfaceInfo,
- * @dynamic_instance_info.
- *
- * If no definition for the signal can be found, %NULL will be returned.
- *
- * If the signal is defined on a #GObject, the #GIObjectInfo for that object
- * will be returned in @static_instance_info. In this case,
- * @static_instance_info is guaranteed to be the same as, or a superclass of,
- * @dynamic_instance_info.
- *
- * If the signal is defined on a #GInterface, the #GIInterfaceInfo for that
- * interface will be returned in @static_instance_info. In this case,
- * @dynamic_instance_info could have been the interface, or any class which
- * implements it.
- *
- * Any value returned in @static_instance_info must be freed using
- * g_base_info_unref(). The returned #GISignalInfo must be freed using
- * g_base_info_unref() as well. */
-static GISignalInfo *
-_gtype_look_up_signal (GIRegisteredTypeInfo *dynamic_instance_info,
-                       GIRegisteredTypeInfo **static_instance_info,
-                       const gchar *signal_name)
-{
-	GISignalInfo *signal_info;
-	gint n_signals;
-
-	if (GI_IS_OBJECT_INFO (dynamic_instance_info)) {
-		n_signals = g_object_info_get_n_signals (dynamic_instance_info);
-	} else if (GI_IS_INTERFACE_INFO (dynamic_instance_info)) {
-		n_signals = g_interface_info_get_n_signals (dynamic_instance_info);
-	} else {
-		g_assert_not_reached ();
-	}
-
-	for (gint i = 0; i < n_signals; i++) {
-		if (GI_IS_OBJECT_INFO (dynamic_instance_info)) {
-			signal_info = g_object_info_get_signal (dynamic_instance_info, i);
-		} else if (GI_IS_INTERFACE_INFO (dynamic_instance_info)) {
-			signal_info = g_interface_info_get_signal (dynamic_instance_info, i);
-		} else {
-			g_assert_not_reached ();
-		}
-
-		if (strcmp (signal_name,
-		            g_base_info_get_name (signal_info)) == 0) {
-			/* Found the signal. */
-			*static_instance_info =
-				g_base_info_ref (dynamic_instance_info);
-			return signal_info;
-		}
-
-		g_base_info_unref (signal_info);
-	}
-
-	if (GI_IS_OBJECT_INFO (dynamic_instance_info)) {
-		/* If the object implements any interfaces, try those. */
-		for (gint i = 0;
-		     i < g_object_info_get_n_interfaces (dynamic_instance_info);
-		     i++) {
-			GIInterfaceInfo *b;
-
-			b = g_object_info_get_interface (dynamic_instance_info, i);
-			signal_info = _gtype_look_up_signal (b,
-			                                     static_instance_info,
-			                                     signal_name);
-			g_base_info_unref (b);
-
-			if (signal_info != NULL) {
-				return signal_info;
-			}
-		}
-
-		/* If the object has a parent class, try that. */
-		dynamic_instance_info = g_object_info_get_parent (dynamic_instance_info);
-		if (dynamic_instance_info != NULL) {
-			signal_info = _gtype_look_up_signal (dynamic_instance_info,
-			                                     static_instance_info,
-			                                     signal_name);
-			g_base_info_unref (dynamic_instance_info);
-
-			return signal_info;
-		}
-	}
-
-	/* Found nothing. */
-	*static_instance_info = NULL;
-	return NULL;
+	return gtype_cache.get_object_info (expr->getType ());
 }
 
 /* Look up the #QualType representing the type in @type_info, which must be
@@ -301,7 +222,7 @@ _type_interface_info_to_type (GITypeInfo *type_info,
 	g_base_info_unref (interface_info);
 
 	if (g_type_info_is_pointer (type_info)) {
-		retval = context.getPointerType (retval);
+		retval = type_manager.get_pointer_type (retval);
 	}
 
 	return retval;
@@ -343,14 +264,10 @@ _type_array_info_to_type (GITypeInfo *array_info,
 		 * examining a callback type (as opposed to a call itself). */
 
 		if (fixed_size > -1) {
-			return context.getConstantArrayType (element_type,
-			                                     llvm::APInt (32, fixed_size),
-			                                     ArrayType::ArraySizeModifier::Static,
-			                                     0);
+			return type_manager.get_constant_array_type (element_type,
+			                                             llvm::APInt (32, fixed_size));
 		} else {
-			return context.getIncompleteArrayType (element_type,
-			                                       ArrayType::ArraySizeModifier::Static,
-			                                       0);
+			return type_manager.get_incomplete_array_type (element_type);
 		}
 	}
 	case GI_ARRAY_TYPE_ARRAY:
@@ -408,7 +325,7 @@ _type_info_to_type (GITypeInfo *type_info,
 		return context.getSizeType ();
 	case GI_TYPE_TAG_UTF8:
 	case GI_TYPE_TAG_FILENAME:
-		return context.getPointerType (context.getConstType (context.CharTy));
+		return type_manager.get_pointer_type (context.getConstType (context.CharTy));
 	case GI_TYPE_TAG_UNICHAR:
 		return context.getIntTypeForBitwidth (32, false);
 	/* Non-basic types */
@@ -435,92 +352,72 @@ _type_info_to_type (GITypeInfo *type_info,
 	}
 }
 
-/* Returns true iff
- *  • @a is a GObject, @b is a GObject, and @a is equal to or a subclass of @b;
- *  • @a is a GInterface, @b is a GInterface, and @a is equal to @b;
- *  • @a is a GInterface, @b is a GObject, and at least one of @a’s
- *    prerequisites is equal to or a subtype of @b;
- *  • @a is a GObject, @b is a GInterface, and @a or one of its superclasses
- *    implements @b.
- */
-static bool
-_is_gtype_subclass (GIBaseInfo *a, GIBaseInfo *b)
+/* Get the callback type expected for @signal_info, which is defined on
+ * @static_instance_info, converting it from the GIR type information the first
+ * time it’s needed and caching it in @callback_types thereafter. */
+static const SignalCallbackType &
+_get_signal_callback_type (GISignalInfo *signal_info,
+                           GIBaseInfo *static_instance_info,
+                           bool is_swapped,
+                           const ASTContext &context,
+                           const GirManager &gir_manager,
+                           TypeManager &type_manager,
+                           SignalCallbackTypeCache &callback_types)
 {
-	GIInfoType a_type, b_type;
-
-	a_type = g_base_info_get_type (a);
-	b_type = g_base_info_get_type (b);
-
-	DEBUG ("Checking whether " << g_base_info_get_name (a) << " is a "
-	       "subtype of " << g_base_info_get_name (b) << ".");
+	std::pair<void *, unsigned int> key (signal_info, is_swapped ? 1 : 0);
+	SignalCallbackTypeCache::iterator it = callback_types.find (key);
 
-	assert (a_type == GI_INFO_TYPE_OBJECT ||
-	        a_type == GI_INFO_TYPE_INTERFACE);
-	assert (b_type == GI_INFO_TYPE_OBJECT ||
-	        b_type == GI_INFO_TYPE_INTERFACE);
-
-	/* The case where @a and @b are equal. */
-	if (g_base_info_equal (a, b)) {
-		return true;
+	if (it != callback_types.end ()) {
+		return it->second;
 	}
 
-	/* The case where @a implements @b. */
-	if (a_type == GI_INFO_TYPE_OBJECT &&
-	    b_type == GI_INFO_TYPE_INTERFACE) {
-		for (gint i = 0; i < g_object_info_get_n_interfaces (a); i++) {
-			GIInterfaceInfo *iface;
-
-			iface = g_object_info_get_interface (a, i);
-			bool eq = g_base_info_equal (iface, b);
-			g_base_info_unref (iface);
+	SignalCallbackType &callback_type = callback_types[key];
+	GICallableInfo *callable_info = signal_info;
+	bool resolved = true;
 
-			if (eq) {
-				return true;
-			}
-		}
-	}
+	for (gint i = 0; i < g_callable_info_get_n_args (callable_info); i++) {
+		GIArgInfo arg_info;
+		GITypeInfo type_info;
 
-	/* The case where one of @a’s prerequisites is a subtype of @b. Note
-	 * that prerequisites may be classes or interfaces, and all interfaces
-	 * have GObject as an implicit prerequisite. */
-	if (a_type == GI_INFO_TYPE_INTERFACE &&
-	    b_type == GI_INFO_TYPE_OBJECT) {
-		/* GObject prerequisite. */
-		if (strcmp (g_base_info_get_namespace (b), "GObject") == 0 &&
-		    strcmp (g_base_info_get_name (b), "Object") == 0) {
-			return true;
-		}
+		g_callable_info_load_arg (callable_info, i, &arg_info);
+		g_arg_info_load_type (&arg_info, &type_info);
 
-		/* Normal prerequisites. */
-		for (gint i = 0; i < g_interface_info_get_n_prerequisites (a); i++) {
-			GIBaseInfo *prereq;
+		QualType param_type = _type_info_to_type (&type_info, context,
+		                                          gir_manager,
+		                                          type_manager);
+		callback_type.param_types.push_back (param_type);
+		resolved = resolved && !param_type.isNull ();
+	}
 
-			prereq = g_interface_info_get_prerequisite (a, i);
-			bool subtype = _is_gtype_subclass (prereq, b);
-			g_base_info_unref (prereq);
+	GITypeInfo return_type_info;
 
-			if (subtype) {
-				return true;
-			}
-		}
-	}
+	g_callable_info_load_return_type (callable_info, &return_type_info);
+	callback_type.return_type = _type_info_to_type (&return_type_info,
+	                                                context, gir_manager,
+	                                                type_manager);
+	resolved = resolved && !callback_type.return_type.isNull ();
 
-	/* The case where @a is a subclass of @b, or a subclass of a class which
-	 * implements @b. */
-	if (a_type == GI_INFO_TYPE_OBJECT) {
-		GIObjectInfo *ap = g_object_info_get_parent (a);
+	/* Build the whole prototype, adding the instance and user data
+	 * parameters which GIR omits. */
+	QualType instance_type =
+		type_manager.find_pointer_type_by_name (gir_manager.get_c_name_for_type (static_instance_info));
+	QualType user_data_type = type_manager.get_pointer_type (context.VoidTy);
 
-		if (ap == NULL) {
-			return false;
-		}
+	if (resolved && !instance_type.isNull ()) {
+		std::vector<QualType> proto_params;
 
-		bool subclass = _is_gtype_subclass (ap, b);
-		g_base_info_unref (ap);
+		proto_params.push_back (is_swapped ? user_data_type : instance_type);
+		proto_params.insert (proto_params.end (),
+		                     callback_type.param_types.begin (),
+		                     callback_type.param_types.end ());
+		proto_params.push_back (is_swapped ? instance_type : user_data_type);
 
-		return subclass;
+		callback_type.proto =
+			type_manager.get_function_type (callback_type.return_type,
+			                                proto_params);
 	}
 
-	return false;
+	return callback_type;
 }
 
 /* A safe calling convention is any convention which is caller-cleanup and where
@@ -686,7 +583,9 @@ _check_signal_callback_type (const Expr *expr,
                              CompilerInstance &compiler,
                              const ASTContext &context,
                              const GirManager &gir_manager,
-                             TypeManager &type_manager)
+                             TypeManager &type_manager,
+                             GTypeCache &gtype_cache,
+                             SignalCallbackTypeCache &callback_types)
 {
 	const FunctionProtoType *callback_type = NULL;
 	SourceRange decl_range;  /* for the callback definition */
@@ -739,7 +638,8 @@ _check_signal_callback_type (const Expr *expr,
 		                                    data_type, is_swapped,
 		                                    signal_info, compiler,
 		                                    context, gir_manager,
-		                                    type_manager);
+		                                    type_manager, gtype_cache,
+		                                    callback_types);
 	}
 	case Stmt::StmtClass::ImplicitCastExprClass:
 	case Stmt::StmtClass::CStyleCastExprClass: {
@@ -752,7 +652,8 @@ _check_signal_callback_type (const Expr *expr,
 		                                    data_type, is_swapped,
 		                                    signal_info, compiler,
 		                                    context, gir_manager,
-		                                    type_manager);
+		                                    type_manager, gtype_cache,
+		                                    callback_types);
 	}
 	case Stmt::StmtClass::NoStmtClass:
 	default:
@@ -784,6 +685,19 @@ _check_signal_callback_type (const Expr *expr,
 	guint n_signal_args = g_callable_info_get_n_args (callable_info) + 2;
 	guint n_callback_args;
 
+	/* Fast path: the callback has exactly the expected type. This is the
+	 * common case, and rules out all of the errors and remarks below. */
+	const SignalCallbackType &signal_callback_type =
+		_get_signal_callback_type (signal_info, static_instance_info,
+		                           is_swapped, context, gir_manager,
+		                           type_manager, callback_types);
+
+	if (!signal_callback_type.proto.isNull () &&
+	    context.hasSameType (QualType (callback_type, 0),
+	                         signal_callback_type.proto)) {
+		return true;
+	}
+
 #ifdef HAVE_LLVM_3_5
 	n_callback_args = callback_type->getNumParams ();
 #else /* if !HAVE_LLVM_3_5 */
@@ -839,15 +753,13 @@ _check_signal_callback_type (const Expr *expr,
 				atp = atp->getPointeeType ();
 			}
 
-			std::string actual_type_str =
-				atp.getUnqualifiedType ().getAsString ();
 			GIBaseInfo *actual_type_info =
-				gir_manager.find_object_info (actual_type_str);
+				gtype_cache.get_object_info (atp);
 
 			if (actual_type_info == NULL && is_swapped) {
 				/* Allow the instance argument to be a gpointer
 				 * if things are swapped. */
-				expected_type = context.getPointerType (context.VoidTy);
+				expected_type = type_manager.get_pointer_type (context.VoidTy);
 
 				DEBUG ("Comparing expected ‘" <<
 				       expected_type.getAsString () << "’ with "
@@ -870,7 +782,7 @@ _check_signal_callback_type (const Expr *expr,
 				<< arg_name
 				<< c_type
 				<< g_base_info_get_name (signal_info)
-				<< actual_type_str
+				<< atp.getUnqualifiedType ().getAsString ()
 				<< decl_range;
 
 				continue;
@@ -896,11 +808,11 @@ _check_signal_callback_type (const Expr *expr,
 				 * checking for the first parameter. */
 				type_error = (actual_type_info == NULL ||
 				              atp.isConstQualified () ||
-				              !_is_gtype_subclass (dynamic_instance_info,
+				              !gtype_cache.is_subclass (dynamic_instance_info,
 				                                   actual_type_info) ||
-				              !_is_gtype_subclass (static_instance_info,
+				              !gtype_cache.is_subclass (static_instance_info,
 				                                   actual_type_info) ||
-				              !_is_gtype_subclass (dynamic_instance_info,
+				              !gtype_cache.is_subclass (dynamic_instance_info,
 				                                   static_instance_info));
 
 				/* Remark about callbacks which have a instance
@@ -939,13 +851,11 @@ _check_signal_callback_type (const Expr *expr,
 					<< actual_type.getAsString ()
 					<< decl_range;
 				}
-
-				g_base_info_unref (actual_type_info);
 			}
 		} else if ((i == n_signal_args - 1 && !is_swapped) ||
 		           (i == 0 && is_swapped)) {
 			/* Final argument is always a gpointer user_data. */
-			expected_type = context.getPointerType (context.VoidTy);
+			expected_type = type_manager.get_pointer_type (context.VoidTy);
 			arg_name = "user_data";
 
 			DEBUG ("Comparing expected ‘" <<
@@ -979,11 +889,7 @@ _check_signal_callback_type (const Expr *expr,
 			g_arg_info_load_type (&arg_info, &expected_type_info);
 
 			arg_name = g_base_info_get_name (&arg_info);
-
-			expected_type = _type_info_to_type (&expected_type_info,
-			                                    context,
-			                                    gir_manager,
-			                                    type_manager);
+			expected_type = signal_callback_type.param_types[i - 1];
 
 			if (expected_type.isNull ()) {
 				/* Error. */
@@ -1062,8 +968,7 @@ _check_signal_callback_type (const Expr *expr,
 #else /* !HAVE_LLVM_3_5 */
 	actual_type = callback_type->getResultType ();
 #endif /* HAVE_LLVM_3_5 */
-	expected_type = _type_info_to_type (&expected_type_info, context,
-	                                    gir_manager, type_manager);
+	expected_type = signal_callback_type.return_type;
 	if (expected_type.isNull ()) {
 		/* Error. */
 
@@ -1214,7 +1119,8 @@ _parse_signal_name (const std::string &in)
  * and ensure that its declaration matches the signal definition.
  *
  * If the signal name string is not a string literal, or if the concrete type
- * of the GObject is not known, we can’t check anything. */
+ * of the GObject is not known, we can’t check anything. Otherwise, if
+ * @connection is non-%NULL, the connection is described in it. */
 static bool
 _check_gsignal_callback_type (const CallExpr &call,
                               const FunctionDecl &func,
@@ -1222,7 +1128,10 @@ _check_gsignal_callback_type (const CallExpr &call,
                               CompilerInstance &compiler,
                               const ASTContext &context,
                               const GirManager &gir_manager,
-                              TypeManager &type_manager)
+                              TypeManager &type_manager,
+                              GTypeCache &gtype_cache,
+                              SignalCallbackTypeCache &callback_types,
+                              SignalConnection *connection)
 {
 	const Expr *callback_arg, *gobject_arg, *signal_name_arg;
 	const Expr *user_data_arg;
@@ -1273,7 +1182,7 @@ _check_gsignal_callback_type (const CallExpr &call,
 	GIObjectInfo *dynamic_instance_info, *static_instance_info = NULL;
 
 	dynamic_instance_info = _expr_to_gtype (gobject_arg->IgnoreParenImpCasts (),
-	                                        context, gir_manager);
+	                                        gtype_cache);
 	if (dynamic_instance_info == NULL) {
 		/* Emit a remark rather than a warning because the user may not
 		 * easily be able to add a GIR file containing the signal
@@ -1303,9 +1212,9 @@ _check_gsignal_callback_type (const CallExpr &call,
 	/* Find the signal in the GObject. */
 	GISignalInfo *signal_info;
 
-	signal_info = _gtype_look_up_signal (dynamic_instance_info,
-	                                     &static_instance_info,
-	                                     signal_name.c_str ());
+	signal_info = gtype_cache.look_up_signal (dynamic_instance_info,
+	                                          signal_name,
+	                                          &static_instance_info);
 	if (signal_info == NULL) {
 		/* Remark on the fact the signal information cannot be found.
 		 * We can’t really make this a warning, since the user may not
@@ -1323,8 +1232,6 @@ _check_gsignal_callback_type (const CallExpr &call,
 		<< gobject_arg->getSourceRange ()
 		<< signal_name_arg->getSourceRange ();
 
-		g_base_info_unref (dynamic_instance_info);
-
 		return false;
 	}
 
@@ -1334,6 +1241,36 @@ _check_gsignal_callback_type (const CallExpr &call,
 	       g_base_info_get_namespace ((GIBaseInfo *) signal_info) <<
 	       "’.");
 
+	if (connection != NULL) {
+		connection->location = call.getLocStart ();
+		connection->connect_func = func_info->func_name;
+		connection->instance_type =
+			gir_manager.get_c_name_for_type (dynamic_instance_info);
+		connection->signal_type = (static_instance_info != NULL) ?
+			gir_manager.get_c_name_for_type (static_instance_info) :
+			connection->instance_type;
+		connection->signal_name = signal_name;
+		connection->swapped = is_swapped;
+
+		llvm::APSInt flags_value;
+
+		connection->after =
+			(strcmp (func_info->func_name,
+			         "g_signal_connect_after") == 0 ||
+			 (flags_arg != NULL &&
+			  type_manager.evaluate_as_int (*flags_arg,
+			                                flags_value) &&
+			  (flags_value.getLimitedValue () & G_CONNECT_AFTER) != 0));
+
+		const DeclRefExpr *callback_ref =
+			dyn_cast<DeclRefExpr> (callback_arg->IgnoreParenCasts ());
+
+		if (callback_ref != NULL) {
+			connection->handler =
+				dyn_cast<FunctionDecl> (callback_ref->getDecl ());
+		}
+	}
+
 	/* Check the callback’s type. */
 	if (!_check_signal_callback_type (callback_arg->IgnoreParenImpCasts (),
 	                                  dynamic_instance_info,
@@ -1341,19 +1278,214 @@ _check_gsignal_callback_type (const CallExpr &call,
 	                                  user_data_arg->getType (), is_swapped,
 	                                  signal_info,
 	                                  compiler, context, gir_manager,
-	                                  type_manager)) {
+	                                  type_manager, gtype_cache,
+	                                  callback_types)) {
 		/* A diagnostic has already been emitted by
 		 * _check_signal_callback_type(). */
-		g_base_info_unref (signal_info);
-		g_base_info_unref (dynamic_instance_info);
-		g_base_info_unref (static_instance_info);
-
 		return false;
 	}
 
-	g_base_info_unref (signal_info);
-	g_base_info_unref (dynamic_instance_info);
-	g_base_info_unref (static_instance_info);
+	return true;
+}
+
+/* Whether @actual_type may be passed as a variadic argument to a signal
+ * emission for a parameter of @expected_type. Both are compared after default
+ * argument promotion; pointers must point to the same type, or to void, or
+ * both to GObjects (whose subtyping isn’t checked). Type layouts are queried
+ * through @type_manager, as they may be computed (and cached in the
+ * #ASTContext) on demand. */
+static bool
+_emission_arg_type_is_compatible (QualType actual_type,
+                                  QualType expected_type,
+                                  const ASTContext &context,
+                                  TypeManager &type_manager,
+                                  GTypeCache &gtype_cache)
+{
+	if (expected_type->isPromotableIntegerType ()) {
+		expected_type =
+			type_manager.get_promoted_integer_type (expected_type);
+	}
+
+	if (expected_type->isPointerType () || actual_type->isPointerType ()) {
+		if (!expected_type->isPointerType () ||
+		    !actual_type->isPointerType ()) {
+			return false;
+		}
+
+		QualType expected_pointee =
+			expected_type->getPointeeType ().getUnqualifiedType ();
+		QualType actual_pointee =
+			actual_type->getPointeeType ().getUnqualifiedType ();
+
+		return (expected_pointee->isVoidType () ||
+		        actual_pointee->isVoidType () ||
+		        context.hasSameType (expected_pointee, actual_pointee) ||
+		        (gtype_cache.get_object_info (expected_pointee) != NULL &&
+		         gtype_cache.get_object_info (actual_pointee) != NULL));
+	}
+
+	if (expected_type->isRealFloatingType () ||
+	    actual_type->isRealFloatingType ()) {
+		return (expected_type->isRealFloatingType () &&
+		        actual_type->isRealFloatingType ());
+	}
+
+	if (expected_type->isIntegralOrEnumerationType () &&
+	    actual_type->isIntegralOrEnumerationType ()) {
+		return (type_manager.get_type_size (expected_type) ==
+		        type_manager.get_type_size (actual_type));
+	}
+
+	return true;
+}
+
+/* Check a g_signal_emit_by_name() call. If it’s inside a loop, warn that the
+ * signal is looked up on each iteration. If the signal can be resolved, check
+ * the variadic arguments against its parameters and return type. */
+static void
+_check_gsignal_emit_by_name (const CallExpr &call,
+                             bool in_loop,
+                             CompilerInstance &compiler,
+                             const ASTContext &context,
+                             const GirManager &gir_manager,
+                             TypeManager &type_manager,
+                             GTypeCache &gtype_cache,
+                             SignalCallbackTypeCache &callback_types)
+{
+	if (call.getNumArgs () < 2) {
+		return;
+	}
+
+	const Expr *gobject_arg = call.getArg (0);
+	const Expr *signal_name_arg = call.getArg (1);
+
+	/* Names which aren’t string literals can’t be looked up up-front
+	 * anyway. */
+	const StringLiteral *signal_name_str =
+		dyn_cast<StringLiteral> (signal_name_arg->IgnoreParenImpCasts ());
+	if (signal_name_str == NULL) {
+		return;
+	}
+
+	std::string signal_name =
+		_parse_signal_name (signal_name_str->getString ().str ());
+
+	if (in_loop) {
+		Debug::emit_warning ("Signal ‘%0’ is looked up by name on "
+		                     "every iteration of this loop. Look up its "
+		                     "ID once using g_signal_lookup(), or use the "
+		                     "ID saved when the signal was created, and "
+		                     "emit it using g_signal_emit().",
+		                     compiler, call.getLocStart ())
+		<< signal_name
+		<< signal_name_arg->getSourceRange ();
+	}
+
+	GIObjectInfo *dynamic_instance_info, *static_instance_info = NULL;
+
+	dynamic_instance_info = _expr_to_gtype (gobject_arg->IgnoreParenImpCasts (),
+	                                        gtype_cache);
+	if (dynamic_instance_info == NULL) {
+		return;
+	}
+
+	GISignalInfo *signal_info =
+		gtype_cache.look_up_signal (dynamic_instance_info, signal_name,
+		                            &static_instance_info);
+	if (signal_info == NULL || static_instance_info == NULL) {
+		return;
+	}
+
+	const SignalCallbackType &signal_callback_type =
+		_get_signal_callback_type (signal_info, static_instance_info,
+		                           false, context, gir_manager,
+		                           type_manager, callback_types);
+	const std::string static_instance_name =
+		gir_manager.get_c_name_for_type (static_instance_info);
+
+	/* The signal’s parameters, then a pointer to the return value
+	 * location, if it has one. */
+	if (signal_callback_type.return_type.isNull ()) {
+		return;
+	}
+
+	unsigned int n_params = signal_callback_type.param_types.size ();
+	bool has_return_value =
+		!signal_callback_type.return_type->isVoidType ();
+	unsigned int n_expected_args = n_params + (has_return_value ? 1 : 0);
+	unsigned int n_actual_args = call.getNumArgs () - 2;
+
+	if (n_actual_args != n_expected_args) {
+		Debug::emit_error ("Incorrect number of arguments to "
+		                   "g_signal_emit_by_name() for signal "
+		                   "‘%0::%1’. Expected %2 but saw %3.",
+		                   compiler, call.getLocStart ())
+		<< static_instance_name
+		<< signal_name
+		<< n_expected_args
+		<< n_actual_args;
+
+		return;
+	}
+
+	for (unsigned int i = 0; i < n_params; i++) {
+		QualType expected_type = signal_callback_type.param_types[i];
+		const Expr *arg = call.getArg (i + 2);
+
+		/* Unresolved types, and NULL, can’t be checked. */
+		if (expected_type.isNull () ||
+		    (expected_type->isPointerType () &&
+		     type_manager.is_null_pointer_constant (*arg,
+		                                            Expr::NPC_ValueDependentIsNotNull))) {
+			continue;
+		}
+
+		if (!_emission_arg_type_is_compatible (arg->getType (),
+		                                       expected_type, context,
+		                                       type_manager,
+		                                       gtype_cache)) {
+			Debug::emit_error ("Incorrect type for argument %0 to "
+			                   "g_signal_emit_by_name() for signal "
+			                   "‘%1::%2’. Expected ‘%3’ but saw "
+			                   "‘%4’.",
+			                   compiler, arg->getLocStart ())
+			<< i + 1
+			<< static_instance_name
+			<< signal_name
+			<< expected_type.getAsString ()
+			<< arg->IgnoreParenImpCasts ()->getType ().getAsString ()
+			<< arg->getSourceRange ();
+		}
+	}
+
+	if (has_return_value) {
+		const Expr *arg = call.getArg (call.getNumArgs () - 1);
+		QualType expected_type =
+			type_manager.get_pointer_type (signal_callback_type.return_type);
+
+		if (!_emission_arg_type_is_compatible (arg->getType (),
+		                                       expected_type, context,
+		                                       type_manager,
+		                                       gtype_cache)) {
+			Debug::emit_error ("Incorrect type for return value "
+			                   "location passed to "
+			                   "g_signal_emit_by_name() for signal "
+			                   "‘%0::%1’. Expected ‘%2’ but saw "
+			                   "‘%3’.",
+			                   compiler, arg->getLocStart ())
+			<< static_instance_name
+			<< signal_name
+			<< expected_type.getAsString ()
+			<< arg->IgnoreParenImpCasts ()->getType ().getAsString ()
+			<< arg->getSourceRange ();
+		}
+	}
+}
+
+bool
+GSignalConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
+{
+	this->_traverse_top_level_decls (decl_group, this->_visitor);
 
 	return true;
 }
@@ -1361,12 +1493,171 @@ _check_gsignal_callback_type (const CallExpr &call,
 void
 GSignalConsumer::HandleTranslationUnit (ASTContext& context)
 {
-	/* Run away if the plugin is disabled. */
-	if (!this->is_enabled ()) {
+	bool record_connections =
+		!this->_options.get ()->signal_graph_output.empty ();
+	std::vector<std::unique_ptr<GSignalVisitor>> workers;
+
+	this->_visitor.record_connections = record_connections;
+
+	if (!this->_traverse_translation_unit<GSignalVisitor> (context,
+	                                                       this->_visitor,
+		[this, record_connections] () {
+			GSignalVisitor *visitor =
+				new GSignalVisitor (this->_compiler,
+				                    this->_gir_manager);
+			visitor->record_connections = record_connections;
+			return visitor;
+		}, &workers) || !record_connections) {
+		return;
+	}
+
+	/* Collect the connections from whichever visitors were used. */
+	std::vector<SignalConnection> connections = this->_visitor.connections;
+
+	for (std::vector<std::unique_ptr<GSignalVisitor>>::const_iterator it = workers.begin (),
+	     ie = workers.end (); it != ie; ++it) {
+		connections.insert (connections.end (),
+		                    (*it)->connections.begin (),
+		                    (*it)->connections.end ());
+	}
+
+	this->_write_signal_graph (connections, context.getSourceManager ());
+}
+
+/* Append @str to @out as a JSON string, or null if it’s empty. */
+static void
+_write_json_string (llvm::raw_ostream &out, const std::string &str)
+{
+	if (str.empty ()) {
+		out << "null";
+		return;
+	}
+
+	out << '"';
+
+	for (std::string::const_iterator it = str.begin (), ie = str.end ();
+	     it != ie; ++it) {
+		unsigned char c = *it;
+
+		if (c == '"' || c == '\\') {
+			out << '\\' << c;
+		} else if (c < 0x20) {
+			out << llvm::format ("\\u%04x", c);
+		} else {
+			out << c;
+		}
+	}
+
+	out << '"';
+}
+
+/* Format @loc as file:line:column, or an empty string if it’s invalid. */
+static std::string
+_format_location (const SourceManager &sm, SourceLocation loc)
+{
+	PresumedLoc presumed_loc = sm.getPresumedLoc (loc);
+
+	if (presumed_loc.isInvalid ()) {
+		return "";
+	}
+
+	return std::string (presumed_loc.getFilename ()) + ":" +
+	       std::to_string (presumed_loc.getLine ()) + ":" +
+	       std::to_string (presumed_loc.getColumn ());
+}
+
+/* Append the signal @connections found in the translation unit to the
+ * --signal-graph file, in source order, as JSON lines. */
+void
+GSignalConsumer::_write_signal_graph (std::vector<SignalConnection>& connections,
+                                      const SourceManager& sm)
+{
+	const std::string& filename =
+		this->_options.get ()->signal_graph_output;
+
+	if (connections.empty ()) {
 		return;
 	}
 
-	this->_visitor.TraverseDecl (context.getTranslationUnitDecl ());
+	std::sort (connections.begin (), connections.end (),
+		[&sm] (const SignalConnection &a, const SignalConnection &b) {
+			return sm.isBeforeInTranslationUnit (a.location,
+			                                     b.location);
+		});
+
+	std::string contents;
+	llvm::raw_string_ostream out (contents);
+
+	for (std::vector<SignalConnection>::const_iterator it = connections.begin (),
+	     ie = connections.end (); it != ie; ++it) {
+		out << "{\"location\": ";
+		_write_json_string (out, _format_location (sm, it->location));
+		out << ", \"caller\": ";
+		_write_json_string (out, it->caller);
+		out << ", \"connect\": ";
+		_write_json_string (out, it->connect_func);
+		out << ", \"instance\": ";
+		_write_json_string (out, it->instance_type);
+		out << ", \"signal\": ";
+		_write_json_string (out, it->signal_type + "::" + it->signal_name);
+		out << ", \"handler\": ";
+		_write_json_string (out, (it->handler != NULL) ?
+		                         it->handler->getNameAsString () : "");
+		out << ", \"handler_location\": ";
+		_write_json_string (out, (it->handler != NULL) ?
+		                         _format_location (sm, it->handler->getLocation ()) : "");
+		out << ", \"after\": " << (it->after ? "true" : "false")
+		    << ", \"swapped\": " << (it->swapped ? "true" : "false")
+		    << "}\n";
+	}
+
+	out.flush ();
+
+	Debug::append_report (filename, contents,
+	                      "Failed to write signal graph ‘%0’: %1",
+	                      this->_compiler);
+}
+
+/* Note: Specifically overriding the Traverse* methods here to track the
+ * loop nesting depth while recursing to child nodes. */
+bool
+GSignalVisitor::TraverseForStmt (ForStmt* stmt)
+{
+	this->_loop_depth++;
+	bool retval = RecursiveASTVisitor<GSignalVisitor>::TraverseForStmt (stmt);
+	this->_loop_depth--;
+
+	return retval;
+}
+
+bool
+GSignalVisitor::TraverseWhileStmt (WhileStmt* stmt)
+{
+	this->_loop_depth++;
+	bool retval = RecursiveASTVisitor<GSignalVisitor>::TraverseWhileStmt (stmt);
+	this->_loop_depth--;
+
+	return retval;
+}
+
+bool
+GSignalVisitor::TraverseDoStmt (DoStmt* stmt)
+{
+	this->_loop_depth++;
+	bool retval = RecursiveASTVisitor<GSignalVisitor>::TraverseDoStmt (stmt);
+	this->_loop_depth--;
+
+	return retval;
+}
+
+bool
+GSignalVisitor::VisitFunctionDecl (FunctionDecl* func)
+{
+	if (func->isThisDeclarationADefinition ()) {
+		this->_current_function = func->getNameAsString ();
+	}
+
+	return true;
 }
 
 /* Note: Specifically overriding the Traverse* method here to re-implement
@@ -1382,16 +1673,42 @@ GSignalVisitor::VisitCallExpr (CallExpr* expr)
 	if (func == NULL)
 		return true;
 
-	/* We’re only interested in functions which connect signals. */
+	const GirManager *gir_manager = this->_gir_manager.get ();
+
+	/* Signal emissions. */
+	const IdentifierInfo *func_ident = func->getIdentifier ();
+	if (func_ident != NULL &&
+	    func_ident->getName () == "g_signal_emit_by_name") {
+		_check_gsignal_emit_by_name (*expr, this->_loop_depth > 0,
+		                             this->_compiler,
+		                             func->getASTContext (),
+		                             *gir_manager, this->_type_manager,
+		                             this->_gtype_cache,
+		                             this->_callback_types);
+		return true;
+	}
+
+	/* Otherwise, we’re only interested in functions which connect
+	 * signals. */
 	func_info = _func_is_gsignal_connect (*func);
 	if (func_info == NULL)
 		return true;
 
 	/* Check the callback type. */
-	const GirManager *gir_manager = this->_gir_manager.get ();
+	SignalConnection connection;
+
 	_check_gsignal_callback_type (*expr, *func, func_info, this->_compiler,
 	                              func->getASTContext (),
-	                              *gir_manager, this->_type_manager);
+	                              *gir_manager, this->_type_manager,
+	                              this->_gtype_cache,
+	                              this->_callback_types,
+	                              this->record_connections ?
+	                                      &connection : NULL);
+
+	if (this->record_connections && !connection.signal_name.empty ()) {
+		connection.caller = this->_current_function;
+		this->connections.push_back (connection);
+	}
 
 	return true;
 }
@@ -23,36 +23,91 @@
 #ifndef TARTAN_GSIGNAL_CHECKER_H
 #define TARTAN_GSIGNAL_CHECKER_H
 
+#include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <clang/AST/AST.h>
 #include <clang/AST/ASTConsumer.h>
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/Frontend/CompilerInstance.h>
+#include <llvm/ADT/DenseMap.h>
 
 #include "checker.h"
 #include "gir-manager.h"
+#include "gtype-cache.h"
 #include "type-manager.h"
 
 namespace tartan {
 
 using namespace clang;
 
+/* The callback type expected for a signal, derived from its GIR information.
+ * @param_types are the types of the signal’s own parameters (excluding the
+ * instance and user data), and @return_type its return type; any of them may
+ * be null if they could not be resolved. @proto is the whole expected
+ * #FunctionProtoType, or null if any part of it could not be resolved. */
+struct SignalCallbackType {
+	QualType proto;
+	std::vector<QualType> param_types;
+	QualType return_type;
+};
+
+/* Keyed by the (cache-owned) #GISignalInfo and whether it’s swapped. */
+typedef llvm::DenseMap<std::pair<void *, unsigned int>,
+                       SignalCallbackType> SignalCallbackTypeCache;
+
+/* A signal connection call whose signal could be resolved, recorded for
+ * --signal-graph. @handler is null if the callback isn’t a direct reference
+ * to a function. */
+struct SignalConnection {
+	SignalConnection () : handler (NULL), after (false), swapped (false) {}
+
+	SourceLocation location;
+	std::string caller;
+	std::string connect_func;
+	std::string instance_type;
+	std::string signal_type;
+	std::string signal_name;
+	const FunctionDecl *handler;
+	bool after;
+	bool swapped;
+};
+
 class GSignalVisitor : public RecursiveASTVisitor<GSignalVisitor> {
 public:
 	explicit GSignalVisitor (CompilerInstance& compiler,
 	                         std::shared_ptr<const GirManager> gir_manager) :
+		record_connections (false),
 		_compiler (compiler), _context (compiler.getASTContext ()),
 		_gir_manager (gir_manager),
-		_type_manager (compiler.getASTContext ()) {}
+		_type_manager (compiler.getASTContext ()),
+		_gtype_cache (gir_manager), _loop_depth (0) {}
+
+	/* Whether to record the resolved connections in @connections. */
+	bool record_connections;
+	std::vector<SignalConnection> connections;
 
 private:
 	CompilerInstance& _compiler;
 	const ASTContext& _context;
 	std::shared_ptr<const GirManager> _gir_manager;
 	TypeManager _type_manager;
+	GTypeCache _gtype_cache;
+	SignalCallbackTypeCache _callback_types;
+
+	/* Name of the function currently being traversed. */
+	std::string _current_function;
+
+	/* Number of loops enclosing the current node. */
+	unsigned int _loop_depth;
 
 public:
+	bool TraverseForStmt (ForStmt* stmt);
+	bool TraverseWhileStmt (WhileStmt* stmt);
+	bool TraverseDoStmt (DoStmt* stmt);
+	bool VisitFunctionDecl (FunctionDecl* func);
 	bool VisitCallExpr (CallExpr* call);
 };
 
@@ -60,14 +115,19 @@ class GSignalConsumer : public tartan::ASTChecker {
 public:
 	GSignalConsumer (CompilerInstance& compiler,
 	                 std::shared_ptr<const GirManager> gir_manager,
-	                 std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins) :
-		ASTChecker (compiler, gir_manager, disabled_plugins),
+	                 std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins,
+	                 std::shared_ptr<const PluginOptions> options) :
+		ASTChecker (compiler, gir_manager, disabled_plugins, options),
 		_visitor (compiler, gir_manager) {};
 
 private:
 	GSignalVisitor _visitor;
 
+	void _write_signal_graph (std::vector<SignalConnection>& connections,
+	                          const SourceManager& sm);
+
 public:
+	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
 	virtual void HandleTranslationUnit (ASTContext& context);
 	const std::string get_name () const { return "gsignal"; }
 };
@@ -0,0 +1,438 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+/**
+ * GTypeCache:
+ *
+ * Looking up a GObject class in the GIR typelibs requires probing each loaded
+ * namespace by name, and looking up a signal on it requires walking its
+ * parents and interfaces, reffing and unreffing infos along the way. The same
+ * few classes are used over and over again in a translation unit, so each
+ * class is resolved once, and its signal and property tables and ancestors are
+ * flattened the first time they’re needed.
+ */
+
+#include "config.h"
+
+#include <cassert>
+#include <vector>
+
+#include "debug.h"
+#include "gtype-cache.h"
+
+namespace tartan {
+
+/* Return the name of @info, qualified with its namespace, which uniquely
+ * identifies it in the repository. */
+static std::string
+_get_qualified_name (GIBaseInfo *info)
+{
+	std::string name (g_base_info_get_namespace (info));
+	name += ".";
+	name += g_base_info_get_name (info);
+
+	return name;
+}
+
+GTypeCache::~GTypeCache ()
+{
+	for (std::unordered_map<std::string, std::unique_ptr<Class>>::iterator
+	     it = this->_classes.begin (), ie = this->_classes.end ();
+	     it != ie; ++it) {
+		Class *klass = it->second.get ();
+
+		/* Inherited signals are owned by the class defining them. */
+		for (std::unordered_map<std::string, Signal>::iterator
+		     st = klass->signals.begin (), se = klass->signals.end ();
+		     st != se; ++st) {
+			if (st->second.owner == klass->info) {
+				g_base_info_unref (st->second.info);
+			}
+		}
+
+		/* Likewise for properties. */
+		for (std::unordered_map<std::string, Property>::iterator
+		     pt = klass->properties.begin (), pe = klass->properties.end ();
+		     pt != pe; ++pt) {
+			if (pt->second.owner == klass->info) {
+				g_base_info_unref (pt->second.info);
+			}
+		}
+
+		g_base_info_unref (klass->info);
+	}
+}
+
+/* Get the cache entry for @info, creating it if necessary. @info is not
+ * consumed. */
+GTypeCache::Class *
+GTypeCache::_get_class (GIBaseInfo *info)
+{
+	const std::string name = _get_qualified_name (info);
+	std::unordered_map<std::string, std::unique_ptr<Class>>::iterator it =
+		this->_classes.find (name);
+
+	if (it != this->_classes.end ()) {
+		return it->second.get ();
+	}
+
+	Class *klass = new Class ();
+	klass->info = g_base_info_ref (info);
+	klass->signals_built = false;
+	klass->properties_built = false;
+	klass->ancestors_built = false;
+	this->_classes[name] = std::unique_ptr<Class> (klass);
+
+	return klass;
+}
+
+/* If @type is a (pointer to a) GObject or GInterface, return the most specific
+ * type information we can for it. Otherwise return %NULL. Negative results are
+ * cached too. */
+GIBaseInfo *
+GTypeCache::get_object_info (QualType type)
+{
+	while (type->isPointerType ()) {
+		type = type->getPointeeType ();
+	}
+
+	type = type.getUnqualifiedType ();
+
+	llvm::DenseMap<void *, GIBaseInfo *>::iterator it =
+		this->_object_infos.find (type.getAsOpaquePtr ());
+
+	if (it != this->_object_infos.end ()) {
+		return it->second;
+	}
+
+	GIBaseInfo *info, *retval = NULL;
+
+	info = this->_gir_manager.get ()->find_object_info (type.getAsString ());
+
+	if (info != NULL) {
+		retval = this->_get_class (info)->info;
+		g_base_info_unref (info);
+	}
+
+	this->_object_infos[type.getAsOpaquePtr ()] = retval;
+
+	return retval;
+}
+
+/* Flatten the signals of @klass and everything it inherits from into
+ * @klass->signals. Where several types define a signal with the same name,
+ * the first one found wins: the type itself, then its interfaces, then its
+ * parent class (recursively). */
+void
+GTypeCache::_build_signals (Class *klass)
+{
+	GIBaseInfo *info = klass->info;
+	gint n_signals;
+
+	klass->signals_built = true;
+
+	if (GI_IS_OBJECT_INFO (info)) {
+		n_signals = g_object_info_get_n_signals (info);
+	} else if (GI_IS_INTERFACE_INFO (info)) {
+		n_signals = g_interface_info_get_n_signals (info);
+	} else {
+		g_assert_not_reached ();
+	}
+
+	for (gint i = 0; i < n_signals; i++) {
+		Signal signal;
+
+		if (GI_IS_OBJECT_INFO (info)) {
+			signal.info = g_object_info_get_signal (info, i);
+		} else {
+			signal.info = g_interface_info_get_signal (info, i);
+		}
+
+		signal.owner = info;
+
+		if (!klass->signals.insert (std::make_pair (g_base_info_get_name (signal.info),
+		                                            signal)).second) {
+			g_base_info_unref (signal.info);
+		}
+	}
+
+	if (!GI_IS_OBJECT_INFO (info)) {
+		return;
+	}
+
+	/* Signals from the interfaces the object implements, then from its
+	 * parent class. */
+	std::vector<Class *> supertypes;
+
+	for (gint i = 0; i < g_object_info_get_n_interfaces (info); i++) {
+		GIInterfaceInfo *iface = g_object_info_get_interface (info, i);
+		supertypes.push_back (this->_get_class (iface));
+		g_base_info_unref (iface);
+	}
+
+	GIObjectInfo *parent = g_object_info_get_parent (info);
+	if (parent != NULL) {
+		supertypes.push_back (this->_get_class (parent));
+		g_base_info_unref (parent);
+	}
+
+	for (std::vector<Class *>::const_iterator it = supertypes.begin (),
+	     ie = supertypes.end (); it != ie; ++it) {
+		Class *super = *it;
+
+		if (!super->signals_built) {
+			this->_build_signals (super);
+		}
+
+		klass->signals.insert (super->signals.begin (),
+		                       super->signals.end ());
+	}
+}
+
+/* Look up a named signal in a #GIObjectInfo or #GIInterfaceInfo,
+ * @instance_info.
+ *
+ * If no definition for the signal can be found, %NULL will be returned.
+ *
+ * Otherwise, the #GIObjectInfo or #GIInterfaceInfo which defines the signal
+ * is returned in @static_instance_info. If it is a #GIObjectInfo, it is
+ * guaranteed to be the same as, or a superclass of, @instance_info. If it is a
+ * #GIInterfaceInfo, @instance_info could have been the interface, or any class
+ * which implements it.
+ *
+ * Both the returned #GISignalInfo and @static_instance_info are owned by the
+ * cache. */
+GISignalInfo *
+GTypeCache::look_up_signal (GIBaseInfo *instance_info,
+                            const std::string& signal_name,
+                            GIBaseInfo **static_instance_info)
+{
+	Class *klass = this->_get_class (instance_info);
+
+	if (!klass->signals_built) {
+		this->_build_signals (klass);
+	}
+
+	std::unordered_map<std::string, Signal>::const_iterator it =
+		klass->signals.find (signal_name);
+
+	if (it == klass->signals.end ()) {
+		*static_instance_info = NULL;
+		return NULL;
+	}
+
+	*static_instance_info = it->second.owner;
+	return it->second.info;
+}
+
+/* Flatten the properties of @klass and everything it inherits from into
+ * @klass->properties, in the same order as _build_signals(). */
+void
+GTypeCache::_build_properties (Class *klass)
+{
+	GIBaseInfo *info = klass->info;
+	gint n_properties;
+
+	klass->properties_built = true;
+
+	if (GI_IS_OBJECT_INFO (info)) {
+		n_properties = g_object_info_get_n_properties (info);
+	} else if (GI_IS_INTERFACE_INFO (info)) {
+		n_properties = g_interface_info_get_n_properties (info);
+	} else {
+		g_assert_not_reached ();
+	}
+
+	for (gint i = 0; i < n_properties; i++) {
+		Property property;
+
+		if (GI_IS_OBJECT_INFO (info)) {
+			property.info = g_object_info_get_property (info, i);
+		} else {
+			property.info = g_interface_info_get_property (info, i);
+		}
+
+		property.owner = info;
+
+		if (!klass->properties.insert (std::make_pair (g_base_info_get_name (property.info),
+		                                               property)).second) {
+			g_base_info_unref (property.info);
+		}
+	}
+
+	if (!GI_IS_OBJECT_INFO (info)) {
+		return;
+	}
+
+	/* Properties from the interfaces the object implements, then from its
+	 * parent class. */
+	std::vector<Class *> supertypes;
+
+	for (gint i = 0; i < g_object_info_get_n_interfaces (info); i++) {
+		GIInterfaceInfo *iface = g_object_info_get_interface (info, i);
+		supertypes.push_back (this->_get_class (iface));
+		g_base_info_unref (iface);
+	}
+
+	GIObjectInfo *parent = g_object_info_get_parent (info);
+	if (parent != NULL) {
+		supertypes.push_back (this->_get_class (parent));
+		g_base_info_unref (parent);
+	}
+
+	for (std::vector<Class *>::const_iterator it = supertypes.begin (),
+	     ie = supertypes.end (); it != ie; ++it) {
+		Class *super = *it;
+
+		if (!super->properties_built) {
+			this->_build_properties (super);
+		}
+
+		klass->properties.insert (super->properties.begin (),
+		                          super->properties.end ());
+	}
+}
+
+/* Look up a named property in a #GIObjectInfo or #GIInterfaceInfo,
+ * @instance_info, as for look_up_signal(). @property_name must use hyphens,
+ * as the GIR does. */
+GIPropertyInfo *
+GTypeCache::look_up_property (GIBaseInfo *instance_info,
+                              const std::string& property_name,
+                              GIBaseInfo **static_instance_info)
+{
+	Class *klass = this->_get_class (instance_info);
+
+	if (!klass->properties_built) {
+		this->_build_properties (klass);
+	}
+
+	std::unordered_map<std::string, Property>::const_iterator it =
+		klass->properties.find (property_name);
+
+	if (it == klass->properties.end ()) {
+		*static_instance_info = NULL;
+		return NULL;
+	}
+
+	*static_instance_info = it->second.owner;
+	return it->second.info;
+}
+
+/* Build the set of types @klass is a subtype of:
+ *  • for a GObject, itself, its superclasses, and the interfaces they
+ *    implement;
+ *  • for a GInterface, itself, GObject (which all interfaces have as an
+ *    implicit prerequisite), and the classes which its prerequisites are
+ *    subtypes of.
+ */
+void
+GTypeCache::_build_ancestors (Class *klass)
+{
+	GIBaseInfo *info = klass->info;
+
+	klass->ancestors_built = true;
+	klass->ancestors.insert (_get_qualified_name (info));
+
+	if (GI_IS_OBJECT_INFO (info)) {
+		for (gint i = 0; i < g_object_info_get_n_interfaces (info); i++) {
+			/* Create entries for the interfaces too, so their
+			 * types are known when filtering below. */
+			GIInterfaceInfo *iface = g_object_info_get_interface (info, i);
+			Class *implemented = this->_get_class (iface);
+			g_base_info_unref (iface);
+
+			klass->ancestors.insert (_get_qualified_name (implemented->info));
+		}
+
+		GIObjectInfo *parent = g_object_info_get_parent (info);
+		if (parent != NULL) {
+			Class *super = this->_get_class (parent);
+			g_base_info_unref (parent);
+
+			if (!super->ancestors_built) {
+				this->_build_ancestors (super);
+			}
+
+			klass->ancestors.insert (super->ancestors.begin (),
+			                         super->ancestors.end ());
+		}
+
+		return;
+	}
+
+	assert (GI_IS_INTERFACE_INFO (info));
+
+	klass->ancestors.insert ("GObject.Object");
+
+	for (gint i = 0; i < g_interface_info_get_n_prerequisites (info); i++) {
+		GIBaseInfo *prereq = g_interface_info_get_prerequisite (info, i);
+		Class *super = this->_get_class (prereq);
+		g_base_info_unref (prereq);
+
+		if (!super->ancestors_built) {
+			this->_build_ancestors (super);
+		}
+
+		/* An interface is only a subtype of another interface if they
+		 * are equal, so only inherit classes from the prerequisites. */
+		for (std::unordered_set<std::string>::const_iterator
+		     it = super->ancestors.begin (),
+		     ie = super->ancestors.end (); it != ie; ++it) {
+			std::unordered_map<std::string, std::unique_ptr<Class>>::const_iterator c =
+				this->_classes.find (*it);
+
+			if (c != this->_classes.end () &&
+			    GI_IS_OBJECT_INFO (c->second->info)) {
+				klass->ancestors.insert (*it);
+			}
+		}
+	}
+}
+
+/* Returns true iff
+ *  • @a is a GObject, @b is a GObject, and @a is equal to or a subclass of @b;
+ *  • @a is a GInterface, @b is a GInterface, and @a is equal to @b;
+ *  • @a is a GInterface, @b is a GObject, and at least one of @a’s
+ *    prerequisites is equal to or a subtype of @b;
+ *  • @a is a GObject, @b is a GInterface, and @a or one of its superclasses
+ *    implements @b.
+ */
+bool
+GTypeCache::is_subclass (GIBaseInfo *a, GIBaseInfo *b)
+{
+	DEBUG ("Checking whether " << g_base_info_get_name (a) << " is a "
+	       "subtype of " << g_base_info_get_name (b) << ".");
+
+	assert (GI_IS_OBJECT_INFO (a) || GI_IS_INTERFACE_INFO (a));
+	assert (GI_IS_OBJECT_INFO (b) || GI_IS_INTERFACE_INFO (b));
+
+	Class *klass = this->_get_class (a);
+
+	if (!klass->ancestors_built) {
+		this->_build_ancestors (klass);
+	}
+
+	return (klass->ancestors.count (_get_qualified_name (b)) > 0);
+}
+
+} /* namespace tartan */
@@ -0,0 +1,109 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_GTYPE_CACHE_H
+#define TARTAN_GTYPE_CACHE_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <clang/AST/AST.h>
+#include <llvm/ADT/DenseMap.h>
+
+#include <girepository.h>
+
+#include "gir-manager.h"
+
+namespace tartan {
+
+using namespace clang;
+
+/* Per-translation-unit cache of the GObject class information used by the
+ * GSignal and GObject notify checkers. This resolves a #QualType to its
+ * #GIObjectInfo (or #GIInterfaceInfo) once, and flattens each class’ signals
+ * and properties (including those inherited from its parents and interfaces)
+ * and ancestors into hash tables, so that repeated signal connections on the
+ * same class are just lookups.
+ *
+ * All returned infos are owned by the cache, and remain valid for its
+ * lifetime. The cache is not thread-safe, so each worker must have its own. */
+class GTypeCache {
+public:
+	explicit GTypeCache (std::shared_ptr<const GirManager> gir_manager) :
+		_gir_manager (gir_manager) {}
+	~GTypeCache ();
+
+	GIBaseInfo *get_object_info (QualType type);
+	GISignalInfo *look_up_signal (GIBaseInfo *instance_info,
+	                              const std::string& signal_name,
+	                              GIBaseInfo **static_instance_info);
+	GIPropertyInfo *look_up_property (GIBaseInfo *instance_info,
+	                                  const std::string& property_name,
+	                                  GIBaseInfo **static_instance_info);
+	bool is_subclass (GIBaseInfo *a, GIBaseInfo *b);
+
+private:
+	/* A signal, and the class or interface which defines it. */
+	struct Signal {
+		GISignalInfo *info;
+		GIBaseInfo *owner;
+	};
+
+	/* A property, and the class or interface which defines it. */
+	struct Property {
+		GIPropertyInfo *info;
+		GIBaseInfo *owner;
+	};
+
+	/* A class or interface. @signals, @properties and @ancestors are
+	 * built lazily; @ancestors contains the qualified names of all types
+	 * this one is a subtype of, as defined by is_subclass(). */
+	struct Class {
+		GIBaseInfo *info;
+		bool signals_built;
+		std::unordered_map<std::string, Signal> signals;
+		bool properties_built;
+		std::unordered_map<std::string, Property> properties;
+		bool ancestors_built;
+		std::unordered_set<std::string> ancestors;
+	};
+
+	Class *_get_class (GIBaseInfo *info);
+	void _build_signals (Class *klass);
+	void _build_properties (Class *klass);
+	void _build_ancestors (Class *klass);
+
+	std::shared_ptr<const GirManager> _gir_manager;
+
+	/* Unqualified pointee type → info, or %NULL if the type isn’t a known
+	 * GObject. Values are borrowed from @_classes. */
+	llvm::DenseMap<void *, GIBaseInfo *> _object_infos;
+
+	/* Qualified name (‘Namespace.Name’) → class. */
+	std::unordered_map<std::string, std::unique_ptr<Class>> _classes;
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_GTYPE_CACHE_H */
@@ -33,7 +33,9 @@
  * For #GVariant methods with format strings but no varargs, the format string
  * is validated.
  *
- * The format string is parsed and varargs are consumed in parallel. The static
+ * Each format string is parsed once (per function direction) into a flat list
+ * of the variadic arguments it expects, which is cached and then matched
+ * against the varargs of every call using that format string. The static
  * type of the varargs is used, so if a weird cast is used (e.g. casting a
  * string literal to an integer and passing it to a ‘u’ format string), no error
  * will be raised. One limitation on the current checker is that the types of
@@ -41,6 +43,13 @@
  * following invalid code:
  *     g_variant_new ('@s', g_variant_new_boolean (FALSE));
  *
+ * Optionally (see PluginOptions), owning out strings (‘s’, ‘o’, ‘g’ and
+ * ‘^ay’) from g_variant_get() and similar functions are also reported if the
+ * variable they’re returned in is only read and then freed, suggesting the
+ * borrowed ‘&s’ (etc.) form, which points into the #GVariant’s data instead of
+ * allocating a copy. Arrays of strings are not reported, as their borrowed
+ * forms still allocate the array.
+ *
  * The checker is quite flexible, and a lot of its behaviour is controlled by
  * the set of #VariantCheckFlags in use for the current part of the parse tree.
  *
@@ -67,6 +76,9 @@
  */
 
 #include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include <clang/AST/Attr.h>
 
@@ -212,6 +224,33 @@ _compare_types (const QualType actual_type, const QualType expected_type,
 	                       flags, context);
 }
 
+/* Memoised wrapper around _compare_types(). Only the direction affects the
+ * comparison, so the other flags are masked out of the key. */
+static bool
+_compare_types_cached (const QualType actual_type,
+                       const QualType expected_type,
+                       unsigned int /* VariantCheckFlags */ flags,
+                       ASTContext& context, TypeComparisonCache &comparisons)
+{
+	flags &= CHECK_FLAG_DIRECTION_OUT;
+
+	std::pair<std::pair<void *, void *>, unsigned int> key (
+		std::make_pair (actual_type.getAsOpaquePtr (),
+		                expected_type.getAsOpaquePtr ()),
+		flags);
+	TypeComparisonCache::iterator it = comparisons.find (key);
+
+	if (it != comparisons.end ()) {
+		return it->second;
+	}
+
+	bool retval = _compare_types (actual_type, expected_type, flags,
+	                              context);
+	comparisons[key] = retval;
+
+	return retval;
+}
+
 /*
  * Return true if the given @type is known to differ in width on different
  * operating systems or processor architectures. This is important for
@@ -269,20 +308,30 @@ _type_is_arch_dependent (const QualType type, ASTContext &context)
 	        context.hasSameType (type, context.LongDoubleTy));
 }
 
-/* Consume a single variadic argument from the varargs array, checking that one
- * exists and has the given @expected_type.
- *
- * Iff %CHECK_FLAG_ALLOW_MAYBE is set, the variadic argument may be NULL.
+/* Record a parse error in @format. The message may refer to up to two
+ * arguments, which are appended to @format->error_args by the caller. Always
+ * returns false so it can be returned directly from the parser. */
+static bool
+_set_format_error (VariantFormat *format, const char *message)
+{
+	format->error = message;
+
+	return false;
+}
+
+/* Add a single variadic argument with the given @expected_type to @format,
+ * first applying the modifications to the expected type required by @flags.
+ * @borrowed_format is the format which would borrow the argument instead, if
+ * it turns out to be an owning out argument.
  *
- * This will emit errors where found. */
+ * If %CHECK_FLAG_CONSUME_ARGS is not set, no argument is expected, and this
+ * is a no-op. */
 static bool
-_consume_variadic_argument (QualType expected_type,
-                            CallExpr::const_arg_iterator *args_begin,
-                            CallExpr::const_arg_iterator *args_end,
-                            unsigned int /* VariantCheckFlags */ flags,
-                            CompilerInstance& compiler,
-                            const StringLiteral *format_arg_str,
-                            ASTContext& context, TypeManager &type_manager)
+_add_variadic_argument (QualType expected_type,
+                        unsigned int /* VariantCheckFlags */ flags,
+                        VariantFormat *format,
+                        ASTContext& context, TypeManager &type_manager,
+                        const char *borrowed_format = NULL)
 {
 	/* If the GVariant method doesn’t use varargs, don’t actually consume
 	 * the argument. */
@@ -307,15 +356,55 @@ _consume_variadic_argument (QualType expected_type,
 		const PointerType *expected2_type = dyn_cast<PointerType> (expected_type);
 		QualType expected_pointee_type = expected2_type->getPointeeType ();
 		expected_pointee_type = context.getConstType (expected_pointee_type);
-		expected_type = context.getPointerType (expected_pointee_type);
+		expected_type = type_manager.get_pointer_type (expected_pointee_type);
 	}
 
 	/* Handle in/out arguments. This must be done after constness. */
 	if ((flags & CHECK_FLAG_DIRECTION_OUT) &&
 	    !(flags & CHECK_FLAG_FORCE_VALIST)) {
-		expected_type = context.getPointerType (expected_type);
+		expected_type = type_manager.get_pointer_type (expected_type);
+	}
+
+	DEBUG ("Adding variadic argument with expected type ‘" <<
+	       expected_type.getAsString () << "’.");
+
+	VariantFormatLeaf leaf;
+	leaf.expected_type = expected_type;
+	leaf.flags = flags;
+	leaf.borrowed_format = NULL;
+
+	/* Arguments which are already const (‘&’), or are GVariants (‘@’),
+	 * can’t be borrowed any further. */
+	if ((flags & CHECK_FLAG_DIRECTION_OUT) &&
+	    !(flags & (CHECK_FLAG_REQUIRE_CONST | CHECK_FLAG_FORCE_GVARIANT |
+	               CHECK_FLAG_FORCE_VALIST))) {
+		leaf.borrowed_format = borrowed_format;
 	}
 
+	format->leaves.push_back (leaf);
+
+	return true;
+}
+
+/* Consume a single variadic argument from the varargs array, checking that one
+ * exists and has the type expected by @leaf.
+ *
+ * Iff %CHECK_FLAG_ALLOW_MAYBE is set, the variadic argument may be NULL.
+ *
+ * This will emit errors where found. */
+static bool
+_consume_variadic_argument (const VariantFormatLeaf &leaf,
+                            CallExpr::const_arg_iterator *args_begin,
+                            CallExpr::const_arg_iterator *args_end,
+                            CompilerInstance& compiler,
+                            const StringLiteral *format_arg_str,
+                            ASTContext& context,
+                            TypeManager &type_manager,
+                            TypeComparisonCache &comparisons)
+{
+	const QualType expected_type = leaf.expected_type;
+	const unsigned int flags = leaf.flags;
+
 	DEBUG ("Consuming variadic argument with expected type ‘" <<
 	       expected_type.getAsString () << "’.");
 
@@ -332,13 +421,15 @@ _consume_variadic_argument (QualType expected_type,
 
 	/* Check its nullability. */
 	QualType actual_type = arg->getType ();
-	bool is_null_constant = arg->isNullPointerConstant (context,
-	                                                    Expr::NPC_ValueDependentIsNull);
+	bool is_null_constant =
+		type_manager.is_null_pointer_constant (*arg,
+		                                       Expr::NPC_ValueDependentIsNull);
 
 	/* Check for int → uint promotions. */
 	llvm::APSInt int_constant_value;
-	bool is_int_constant = arg->isIntegerConstantExpr (int_constant_value,
-	                                                   context);
+	bool is_int_constant =
+		type_manager.is_integer_constant_expr (*arg,
+		                                       int_constant_value);
 
 	if (is_int_constant && int_constant_value.isNonNegative () &&
 	    expected_type->isUnsignedIntegerType () &&
@@ -357,8 +448,10 @@ _consume_variadic_argument (QualType expected_type,
 		return false;
 	} else if (!is_null_constant) {
 		/* Normal case. */
-		bool type_error = !_compare_types (actual_type, expected_type,
-		                                   flags, context);
+		bool type_error = !_compare_types_cached (actual_type,
+		                                          expected_type,
+		                                          flags, context,
+		                                          comparisons);
 		bool arch_error = _type_is_arch_dependent (actual_type,
 		                                           context);
 
@@ -391,23 +484,20 @@ _consume_variadic_argument (QualType expected_type,
 }
 
 /* Parse a single basic type string from the beginning of the string pointed to
- * by @type_str (i.e. *type_str). Consume any variadic parameters from
- * @args_begin as appropriate. This will emit errors where found.
+ * by @type_str (i.e. *type_str), adding the variadic parameters it expects to
+ * @format. Parse errors are recorded in @format.
  *
- * @type_str and @args_begin are updated as the type string and arguments are
- * consumed. */
+ * @type_str is updated as the type string is consumed. */
 static bool
-_check_basic_type_string (const gchar **type_str,
-                          CallExpr::const_arg_iterator *args_begin,
-                          CallExpr::const_arg_iterator *args_end,
+_parse_basic_type_string (const gchar **type_str,
                           unsigned int /* VariantCheckFlags */ flags,
-                          CompilerInstance& compiler,
-                          const StringLiteral *format_arg_str,
+                          VariantFormat *format,
                           ASTContext& context, TypeManager &type_manager)
 {
-	DEBUG ("Checking basic type string ‘" << *type_str << "’.");
+	DEBUG ("Parsing basic type string ‘" << *type_str << "’.");
 
 	QualType expected_type;
+	const char *borrowed_format = NULL;
 
 	/* Reference: GVariant Type Strings. */
 	switch (**type_str) {
@@ -446,19 +536,26 @@ _check_basic_type_string (const gchar **type_str,
 	case 'g': /* gchar* ≡ char* */
 		/* FIXME: Could also validate o and g as D-Bus object paths and
 		 * type signatures. */
-		expected_type = context.getPointerType (context.CharTy);
+		expected_type = type_manager.get_pointer_type (context.CharTy);
+
+		if (**type_str == 's')
+			borrowed_format = "&s";
+		else if (**type_str == 'o')
+			borrowed_format = "&o";
+		else
+			borrowed_format = "&g";
+
 		break;
 	/* Basic types */
 	case '?': /* GVariant* of any type */
 		expected_type = type_manager.find_pointer_type_by_name ("GVariant");
 		break;
 	default:
-		Debug::emit_error ("Expected a GVariant basic type string but "
-		                   "saw ‘%0’.", compiler,
-		                   format_arg_str->getLocStart ())
-		<< std::string (1, **type_str);
+		format->error_args.push_back (std::string (1, **type_str));
 
-		return false;
+		return _set_format_error (
+			format,
+			"Expected a GVariant basic type string but saw ‘%0’.");
 	}
 
 	assert (!expected_type.isNull ());
@@ -479,35 +576,28 @@ _check_basic_type_string (const gchar **type_str,
 	if (!(flags & CHECK_FLAG_DIRECTION_OUT) &&
 	    (**type_str == 'y' || **type_str == 'n' || **type_str == 'q')) {
 		assert (expected_type->isPromotableIntegerType ());
-		expected_type = context.getPromotedIntegerType (expected_type);
+		expected_type = type_manager.get_promoted_integer_type (expected_type);
 	}
 
 	/* Consume the type string. */
 	*type_str = *type_str + 1;
 
-	return _consume_variadic_argument (expected_type,
-	                                   args_begin, args_end,
-	                                   flags, compiler,
-	                                   format_arg_str, context,
-	                                   type_manager);
+	return _add_variadic_argument (expected_type, flags, format, context,
+	                               type_manager, borrowed_format);
 }
 
 /* Parse a single type string from the beginning of the string pointed to
- * by @type_str (i.e. *type_str). Consume any variadic parameters from
- * @args_begin as appropriate. This will emit errors where found.
+ * by @type_str (i.e. *type_str). Add the variadic parameters it
+ * expects to @format, and record any parse error there.
  *
- * @type_str and @args_begin are updated as the type string and arguments are
- * consumed. */
+ * @type_str is updated as the type string is consumed. */
 static bool
-_check_type_string (const gchar **type_str,
-                    CallExpr::const_arg_iterator *args_begin,
-                    CallExpr::const_arg_iterator *args_end,
+_parse_type_string (const gchar **type_str,
                     unsigned int /* VariantCheckFlags */ flags,
-                    CompilerInstance& compiler,
-                    const StringLiteral *format_arg_str,
+                    VariantFormat *format,
                     ASTContext& context, TypeManager &type_manager)
 {
-	DEBUG ("Checking type string ‘" << *type_str << "’.");
+	DEBUG ("Parsing type string ‘" << *type_str << "’.");
 
 	QualType expected_type;
 
@@ -535,46 +625,37 @@ _check_type_string (const gchar **type_str,
 
 		/* Check and consume the type string for the array element
 		 * type. */
-		if (!_check_type_string (type_str, args_begin, args_end,
+		if (!_parse_type_string (type_str,
 		                         flags & ~CHECK_FLAG_CONSUME_ARGS,
-		                         compiler, format_arg_str, context,
-		                         type_manager)) {
+		                         format, context, type_manager)) {
 			return false;
 		}
 
 		/* Consume the single GVariantBuilder for the array. */
-		return _consume_variadic_argument (expected_type,
-		                                   args_begin, args_end,
-		                                   flags, compiler,
-		                                   format_arg_str, context,
-		                                   type_manager);
+		return _add_variadic_argument (expected_type, flags, format,
+		                               context, type_manager);
 	/* Maybe Types */
 	case 'm':
 		*type_str = *type_str + 1;  /* consume the ‘m’ */
-		return _check_type_string (type_str, args_begin, args_end,
+		return _parse_type_string (type_str,
 		                           flags | CHECK_FLAG_ALLOW_MAYBE,
-		                           compiler, format_arg_str, context,
-		                           type_manager);
+		                           format, context, type_manager);
 	/* Tuples */
 	case '(':
 		*type_str = *type_str + 1;  /* consume the opening bracket */
 
 		while (**type_str != ')' && **type_str != '\0') {
-			if (!_check_type_string (type_str, args_begin,
-			                         args_end,
-			                         flags, compiler,
-			                         format_arg_str, context,
-			                         type_manager)) {
+			if (!_parse_type_string (type_str, flags, format,
+			                         context, type_manager)) {
 				return false;
 			}
 		}
 
 		if (**type_str != ')') {
-			Debug::emit_error ("Invalid GVariant type string: "
-			                   "tuple did not end with ‘)’.",
-			                   compiler,
-			                   format_arg_str->getLocStart ());
-			return false;
+			return _set_format_error (
+				format,
+				"Invalid GVariant type string: "
+				"tuple did not end with ‘)’.");
 		}
 
 		*type_str = *type_str + 1;  /* consume the closing bracket */
@@ -589,48 +670,35 @@ _check_type_string (const gchar **type_str,
 		*type_str = *type_str + 1;  /* consume the opening brace */
 
 		if (**type_str == '}') {
-			Debug::emit_error (
+			return _set_format_error (
+				format,
 				"Invalid GVariant type string: dict did not "
-				"contain exactly two elements.",
-				compiler,
-				format_arg_str->getLocStart ());
-			return false;
-		} else if (!_check_basic_type_string (type_str, args_begin,
-		                                      args_end,
-		                                      flags, compiler,
-		                                      format_arg_str, context,
-		                                      type_manager)) {
+				"contain exactly two elements.");
+		} else if (!_parse_basic_type_string (type_str, flags, format,
+		                                      context, type_manager)) {
 			return false;
 		}
 
 		if (**type_str == '}') {
-			Debug::emit_error (
+			return _set_format_error (
+				format,
 				"Invalid GVariant type string: dict did not "
-				"contain exactly two elements.",
-				compiler,
-				format_arg_str->getLocStart ());
-			return false;
-		} else if (!_check_type_string (type_str, args_begin, args_end,
-		                                flags, compiler,
-		                                format_arg_str, context,
-		                                type_manager)) {
+				"contain exactly two elements.");
+		} else if (!_parse_type_string (type_str, flags, format,
+		                                context, type_manager)) {
 			return false;
 		}
 
 		if (**type_str == '\0') {
-			Debug::emit_error (
+			return _set_format_error (
+				format,
 				"Invalid GVariant type string: dict "
-				"did not end with ‘}’.",
-				compiler,
-				format_arg_str->getLocStart ());
-			return false;
+				"did not end with ‘}’.");
 		} else if (**type_str != '}') {
-			Debug::emit_error (
+			return _set_format_error (
+				format,
 				"Invalid GVariant type string: dict "
-				"contains more than two elements.",
-				compiler,
-				format_arg_str->getLocStart ());
-			return false;
+				"contains more than two elements.");
 		}
 
 		*type_str = *type_str + 1;  /* consume the closing brace */
@@ -642,74 +710,58 @@ _check_type_string (const gchar **type_str,
 		break;
 	default:
 		/* Fall back to checking basic types. */
-		return _check_basic_type_string (type_str, args_begin, args_end,
-		                                 flags, compiler,
-		                                 format_arg_str, context,
-		                                 type_manager);
+		return _parse_basic_type_string (type_str, flags, format,
+		                                 context, type_manager);
 	}
 
 	/* Consume the type string. */
 	*type_str = *type_str + 1;
 
-	return _consume_variadic_argument (expected_type,
-	                                   args_begin, args_end,
-	                                   flags, compiler,
-	                                   format_arg_str, context,
-	                                   type_manager);
+	return _add_variadic_argument (expected_type, flags, format, context,
+	                               type_manager);
 }
 
 /* Parse a single basic format string from the beginning of the string pointed
- * to by @format_str (i.e. *format_str). Consume any variadic parameters from
- * @args_begin as appropriate. This will emit errors where found.
+ * to by @format_str (i.e. *format_str). Add the variadic parameters it
+ * expects to @format, and record any parse error there.
  *
- * @format_str and @args_begin are updated as the format string and arguments
- * are consumed. */
+ * @format_str is updated as the format string is consumed. */
 static bool
-_check_basic_format_string (const gchar **format_str,
-                            CallExpr::const_arg_iterator *args_begin,
-                            CallExpr::const_arg_iterator *args_end,
+_parse_basic_format_string (const gchar **format_str,
                             unsigned int /* VariantCheckFlags */ flags,
-                            CompilerInstance& compiler,
-                            const StringLiteral *format_arg_str,
+                            VariantFormat *format,
                             ASTContext& context, TypeManager &type_manager)
 {
-	DEBUG ("Checking format string ‘" << *format_str << "’.");
+	DEBUG ("Parsing format string ‘" << *format_str << "’.");
 
 	/* Reference: GVariant Format Strings documentation, §Syntax. */
 	switch (**format_str) {
 	case '@':
 		*format_str = *format_str + 1;  /* consume the ‘@’ */
-		return _check_basic_type_string (format_str, args_begin,
-		                                 args_end,
-		                                 flags |
-		                                 CHECK_FLAG_FORCE_GVARIANT,
-		                                 compiler, format_arg_str,
-		                                 context, type_manager);
+		return _parse_basic_type_string (format_str,
+		                                 flags | CHECK_FLAG_FORCE_GVARIANT,
+		                                 format, context, type_manager);
 	case '?':
 		/* Direct GVariant. */
 		*format_str = *format_str + 1;  /* consume the argument */
-		return _consume_variadic_argument (type_manager.find_pointer_type_by_name ("GVariant"),
-		                                   args_begin, args_end,
-		                                   flags,
-		                                   compiler, format_arg_str,
-		                                   context, type_manager);
+		return _add_variadic_argument (type_manager.find_pointer_type_by_name ("GVariant"),
+		                               flags, format, context,
+		                               type_manager);
 	case '&':
 		/* Ignore it for inbound arguments; require that outbound
 		 * arguments are const. */
 		*format_str = *format_str + 1;
-		return _check_basic_type_string (format_str, args_begin,
-		                                 args_end,
-		                                 flags |
-		                                 CHECK_FLAG_REQUIRE_CONST,
-		                                 compiler, format_arg_str,
-		                                 context, type_manager);
+		return _parse_basic_type_string (format_str,
+		                                 flags | CHECK_FLAG_REQUIRE_CONST,
+		                                 format, context, type_manager);
 	case '^': {
 		/* Various different hard-coded types. */
 		*format_str = *format_str + 1;
 
 		QualType expected_type;
-		QualType char_array = context.getPointerType (context.CharTy);
-		QualType const_char_array = context.getPointerType (context.getConstType (context.CharTy));
+		QualType char_array = type_manager.get_pointer_type (context.CharTy);
+		QualType const_char_array = type_manager.get_pointer_type (context.getConstType (context.CharTy));
+		const char *borrowed_format = NULL;
 		guint skip;
 
 		/* Effectively hard-code the table from
@@ -717,114 +769,95 @@ _check_basic_format_string (const gchar **format_str,
 #define CONVENIENCE_FORMAT(STR_PTR, F) (strncmp (STR_PTR, F, strlen (F)) == 0)
 		if (CONVENIENCE_FORMAT (*format_str, "as") ||
 		    CONVENIENCE_FORMAT (*format_str, "ao")) {
-			expected_type = context.getPointerType (char_array);
+			expected_type = type_manager.get_pointer_type (char_array);
 			skip = 2;
 		} else if (CONVENIENCE_FORMAT (*format_str, "a&s") ||
 		           CONVENIENCE_FORMAT (*format_str, "a&o")) {
-			expected_type = context.getPointerType (const_char_array);
+			expected_type = type_manager.get_pointer_type (const_char_array);
 			skip = 3;
 		} else if (CONVENIENCE_FORMAT (*format_str, "aay")) {
-			expected_type = context.getPointerType (char_array);
+			expected_type = type_manager.get_pointer_type (char_array);
 			skip = 3;
 		} else if (CONVENIENCE_FORMAT (*format_str, "ay")) {
 			expected_type = char_array;
+			borrowed_format = "^&ay";
 			skip = 2;
 		} else if (CONVENIENCE_FORMAT (*format_str, "&ay")) {
 			expected_type = const_char_array;
 			skip = 3;
 		} else if (CONVENIENCE_FORMAT (*format_str, "a&ay")) {
-			expected_type = context.getPointerType (const_char_array);
+			expected_type = type_manager.get_pointer_type (const_char_array);
 			skip = 4;
 		} else {
-			Debug::emit_error (
+			return _set_format_error (
+				format,
 				"Invalid GVariant basic format string: "
 				"convenience operator ‘^’ was not followed by "
-				"a recognized convenience conversion.",
-				compiler,
-				format_arg_str->getLocStart ());
-			return false;
+				"a recognized convenience conversion.");
 		}
 #undef CONVENIENCE_FORMAT
 
 		*format_str = *format_str + skip;
 
-		return _consume_variadic_argument (expected_type, args_begin,
-		                                   args_end,
-		                                   flags, compiler,
-		                                   format_arg_str, context,
-		                                   type_manager);
+		return _add_variadic_argument (expected_type, flags, format,
+		                               context, type_manager,
+		                               borrowed_format);
 	}
 	default:
 		/* Assume it’s a type string. */
-		return _check_basic_type_string (format_str, args_begin,
-		                                 args_end,
-		                                 flags, compiler,
-		                                 format_arg_str, context,
-		                                 type_manager);
+		return _parse_basic_type_string (format_str, flags, format,
+		                                 context, type_manager);
 	}
 }
 
 /* Parse a single format string from the beginning of the string pointed
- * to by @format_str (i.e. *format_str). Consume any variadic parameters from
- * @args_begin as appropriate. This will emit errors where found.
+ * to by @format_str (i.e. *format_str). Add the variadic parameters it
+ * expects to @format, and record any parse error there.
  *
- * @format_str and @args_begin are updated as the format string and arguments
- * are consumed. */
+ * @format_str is updated as the format string is consumed. */
 static bool
-_check_format_string (const gchar **format_str,
-                      CallExpr::const_arg_iterator *args_begin,
-                      CallExpr::const_arg_iterator *args_end,
+_parse_format_string (const gchar **format_str,
                       unsigned int /* VariantCheckFlags */ flags,
-                      CompilerInstance& compiler,
-                      const StringLiteral *format_arg_str,
+                      VariantFormat *format,
                       ASTContext& context, TypeManager &type_manager)
 {
-	DEBUG ("Checking format string ‘" << *format_str << "’.");
+	DEBUG ("Parsing format string ‘" << *format_str << "’.");
 
 	/* Reference: GVariant Format Strings documentation, §Syntax. */
 	switch (**format_str) {
 	case '@':
 		*format_str = *format_str + 1;  /* consume the ‘@’ */
-		return _check_type_string (format_str, args_begin, args_end,
+		return _parse_type_string (format_str,
 		                           flags | CHECK_FLAG_FORCE_GVARIANT,
-		                           compiler, format_arg_str, context,
-		                           type_manager);
+		                           format, context, type_manager);
 	case 'm':
 		*format_str = *format_str + 1;  /* consume the ‘m’ */
-		return _check_format_string (format_str, args_begin, args_end,
+		return _parse_format_string (format_str,
 		                             flags | CHECK_FLAG_ALLOW_MAYBE,
-		                             compiler, format_arg_str, context,
-		                             type_manager);
+		                             format, context, type_manager);
 	case '*':
 	case '?':
 	case 'r':
 		/* Direct GVariants. */
 		*format_str = *format_str + 1;  /* consume the argument */
-		return _consume_variadic_argument (type_manager.find_pointer_type_by_name ("GVariant"),
-		                                   args_begin, args_end,
-		                                   flags,
-		                                   compiler, format_arg_str,
-		                                   context, type_manager);
+		return _add_variadic_argument (type_manager.find_pointer_type_by_name ("GVariant"),
+		                               flags, format, context,
+		                               type_manager);
 	case '(':
 		*format_str = *format_str + 1;  /* consume the opening bracket */
 
 		while (**format_str != ')' && **format_str != '\0') {
-			if (!_check_format_string (format_str, args_begin,
-			                           args_end,
-			                           flags, compiler,
-			                           format_arg_str, context,
-			                           type_manager)) {
+			if (!_parse_format_string (format_str, flags, format,
+			                           context, type_manager)) {
 				return false;
 			}
 		}
 
 		if (**format_str != ')') {
-			Debug::emit_error (
+			return _set_format_error (
+				format,
 				"Invalid GVariant format string: tuple "
-				"did not end with ‘)’.",
-				compiler,
-				format_arg_str->getLocStart ());
-			return false;
+				"did not end with ‘)’.");
 		}
 
 		*format_str = *format_str + 1;  /* consume the closing bracket */
@@ -834,50 +867,36 @@ _check_format_string (const gchar **format_str,
 		*format_str = *format_str + 1;  /* consume the opening brace */
 
 		if (**format_str == '}') {
-			Debug::emit_error (
+			return _set_format_error (
+				format,
 				"Invalid GVariant format string: dict did not "
-				"contain exactly two elements.",
-				compiler,
-				format_arg_str->getLocStart ());
-			return false;
-		} else if (!_check_basic_format_string (format_str, args_begin,
-		                                        args_end,
-		                                        flags, compiler,
-		                                        format_arg_str,
-		                                        context,
+				"contain exactly two elements.");
+		} else if (!_parse_basic_format_string (format_str, flags,
+		                                        format, context,
 		                                        type_manager)) {
 			return false;
 		}
 
 		if (**format_str == '}') {
-			Debug::emit_error (
+			return _set_format_error (
+				format,
 				"Invalid GVariant format string: dict did not "
-				"contain exactly two elements.",
-				compiler,
-				format_arg_str->getLocStart ());
-			return false;
-		} else if (!_check_format_string (format_str, args_begin,
-		                                  args_end,
-		                                  flags, compiler,
-		                                  format_arg_str, context,
-		                                  type_manager)) {
+				"contain exactly two elements.");
+		} else if (!_parse_format_string (format_str, flags, format,
+		                                  context, type_manager)) {
 			return false;
 		}
 
 		if (**format_str == '\0') {
-			Debug::emit_error (
+			return _set_format_error (
+				format,
 				"Invalid GVariant format string: dict "
-				"did not end with ‘}’.",
-				compiler,
-				format_arg_str->getLocStart ());
-			return false;
+				"did not end with ‘}’.");
 		} else if (**format_str != '}') {
-			Debug::emit_error (
+			return _set_format_error (
+				format,
 				"Invalid GVariant format string: dict "
-				"contains more than two elements.",
-				compiler,
-				format_arg_str->getLocStart ());
-			return false;
+				"contains more than two elements.");
 		}
 
 		*format_str = *format_str + 1;  /* consume the closing brace */
@@ -887,22 +906,16 @@ _check_format_string (const gchar **format_str,
 		/* Ignore it for inbound arguments; require that outbound
 		 * arguments are const. */
 		*format_str = *format_str + 1;
-		return _check_type_string (format_str, args_begin, args_end,
+		return _parse_type_string (format_str,
 		                           flags | CHECK_FLAG_REQUIRE_CONST,
-		                           compiler, format_arg_str, context,
-		                           type_manager);
+		                           format, context, type_manager);
 	case '^':
 		/* Handled by the basic format string parser. */
-		return _check_basic_format_string (format_str, args_begin,
-		                                   args_end,
-		                                   flags, compiler,
-		                                   format_arg_str, context,
-		                                   type_manager);
+		return _parse_basic_format_string (format_str, flags, format,
+		                                   context, type_manager);
 	default:
 		/* Assume it’s a type string. */
-		return _check_type_string (format_str, args_begin, args_end,
-		                           flags, compiler,
-		                           format_arg_str, context,
+		return _parse_type_string (format_str, flags, format, context,
 		                           type_manager);
 	}
 }
@@ -926,7 +939,7 @@ _gvariant_format_string_for_type (QualType type,
 	} else if (bt != NULL && bt->getKind () == BuiltinType::LongDouble) {
 		return g_strdup ("d");
 	} else if (type->isSignedIntegerType ()) {
-		uint64_t size = context.getTypeSize (type);
+		uint64_t size = type_manager.get_type_size (type);
 
 		if (size == 16) {
 			return g_strdup ("n");
@@ -936,7 +949,7 @@ _gvariant_format_string_for_type (QualType type,
 			return g_strdup ("x");
 		}
 	} else if (type->isUnsignedIntegerType ()) {
-		uint64_t size = context.getTypeSize (type);
+		uint64_t size = type_manager.get_type_size (type);
 
 		if (size == 16) {
 			return g_strdup ("q");
@@ -972,17 +985,56 @@ _gvariant_format_string_for_type (QualType type,
 	return NULL;
 }
 
+/* Parse the whole of @format_str into @format, with the top-level @flags.
+ * Any format strings left over after the first one are an error, as the user
+ * has probably forgotten to add tuple brackets around their format string. */
+static void
+_compile_format_string (const gchar *format_str,
+                        unsigned int /* VariantCheckFlags */ flags,
+                        VariantFormat *format,
+                        ASTContext& context, TypeManager &type_manager)
+{
+	const gchar *whole_format_str = format_str;
+
+	DEBUG ("Compiling GVariant format string ‘" << format_str << "’.");
+
+	if (!_parse_format_string (&format_str, flags, format, context,
+	                           type_manager)) {
+		return;
+	}
+
+	if (*format_str != '\0') {
+		format->error_args.push_back (format_str);
+		format->error_args.push_back (whole_format_str);
+
+		_set_format_error (format,
+		                   "Unexpected GVariant format strings ‘%0’ "
+		                   "with unpaired arguments. If using multiple "
+		                   "format strings, they should be enclosed in "
+		                   "brackets to create a tuple (e.g. ‘(%1)’).");
+	}
+}
+
 /* Check a GVariant function call which passes a format parameter. Validate the
  * format parameter string, and if the function takes varargs, validate their
  * types against that parameter.
  *
+ * Each format string is only parsed once for each set of top-level flags;
+ * the result is kept in @formats and reused for subsequent calls.
+ *
+ * If @borrowable_args is non-%NULL, each vararg which is an owning out string
+ * is appended to it, along with the format which would borrow it instead.
+ *
  * If the format string is not a string literal, we can’t check anything. */
 static bool
 _check_gvariant_format_param (const CallExpr& call,
                               const FunctionDecl &func,
                               const VariantFuncInfo *func_info,
                               CompilerInstance& compiler,
-                              ASTContext& context, TypeManager &type_manager)
+                              ASTContext& context, TypeManager &type_manager,
+                              VariantFormatCache &formats,
+                              TypeComparisonCache &comparisons,
+                              std::vector<std::pair<const Expr *, const char *>> *borrowable_args)
 {
 	/* Grab the format parameter string. */
 	const Expr *format_arg = call.getArg (func_info->format_param_index)->IgnoreParenImpCasts ();
@@ -1001,24 +1053,6 @@ _check_gvariant_format_param (const CallExpr& call,
 		return false;
 	}
 
-	/* Check the string. Parse it hand-in-hand with iterating through the
-	 * varargs list. Take a copy of the format_str because StringRef.str()
-	 * only uses a temporary internal buffer. */
-	DEBUG ("Checking GVariant format string ‘" <<
-	       format_arg_str->getString () << "’ with " <<
-	       call.getNumArgs () << " variadic arguments.");
-
-	gchar *whole_format_str;
-	whole_format_str = g_strdup (format_arg_str->getString ().str ().c_str ());
-	const gchar *format_str = whole_format_str;
-	CallExpr::const_arg_iterator args_begin = call.arg_begin ();
-	CallExpr::const_arg_iterator args_end = call.arg_end ();
-
-	/* Skip up to the varargs. If args_begin points to a va_list, the rest
-	 * of the code will ignore it. */
-	for (unsigned int i = 0; i < func_info->first_vararg_param_index; i++)
-		++args_begin;
-
 	unsigned int flags = CHECK_FLAG_NONE;
 	if (!func_info->uses_va_list)
 		flags |= CHECK_FLAG_CONSUME_ARGS;
@@ -1030,32 +1064,71 @@ _check_gvariant_format_param (const CallExpr& call,
 	if (!func_info->args_in)
 		flags |= (CHECK_FLAG_DIRECTION_OUT | CHECK_FLAG_ALLOW_MAYBE);
 
-	if (!_check_format_string (&format_str, &args_begin, &args_end,
-	                           flags, compiler, format_arg_str, context,
-	                           type_manager)) {
-		g_free (whole_format_str);
-		return false;
+	/* Look up the compiled format, parsing it if this is the first time
+	 * it’s been seen with these flags. */
+	const StringRef format_string = format_arg_str->getString ();
+	llvm::StringMap<VariantFormat> &flag_formats = formats[flags];
+	llvm::StringMap<VariantFormat>::iterator it = flag_formats.find (format_string);
+	const VariantFormat *format;
+
+	if (it != flag_formats.end ()) {
+		format = &it->getValue ();
+	} else {
+		/* The parser needs a nul-terminated string. */
+		const std::string whole_format_str = format_string.str ();
+		VariantFormat *new_format = &flag_formats[format_string];
+
+		_compile_format_string (whole_format_str.c_str (), flags,
+		                        new_format, context, type_manager);
+		format = new_format;
 	}
 
-	/* Sanity check that we’ve consumed all format strings. If not, the
-	 * user has probably forgotten to add tuple brackets around their format
-	 * string. Don’t emit any error messages about unpaired variadic
-	 * arguments because that would just confuse things. */
-	if (*format_str != '\0') {
-		Debug::emit_error ("Unexpected GVariant format strings ‘%0’ "
-		                   "with unpaired arguments. If using multiple "
-		                   "format strings, they should be enclosed in "
-		                   "brackets to create a tuple (e.g. ‘(%1)’).",
-		                   compiler, format_arg_str->getLocStart ())
-		<< format_str
-		<< whole_format_str;
+	/* Match the varargs against the compiled format. */
+	DEBUG ("Checking GVariant format string ‘" << format_string <<
+	       "’ with " << call.getNumArgs () << " variadic arguments.");
 
-		g_free (whole_format_str);
+	CallExpr::const_arg_iterator args_begin = call.arg_begin ();
+	CallExpr::const_arg_iterator args_end = call.arg_end ();
 
-		return false;
+	/* Skip up to the varargs. If args_begin points to a va_list, the rest
+	 * of the code will ignore it. */
+	for (unsigned int i = 0; i < func_info->first_vararg_param_index; i++)
+		++args_begin;
+
+	for (std::vector<VariantFormatLeaf>::const_iterator
+	     leaf = format->leaves.begin (), le = format->leaves.end ();
+	     leaf != le; ++leaf) {
+		if (borrowable_args != NULL && leaf->borrowed_format != NULL &&
+		    args_begin != args_end) {
+			borrowable_args->push_back (
+				std::make_pair (*args_begin,
+				                leaf->borrowed_format));
+		}
+
+		if (!_consume_variadic_argument (*leaf, &args_begin, &args_end,
+		                                 compiler, format_arg_str,
+		                                 context, type_manager,
+		                                 comparisons)) {
+			return false;
+		}
 	}
 
-	g_free (whole_format_str);
+	/* Report any parse error. Don’t emit any error messages about unpaired
+	 * variadic arguments after that because that would just confuse
+	 * things. */
+	if (!format->error.empty ()) {
+		Debug::PendingDiagnostic diagnostic =
+			Debug::emit_error (format->error.c_str (), compiler,
+			                   format_arg_str->getLocStart ());
+
+		for (std::vector<std::string>::const_iterator
+		     arg = format->error_args.begin (),
+		     ae = format->error_args.end (); arg != ae; ++arg) {
+			diagnostic << *arg;
+		}
+
+		return false;
+	}
 
 	/* Sanity check that we’ve consumed all arguments. */
 	bool retval = true;
@@ -1100,15 +1173,351 @@ _check_gvariant_format_param (const CallExpr& call,
 	return retval;
 }
 
+/* Whether the owning out strings returned by @func can be borrowed from the
+ * #GVariant instead, and whether @func frees them itself (as
+ * g_variant_iter_loop() does on the following iteration). */
+static bool
+_func_allows_borrowed_strings (const FunctionDecl& func,
+                               bool *freed_by_callee)
+{
+	const std::string func_name = func.getNameAsString ();
+
+	*freed_by_callee = (func_name == "g_variant_iter_loop");
+
+	return (func_name == "g_variant_get" ||
+	        func_name == "g_variant_get_child" ||
+	        func_name == "g_variant_lookup" ||
+	        func_name == "g_variant_iter_loop");
+}
+
+/* Collects all references to either of two given variables, in the order
+ * they’re traversed, which follows the source order of the statements. */
+class VarRefCollector : public RecursiveASTVisitor<VarRefCollector> {
+public:
+	VarRefCollector (const VarDecl *var1, const VarDecl *var2) :
+		_var1 (var1), _var2 (var2) {}
+
+	std::vector<const DeclRefExpr *> refs;
+
+private:
+	const VarDecl *_var1;
+	const VarDecl *_var2;
+
+public:
+	bool VisitDeclRefExpr (DeclRefExpr *ref)
+	{
+		if (ref->getDecl () == this->_var1 ||
+		    ref->getDecl () == this->_var2)
+			this->refs.push_back (ref);
+
+		return true;
+	}
+};
+
+/* How a reference to an owning string variable uses it. */
+typedef enum {
+	/* Only reads the string (or the pointer to it). */
+	VAR_USE_READ,
+	/* Frees the string. */
+	VAR_USE_FREE,
+	/* Anything else, including storing, returning or modifying the
+	 * string, or passing it to a function which might. */
+	VAR_USE_OTHER,
+} VarUse;
+
+/* Return the parent of @expr in @parents, looking through any parentheses and
+ * casts. @expr is updated to the outermost of those. */
+static const Stmt *
+_get_parent_ignoring_casts (const Stmt **expr, const ParentMap &parents)
+{
+	const Stmt *parent = parents.getParent (*expr);
+
+	while (parent != NULL &&
+	       (isa<ParenExpr> (parent) || isa<CastExpr> (parent))) {
+		*expr = parent;
+		parent = parents.getParent (parent);
+	}
+
+	return parent;
+}
+
+/* Whether @expr is assigned to, incremented or decremented. */
+static bool
+_expr_is_written (const Stmt *expr, const ParentMap &parents)
+{
+	const Stmt *parent = _get_parent_ignoring_casts (&expr, parents);
+
+	if (const BinaryOperator *op = dyn_cast_or_null<BinaryOperator> (parent)) {
+		return (op->isAssignmentOp () && op->getLHS () == expr);
+	} else if (const UnaryOperator *op = dyn_cast_or_null<UnaryOperator> (parent)) {
+		return op->isIncrementDecrementOp ();
+	}
+
+	return false;
+}
+
+static VarUse
+_classify_var_use (const DeclRefExpr &ref, const ParentMap &parents,
+                   TypeManager &type_manager)
+{
+	const Stmt *expr = &ref;
+	const Stmt *parent = _get_parent_ignoring_casts (&expr, parents);
+
+	if (parent == NULL)
+		return VAR_USE_OTHER;
+
+	if (const CallExpr *call = dyn_cast<CallExpr> (parent)) {
+		const FunctionDecl *func = call->getDirectCallee ();
+		if (func == NULL)
+			return VAR_USE_OTHER;
+
+		const std::string func_name = func->getNameAsString ();
+
+		for (unsigned int i = 0; i < call->getNumArgs (); i++) {
+			if (call->getArg (i) != expr)
+				continue;
+
+			if (func_name == "g_free")
+				return VAR_USE_FREE;
+
+			/* Variadic arguments, such as to g_print(), are only
+			 * read. */
+			if (i >= func->getNumParams ())
+				return VAR_USE_READ;
+
+			QualType param_type = func->getParamDecl (i)->getType ();
+
+			if (param_type->isPointerType () &&
+			    param_type->getPointeeType ().isConstQualified ())
+				return VAR_USE_READ;
+
+			return VAR_USE_OTHER;
+		}
+
+		return VAR_USE_OTHER;
+	} else if (const BinaryOperator *op = dyn_cast<BinaryOperator> (parent)) {
+		if (op->isComparisonOp () || op->isLogicalOp ())
+			return VAR_USE_READ;
+
+		/* Clearing the variable after freeing it is harmless. */
+		if (op->getOpcode () == BO_Assign && op->getLHS () == expr &&
+		    type_manager.is_null_pointer_constant (*op->getRHS (),
+		                                           Expr::NPC_ValueDependentIsNull))
+			return VAR_USE_READ;
+
+		return VAR_USE_OTHER;
+	} else if (const UnaryOperator *op = dyn_cast<UnaryOperator> (parent)) {
+		if (op->getOpcode () == UO_LNot)
+			return VAR_USE_READ;
+		if (op->getOpcode () == UO_Deref && !_expr_is_written (op, parents))
+			return VAR_USE_READ;
+
+		return VAR_USE_OTHER;
+	} else if (const ArraySubscriptExpr *subscript = dyn_cast<ArraySubscriptExpr> (parent)) {
+		if (subscript->getBase () == expr &&
+		    !_expr_is_written (subscript, parents))
+			return VAR_USE_READ;
+
+		return VAR_USE_OTHER;
+	}
+
+	/* Conditions. */
+	const Stmt *cond = NULL;
+
+	if (const IfStmt *stmt = dyn_cast<IfStmt> (parent))
+		cond = stmt->getCond ();
+	else if (const WhileStmt *stmt = dyn_cast<WhileStmt> (parent))
+		cond = stmt->getCond ();
+	else if (const DoStmt *stmt = dyn_cast<DoStmt> (parent))
+		cond = stmt->getCond ();
+	else if (const ForStmt *stmt = dyn_cast<ForStmt> (parent))
+		cond = stmt->getCond ();
+	else if (const ConditionalOperator *op = dyn_cast<ConditionalOperator> (parent))
+		cond = op->getCond ();
+
+	return (cond != NULL && cond == expr) ? VAR_USE_READ : VAR_USE_OTHER;
+}
+
+/* Whether @ref might release the #GVariant or #GVariantIter held in the
+ * variable it refers to: by unreffing or freeing it, by taking its address
+ * (as g_clear_pointer() and g_steal_pointer() do), or by overwriting the
+ * variable. */
+static bool
+_var_use_releases (const DeclRefExpr &ref, const ParentMap &parents)
+{
+	const Stmt *expr = &ref;
+	const Stmt *parent = _get_parent_ignoring_casts (&expr, parents);
+
+	if (parent == NULL)
+		return false;
+
+	if (_expr_is_written (expr, parents))
+		return true;
+
+	if (const UnaryOperator *op = dyn_cast<UnaryOperator> (parent))
+		return (op->getOpcode () == UO_AddrOf);
+
+	if (const CallExpr *call = dyn_cast<CallExpr> (parent)) {
+		const FunctionDecl *func = call->getDirectCallee ();
+		if (func == NULL)
+			return true;
+
+		const std::string func_name = func->getNameAsString ();
+
+		return (func_name == "g_variant_unref" ||
+		        func_name == "g_variant_iter_free");
+	}
+
+	return false;
+}
+
+bool
+GVariantConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
+{
+	this->_visitor.suggest_borrowed_strings =
+		this->_options.get ()->suggest_borrowed_gvariant_strings;
+	this->_traverse_top_level_decls (decl_group, this->_visitor);
+
+	return true;
+}
+
 void
 GVariantConsumer::HandleTranslationUnit (ASTContext& context)
 {
-	/* Run away if the plugin is disabled. */
-	if (!this->is_enabled ()) {
+	bool suggest_borrowed_strings =
+		this->_options.get ()->suggest_borrowed_gvariant_strings;
+
+	this->_visitor.suggest_borrowed_strings = suggest_borrowed_strings;
+	this->_traverse_translation_unit<GVariantVisitor> (context,
+	                                                   this->_visitor,
+		[this, suggest_borrowed_strings] () {
+			GVariantVisitor *visitor =
+				new GVariantVisitor (this->_compiler);
+			visitor->suggest_borrowed_strings =
+				suggest_borrowed_strings;
+			return visitor;
+		});
+}
+
+/* Suggest a borrowed format for the owning out string @arg of @call if the
+ * variable it’s returned in is only read, and then freed (unless the callee
+ * frees it itself), and the #GVariant (or #GVariantIter) passed to @call is
+ * not released before the last of those reads. Anything else might need the
+ * string to outlive the #GVariant, so is left alone. */
+void
+GVariantVisitor::_check_borrowed_string (const CallExpr &call,
+                                         const Expr &arg,
+                                         const char *borrowed_format,
+                                         bool freed_by_callee)
+{
+	/* Only handle ‘&var’ for local variables. */
+	const UnaryOperator *addr_of =
+		dyn_cast<UnaryOperator> (arg.IgnoreParenCasts ());
+	if (addr_of == NULL || addr_of->getOpcode () != UO_AddrOf)
+		return;
+
+	const DeclRefExpr *arg_ref =
+		dyn_cast<DeclRefExpr> (addr_of->getSubExpr ()->IgnoreParenCasts ());
+	if (arg_ref == NULL)
+		return;
+
+	const VarDecl *var = dyn_cast<VarDecl> (arg_ref->getDecl ());
+	if (var == NULL || this->_current_function == NULL ||
+	    var->getDeclContext () != this->_current_function ||
+	    !var->hasLocalStorage () || isa<ParmVarDecl> (var))
 		return;
+
+	/* The container must be held in a variable so that its releases can
+	 * be found. A temporary, such as a floating #GVariant, might be
+	 * released as soon as @call returns. */
+	const DeclRefExpr *container_ref =
+		dyn_cast<DeclRefExpr> (call.getArg (0)->IgnoreParenCasts ());
+	if (container_ref == NULL)
+		return;
+
+	const VarDecl *container = dyn_cast<VarDecl> (container_ref->getDecl ());
+	if (container == NULL)
+		return;
+
+	Stmt *body = this->_current_function->getBody ();
+	if (body == NULL)
+		return;
+
+	if (this->_parent_map_root != body) {
+		this->_parent_map.reset (new ParentMap (body));
+		this->_parent_map_root = body;
+	}
+
+	/* Walk the uses of the string and the container in order. Comparing
+	 * their source locations would need the SourceManager, which can’t be
+	 * used from a worker thread. */
+	VarRefCollector collector (var, container);
+	collector.TraverseStmt (body);
+
+	/* g_autofree counts as freeing it. */
+	bool freed = freed_by_callee || var->hasAttr<CleanupAttr> ();
+	bool after_call = false, released = false;
+
+	for (std::vector<const DeclRefExpr *>::const_iterator
+	     it = collector.refs.begin (), ie = collector.refs.end ();
+	     it != ie; ++it) {
+		if (*it == arg_ref) {
+			after_call = true;
+			continue;
+		}
+
+		/* The borrowed string is only valid while the container is,
+		 * so note if it’s released after @call. */
+		if ((*it)->getDecl () == container) {
+			if (after_call &&
+			    _var_use_releases (**it, *this->_parent_map))
+				released = true;
+
+			continue;
+		}
+
+		switch (_classify_var_use (**it, *this->_parent_map,
+		                           this->_type_manager)) {
+		case VAR_USE_READ:
+			/* Clearing the variable doesn’t read the string, but
+			 * reading it after the container is released would
+			 * read freed memory once it’s borrowed. */
+			if (released &&
+			    !_expr_is_written (*it, *this->_parent_map))
+				return;
+
+			break;
+		case VAR_USE_FREE:
+			freed = true;
+			break;
+		case VAR_USE_OTHER:
+		default:
+			return;
+		}
+	}
+
+	if (!freed)
+		return;
+
+	Debug::emit_warning ("The string returned in ‘%0’ by %1() is only "
+	                     "read and then freed, so could be borrowed from "
+	                     "the GVariant using the ‘%2’ format instead, "
+	                     "avoiding an allocation and copy. It must then "
+	                     "not be freed.",
+	                     this->_compiler, arg.getLocStart ())
+	<< var->getNameAsString ()
+	<< call.getDirectCallee ()->getNameAsString ()
+	<< borrowed_format;
+}
+
+bool
+GVariantVisitor::VisitFunctionDecl (FunctionDecl* func)
+{
+	if (func->isThisDeclarationADefinition ()) {
+		this->_current_function = func;
 	}
 
-	this->_visitor.TraverseDecl (context.getTranslationUnitDecl ());
+	return true;
 }
 
 /* Note: Specifically overriding the Traverse* method here to re-implement
@@ -1129,10 +1538,31 @@ GVariantVisitor::VisitCallExpr (CallExpr* expr)
 	if (func_info == NULL)
 		return true;
 
-	/* Check the format parameter. */
-	_check_gvariant_format_param (*expr, *func, func_info, this->_compiler,
-	                              func->getASTContext (),
-	                              this->_type_manager);
+	/* Check the format parameter, noting any owning out strings if the
+	 * function could return them borrowed instead. */
+	std::vector<std::pair<const Expr *, const char *>> borrowable_args;
+	bool freed_by_callee = false;
+	bool check_borrowing = this->suggest_borrowed_strings &&
+	                       _func_allows_borrowed_strings (*func,
+	                                                      &freed_by_callee);
+
+	if (!_check_gvariant_format_param (*expr, *func, func_info,
+	                                   this->_compiler,
+	                                   func->getASTContext (),
+	                                   this->_type_manager,
+	                                   this->_formats,
+	                                   this->_type_comparisons,
+	                                   check_borrowing ?
+	                                   &borrowable_args : NULL)) {
+		return true;
+	}
+
+	for (std::vector<std::pair<const Expr *, const char *>>::const_iterator
+	     it = borrowable_args.begin (), ie = borrowable_args.end ();
+	     it != ie; ++it) {
+		this->_check_borrowed_string (*expr, *it->first, it->second,
+		                              freed_by_callee);
+	}
 
 	return true;
 }
@@ -23,12 +23,20 @@
 #ifndef TARTAN_GVARIANT_CHECKER_H
 #define TARTAN_GVARIANT_CHECKER_H
 
+#include <map>
+#include <memory>
+#include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <clang/AST/AST.h>
 #include <clang/AST/ASTConsumer.h>
+#include <clang/AST/ParentMap.h>
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/Frontend/CompilerInstance.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringMap.h>
 
 #include "checker.h"
 #include "type-manager.h"
@@ -37,11 +45,50 @@ namespace tartan {
 
 using namespace clang;
 
+/* A single variadic argument expected by a GVariant format string. The
+ * @expected_type already has all the modifiers from the preceding characters in
+ * the format string (‘@’, ‘&’, direction, etc.) applied; @flags are the
+ * #VariantCheckFlags in effect for it. If the argument is an owning out string
+ * (such as for ‘s’ or ‘^ay’), @borrowed_format is the format which would
+ * borrow it from the #GVariant instead (‘&s’ or ‘^&ay’); otherwise it is
+ * %NULL. */
+struct VariantFormatLeaf {
+	QualType expected_type;
+	unsigned int flags;
+	const char *borrowed_format;
+};
+
+/* A GVariant format string, parsed once for a given function direction and
+ * then matched against the variadic arguments of every call which uses it.
+ * If the string is invalid, @leaves contains the arguments expected before the
+ * parse error, and @error (with its %-arguments in @error_args) is the error
+ * to report once they have been checked. */
+struct VariantFormat {
+	std::vector<VariantFormatLeaf> leaves;
+	std::string error;
+	std::vector<std::string> error_args;
+};
+
+/* Compiled formats, keyed by the top-level #VariantCheckFlags and then the
+ * format string. */
+typedef std::map<unsigned int, llvm::StringMap<VariantFormat>> VariantFormatCache;
+
+/* Results of _compare_types(), keyed by the opaque actual and expected types
+ * and the direction flag. */
+typedef llvm::DenseMap<std::pair<std::pair<void *, void *>, unsigned int>,
+                       bool> TypeComparisonCache;
+
 class GVariantVisitor : public RecursiveASTVisitor<GVariantVisitor> {
 public:
 	explicit GVariantVisitor (CompilerInstance& compiler) :
+		suggest_borrowed_strings (false),
 		_compiler (compiler), _context (compiler.getASTContext ()),
-		_type_manager (compiler.getASTContext ()) {}
+		_type_manager (compiler.getASTContext ()),
+		_current_function (NULL), _parent_map_root (NULL) {}
+
+	/* Whether to suggest borrowing owning out strings which are only
+	 * read and then freed (see PluginOptions). */
+	bool suggest_borrowed_strings;
 
 private:
 	QualType _gvariant_pointer_type;
@@ -49,7 +96,22 @@ private:
 	const ASTContext& _context;
 	TypeManager _type_manager;
 
+	/* Both caches hold types from @_context, so are per-visitor. */
+	VariantFormatCache _formats;
+	TypeComparisonCache _type_comparisons;
+
+	/* Definition of the function currently being traversed, and the
+	 * parent map of its body, built lazily by _check_borrowed_string(). */
+	const FunctionDecl *_current_function;
+	std::unique_ptr<ParentMap> _parent_map;
+	const Stmt *_parent_map_root;
+
+	void _check_borrowed_string (const CallExpr &call, const Expr &arg,
+	                             const char *borrowed_format,
+	                             bool freed_by_callee);
+
 public:
+	bool VisitFunctionDecl (FunctionDecl* func);
 	bool VisitCallExpr (CallExpr* call);
 };
 
@@ -57,14 +119,16 @@ class GVariantConsumer : public tartan::ASTChecker {
 public:
 	GVariantConsumer (CompilerInstance& compiler,
 	                  std::shared_ptr<const GirManager> gir_manager,
-	                  std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins) :
-		ASTChecker (compiler, gir_manager, disabled_plugins),
+	                  std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins,
+	                  std::shared_ptr<const PluginOptions> options) :
+		ASTChecker (compiler, gir_manager, disabled_plugins, options),
 		_visitor (compiler) {}
 
 private:
 	GVariantVisitor _visitor;
 
 public:
+	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
 	virtual void HandleTranslationUnit (ASTContext& context);
 	const std::string get_name () const { return "gvariant"; }
 };
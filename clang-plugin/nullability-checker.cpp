@@ -58,7 +58,9 @@
  * unchanged.
  */
 
+#include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include <girepository.h>
 #include <gitypes.h>
@@ -71,15 +73,23 @@
 
 namespace tartan {
 
+bool
+NullabilityConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
+{
+	this->_traverse_top_level_decls (decl_group, this->_visitor);
+
+	return true;
+}
+
 void
 NullabilityConsumer::HandleTranslationUnit (ASTContext& context)
 {
-	/* Run away if the plugin is disabled. */
-	if (!this->is_enabled ()) {
-		return;
-	}
-
-	this->_visitor.TraverseDecl (context.getTranslationUnitDecl ());
+	this->_traverse_translation_unit<NullabilityVisitor> (context, this->_visitor,
+		[this] () {
+			return new NullabilityVisitor (this->_compiler,
+			                               this->_gir_manager,
+			                               this->_preconditions);
+		});
 }
 
 /* Note: Specifically overriding the Traverse* method here to re-implement
@@ -95,18 +105,15 @@ NullabilityVisitor::TraverseFunctionDecl (FunctionDecl* func)
 		return true;
 
 	/* Can only handle functions which have a body defined. */
-	Stmt* func_body = func->getBody ();
-	if (func_body == NULL || !func->isThisDeclarationADefinition ())
+	if (!func->isThisDeclarationADefinition ())
 		return true;
 
-	/* The body should be a compound statement, e.g.
-	 * { stmt; stmt; } */
-	CompoundStmt* body_stmt = dyn_cast<CompoundStmt> (func_body);
-	if (body_stmt == NULL) {
-		DEBUG ("Ignoring function " << func->getNameAsString () <<
-		       " due to having a non-compound statement body.");
+	/* Get the parameters checked by the function’s precondition
+	 * assertions. */
+	const AssertionExtracter::Preconditions* preconditions =
+		this->_preconditions.get ()->get_preconditions (*func);
+	if (preconditions == NULL)
 		return true;
-	}
 
 	DEBUG ("Examining " << func->getNameAsString ());
 
@@ -139,35 +146,8 @@ NullabilityVisitor::TraverseFunctionDecl (FunctionDecl* func)
 		return true;
 	}
 
-	/* Parse the function’s body for assertions. */
-	std::unordered_set<const ValueDecl*> asserted_parms;
-	ASTContext& context = func->getASTContext ();
-
-	/* Iterate through the function body until the first non-assertion and
-	 * non-declaration statement is reached. Specifically stop before the
-	 * first assignment, as that could affect the outcome of any subsequent
-	 * assertions. */
-	for (CompoundStmt::const_body_iterator it = body_stmt->body_begin (),
-	     ie = body_stmt->body_end (); it != ie; ++it) {
-		Stmt* st = *it;
-
-		Expr* assertion_expr =
-			AssertionExtracter::is_assertion_stmt (*st, context);
-
-		if (assertion_expr == NULL) {
-			/* Potential program state mutation reached, so run
-			 * away. */
-			break;
-		}
-
-		/* If the assertion is a non-NULL check, record the parameters
-		 * it checks. */
-		AssertionExtracter::assertion_is_nonnull_check (*assertion_expr,
-		                                                context,
-		                                                asserted_parms);
-	}
-
-	DEBUG ("");
+	const std::unordered_set<const ValueDecl*>& asserted_parms =
+		preconditions->nonnull_decls;
 
 	GICallableInfo *callable_info = (GICallableInfo *) info;
 
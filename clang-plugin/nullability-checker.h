@@ -30,6 +30,7 @@
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/Frontend/CompilerInstance.h>
 
+#include "assertion-extracter.h"
 #include "checker.h"
 #include "gir-manager.h"
 
@@ -40,14 +41,16 @@ using namespace clang;
 class NullabilityVisitor : public RecursiveASTVisitor<NullabilityVisitor> {
 public:
 	explicit NullabilityVisitor (CompilerInstance& compiler,
-	                             std::shared_ptr<const GirManager> gir_manager) :
+	                             std::shared_ptr<const GirManager> gir_manager,
+	                             std::shared_ptr<PreconditionCache> preconditions) :
 		_compiler (compiler), _context (compiler.getASTContext ()),
-		_gir_manager (gir_manager) {}
+		_gir_manager (gir_manager), _preconditions (preconditions) {}
 
 private:
 	CompilerInstance& _compiler;
 	const ASTContext& _context;
 	std::shared_ptr<const GirManager> _gir_manager;
+	std::shared_ptr<PreconditionCache> _preconditions;
 
 public:
 	bool TraverseFunctionDecl (FunctionDecl* func);
@@ -57,14 +60,19 @@ class NullabilityConsumer : public tartan::ASTChecker {
 public:
 	NullabilityConsumer (CompilerInstance& compiler,
 	                     std::shared_ptr<const GirManager> gir_manager,
-	                     std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins) :
-		ASTChecker (compiler, gir_manager, disabled_plugins),
-		_visitor (compiler, gir_manager) {}
+	                     std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins,
+	                     std::shared_ptr<const PluginOptions> options,
+	                     std::shared_ptr<PreconditionCache> preconditions) :
+		ASTChecker (compiler, gir_manager, disabled_plugins, options),
+		_visitor (compiler, gir_manager, preconditions),
+		_preconditions (preconditions) {}
 
 private:
 	NullabilityVisitor _visitor;
+	std::shared_ptr<PreconditionCache> _preconditions;
 
 public:
+	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
 	virtual void HandleTranslationUnit (ASTContext& context);
 	const std::string get_name () const { return "nullability"; }
 };
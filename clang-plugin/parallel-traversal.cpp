@@ -0,0 +1,156 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+/**
+ * Parallel traversal of a translation unit:
+ *
+ * The read-only AST checkers examine each function independently, so the
+ * top-level declarations of a translation unit can be split between several
+ * worker threads. The AST nodes are only read by the workers, but the
+ * #ASTContext is not: constructing types, computing type layouts (which are
+ * memoised), allocating nodes and evaluating constant expressions all modify
+ * it, so must go through the #TypeManager lock. The #SourceManager memoises
+ * location lookups and orderings, so workers must not query it at all; any
+ * filtering of declarations by location is done on the calling thread before
+ * the workers start. The #DiagnosticsEngine is not thread-safe either, so each
+ * worker collects its diagnostics in a #Debug::DiagnosticBuffer. Declarations
+ * are handed out in fixed-size chunks, each with its own buffer, and once all
+ * workers have finished the buffers are flushed in chunk order. Diagnostics
+ * are therefore emitted in source order, exactly as for a serial traversal,
+ * regardless of how the work was scheduled.
+ */
+
+#include "config.h"
+
+#include <vector>
+
+#include <glib.h>
+
+#include "debug.h"
+#include "parallel-traversal.h"
+
+namespace tartan {
+
+/* Number of consecutive top-level declarations handed to a worker at once.
+ * Most top-level declarations come from headers and are trivial to check, so
+ * handing them out singly would mostly measure contention on the counter. */
+#define CHUNK_SIZE 32
+
+typedef struct {
+	std::vector<Decl *> decls;
+	std::vector<Debug::DiagnosticBuffer> buffers;  /* one per chunk */
+	volatile gint next_chunk;
+	DeclCheckFunc func;
+} ParallelTraversal;
+
+typedef struct {
+	ParallelTraversal *traversal;
+	unsigned int index;
+} Worker;
+
+static gpointer
+_worker_thread_cb (gpointer user_data)
+{
+	Worker *worker = (Worker *) user_data;
+	ParallelTraversal *traversal = worker->traversal;
+	gint n_chunks = traversal->buffers.size ();
+	gint chunk;
+
+	while ((chunk = g_atomic_int_add (&traversal->next_chunk, 1)) <
+	       n_chunks) {
+		std::vector<Decl *>::size_type i, end;
+
+		end = MIN ((std::vector<Decl *>::size_type) (chunk + 1) * CHUNK_SIZE,
+		           traversal->decls.size ());
+
+		Debug::set_diagnostic_buffer (&traversal->buffers[chunk]);
+
+		for (i = chunk * CHUNK_SIZE; i < end; i++) {
+			traversal->func (worker->index, traversal->decls[i]);
+		}
+
+		Debug::set_diagnostic_buffer (NULL);
+	}
+
+	return NULL;
+}
+
+/* Call @func on each top-level declaration in @tu for which @filter returns
+ * true, using up to @n_workers threads (including the calling thread).
+ * Diagnostics emitted by @func are buffered and emitted in source order once
+ * all declarations have been checked. */
+void
+traverse_decls_in_parallel (TranslationUnitDecl &tu, unsigned int n_workers,
+                            DeclCheckFunc func, DeclFilterFunc filter)
+{
+	ParallelTraversal traversal;
+	std::vector<Worker> workers (n_workers);
+	std::vector<GThread *> threads;
+
+	for (DeclContext::decl_iterator it = tu.decls_begin (),
+	     ie = tu.decls_end (); it != ie; ++it) {
+		if (filter (**it)) {
+			traversal.decls.push_back (*it);
+		}
+	}
+
+	traversal.buffers.resize ((traversal.decls.size () + CHUNK_SIZE - 1) /
+	                          CHUNK_SIZE);
+	traversal.next_chunk = 0;
+	traversal.func = func;
+
+	DEBUG ("Checking " << traversal.decls.size () << " top-level "
+	       "declarations using " << n_workers << " workers.");
+
+	/* Worker 0 is the calling thread. If spawning a thread fails, the
+	 * remaining workers will pick up its share of the chunks. */
+	for (unsigned int i = 0; i < n_workers; i++) {
+		workers[i].traversal = &traversal;
+		workers[i].index = i;
+
+		if (i == 0) {
+			continue;
+		}
+
+		GThread *thread = g_thread_try_new ("tartan-worker",
+		                                    _worker_thread_cb,
+		                                    &workers[i], NULL);
+		if (thread != NULL) {
+			threads.push_back (thread);
+		}
+	}
+
+	_worker_thread_cb (&workers[0]);
+
+	for (std::vector<GThread *>::const_iterator it = threads.begin (),
+	     ie = threads.end (); it != ie; ++it) {
+		g_thread_join (*it);
+	}
+
+	/* Emit everything in source order. */
+	for (std::vector<Debug::DiagnosticBuffer>::iterator it = traversal.buffers.begin (),
+	     ie = traversal.buffers.end (); it != ie; ++it) {
+		it->flush ();
+	}
+}
+
+} /* namespace tartan */
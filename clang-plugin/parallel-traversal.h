@@ -0,0 +1,52 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_PARALLEL_TRAVERSAL_H
+#define TARTAN_PARALLEL_TRAVERSAL_H
+
+#include <functional>
+
+#include <clang/AST/AST.h>
+
+namespace tartan {
+
+using namespace clang;
+
+/* Callback to check a single top-level declaration. @worker is the index of
+ * the worker running the callback, in the range [0, n_workers). All callbacks
+ * for a given @worker are invoked on the same thread, so per-worker state (such
+ * as an AST visitor) may be indexed by it without locking. */
+typedef std::function<void (unsigned int worker, Decl *decl)> DeclCheckFunc;
+
+/* Callback to choose which top-level declarations to check. It is invoked on
+ * the calling thread, before any are handed to the workers, so may use
+ * non-thread-safe state such as the #SourceManager. */
+typedef std::function<bool (const Decl &decl)> DeclFilterFunc;
+
+void traverse_decls_in_parallel (TranslationUnitDecl &tu,
+                                 unsigned int n_workers,
+                                 DeclCheckFunc func,
+                                 DeclFilterFunc filter);
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_PARALLEL_TRAVERSAL_H */
@@ -0,0 +1,302 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <clang/Basic/FileManager.h>
+
+#include "debug.h"
+#include "plugin-options.h"
+
+namespace tartan {
+
+/* Minimum interval between checks for the --cancel-file, in microseconds. */
+#define CANCEL_FILE_CHECK_INTERVAL (10 * G_TIME_SPAN_MILLISECOND)
+
+/* Load the lines changed in each file from @filename, which should contain a
+ * unified diff such as the output of `git diff -U0`. Only the hunk headers
+ * are used, so any amount of context is fine. Paths are taken from the ‘+++’
+ * lines, with git’s ‘b/’ prefix stripped, and are matched against the ends
+ * of the paths of the files being compiled. */
+bool
+PluginOptions::load_changed_lines (const std::string &filename,
+                                   GError **error)
+{
+	gchar *contents = NULL;
+
+	if (!g_file_get_contents (filename.c_str (), &contents, NULL, error)) {
+		return false;
+	}
+
+	gchar **lines = g_strsplit (contents, "\n", -1);
+	LineRanges *ranges = NULL;
+	bool after_old_path = false;
+
+	for (gchar **line = lines; *line != NULL; line++) {
+		/* A ‘+++’ line is only a file header if it follows a ‘---’
+		 * line; otherwise it’s an added line starting with ‘++’. */
+		if (after_old_path && g_str_has_prefix (*line, "+++ ")) {
+			const gchar *path = g_strstrip (*line + strlen ("+++ "));
+
+			if (strcmp (path, "/dev/null") == 0) {
+				/* Deleted file. */
+				ranges = NULL;
+			} else {
+				if (g_str_has_prefix (path, "b/")) {
+					path += strlen ("b/");
+				}
+
+				ranges = &this->changed_lines[path];
+			}
+		} else if (ranges != NULL && g_str_has_prefix (*line, "@@ ")) {
+			/* @@ -old_start[,old_count] +new_start[,new_count] @@ */
+			const gchar *new_range = strstr (*line, " +");
+			gchar *end = NULL;
+
+			if (new_range == NULL) {
+				continue;
+			}
+
+			guint64 start = g_ascii_strtoull (new_range + 2, &end,
+			                                  10);
+			guint64 count = 1;
+
+			if (*end == ',') {
+				count = g_ascii_strtoull (end + 1, NULL, 10);
+			}
+
+			/* A hunk which only deletes lines has a count of 0,
+			 * and @start is the line before the deletion. Count
+			 * that line as changed, so the function the lines
+			 * were deleted from is still checked. */
+			ranges->push_back (std::make_pair ((unsigned int) start,
+			                                   (unsigned int) (start + MAX (count, 1) - 1)));
+		}
+
+		after_old_path = g_str_has_prefix (*line, "--- ");
+	}
+
+	g_strfreev (lines);
+	g_free (contents);
+
+	this->restrict_to_changed_lines = true;
+
+	return true;
+}
+
+/* Check whether the user has asked for checking to be abandoned, either by
+ * exceeding the --time-budget or by creating the --cancel-file. Once this has
+ * returned %TRUE it always will, so that checking isn’t resumed part-way
+ * through a translation unit. As this is called for each declaration, the
+ * cancel file is only looked for every %CANCEL_FILE_CHECK_INTERVAL. */
+bool
+PluginOptions::is_cancelled () const
+{
+	if (this->deadline == 0 && this->cancel_file.empty ()) {
+		return false;
+	}
+
+	gint64 now = g_get_monotonic_time ();
+	bool retval;
+
+	g_mutex_lock (&this->_lock);
+
+	if (!this->_cancelled && this->deadline != 0 && now >= this->deadline) {
+		DEBUG ("Checking cancelled: time budget exhausted.");
+		this->_cancelled = true;
+	}
+
+	if (!this->_cancelled && !this->cancel_file.empty () &&
+	    now - this->_last_cancel_file_check >= CANCEL_FILE_CHECK_INTERVAL) {
+		this->_last_cancel_file_check = now;
+
+		if (g_file_test (this->cancel_file.c_str (),
+		                 G_FILE_TEST_EXISTS)) {
+			DEBUG ("Checking cancelled: cancel file exists.");
+			this->_cancelled = true;
+		}
+	}
+
+	retval = this->_cancelled;
+
+	g_mutex_unlock (&this->_lock);
+
+	return retval;
+}
+
+/* Check whether @decl should be annotated and checked. In the normal mode,
+ * every declaration in the translation unit is; in editor mode, only those in
+ * the main file or the listed project headers are, and none are once checking
+ * has been cancelled. */
+bool
+PluginOptions::decl_is_in_scope (const Decl &decl) const
+{
+	if (!this->editor_mode) {
+		return true;
+	}
+
+	const SourceManager &sm = decl.getASTContext ().getSourceManager ();
+	SourceLocation loc = sm.getExpansionLoc (decl.getLocation ());
+
+	if (loc.isInvalid ()) {
+		return false;
+	}
+
+	/* Only check for cancellation once the declaration is known to be in
+	 * scope, as the vast majority are in system headers. */
+#ifdef HAVE_LLVM_3_5
+	if (sm.isInMainFile (loc)) {
+#else /* if !HAVE_LLVM_3_5 */
+	if (sm.isFromMainFile (loc)) {
+#endif /* !HAVE_LLVM_3_5 */
+		return !this->is_cancelled ();
+	}
+
+	if (this->project_headers.empty ()) {
+		return false;
+	}
+
+	const FileEntry *entry = sm.getFileEntryForID (sm.getFileID (loc));
+	if (entry == NULL) {
+		return false;
+	}
+
+	/* Look the headers up through the FileManager so that comparisons
+	 * are by file identity rather than by path spelling. */
+	g_mutex_lock (&this->_lock);
+
+	if (!this->_project_header_entries_resolved) {
+		FileManager &fm = sm.getFileManager ();
+
+		for (std::unordered_set<std::string>::const_iterator it = this->project_headers.begin (),
+		     ie = this->project_headers.end (); it != ie; ++it) {
+			const FileEntry *header_entry = fm.getFile (*it);
+
+			if (header_entry != NULL) {
+				this->_project_header_entries.insert (header_entry);
+			} else {
+				WARN ("Could not find project header ‘" << *it <<
+				      "’.");
+			}
+		}
+
+		this->_project_header_entries_resolved = true;
+	}
+
+	bool in_scope = (this->_project_header_entries.find (entry) !=
+	                 this->_project_header_entries.end ());
+
+	g_mutex_unlock (&this->_lock);
+
+	return in_scope && !this->is_cancelled ();
+}
+
+/* Find the changed lines for the file with @file_id. */
+const PluginOptions::LineRanges *
+PluginOptions::_get_changed_lines (const SourceManager &sm,
+                                   FileID file_id) const
+{
+	std::unordered_map<unsigned int, const LineRanges *>::const_iterator it =
+		this->_changed_line_files.find (file_id.getHashValue ());
+
+	if (it != this->_changed_line_files.end ()) {
+		return it->second;
+	}
+
+	const FileEntry *entry = sm.getFileEntryForID (file_id);
+	const LineRanges *ranges = NULL;
+
+	if (entry != NULL) {
+		const std::string file_name = entry->getName ();
+
+		for (std::unordered_map<std::string, LineRanges>::const_iterator jt = this->changed_lines.begin (),
+		     je = this->changed_lines.end (); jt != je; ++jt) {
+			const std::string &path = jt->first;
+
+			if (file_name == path ||
+			    (file_name.size () > path.size () &&
+			     file_name.compare (file_name.size () - path.size (),
+			                        path.size (), path) == 0 &&
+			     file_name[file_name.size () - path.size () - 1] == '/')) {
+				ranges = &jt->second;
+				break;
+			}
+		}
+	}
+
+	this->_changed_line_files[file_id.getHashValue ()] = ranges;
+
+	return ranges;
+}
+
+/* Check whether @decl should be checked given the --changed-lines. Function
+ * definitions are only checked if they overlap a changed range; everything
+ * else is, as it’s cheap and may be needed to check the functions. This is
+ * independent of decl_is_in_scope(), and is not applied to annotation, so
+ * that GIR attributes are still added to the whole translation unit.
+ *
+ * This queries the #SourceManager, which isn’t thread-safe, so must only be
+ * called on the main thread: --jobs workers are only handed the declarations
+ * which have already passed it (see traverse_decls_in_parallel()). */
+bool
+PluginOptions::decl_is_changed (const Decl &decl) const
+{
+	if (!this->restrict_to_changed_lines) {
+		return true;
+	}
+
+	const FunctionDecl *func = dyn_cast<FunctionDecl> (&decl);
+
+	if (func == NULL || !func->doesThisDeclarationHaveABody ()) {
+		return true;
+	}
+
+	const SourceManager &sm = decl.getASTContext ().getSourceManager ();
+	SourceRange range = decl.getSourceRange ();
+	SourceLocation begin = sm.getExpansionLoc (range.getBegin ());
+	SourceLocation end = sm.getExpansionLoc (range.getEnd ());
+
+	if (begin.isInvalid () || end.isInvalid ()) {
+		return true;
+	}
+
+	unsigned int first_line = sm.getExpansionLineNumber (begin);
+	unsigned int last_line = sm.getExpansionLineNumber (end);
+	bool retval = false;
+
+	const LineRanges *ranges = this->_get_changed_lines (sm,
+	                                                     sm.getFileID (begin));
+
+	if (ranges != NULL) {
+		for (LineRanges::const_iterator it = ranges->begin (),
+		     ie = ranges->end (); it != ie && !retval; ++it) {
+			retval = (it->first <= last_line &&
+			          it->second >= first_line);
+		}
+	}
+
+	return retval;
+}
+
+} /* namespace tartan */
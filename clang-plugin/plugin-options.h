@@ -0,0 +1,159 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_PLUGIN_OPTIONS_H
+#define TARTAN_PLUGIN_OPTIONS_H
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <clang/AST/AST.h>
+#include <clang/Basic/SourceManager.h>
+
+#include <glib.h>
+
+namespace tartan {
+
+using namespace clang;
+
+/* Options set from the plugin’s command line arguments. As with the set of
+ * disabled checkers, this is allocated before the arguments are parsed (see
+ * TartanAction::CreateASTConsumer()) and shared with the consumers, so must
+ * only be read once parsing is underway. */
+class PluginOptions {
+public:
+	PluginOptions () : n_jobs (1), editor_mode (false), deadline (0),
+		max_analysis_nodes (0), max_analysis_states (0),
+		max_analysis_time (0),
+		suggest_borrowed_gvariant_strings (false),
+		restrict_to_changed_lines (false),
+		_cancelled (false), _last_cancel_file_check (0),
+		_project_header_entries_resolved (false)
+	{
+		g_mutex_init (&this->_lock);
+	}
+
+	~PluginOptions ()
+	{
+		g_mutex_clear (&this->_lock);
+	}
+
+	/* Number of threads to use for running the read-only AST checkers
+	 * over the functions in a translation unit. 1 disables threading. */
+	unsigned int n_jobs;
+
+	/* Low-latency mode for editor integration: only declarations in the
+	 * main file (or in one of the @project_headers) are annotated and
+	 * checked, and the AST checkers run from HandleTopLevelDecl() as each
+	 * declaration is parsed, rather than at the end of the translation
+	 * unit. */
+	bool editor_mode;
+	std::unordered_set<std::string> project_headers;
+
+	/* Monotonic time (in microseconds) after which checking is abandoned,
+	 * or 0 for no limit; and a file whose existence signals that checking
+	 * should be abandoned (for example, because the editor has started a
+	 * newer reparse), or empty for none. Both are only used in
+	 * @editor_mode. */
+	gint64 deadline;
+	std::string cancel_file;
+
+	/* Per-function budgets for the path-sensitive checkers (see
+	 * AnalysisBudget): the number of ExplodedGraph nodes, the number of
+	 * states a checker tracks on a path, and the time in microseconds.
+	 * 0 means no limit. */
+	unsigned int max_analysis_nodes;
+	unsigned int max_analysis_states;
+	gint64 max_analysis_time;
+
+	/* File to write a header of GIR-derived attributes to, or empty; and
+	 * the symbols covered by a previously generated header, which
+	 * GirAttributesConsumer needn’t look up. The header is overwritten by
+	 * each translation unit, so should be generated from a single one
+	 * (see GirAttributesHeaderGenerator). */
+	std::string attributes_header_output;
+	std::unordered_set<std::string> attributes_header_symbols;
+
+	/* File to append a report of the allocation hotspots in the
+	 * translation unit to (see AllocationReporter), or empty. */
+	std::string allocation_report_output;
+
+	/* File to append the resolved signal connections in the translation
+	 * unit to, as JSON lines (see GSignalConsumer), or empty. */
+	std::string signal_graph_output;
+
+	/* GIR namespace (without version) whose annotations should be
+	 * checked against the declarations in the translation unit in one
+	 * batch (see GirAttributesChecker), or empty. */
+	std::string check_gir_namespace;
+
+	/* Whether GVariantVisitor should suggest the borrowed ‘&s’ (etc.)
+	 * forms for owning out strings which are only read and then freed.
+	 * Off by default, as borrowing ties the string’s lifetime to the
+	 * #GVariant’s. */
+	bool suggest_borrowed_gvariant_strings;
+
+	/* Inclusive ranges of lines changed in each file, loaded from a
+	 * unified diff using --changed-lines and keyed by the paths in the
+	 * diff. If @restrict_to_changed_lines is set, only function
+	 * definitions overlapping these ranges are checked; annotation is
+	 * unaffected. */
+	typedef std::vector<std::pair<unsigned int, unsigned int>> LineRanges;
+
+	bool restrict_to_changed_lines;
+	std::unordered_map<std::string, LineRanges> changed_lines;
+
+	bool load_changed_lines (const std::string &filename, GError **error);
+
+	bool is_cancelled () const;
+	bool decl_is_in_scope (const Decl &decl) const;
+	bool decl_is_changed (const Decl &decl) const;
+
+private:
+	mutable GMutex _lock;
+
+	/* Whether checking has been cancelled, and when the cancel file was
+	 * last looked for. Protected by @_lock, as is_cancelled() may be
+	 * called from several threads. */
+	mutable bool _cancelled;
+	mutable gint64 _last_cancel_file_check;
+
+	/* Resolved lazily from @project_headers, as the #FileManager isn’t
+	 * available when the options are parsed. Protected by @_lock. */
+	mutable bool _project_header_entries_resolved;
+	mutable std::unordered_set<const FileEntry *> _project_header_entries;
+
+	/* @changed_lines for each file, keyed by #FileID hash value, or %NULL
+	 * if the file is unchanged. Resolved lazily as for the project
+	 * headers. Only used on the main thread (see decl_is_changed()). */
+	mutable std::unordered_map<unsigned int, const LineRanges *> _changed_line_files;
+
+	const LineRanges *_get_changed_lines (const SourceManager &sm,
+	                                      FileID file_id) const;
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_PLUGIN_OPTIONS_H */
@@ -30,13 +30,20 @@
 #include <clang/Frontend/MultiplexConsumer.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include "allocation-report.h"
 #include "debug.h"
 #include "gir-attributes.h"
 #include "gassert-attributes.h"
 #include "gerror-checker.h"
+#include "gir-modeller.h"
+#include "glist-checker.h"
+#include "gobject-notify-checker.h"
 #include "gsignal-checker.h"
 #include "gvariant-checker.h"
 #include "nullability-checker.h"
+#include "plugin-options.h"
+#include "slow-api-checker.h"
+#include "string-building-checker.h"
 
 using namespace clang;
 
@@ -46,6 +53,14 @@ namespace tartan {
 std::shared_ptr<GirManager> global_gir_manager =
 	std::make_shared<GirManager> ();
 
+/* Plugin options for the translation unit currently being compiled, shared
+ * with the path-sensitive checkers, which are constructed by the analyser
+ * rather than by TartanAction. Each TartanAction (one per translation unit)
+ * has its own options, as they include state about the translation unit, and
+ * points this at them. */
+std::shared_ptr<PluginOptions> global_plugin_options =
+	std::make_shared<PluginOptions> ();
+
 /**
  * Plugin core.
  */
@@ -57,6 +72,14 @@ private:
 	std::shared_ptr<std::unordered_set<std::string>> _disabled_checkers =
 		std::make_shared<std::unordered_set<std::string>> ();
 
+	/* Other options, shared with the checkers in the same way. These are
+	 * per-action rather than per-process, as they cache state about the
+	 * translation unit (such as whether checking has been cancelled, and
+	 * the FileEntries of the project headers), which must not leak into
+	 * the next translation unit compiled by a long-lived host. */
+	std::shared_ptr<PluginOptions> _options =
+		std::make_shared<PluginOptions> ();
+
 	/* Whether to limit output to only diagnostics. */
 	enum {
 		VERBOSITY_QUIET,
@@ -64,6 +87,14 @@ private:
 		VERBOSITY_VERBOSE,
 	}_verbosity = VERBOSITY_NORMAL;
 
+public:
+	TartanAction ()
+	{
+		/* The path-sensitive checkers for this translation unit are run
+		 * after this action is created, so point them at its options. */
+		global_plugin_options = this->_options;
+	}
+
 protected:
 	/* Note: This is called before ParseArgs, and must transfer ownership
 	 * of the ASTConsumer. The TartanAction object is destroyed immediately
@@ -92,29 +123,72 @@ protected:
 
 		std::vector<std::unique_ptr<ASTConsumer>> consumers;
 
+		/* Preconditions are extracted once per function, and shared
+		 * between the annotaters and checkers. */
+		std::shared_ptr<PreconditionCache> preconditions =
+			std::make_shared<PreconditionCache> ();
+
+		/* Generators. These must come before the annotaters so they
+		 * see the declarations as written. */
+		consumers.push_back (std::unique_ptr<ASTConsumer> (
+			new GirAttributesHeaderGenerator (compiler,
+			                                  global_gir_manager,
+			                                  this->_options)));
+		consumers.push_back (std::unique_ptr<ASTConsumer> (
+			new AllocationReporter (compiler,
+			                        global_gir_manager,
+			                        this->_options)));
+
 		/* Annotaters. */
 		consumers.push_back (std::unique_ptr<ASTConsumer> (
-			new GirAttributesConsumer (global_gir_manager)));
+			new GirAttributesConsumer (global_gir_manager,
+			                           this->_options)));
 		consumers.push_back (std::unique_ptr<ASTConsumer> (
-			new GAssertAttributesConsumer ()));
+			new GAssertAttributesConsumer (this->_options,
+			                               preconditions)));
 
 		/* Checkers. */
 		consumers.push_back (std::unique_ptr<ASTConsumer> (
 			new NullabilityConsumer (compiler,
 			                         global_gir_manager,
-			                         this->_disabled_checkers)));
+			                         this->_disabled_checkers,
+			                         this->_options,
+			                         preconditions)));
 		consumers.push_back (std::unique_ptr<ASTConsumer> (
 			new GVariantConsumer (compiler,
 			                      global_gir_manager,
-			                      this->_disabled_checkers)));
+			                      this->_disabled_checkers,
+			                      this->_options)));
 		consumers.push_back (std::unique_ptr<ASTConsumer> (
 			new GSignalConsumer (compiler,
 			                     global_gir_manager,
-			                     this->_disabled_checkers)));
+			                     this->_disabled_checkers,
+			                     this->_options)));
 		consumers.push_back (std::unique_ptr<ASTConsumer> (
 			new GirAttributesChecker (compiler,
 			                          global_gir_manager,
-			                          this->_disabled_checkers)));
+			                          this->_disabled_checkers,
+			                          this->_options)));
+		consumers.push_back (std::unique_ptr<ASTConsumer> (
+			new SlowApiConsumer (compiler,
+			                     global_gir_manager,
+			                     this->_disabled_checkers,
+			                     this->_options)));
+		consumers.push_back (std::unique_ptr<ASTConsumer> (
+			new GListConsumer (compiler,
+			                   global_gir_manager,
+			                   this->_disabled_checkers,
+			                   this->_options)));
+		consumers.push_back (std::unique_ptr<ASTConsumer> (
+			new GObjectNotifyConsumer (compiler,
+			                           global_gir_manager,
+			                           this->_disabled_checkers,
+			                           this->_options)));
+		consumers.push_back (std::unique_ptr<ASTConsumer> (
+			new StringBuildingConsumer (compiler,
+			                            global_gir_manager,
+			                            this->_disabled_checkers,
+			                            this->_options)));
 
 		return llvm::make_unique<MultiplexConsumer> (std::move (consumers));
 	}
@@ -124,29 +198,72 @@ protected:
 	{
 		std::vector<ASTConsumer*> consumers;
 
+		/* Preconditions are extracted once per function, and shared
+		 * between the annotaters and checkers. */
+		std::shared_ptr<PreconditionCache> preconditions =
+			std::make_shared<PreconditionCache> ();
+
+		/* Generators. These must come before the annotaters so they
+		 * see the declarations as written. */
+		consumers.push_back (
+			new GirAttributesHeaderGenerator (compiler,
+			                                  global_gir_manager,
+			                                  this->_options));
+		consumers.push_back (
+			new AllocationReporter (compiler,
+			                        global_gir_manager,
+			                        this->_options));
+
 		/* Annotaters. */
 		consumers.push_back (
-			new GirAttributesConsumer (global_gir_manager));
+			new GirAttributesConsumer (global_gir_manager,
+			                           this->_options));
 		consumers.push_back (
-			new GAssertAttributesConsumer ());
+			new GAssertAttributesConsumer (this->_options,
+			                               preconditions));
 
 		/* Checkers. */
 		consumers.push_back (
 			new NullabilityConsumer (compiler,
 			                         global_gir_manager,
-			                         this->_disabled_checkers));
+			                         this->_disabled_checkers,
+			                         this->_options,
+			                         preconditions));
 		consumers.push_back (
 			new GVariantConsumer (compiler,
 			                      global_gir_manager,
-			                      this->_disabled_checkers));
+			                      this->_disabled_checkers,
+			                      this->_options));
 		consumers.push_back (
 			new GSignalConsumer (compiler,
 			                     global_gir_manager,
-			                     this->_disabled_checkers));
+			                     this->_disabled_checkers,
+			                     this->_options));
 		consumers.push_back (
 			new GirAttributesChecker (compiler,
 			                          global_gir_manager,
-			                          this->_disabled_checkers));
+			                          this->_disabled_checkers,
+			                          this->_options));
+		consumers.push_back (
+			new SlowApiConsumer (compiler,
+			                     global_gir_manager,
+			                     this->_disabled_checkers,
+			                     this->_options));
+		consumers.push_back (
+			new GListConsumer (compiler,
+			                   global_gir_manager,
+			                   this->_disabled_checkers,
+			                   this->_options));
+		consumers.push_back (
+			new GObjectNotifyConsumer (compiler,
+			                           global_gir_manager,
+			                           this->_disabled_checkers,
+			                           this->_options));
+		consumers.push_back (
+			new StringBuildingConsumer (compiler,
+			                            global_gir_manager,
+			                            this->_disabled_checkers,
+			                            this->_options));
 
 		return new MultiplexConsumer (consumers);
 	}
@@ -199,6 +316,65 @@ private:
 		return true;
 	}
 
+	/* Load a namespace from an uninstalled .gir file, compiling it to a
+	 * typelib if needed. */
+	bool
+	_load_gir_file (const CompilerInstance &CI,
+	                const std::string& gir_filename)
+	{
+		GError *error = NULL;
+
+		DEBUG ("Loading GIR file " + gir_filename);
+
+		global_gir_manager.get ()->load_gir_file (gir_filename,
+		                                          &error);
+
+		if (error != NULL) {
+			DiagnosticsEngine &d = CI.getDiagnostics ();
+
+			unsigned int id = d.getCustomDiagID (
+				DiagnosticsEngine::Warning,
+				"Error loading GIR file ‘%0’: %1");
+			d.Report (id)
+				<< gir_filename
+				<< error->message;
+
+			g_error_free (error);
+
+			return false;
+		}
+
+		return true;
+	}
+
+	/* Load a file of annotation overrides for libraries without GIR
+	 * data. */
+	bool
+	_load_overrides (const CompilerInstance &CI,
+	                 const std::string& filename)
+	{
+		GError *error = NULL;
+
+		global_gir_manager.get ()->load_overrides (filename, &error);
+
+		if (error != NULL) {
+			DiagnosticsEngine &d = CI.getDiagnostics ();
+
+			unsigned int id = d.getCustomDiagID (
+				DiagnosticsEngine::Warning,
+				"Error loading annotation overrides ‘%0’: %1");
+			d.Report (id)
+				<< filename
+				<< error->message;
+
+			g_error_free (error);
+
+			return false;
+		}
+
+		return true;
+	}
+
 	/* Load all the GI typelibs we can find. This shouldn’t take long, and
 	 * saves the user having to specify which typelibs to use (or us having
 	 * to try and work out which ones the user’s code uses by looking at
@@ -253,6 +429,74 @@ private:
 		return true;
 	}
 
+	/* Load the list of symbols covered by a header generated using
+	 * --generate-attributes-header. */
+	bool
+	_load_attributes_header (const CompilerInstance &CI,
+	                         const std::string& filename)
+	{
+		gchar *contents = NULL;
+		GError *error = NULL;
+
+		if (!g_file_get_contents (filename.c_str (), &contents, NULL,
+		                          &error)) {
+			DiagnosticsEngine &d = CI.getDiagnostics ();
+
+			unsigned int id = d.getCustomDiagID (
+				DiagnosticsEngine::Warning,
+				"Error loading attributes header ‘%0’: %1");
+			d.Report (id)
+				<< filename
+				<< error->message;
+
+			g_error_free (error);
+
+			return false;
+		}
+
+		static const char prefix[] = " * tartan-covered: ";
+		gchar **lines = g_strsplit (contents, "\n", -1);
+
+		for (gchar **line = lines; *line != NULL; line++) {
+			if (g_str_has_prefix (*line, prefix)) {
+				this->_options.get ()->attributes_header_symbols.insert (
+					std::string (*line + strlen (prefix)));
+			}
+		}
+
+		g_strfreev (lines);
+		g_free (contents);
+
+		return true;
+	}
+
+	/* Load the changed line ranges to restrict checking to, from a
+	 * unified diff. */
+	bool
+	_load_changed_lines (const CompilerInstance &CI,
+	                     const std::string& filename)
+	{
+		GError *error = NULL;
+
+		if (!this->_options.get ()->load_changed_lines (filename,
+		                                                &error)) {
+			DiagnosticsEngine &d = CI.getDiagnostics ();
+
+			unsigned int id = d.getCustomDiagID (
+				DiagnosticsEngine::Warning,
+				"Error loading changed lines ‘%0’: %1");
+			d.Report (id)
+				<< filename
+				<< error->message;
+
+			g_error_free (error);
+
+			return false;
+		}
+
+		return true;
+	}
+
 protected:
 	/* Parse command line arguments for the plugin. Note: This is called
 	 * after CreateASTConsumer. */
@@ -260,6 +504,15 @@ protected:
 	ParseArgs (const CompilerInstance &CI,
 	           const std::vector<std::string>& args)
 	{
+		/* Load any uninstalled GIR files first, so that they take
+		 * precedence over installed typelibs for the same namespace. */
+		for (std::vector<std::string>::const_iterator it = args.begin ();
+		     it != args.end (); ++it) {
+			if (*it == "--gir" && it + 1 != args.end ()) {
+				this->_load_gir_file (CI, *(++it));
+			}
+		}
+
 		/* Load all typelibs. */
 		this->_load_gi_repositories (CI);
 
@@ -284,6 +537,76 @@ protected:
 			} else if (arg == "--disable-checker") {
 				const std::string checker = *(++it);
 				this->_disabled_checkers.get ()->insert (std::string (checker));
+			} else if (arg == "--jobs") {
+				const std::string n_jobs = *(++it);
+				unsigned long n = strtoul (n_jobs.c_str (), NULL, 10);
+
+				/* 0 means ‘one per processor’. */
+				if (n == 0) {
+					n = g_get_num_processors ();
+				}
+
+				this->_options.get ()->n_jobs = n;
+			} else if (arg == "--editor-mode") {
+				this->_options.get ()->editor_mode = true;
+			} else if (arg == "--project-header") {
+				const std::string header = *(++it);
+				this->_options.get ()->project_headers.insert (header);
+			} else if (arg == "--time-budget") {
+				const std::string budget = *(++it);
+				gint64 ms = g_ascii_strtoll (budget.c_str (), NULL, 10);
+
+				if (ms > 0) {
+					this->_options.get ()->deadline =
+						g_get_monotonic_time () + ms * 1000;
+				}
+			} else if (arg == "--cancel-file") {
+				this->_options.get ()->cancel_file = *(++it);
+			} else if (arg == "--check-gir-namespace") {
+				const std::string nspace_version = *(++it);
+				std::string::size_type p = nspace_version.find ("-");
+
+				/* Make sure it’s loaded, in case it isn’t in
+				 * the typelib search path. */
+				this->_load_typelib (CI, nspace_version);
+				this->_options.get ()->check_gir_namespace =
+					nspace_version.substr (0, p);
+			} else if (arg == "--changed-lines") {
+				const std::string changed_lines = *(++it);
+				this->_load_changed_lines (CI, changed_lines);
+			} else if (arg == "--max-analysis-nodes") {
+				const std::string n_nodes = *(++it);
+				this->_options.get ()->max_analysis_nodes =
+					strtoul (n_nodes.c_str (), NULL, 10);
+			} else if (arg == "--max-analysis-states") {
+				const std::string n_states = *(++it);
+				this->_options.get ()->max_analysis_states =
+					strtoul (n_states.c_str (), NULL, 10);
+			} else if (arg == "--max-analysis-time") {
+				const std::string budget = *(++it);
+				gint64 ms = g_ascii_strtoll (budget.c_str (), NULL, 10);
+
+				if (ms > 0) {
+					this->_options.get ()->max_analysis_time =
+						ms * 1000;
+				}
+			} else if (arg == "--generate-attributes-header") {
+				this->_options.get ()->attributes_header_output = *(++it);
+			} else if (arg == "--allocation-report") {
+				this->_options.get ()->allocation_report_output = *(++it);
+			} else if (arg == "--signal-graph") {
+				this->_options.get ()->signal_graph_output = *(++it);
+			} else if (arg == "--gvariant-borrowed-strings") {
+				this->_options.get ()->suggest_borrowed_gvariant_strings = true;
+			} else if (arg == "--attributes-header") {
+				const std::string header = *(++it);
+				this->_load_attributes_header (CI, header);
+			} else if (arg == "--gir") {
+				/* Already loaded above. */
+				++it;
+			} else if (arg == "--overrides") {
+				const std::string overrides = *(++it);
+				this->_load_overrides (CI, overrides);
 			}
 		}
 
@@ -314,7 +637,9 @@ protected:
 				llvm::outs () << "(none)";
 			}
 
-			llvm::outs () << "\n";
+			llvm::outs () << "\n" <<
+			                 "Jobs: " << this->_options.get ()->n_jobs <<
+			                 "\n";
 		}
 
 		return true;
@@ -338,6 +663,116 @@ protected:
 		       "        Disable the given Tartan checker, which may be "
 		               "‘all’. All checkers are\n"
 		       "        enabled by default.\n"
+		       "    --jobs [N]\n"
+		       "        Check the functions in each translation unit "
+		               "using N threads, or\n"
+		       "        one per processor if N is 0. Diagnostics are "
+		               "still emitted in\n"
+		       "        source order. The default is 1.\n"
+		       "    --editor-mode\n"
+		       "        Low-latency mode for use from editors: only "
+		               "check declarations in\n"
+		       "        the main file (and any --project-header), "
+		               "emitting diagnostics\n"
+		       "        as each one is parsed.\n"
+		       "    --project-header [file]\n"
+		       "        Also check declarations in the given header in "
+		               "editor mode. May be\n"
+		       "        given multiple times.\n"
+		       "    --time-budget [ms]\n"
+		       "        Abandon checking once the given number of "
+		               "milliseconds have passed.\n"
+		       "        Only used with --editor-mode.\n"
+		       "    --cancel-file [file]\n"
+		       "        Abandon checking as soon as the given file "
+		               "exists. Only used with\n"
+		       "        --editor-mode.\n"
+		       "    --check-gir-namespace [namespace-version]\n"
+		       "        Check the annotations of every function, "
+		               "signal and property in\n"
+		       "        the given GIR namespace against the "
+		               "declarations in the translation\n"
+		       "        unit, in one batch, instead of checking the "
+		               "declarations as each\n"
+		       "        translation unit is compiled. The translation "
+		               "unit should include\n"
+		       "        all the library’s public headers; see "
+		               "tartan-check-gir.\n"
+		       "    --changed-lines [file]\n"
+		       "        Only check function definitions which overlap "
+		               "the lines changed by\n"
+		       "        the given unified diff, such as the output of "
+		               "‘git diff -U0’. GIR\n"
+		       "        annotations are still applied to the whole "
+		               "translation unit.\n"
+		       "    --max-analysis-nodes [N]\n"
+		       "    --max-analysis-states [N]\n"
+		       "    --max-analysis-time [ms]\n"
+		       "        Per-function budgets for the path-sensitive "
+		               "checkers: the number of\n"
+		       "        analysis nodes, the number of states tracked "
+		               "on a path (such as\n"
+		       "        GErrors), and the time taken. Once one is "
+		               "exhausted, the checker\n"
+		       "        stops detailed tracking for the rest of the "
+		               "function, and the\n"
+		       "        function is reported as a remark with its "
+		               "cost. No limit by default.\n"
+		       "    --generate-attributes-header [file]\n"
+		       "        Write a header redeclaring the GIR-annotated "
+		               "functions declared in\n"
+		       "        the translation unit with nonnull, "
+		               "returns_nonnull, malloc, pure\n"
+		       "        and warn_unused_result attributes, for "
+		               "force-including in normal\n"
+		       "        builds. The file is overwritten, so run this "
+		               "on a single translation\n"
+		       "        unit which includes all the headers of "
+		               "interest.\n"
+		       "    --attributes-header [file]\n"
+		       "        Skip GIR lookups for the functions fully "
+		               "covered by a header\n"
+		       "        generated using --generate-attributes-header.\n"
+		       "    --allocation-report [file]\n"
+		       "        Append a report of the functions defined in "
+		               "the translation unit to\n"
+		       "        the given file, ranked by an estimate of how "
+		               "much they allocate:\n"
+		       "        allocating GLib calls and calls returning "
+		               "(transfer full) or\n"
+		       "        (transfer container) values, weighted by loop "
+		               "nesting depth.\n"
+		       "    --signal-graph [file]\n"
+		       "        Append each signal connection whose signal "
+		               "could be resolved to the\n"
+		       "        given file, as a line of JSON giving the "
+		               "connection site, signal,\n"
+		       "        handler and flags. Requires the gsignal "
+		               "checker.\n"
+		       "    --gvariant-borrowed-strings\n"
+		       "        Suggest the borrowed ‘&s’, ‘&o’, ‘&g’ and "
+		               "‘^&ay’ forms for strings\n"
+		       "        returned by g_variant_get() and similar "
+		               "functions which are only\n"
+		       "        read and then freed. Requires the gvariant "
+		               "checker.\n"
+		       "    --gir [file]\n"
+		       "        Use the given .gir file for its namespace in "
+		               "preference to any\n"
+		       "        installed typelib; for example, for a library "
+		               "built earlier in the\n"
+		       "        same build. It is compiled to a typelib which "
+		               "is cached next to it.\n"
+		       "        May be given multiple times.\n"
+		       "    --overrides [file]\n"
+		       "        Load annotations (nullability, transfer, "
+		               "throws, deprecation and\n"
+		       "        slow API notes) for functions which have no "
+		               "GIR data from the given\n"
+		       "        key file. It is compiled to an index which is "
+		               "cached in the user\n"
+		       "        cache directory.\n"
+		       "        May be given multiple times.\n"
 		       "    --quiet\n"
 		       "        Disable all plugin output except code "
 		               "diagnostics (remarks,\n"
@@ -376,6 +811,9 @@ extern "C"
 void clang_registerCheckers (ento::CheckerRegistry &registry) {
 	registry.addChecker<GErrorChecker> ("tartan.GErrorChecker",
 	                                    "Check GError API usage");
+	registry.addChecker<GirModeller> ("tartan.GirModeller",
+	                                  "Model side-effect-free GLib and "
+	                                  "GIR accessor functions");
 }
 
 extern "C"
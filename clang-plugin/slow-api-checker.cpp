@@ -0,0 +1,85 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+/**
+ * SlowApiVisitor:
+ *
+ * This is a checker for calls to functions which have been marked as slow in
+ * an annotation override file (see #AnnotationOverrides), such as functions
+ * which perform synchronous I/O. It emits a remark giving the note from the
+ * override file for each call, so that such calls can be audited.
+ */
+
+#include "config.h"
+
+#include <memory>
+#include <vector>
+
+#include "debug.h"
+#include "slow-api-checker.h"
+
+namespace tartan {
+
+bool
+SlowApiConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
+{
+	this->_traverse_top_level_decls (decl_group, this->_visitor);
+
+	return true;
+}
+
+void
+SlowApiConsumer::HandleTranslationUnit (ASTContext& context)
+{
+	this->_traverse_translation_unit<SlowApiVisitor> (context, this->_visitor,
+		[this] () {
+			return new SlowApiVisitor (this->_compiler,
+			                           this->_gir_manager);
+		});
+}
+
+bool
+SlowApiVisitor::VisitCallExpr (CallExpr* call)
+{
+	const FunctionDecl *func = call->getDirectCallee ();
+	if (func == NULL)
+		return true;
+
+	const IdentifierInfo *func_ident = func->getIdentifier ();
+	if (func_ident == NULL)
+		return true;
+
+	AnnotationOverride annotations;
+	if (!this->_gir_manager.get ()->find_override (func_ident->getName ().str (),
+	                                               annotations) ||
+	    annotations.slow_note.empty ())
+		return true;
+
+	Debug::emit_remark ("Call to slow function %0(): %1",
+	                    this->_compiler, call->getLocStart ())
+	<< func_ident->getName ().str ()
+	<< annotations.slow_note;
+
+	return true;
+}
+
+} /* namespace tartan */
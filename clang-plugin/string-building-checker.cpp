@@ -0,0 +1,442 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+/**
+ * StringBuildingVisitor:
+ *
+ * This is a checker for strings which are built up inside a loop by
+ * reallocating and copying the whole string on every iteration, which is
+ * quadratic in the length of the result. For example:
+ *     for (l = items; l != NULL; l = l->next) {
+ *             gchar *new_str = g_strconcat (str, l->data, NULL);
+ *             g_free (str);
+ *             str = new_str;
+ *     }
+ *
+ * A call to g_strconcat(), g_strdup_printf() or g_strjoin() is reported if it
+ * takes the old value of the accumulator and its result replaces that value:
+ * either it is assigned straight back to the same variable, or the old value
+ * is freed with g_free() and the two variables are swapped by assignment
+ * somewhere in the same loop. A warning is emitted suggesting a #GString.
+ *
+ * Separately, calls to g_string_append_printf() whose format is a string
+ * literal with no conversions are reported anywhere, suggesting
+ * g_string_append(), which doesn’t need to parse the format.
+ */
+
+#include "config.h"
+
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <glib.h>
+
+#include "debug.h"
+#include "string-building-checker.h"
+
+namespace tartan {
+
+/* Functions which return a newly allocated copy of (among other things) all
+ * of their string arguments. */
+static const char *string_building_funcs[] = {
+	"g_strconcat",
+	"g_strdup_printf",
+	"g_strjoin",
+};
+
+static bool
+_func_is_string_building_func (const FunctionDecl& func)
+{
+	const IdentifierInfo *func_ident = func.getIdentifier ();
+	guint i;
+
+	if (func_ident == NULL)
+		return false;
+
+	StringRef func_name = func_ident->getName ();
+
+	/* Fast path elimination of irrelevant functions. */
+	if (!func_name.startswith ("g_str"))
+		return false;
+
+	for (i = 0; i < G_N_ELEMENTS (string_building_funcs); i++) {
+		if (func_name == string_building_funcs[i]) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool
+_func_is_named (const FunctionDecl& func, const char *name)
+{
+	const IdentifierInfo *func_ident = func.getIdentifier ();
+
+	return (func_ident != NULL && func_ident->getName () == name);
+}
+
+/* Return the variable @expr refers to, looking through parentheses and
+ * casts, or %NULL if it isn’t a plain variable reference. */
+static const VarDecl *
+_expr_get_var (const Expr *expr)
+{
+	if (expr == NULL)
+		return NULL;
+
+	const DeclRefExpr *decl_ref =
+		dyn_cast<DeclRefExpr> (expr->IgnoreParenCasts ());
+	if (decl_ref == NULL)
+		return NULL;
+
+	return dyn_cast<VarDecl> (decl_ref->getDecl ());
+}
+
+/* Return true iff a DeclStmt within @stmt declares @var. */
+static bool
+_stmt_declares_var (const Stmt *stmt, const VarDecl *var)
+{
+	if (stmt == NULL)
+		return false;
+
+	const DeclStmt *decl_stmt = dyn_cast<DeclStmt> (stmt);
+	if (decl_stmt != NULL) {
+		for (DeclStmt::const_decl_iterator it = decl_stmt->decl_begin (),
+		     ie = decl_stmt->decl_end (); it != ie; ++it) {
+			if (*it == var)
+				return true;
+		}
+	}
+
+	for (Stmt::const_child_iterator it = stmt->child_begin (),
+	     ie = stmt->child_end (); it != ie; ++it) {
+		if (_stmt_declares_var (*it, var))
+			return true;
+	}
+
+	return false;
+}
+
+/* Return true iff @var keeps its value from one iteration of @loop to the
+ * next, because it’s declared outside the loop’s body. Variables declared in
+ * a for loop’s initialiser count, since that’s only evaluated once. This only
+ * looks at the AST, as it’s called on worker threads where the SourceManager
+ * can’t be used. */
+static bool
+_var_outlives_iteration (const Stmt *loop, const VarDecl *var)
+{
+	if (const ForStmt *for_stmt = dyn_cast<ForStmt> (loop)) {
+		return !(_stmt_declares_var (for_stmt->getCond (), var) ||
+		         _stmt_declares_var (for_stmt->getInc (), var) ||
+		         _stmt_declares_var (for_stmt->getBody (), var));
+	}
+
+	return !_stmt_declares_var (loop, var);
+}
+
+/* A call to one of the @string_building_funcs whose result is stored in
+ * @result. @args are the variables passed to it, and @loop is the innermost
+ * loop containing it. */
+typedef struct {
+	const CallExpr *call;
+	const VarDecl *result;
+	std::vector<const VarDecl *> args;
+	const Stmt *loop;
+} StringBuildingCall;
+
+/* Collects the facts about a single outermost loop (including any loops
+ * nested inside it) which are needed to decide whether a string is being
+ * built up across its iterations. */
+class StringBuildingLoopScanner :
+	public RecursiveASTVisitor<StringBuildingLoopScanner> {
+public:
+	std::vector<StringBuildingCall> calls;
+
+	/* Variables passed to g_free(). */
+	std::set<const VarDecl *> freed;
+
+	/* (lhs, rhs) pairs for each ‘lhs = rhs’ assignment between two
+	 * variables, including initialisations. */
+	std::set<std::pair<const VarDecl *, const VarDecl *>> copies;
+
+private:
+	/* The loops enclosing the current node, innermost last. */
+	std::vector<const Stmt *> _loops;
+
+	void _handle_assignment (const VarDecl *lhs, const Expr *rhs)
+	{
+		if (lhs == NULL || rhs == NULL)
+			return;
+
+		const VarDecl *rhs_var = _expr_get_var (rhs);
+		if (rhs_var != NULL) {
+			this->copies.insert (std::make_pair (lhs, rhs_var));
+			return;
+		}
+
+		const CallExpr *call =
+			dyn_cast<CallExpr> (rhs->IgnoreParenCasts ());
+		if (call == NULL)
+			return;
+
+		const FunctionDecl *func = call->getDirectCallee ();
+		if (func == NULL || !_func_is_string_building_func (*func))
+			return;
+
+		StringBuildingCall building_call;
+		building_call.call = call;
+		building_call.result = lhs;
+		building_call.loop = this->_loops.back ();
+
+		for (CallExpr::const_arg_iterator it = call->arg_begin (),
+		     ie = call->arg_end (); it != ie; ++it) {
+			const VarDecl *arg_var = _expr_get_var (*it);
+			if (arg_var != NULL)
+				building_call.args.push_back (arg_var);
+		}
+
+		this->calls.push_back (building_call);
+	}
+
+public:
+	bool TraverseForStmt (ForStmt *stmt)
+	{
+		this->_loops.push_back (stmt);
+		bool retval = RecursiveASTVisitor<StringBuildingLoopScanner>::TraverseForStmt (stmt);
+		this->_loops.pop_back ();
+
+		return retval;
+	}
+
+	bool TraverseWhileStmt (WhileStmt *stmt)
+	{
+		this->_loops.push_back (stmt);
+		bool retval = RecursiveASTVisitor<StringBuildingLoopScanner>::TraverseWhileStmt (stmt);
+		this->_loops.pop_back ();
+
+		return retval;
+	}
+
+	bool TraverseDoStmt (DoStmt *stmt)
+	{
+		this->_loops.push_back (stmt);
+		bool retval = RecursiveASTVisitor<StringBuildingLoopScanner>::TraverseDoStmt (stmt);
+		this->_loops.pop_back ();
+
+		return retval;
+	}
+
+	bool VisitBinaryOperator (BinaryOperator *op)
+	{
+		if (op->getOpcode () == BO_Assign) {
+			this->_handle_assignment (_expr_get_var (op->getLHS ()),
+			                          op->getRHS ());
+		}
+
+		return true;
+	}
+
+	bool VisitVarDecl (VarDecl *decl)
+	{
+		this->_handle_assignment (decl, decl->getInit ());
+		return true;
+	}
+
+	bool VisitCallExpr (CallExpr *call)
+	{
+		const FunctionDecl *func = call->getDirectCallee ();
+
+		if (func != NULL && call->getNumArgs () == 1 &&
+		    _func_is_named (*func, "g_free")) {
+			const VarDecl *var = _expr_get_var (call->getArg (0));
+			if (var != NULL)
+				this->freed.insert (var);
+		}
+
+		return true;
+	}
+};
+
+bool
+StringBuildingConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
+{
+	this->_traverse_top_level_decls (decl_group, this->_visitor);
+
+	return true;
+}
+
+void
+StringBuildingConsumer::HandleTranslationUnit (ASTContext& context)
+{
+	this->_traverse_translation_unit<StringBuildingVisitor> (context, this->_visitor,
+		[this] () {
+			return new StringBuildingVisitor (this->_compiler);
+		});
+}
+
+/* Check an outermost @loop for strings built up across its iterations. Any
+ * loops nested inside it are covered by the same scan, so each call is only
+ * reported once. */
+void
+StringBuildingVisitor::_check_loop (Stmt *loop)
+{
+	StringBuildingLoopScanner scanner;
+	scanner.TraverseStmt (loop);
+
+	std::vector<StringBuildingCall>::const_iterator it, ie;
+
+	for (it = scanner.calls.begin (), ie = scanner.calls.end ();
+	     it != ie; ++it) {
+		const StringBuildingCall &building_call = *it;
+		const VarDecl *result = building_call.result;
+		const VarDecl *accumulator = NULL;
+
+		std::vector<const VarDecl *>::const_iterator arg, arg_end;
+
+		for (arg = building_call.args.begin (),
+		     arg_end = building_call.args.end ();
+		     arg != arg_end && accumulator == NULL; ++arg) {
+			const VarDecl *old_value = *arg;
+
+			if (old_value == result) {
+				/* str = g_strconcat (str, …), where str
+				 * outlives an iteration of the innermost
+				 * loop. A string declared inside the loop is
+				 * only built up within one iteration. */
+				if (_var_outlives_iteration (building_call.loop,
+				                             result)) {
+					accumulator = result;
+				}
+			} else if (scanner.freed.count (old_value) > 0 &&
+			           (scanner.copies.count (std::make_pair (old_value, result)) > 0 ||
+			            scanner.copies.count (std::make_pair (result, old_value)) > 0)) {
+				/* Either:
+				 *     new_str = g_strconcat (str, …);
+				 *     g_free (str);
+				 *     str = new_str;
+				 * or:
+				 *     old_str = str;
+				 *     str = g_strconcat (old_str, …);
+				 *     g_free (old_str);
+				 * Name whichever variable outlives an
+				 * iteration. */
+				if (_var_outlives_iteration (building_call.loop,
+				                             old_value)) {
+					accumulator = old_value;
+				} else {
+					accumulator = result;
+				}
+			}
+		}
+
+		if (accumulator == NULL)
+			continue;
+
+		Debug::emit_warning ("String ‘%0’ is rebuilt by %1() on every "
+		                     "iteration of the enclosing loop, copying "
+		                     "the whole string each time, which is "
+		                     "quadratic. Build it in a GString using "
+		                     "g_string_append() or "
+		                     "g_string_append_printf() instead, created "
+		                     "with g_string_sized_new() if its final "
+		                     "length can be estimated.",
+		                     this->_compiler,
+		                     building_call.call->getLocStart ())
+		<< accumulator->getNameAsString ()
+		<< building_call.call->getDirectCallee ()->getNameAsString ();
+	}
+}
+
+bool
+StringBuildingVisitor::_traverse_loop (Stmt *loop)
+{
+	bool retval;
+
+	if (this->_loop_depth == 0)
+		this->_check_loop (loop);
+
+	/* Recurse into the loop anyway, to check the calls in it. */
+	this->_loop_depth++;
+
+	if (ForStmt *for_stmt = dyn_cast<ForStmt> (loop)) {
+		retval = RecursiveASTVisitor<StringBuildingVisitor>::TraverseForStmt (for_stmt);
+	} else if (WhileStmt *while_stmt = dyn_cast<WhileStmt> (loop)) {
+		retval = RecursiveASTVisitor<StringBuildingVisitor>::TraverseWhileStmt (while_stmt);
+	} else {
+		retval = RecursiveASTVisitor<StringBuildingVisitor>::TraverseDoStmt (cast<DoStmt> (loop));
+	}
+
+	this->_loop_depth--;
+
+	return retval;
+}
+
+bool
+StringBuildingVisitor::TraverseForStmt (ForStmt *stmt)
+{
+	return this->_traverse_loop (stmt);
+}
+
+bool
+StringBuildingVisitor::TraverseWhileStmt (WhileStmt *stmt)
+{
+	return this->_traverse_loop (stmt);
+}
+
+bool
+StringBuildingVisitor::TraverseDoStmt (DoStmt *stmt)
+{
+	return this->_traverse_loop (stmt);
+}
+
+bool
+StringBuildingVisitor::VisitCallExpr (CallExpr *call)
+{
+	/* Only g_string_append_printf (string, format) with no variadic
+	 * arguments is interesting. */
+	const FunctionDecl *func = call->getDirectCallee ();
+	if (func == NULL || call->getNumArgs () != 2 ||
+	    !_func_is_named (*func, "g_string_append_printf"))
+		return true;
+
+	const StringLiteral *format =
+		dyn_cast<StringLiteral> (call->getArg (1)->IgnoreParenCasts ());
+	if (format == NULL || format->getCharByteWidth () != 1)
+		return true;
+
+	/* Any conversion, including ‘%%’, means the format has to be
+	 * parsed. */
+	if (format->getString ().find ('%') != StringRef::npos)
+		return true;
+
+	Debug::emit_warning ("g_string_append_printf() is called with a "
+	                     "constant format string containing no "
+	                     "conversions, which is parsed on every call. Use "
+	                     "g_string_append() instead.",
+	                     this->_compiler, call->getLocStart ());
+
+	return true;
+}
+
+} /* namespace tartan */
@@ -0,0 +1,80 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2014 Collabora Ltd.
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip.withnall@collabora.co.uk>
+ */
+
+#ifndef TARTAN_STRING_BUILDING_CHECKER_H
+#define TARTAN_STRING_BUILDING_CHECKER_H
+
+#include <clang/AST/AST.h>
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Frontend/CompilerInstance.h>
+
+#include "checker.h"
+#include "gir-manager.h"
+
+namespace tartan {
+
+using namespace clang;
+
+class StringBuildingVisitor :
+	public RecursiveASTVisitor<StringBuildingVisitor> {
+public:
+	explicit StringBuildingVisitor (CompilerInstance& compiler) :
+		_compiler (compiler), _loop_depth (0) {}
+
+private:
+	CompilerInstance& _compiler;
+
+	/* Number of loops enclosing the current node. */
+	unsigned int _loop_depth;
+
+	void _check_loop (Stmt *loop);
+	bool _traverse_loop (Stmt *loop);
+
+public:
+	bool TraverseForStmt (ForStmt *stmt);
+	bool TraverseWhileStmt (WhileStmt *stmt);
+	bool TraverseDoStmt (DoStmt *stmt);
+	bool VisitCallExpr (CallExpr *call);
+};
+
+class StringBuildingConsumer : public tartan::ASTChecker {
+public:
+	StringBuildingConsumer (CompilerInstance& compiler,
+	                        std::shared_ptr<const GirManager> gir_manager,
+	                        std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins,
+	                        std::shared_ptr<const PluginOptions> options) :
+		ASTChecker (compiler, gir_manager, disabled_plugins, options),
+		_visitor (compiler) {}
+
+private:
+	StringBuildingVisitor _visitor;
+
+public:
+	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
+	virtual void HandleTranslationUnit (ASTContext& context);
+	const std::string get_name () const { return "string-building"; }
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_STRING_BUILDING_CHECKER_H */
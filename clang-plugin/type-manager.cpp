@@ -32,6 +32,8 @@
 
 namespace tartan {
 
+GMutex TypeManager::_context_lock;
+
 /* Find a #QualType for the typedeffed type with the given @name. This is a very
  * slow call (it requires iterating through all defined types in the given
  * @context), so its results are cached where possible.
@@ -47,6 +49,8 @@ TypeManager::find_type_by_name (const std::string name)
 		return (*cached).second;
 	}
 
+	g_mutex_lock (&TypeManager::_context_lock);
+
 #ifdef HAVE_LLVM_3_8
 	for (SmallVectorImpl<Type *>::const_iterator it = this->_context.getTypes ().begin (),
 	     ie = this->_context.getTypes ().end (); it != ie; ++it) {
@@ -74,11 +78,15 @@ TypeManager::find_type_by_name (const std::string name)
 				std::string _name (name);
 				this->_type_cache.emplace (_name, qt);
 
+				g_mutex_unlock (&TypeManager::_context_lock);
+
 				return qt;
 			}
 		}
 	}
 
+	g_mutex_unlock (&TypeManager::_context_lock);
+
 	DEBUG ("Failed to find type ‘" << name << "’.");
 
 	return QualType ();
@@ -90,10 +98,140 @@ TypeManager::find_pointer_type_by_name (const std::string name)
 {
 	QualType qt = this->find_type_by_name (name);
 	if (!qt.isNull ()) {
-		return this->_context.getPointerType (qt);
+		return this->get_pointer_type (qt);
 	}
 
 	return QualType ();
 }
 
+/* Thread-safe wrappers around the #ASTContext methods for constructing derived
+ * types. */
+const QualType
+TypeManager::get_pointer_type (QualType pointee_type)
+{
+	g_mutex_lock (&TypeManager::_context_lock);
+	QualType retval = this->_context.getPointerType (pointee_type);
+	g_mutex_unlock (&TypeManager::_context_lock);
+
+	return retval;
+}
+
+const QualType
+TypeManager::get_constant_array_type (QualType element_type,
+                                      const llvm::APInt &size)
+{
+	g_mutex_lock (&TypeManager::_context_lock);
+	QualType retval =
+		this->_context.getConstantArrayType (element_type, size,
+		                                     ArrayType::ArraySizeModifier::Static,
+		                                     0);
+	g_mutex_unlock (&TypeManager::_context_lock);
+
+	return retval;
+}
+
+const QualType
+TypeManager::get_incomplete_array_type (QualType element_type)
+{
+	g_mutex_lock (&TypeManager::_context_lock);
+	QualType retval =
+		this->_context.getIncompleteArrayType (element_type,
+		                                       ArrayType::ArraySizeModifier::Static,
+		                                       0);
+	g_mutex_unlock (&TypeManager::_context_lock);
+
+	return retval;
+}
+
+const QualType
+TypeManager::get_function_type (QualType result_type,
+                                ArrayRef<QualType> param_types)
+{
+	FunctionProtoType::ExtProtoInfo info;
+
+	g_mutex_lock (&TypeManager::_context_lock);
+	QualType retval = this->_context.getFunctionType (result_type,
+	                                                  param_types, info);
+	g_mutex_unlock (&TypeManager::_context_lock);
+
+	return retval;
+}
+
+/* Thread-safe wrappers around the #ASTContext methods which compute (and
+ * memoise) type layouts. */
+uint64_t
+TypeManager::get_type_size (QualType type)
+{
+	g_mutex_lock (&TypeManager::_context_lock);
+	uint64_t retval = this->_context.getTypeSize (type);
+	g_mutex_unlock (&TypeManager::_context_lock);
+
+	return retval;
+}
+
+const QualType
+TypeManager::get_promoted_integer_type (QualType type)
+{
+	g_mutex_lock (&TypeManager::_context_lock);
+	QualType retval = this->_context.getPromotedIntegerType (type);
+	g_mutex_unlock (&TypeManager::_context_lock);
+
+	return retval;
+}
+
+/* Thread-safe wrappers around the #Expr methods which evaluate constant
+ * expressions. Evaluation may cache the values of variable initialisers on
+ * their #VarDecls and compute record layouts, both of which modify the
+ * #ASTContext. */
+bool
+TypeManager::is_null_pointer_constant (const Expr &expr,
+                                       Expr::NullPointerConstantValueDependence npc)
+{
+	/* isNullPointerConstant() takes a non-const context, but only so it
+	 * can evaluate the expression. */
+	ASTContext &context = const_cast<ASTContext &> (this->_context);
+
+	g_mutex_lock (&TypeManager::_context_lock);
+	bool retval = (expr.isNullPointerConstant (context, npc) !=
+	               Expr::NPCK_NotNull);
+	g_mutex_unlock (&TypeManager::_context_lock);
+
+	return retval;
+}
+
+bool
+TypeManager::is_integer_constant_expr (const Expr &expr, llvm::APSInt &value)
+{
+	g_mutex_lock (&TypeManager::_context_lock);
+	bool retval = expr.isIntegerConstantExpr (value, this->_context);
+	g_mutex_unlock (&TypeManager::_context_lock);
+
+	return retval;
+}
+
+bool
+TypeManager::evaluate_as_int (const Expr &expr, llvm::APSInt &value)
+{
+	g_mutex_lock (&TypeManager::_context_lock);
+	bool retval = expr.EvaluateAsInt (value, this->_context);
+	g_mutex_unlock (&TypeManager::_context_lock);
+
+	return retval;
+}
+
+/* Take the #ASTContext lock for code which modifies the context other than
+ * through a TypeManager, for example by allocating nodes in it or evaluating
+ * constant expressions. Must not be held while calling TypeManager methods. */
+void
+TypeManager::lock_context ()
+{
+	g_mutex_lock (&TypeManager::_context_lock);
+}
+
+void
+TypeManager::unlock_context ()
+{
+	g_mutex_unlock (&TypeManager::_context_lock);
+}
+
 } /* namespace tartan */
@@ -26,6 +26,9 @@
 #include <unordered_map>
 
 #include <clang/AST/ASTContext.h>
+#include <clang/AST/Expr.h>
+
+#include <glib.h>
 
 namespace tartan {
 
@@ -39,7 +42,33 @@ public:
 	const QualType find_type_by_name (const std::string name);
 	const QualType find_pointer_type_by_name (const std::string name);
 
+	const QualType get_pointer_type (QualType pointee_type);
+	const QualType get_constant_array_type (QualType element_type,
+	                                        const llvm::APInt &size);
+	const QualType get_incomplete_array_type (QualType element_type);
+	const QualType get_function_type (QualType result_type,
+	                                  ArrayRef<QualType> param_types);
+
+	uint64_t get_type_size (QualType type);
+	const QualType get_promoted_integer_type (QualType type);
+
+	bool is_null_pointer_constant (const Expr &expr,
+	                               Expr::NullPointerConstantValueDependence npc);
+	bool is_integer_constant_expr (const Expr &expr, llvm::APSInt &value);
+	bool evaluate_as_int (const Expr &expr, llvm::APSInt &value);
+
+	static void lock_context ();
+	static void unlock_context ();
+
 private:
+	/* Constructing types, allocating nodes, computing type layouts and
+	 * evaluating constant expressions all modify the #ASTContext, which is not thread-safe, so all
+	 * TypeManagers (and other code doing those things from checkers, see
+	 * lock_context()) serialise their accesses to it through this lock.
+	 * It is only contended when checkers are run on multiple threads (see
+	 * PluginOptions::n_jobs). */
+	static GMutex _context_lock;
+
 	const ASTContext &_context;
 
 	std::unordered_map<std::string, QualType> _type_cache;
@@ -0,0 +1,43 @@
+/* Template: toplevel */
+/* Options: --allocation-report @outdir@/allocations.txt */
+/* Ordered: yes */
+
+/*
+ * 101	2	nested_loop_func
+ * 10	1	loop_func
+ * 1	1	single_func
+ */
+static gchar *
+single_func (void)
+{
+	return g_strdup ("single");
+}
+
+static void
+loop_func (void)
+{
+	guint i;
+
+	for (i = 0; i < 10; i++)
+		g_free (g_strdup ("loop"));
+}
+
+static void
+nested_loop_func (void)
+{
+	guint i, j;
+	gchar *str = g_strdup ("outer");
+
+	g_free (str);
+
+	for (i = 0; i < 10; i++) {
+		for (j = 0; j < 10; j++)
+			g_free (g_strdup ("inner"));
+	}
+}
+
+static void
+non_allocating_func (void)
+{
+	g_print ("Not reported\n");
+}
@@ -0,0 +1,50 @@
+/* Template: generic */
+/* Options: --overrides @srcdir@/annotation-overrides.ini */
+
+/*
+ * Call to slow function g_usleep(): Blocks the calling thread.
+ *         g_usleep (G_USEC_PER_SEC);
+ *         ^
+ */
+{
+	g_usleep (G_USEC_PER_SEC);
+}
+
+/*
+ * Call to slow function puts(): Writes synchronously to standard output.
+ *         puts ("Hello world!");
+ *         ^
+ */
+{
+	puts ("Hello world!");
+}
+
+/*
+ * No error
+ */
+{
+	printf ("Hello world!\n");
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         puts (NULL);
+ */
+{
+	puts (NULL);
+}
+
+/*
+ * is deprecated: Deprecated since 1.0: Use g_getenv() instead.
+ *         const char *home = getenv ("HOME");
+ */
+{
+	const char *home = getenv ("HOME");
+}
+
+/*
+ * No error
+ */
+{
+	const gchar *home = g_getenv ("HOME");
+}
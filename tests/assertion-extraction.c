@@ -129,3 +129,136 @@
 	// Can’t statically analyse this at the moment.
 	g_return_if_fail (some_str || some_obj);
 }
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 1, obj);
+ *                         ~~~~        ^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                         ~~~~         ^
+ */
+{
+	// Looking through G_LIKELY() to the condition.
+	g_return_if_fail (G_LIKELY (some_str));
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func ("str", 2, NULL);
+ *                                   ~~~~^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                                  ~~~~^
+ */
+{
+	// Looking through __builtin_expect() to the condition.
+	g_return_if_fail (__builtin_expect (some_obj != NULL, 1));
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func ("str", 2, NULL);
+ *                                   ~~~~^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                                  ~~~~^
+ */
+{
+	// An implication spanning several assertions.
+	g_return_if_fail (some_str != NULL || some_obj != NULL);
+	g_return_if_fail (some_str == NULL);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func ("str", 2, NULL);
+ *                                   ~~~~^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                                  ~~~~^
+ */
+{
+	// A variable which is non-NULL checked on both sides of a disjunction.
+	g_return_if_fail ((some_str != NULL && some_obj != NULL) ||
+	                  some_obj != NULL);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func ("str", 2, NULL);
+ *                                   ~~~~^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                                  ~~~~^
+ */
+{
+	// A GObject type check on one side of a disjunction and a non-NULL
+	// check on the other still implies a non-NULL check.
+	g_return_if_fail (G_IS_OBJECT (some_obj) || some_obj != NULL);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 1, obj);
+ *                         ~~~~        ^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                         ~~~~         ^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func ("str", 2, NULL);
+ *                                   ~~~~^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                                  ~~~~^
+ */
+{
+	// A precondition whose ROBDD is too big, because the a variables are
+	// all ordered before the b variables. The structural analysis is
+	// used instead, and still finds the non-NULL checks.
+	const gchar *a1 = some_str, *b1 = some_str;
+	const gchar *a2 = some_str, *b2 = some_str;
+	const gchar *a3 = some_str, *b3 = some_str;
+	const gchar *a4 = some_str, *b4 = some_str;
+	const gchar *a5 = some_str, *b5 = some_str;
+	const gchar *a6 = some_str, *b6 = some_str;
+	const gchar *a7 = some_str, *b7 = some_str;
+	const gchar *a8 = some_str, *b8 = some_str;
+	const gchar *a9 = some_str, *b9 = some_str;
+	const gchar *a10 = some_str, *b10 = some_str;
+	const gchar *a11 = some_str, *b11 = some_str;
+	const gchar *a12 = some_str, *b12 = some_str;
+	const gchar *a13 = some_str, *b13 = some_str;
+	const gchar *a14 = some_str, *b14 = some_str;
+
+	g_return_if_fail ((a1 || !a1) &&
+	                  (a2 || !a2) &&
+	                  (a3 || !a3) &&
+	                  (a4 || !a4) &&
+	                  (a5 || !a5) &&
+	                  (a6 || !a6) &&
+	                  (a7 || !a7) &&
+	                  (a8 || !a8) &&
+	                  (a9 || !a9) &&
+	                  (a10 || !a10) &&
+	                  (a11 || !a11) &&
+	                  (a12 || !a12) &&
+	                  (a13 || !a13) &&
+	                  (a14 || !a14));
+	g_return_if_fail ((a1 && b1) ||
+	                  (a2 && b2) ||
+	                  (a3 && b3) ||
+	                  (a4 && b4) ||
+	                  (a5 && b5) ||
+	                  (a6 && b6) ||
+	                  (a7 && b7) ||
+	                  (a8 && b8) ||
+	                  (a9 && b9) ||
+	                  (a10 && b10) ||
+	                  (a11 && b11) ||
+	                  (a12 && b12) ||
+	                  (a13 && b13) ||
+	                  (a14 && b14));
+	g_return_if_fail (some_str != NULL);
+	g_return_if_fail (G_IS_OBJECT (some_obj) || some_obj != NULL);
+}
@@ -0,0 +1,18 @@
+/* Template: generic */
+/* Options: --overrides @srcdir@/annotation-overrides.ini --attributes-header @srcdir@/attributes-header.h */
+
+/*
+ * No error
+ */
+{
+	// getenv() is covered by the header, so its overrides aren’t applied.
+	const char *home = getenv ("HOME");
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         puts (NULL);
+ */
+{
+	puts (NULL);
+}
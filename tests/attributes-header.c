@@ -0,0 +1,13 @@
+/* Template: generic */
+/* Options: --overrides @srcdir@/attributes-header.ini --generate-attributes-header @outdir@/attributes.h */
+
+/*
+ * tartan-covered: g_variant_get_type_string
+ * tartan-covered: getenv
+ * #define TARTAN_RETURNS_NONNULL __attribute__ ((__returns_nonnull__))
+ * extern const gchar *g_variant_get_type_string(GVariant *) __attribute__ ((__pure__));
+ * extern char *getenv(const char *) __attribute__ ((__nonnull__ (1))) TARTAN_RETURNS_NONNULL;
+ */
+{
+	// Only the declarations in the headers are used.
+}
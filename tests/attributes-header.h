@@ -0,0 +1,6 @@
+/* Attributes header used by attributes-header-covered.c, as generated using
+ * --generate-attributes-header. Only its list of covered symbols is read by
+ * --attributes-header, so the redeclarations are omitted.
+ *
+ * tartan-covered: getenv
+ */
@@ -0,0 +1,31 @@
+/* Template: toplevel */
+/* Options: --changed-lines @srcdir@/changed-lines.diff */
+
+/*
+ * No error
+ */
+static GVariant *
+unchanged_func (guint unchanged)
+{
+	return g_variant_new ("s", unchanged);
+}
+
+/*
+ * Expected a GVariant variadic argument of type 'char *' but saw one of type 'guint' (aka 'unsigned int').
+ *         return g_variant_new ("s", changed);
+ *                                    ^
+ */
+static GVariant *
+changed_func (guint changed)
+{
+	return g_variant_new ("s", changed);
+}
+
+/*
+ * No error
+ */
+static GVariant *
+unchanged_file_func (guint unchanged)
+{
+	return g_variant_new ("s", unchanged);
+}
@@ -0,0 +1,11 @@
+/* Template: toplevel */
+/* Options: --editor-mode --cancel-file @srcdir@/editor-mode-cancelled.c */
+
+/*
+ * No error
+ */
+static GVariant *
+main_file_func (guint main_file)
+{
+	return g_variant_new ("s", main_file);
+}
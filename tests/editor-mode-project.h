@@ -0,0 +1,15 @@
+/* Used by editor-mode.c, which passes this header as a --project-header, so
+ * it is checked in editor mode. */
+
+#ifndef EDITOR_MODE_PROJECT_H
+#define EDITOR_MODE_PROJECT_H
+
+#include <glib.h>
+
+static GVariant *
+project_func (guint project)
+{
+	return g_variant_new ("s", project);
+}
+
+#endif /* !EDITOR_MODE_PROJECT_H */
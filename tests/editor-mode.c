@@ -0,0 +1,30 @@
+/* Template: toplevel */
+/* Options: --editor-mode --project-header @srcdir@/editor-mode-project.h */
+
+/*
+ * Expected a GVariant variadic argument of type 'char *' but saw one of type 'guint' (aka 'unsigned int').
+ *         return g_variant_new ("s", main_file);
+ *                                    ^
+ */
+static GVariant *
+main_file_func (guint main_file)
+{
+	return g_variant_new ("s", main_file);
+}
+
+/*
+ * Expected a GVariant variadic argument of type 'char *' but saw one of type 'guint' (aka 'unsigned int').
+ *         return g_variant_new ("s", project);
+ *                                    ^
+ */
+#include "editor-mode-project.h"
+
+/*
+ * No error
+ */
+#include "editor-mode-other.h"
+
+/*
+ * No error
+ */
+#include "editor-mode-system.h"
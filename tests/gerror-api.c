@@ -256,8 +256,8 @@
 
 /*
  * warning: Overwriting already-set GError
- *         g_set_error (error, G_IO_ERROR, G_IO_ERROR_PENDING, "Pending error");
- *         ^~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *                 some_failing_func (&child_error);
+ *                 ^~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
 {
 	guint i;
@@ -663,3 +663,97 @@
 
 	g_error_free (sub_error);
 }
+
+/*
+ * No error
+ */
+{
+	GError *some_error = NULL;
+
+	// Returns FALSE exactly when it sets the error.
+	if (!some_conventional_func (some_cond, &some_error)) {
+		g_error_free (some_error);
+	}
+}
+
+/*
+ * warning: Freeing non-set GError
+ *                 g_error_free (some_error);
+ */
+{
+	GError *some_error = NULL;
+
+	// Can return FALSE without setting the error.
+	if (!some_unconventional_func (some_cond, &some_error)) {
+		g_error_free (some_error);
+	}
+}
+
+/*
+ * warning: Freeing non-set GError
+ *                 g_error_free (some_error);
+ */
+{
+	GKeyFile *key_file = g_key_file_new ();
+	GError *some_error = NULL;
+
+	// Returns FALSE for a key set to false, without setting the error.
+	if (!g_key_file_get_boolean (key_file, "group", "key", &some_error)) {
+		g_error_free (some_error);
+	}
+
+	g_key_file_free (key_file);
+}
+
+/*
+ * warning: Freeing non-set GError
+ *                 g_error_free (some_error);
+ */
+{
+	GFile *file = g_file_new_for_path ("/");
+	GFileEnumerator *enumerator;
+	GFileInfo *info;
+	GError *some_error = NULL;
+
+	enumerator = g_file_enumerate_children (file, "*",
+	                                        G_FILE_QUERY_INFO_NONE, NULL,
+	                                        NULL);
+	g_object_unref (file);
+
+	if (enumerator == NULL) {
+		return;
+	}
+
+	// Returns NULL at the end of the enumeration, without setting the
+	// error, as its return value is nullable.
+	info = g_file_enumerator_next_file (enumerator, NULL, &some_error);
+
+	if (info == NULL) {
+		g_error_free (some_error);
+	} else {
+		g_object_unref (info);
+	}
+
+	g_object_unref (enumerator);
+}
+
+/*
+ * No error
+ */
+{
+	GFile *file = g_file_new_for_path ("/");
+	GFileInputStream *stream;
+	GError *some_error = NULL;
+
+	// Its non-nullable return value is NULL exactly when it sets the
+	// error.
+	stream = g_file_read (file, NULL, &some_error);
+
+	if (stream == NULL) {
+		g_error_free (some_error);
+	} else {
+		g_object_unref (stream);
+	}
+
+	g_object_unref (file);
+}
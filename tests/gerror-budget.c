@@ -0,0 +1,13 @@
+/* Template: gerror */
+/* Options: --max-analysis-nodes 1 */
+
+/*
+ * GError checker stopped tracking in ‘some_failable_func’ after exhausting its node budget
+ * some_failable_func (gboolean some_cond, GError **error)
+ */
+{
+	GError *some_error = NULL;
+
+	some_failing_func (&some_error);
+	g_error_free (some_error);
+}
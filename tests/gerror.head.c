@@ -11,6 +11,30 @@ some_failing_func (GError **error)
 	g_set_error (error, G_IO_ERROR, G_IO_ERROR_PENDING, "Pending error");
 }
 
+/* Follows the GLib convention: returns FALSE exactly when it sets @error. */
+static gboolean
+some_conventional_func (gboolean some_cond, GError **error)
+{
+	if (some_cond) {
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Doesn’t follow the convention: returns FALSE without setting @error. */
+static gboolean
+some_unconventional_func (gboolean some_cond, GError **error)
+{
+	if (some_cond) {
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed");
+		return FALSE;
+	}
+
+	return g_random_boolean ();
+}
+
 static void
 some_failable_func (gboolean some_cond, GError **error)
 {
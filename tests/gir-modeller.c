@@ -0,0 +1,90 @@
+/* Template: generic */
+
+/*
+ * No error
+ */
+{
+	gint *some_ptr = NULL;
+
+	// Paths after a failed precondition aren’t explored.
+	g_return_if_fail_warning (G_LOG_DOMAIN, G_STRFUNC, "some_ptr != NULL");
+	*some_ptr = 1;
+}
+
+/*
+ * No error
+ */
+{
+	gint *some_ptr = NULL;
+	GObject *obj = (GObject *) g_getenv ("SOME_OBJECT");
+
+	// G_OBJECT() returns its argument.
+	if (G_OBJECT (obj) != obj) {
+		*some_ptr = 1;
+	}
+}
+
+/*
+ * No error
+ */
+{
+	gint *some_ptr = NULL;
+	FILE *in = stdin;
+	gunichar c;
+
+	// A pure function can’t change any globals.
+	c = g_unichar_tolower ('A');
+
+	if (stdin != in) {
+		*some_ptr = 1;
+	}
+}
+
+/*
+ * No error
+ */
+{
+	gint *some_ptr = NULL;
+	FILE *in = stdin;
+	GType type;
+
+	// Nor can registering a type.
+	type = g_object_get_type ();
+
+	if (stdin != in) {
+		*some_ptr = 1;
+	}
+}
+
+/*
+ * Dereference of null pointer
+ *                 *some_ptr = 1;
+ */
+{
+	gint *some_ptr = NULL;
+	FILE *in = stdin;
+
+	// An arbitrary function can.
+	g_usleep (0);
+
+	if (stdin != in) {
+		*some_ptr = 1;
+	}
+}
+
+/*
+ * No error
+ */
+{
+	gint *some_ptr = NULL;
+	GParamSpec *pspec = g_param_spec_int ("some-int", "Some int",
+	                                      "Some int", 0, 10, 0,
+	                                      G_PARAM_READWRITE);
+
+	// An accessor whose GIR says it can’t return NULL.
+	if (g_param_spec_get_name (pspec) == NULL) {
+		*some_ptr = 1;
+	}
+
+	g_param_spec_unref (pspec);
+}
@@ -0,0 +1,169 @@
+/* Template: generic */
+
+/*
+ * No error
+ */
+{
+	GList *list = NULL;
+	guint i;
+
+	for (i = 0; i < 10; i++)
+		list = g_list_prepend (list, GUINT_TO_POINTER (i));
+
+	list = g_list_reverse (list);
+	g_list_free (list);
+}
+
+/*
+ * No error
+ */
+{
+	guint i;
+
+	for (i = 0; i < 10; i++) {
+		GList *local = NULL;
+		local = g_list_append (local, GUINT_TO_POINTER (i));
+		g_list_free (local);
+	}
+}
+
+/*
+ * No error
+ */
+{
+	GList *list = NULL, *l;
+	guint length;
+
+	list = g_list_prepend (list, NULL);
+	length = g_list_length (list);
+
+	for (l = list; l != NULL; l = l->next)
+		length--;
+
+	g_list_free (list);
+}
+
+/*
+ * g_list_append() is O(n) in the length of ‘list’, which is carried across iterations of the enclosing loop, making the loop quadratic. Build the list with g_list_prepend() and reverse it with g_list_reverse() after the loop, keep a pointer to its tail, or use a GQueue or GPtrArray.
+ *                 list = g_list_append (list, GUINT_TO_POINTER (i));
+ *                        ^
+ */
+{
+	GList *list = NULL;
+	guint i;
+
+	for (i = 0; i < 10; i++)
+		list = g_list_append (list, GUINT_TO_POINTER (i));
+
+	g_list_free (list);
+}
+
+/*
+ * g_slist_append() is O(n) in the length of ‘list’, which is carried across iterations of the enclosing loop, making the loop quadratic. Build the list with g_slist_prepend() and reverse it with g_slist_reverse() after the loop, keep a pointer to its tail, or use a GQueue or GPtrArray.
+ *                 list = g_slist_append (list, GUINT_TO_POINTER (i));
+ *                        ^
+ */
+{
+	GSList *list = NULL;
+	guint i = 0;
+
+	while (i++ < 10)
+		list = g_slist_append (list, GUINT_TO_POINTER (i));
+
+	g_slist_free (list);
+}
+
+/*
+ * g_list_length() is O(n), and is called on every evaluation of the loop condition, making the loop quadratic. Compute the length once before the loop, or use a GQueue, which stores its length.
+ *         for (i = 0; i < g_list_length (list); i++)
+ *                         ^
+ * g_list_nth_data() is O(n) in the length of ‘list’, which is carried across iterations of the enclosing loop, making the loop quadratic. Iterate over the list using its ‘next’ pointers instead, or use a GPtrArray for indexed access.
+ *                 data = g_list_nth_data (list, i);
+ *                        ^
+ */
+{
+	GList *list = NULL;
+	gpointer data = NULL;
+	guint i;
+
+	list = g_list_prepend (list, NULL);
+
+	for (i = 0; i < g_list_length (list); i++)
+		data = g_list_nth_data (list, i);
+
+	g_list_free (list);
+	g_assert (data == NULL);
+}
+
+/*
+ * g_list_find() is O(n) in the length of ‘seen’, which is carried across iterations of the enclosing loop, making the loop quadratic. Use a GHashTable to look up elements.
+ *                 if (g_list_find (seen, l->data) == NULL)
+ *                     ^
+ */
+{
+	GList *list = NULL, *seen = NULL, *l;
+
+	list = g_list_prepend (list, NULL);
+
+	for (l = list; l != NULL; l = l->next) {
+		if (g_list_find (seen, l->data) == NULL)
+			seen = g_list_prepend (seen, l->data);
+	}
+
+	g_list_free (seen);
+	g_list_free (list);
+}
+
+/*
+ * No error
+ */
+{
+	GHashTable *table = g_hash_table_new (NULL, NULL);
+	GList *l;
+	guint i, n = 0;
+
+	for (i = 0; i < 10; i++) {
+		// A fresh list on each iteration.
+		l = g_hash_table_get_keys (table);
+		n += g_list_length (l);
+		g_list_free (l);
+	}
+
+	g_hash_table_unref (table);
+}
+
+/*
+ * g_list_append() is O(n) in the length of ‘list’, which is carried across iterations of the enclosing loop, making the loop quadratic. Build the list with g_list_prepend() and reverse it with g_list_reverse() after the loop, keep a pointer to its tail, or use a GQueue or GPtrArray.
+ *                 list = g_list_append (list, GUINT_TO_POINTER (i));
+ *                        ^
+ */
+{
+	guint i = 0;
+
+	// The initialiser only runs once, so the list persists.
+	for (GList *list = NULL; i < 10; i++) {
+		list = g_list_append (list, GUINT_TO_POINTER (i));
+
+		if (i == 9)
+			g_list_free (list);
+	}
+}
+
+/*
+ * g_list_append() is O(n) in the length of ‘row’, which is carried across iterations of the enclosing loop, making the loop quadratic. Build the list with g_list_prepend() and reverse it with g_list_reverse() after the loop, keep a pointer to its tail, or use a GQueue or GPtrArray.
+ *                         row = g_list_append (row, GUINT_TO_POINTER (j));
+ *                               ^
+ */
+{
+	guint i, j;
+
+	for (i = 0; i < 10; i++) {
+		// Declared in the outer loop, but built up by the inner one.
+		GList *row = NULL;
+
+		for (j = 0; j < 10; j++)
+			row = g_list_append (row, GUINT_TO_POINTER (j));
+
+		g_list_free (row);
+	}
+}
@@ -0,0 +1,40 @@
+/* Template: gsignal */
+
+/*
+ * No error
+ */
+{
+	GObject *some_object = g_malloc (5);  // only checking the type
+	GParamSpec *pspec = g_malloc (5);  // only checking the type
+	g_object_notify_by_pspec (some_object, pspec);
+}
+
+/*
+ * g_object_notify() looks up property ‘application-id’ by name on every call. Use g_object_notify_by_pspec() with the GParamSpec saved when the property was installed, for example in a class-level ‘properties[]’ array.
+ *         g_object_notify (G_OBJECT (app), "application-id");
+ *         ^
+ */
+{
+	GApplication *app = g_malloc (5);  // only checking the type
+	g_object_notify (G_OBJECT (app), "application-id");
+}
+
+/*
+ * g_object_notify() looks up property ‘application-id’ by name on every call. Use g_object_notify_by_pspec() with the GParamSpec saved when the property was installed, for example in a class-level ‘properties[]’ array.
+ *         g_object_notify (G_OBJECT (app), "application_id");
+ *         ^
+ */
+{
+	GApplication *app = g_malloc (5);  // only checking the type
+	g_object_notify (G_OBJECT (app), "application_id");
+}
+
+/*
+ * No property named ‘not-a-property’ on class ‘GApplication’ or its ancestors, so g_object_notify() will fail at runtime.
+ *         g_object_notify (G_OBJECT (app), "not-a-property");
+ *                                          ^
+ */
+{
+	GApplication *app = g_malloc (5);  // only checking the type
+	g_object_notify (G_OBJECT (app), "not-a-property");
+}
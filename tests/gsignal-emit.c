@@ -0,0 +1,53 @@
+/* Template: gsignal */
+
+/*
+ * No error
+ */
+{
+	GObject *some_object = g_malloc (5);  // only checking the type
+	GParamSpec *pspec = g_malloc (5);  // only checking the type
+	g_signal_emit_by_name (some_object, "notify", pspec);
+}
+
+/*
+ * No error
+ */
+{
+	GObject *some_object = g_malloc (5);  // only checking the type
+	g_signal_emit_by_name (some_object, "notify::something", NULL);
+}
+
+/*
+ * Incorrect number of arguments to g_signal_emit_by_name() for signal ‘GObject::notify’. Expected 1 but saw 0.
+ *         g_signal_emit_by_name (some_object, "notify");
+ *         ^
+ */
+{
+	GObject *some_object = g_malloc (5);  // only checking the type
+	g_signal_emit_by_name (some_object, "notify");
+}
+
+/*
+ * Incorrect type for argument 1 to g_signal_emit_by_name() for signal ‘GObject::notify’. Expected ‘GParamSpec *’ but saw ‘guint’.
+ *         g_signal_emit_by_name (some_object, "notify", not_a_pspec);
+ *                                                       ^
+ */
+{
+	GObject *some_object = g_malloc (5);  // only checking the type
+	guint not_a_pspec = 5;
+	g_signal_emit_by_name (some_object, "notify", not_a_pspec);
+}
+
+/*
+ * Signal ‘notify’ is looked up by name on every iteration of this loop. Look up its ID once using g_signal_lookup(), or use the ID saved when the signal was created, and emit it using g_signal_emit().
+ *                 g_signal_emit_by_name (some_object, "notify", pspec);
+ *                 ^
+ */
+{
+	GObject *some_object = g_malloc (5);  // only checking the type
+	GParamSpec *pspec = g_malloc (5);  // only checking the type
+	guint i;
+
+	for (i = 0; i < 10; i++)
+		g_signal_emit_by_name (some_object, "notify", pspec);
+}
@@ -0,0 +1,68 @@
+/* Template: gvariant */
+/* Options: --gvariant-borrowed-strings */
+
+/*
+ * The string returned in ‘str’ by g_variant_get() is only read and then freed, so could be borrowed from the GVariant using the ‘&s’ format instead, avoiding an allocation and copy. It must then not be freed.
+ *         g_variant_get (existing_variant, "s", &str);
+ *                                               ^
+ */
+{
+	gchar *str = NULL;
+
+	g_variant_get (existing_variant, "s", &str);
+	g_print ("%s\n", str);
+	g_free (str);
+}
+
+/*
+ * The string returned in ‘str’ by g_variant_get() is only read and then freed, so could be borrowed from the GVariant using the ‘&s’ format instead, avoiding an allocation and copy. It must then not be freed.
+ *         g_variant_get (existing_variant, "s", &str);
+ *                                               ^
+ */
+{
+	g_autofree gchar *str = NULL;
+
+	g_variant_get (existing_variant, "s", &str);
+	g_print ("%s\n", str);
+}
+
+/*
+ * The string returned in ‘str’ by g_variant_iter_loop() is only read and then freed, so could be borrowed from the GVariant using the ‘&s’ format instead, avoiding an allocation and copy. It must then not be freed.
+ *         while (g_variant_iter_loop (iter, "s", &str))
+ *                                                ^
+ */
+{
+	GVariantIter *iter = g_variant_iter_new (existing_variant);
+	gchar *str;
+
+	// g_variant_iter_loop() frees the string itself.
+	while (g_variant_iter_loop (iter, "s", &str))
+		g_print ("%s\n", str);
+
+	g_variant_iter_free (iter);
+}
+
+/*
+ * No error
+ */
+{
+	GVariant *variant = g_variant_ref_sink (g_variant_new_string ("value"));
+	gchar *str = NULL;
+
+	// The string is read after the GVariant it would borrow from is gone.
+	g_variant_get (variant, "s", &str);
+	g_variant_unref (variant);
+	g_print ("%s\n", str);
+	g_free (str);
+}
+
+/*
+ * No error
+ */
+{
+	gchar *str = NULL;
+
+	// The string outlives the function.
+	g_variant_get (existing_variant, "s", &str);
+	floating_variant = g_variant_new_take_string (str);
+}
@@ -0,0 +1,74 @@
+/* Template: toplevel */
+/* Options: --jobs 4 --signal-graph @outdir@/signals.json */
+/* Ordered: yes */
+
+/*
+ * "caller": "first_func", "connect": "g_signal_connect_data", "instance": "GApplication", "signal": "GApplication::activate", "handler": "first_activate_cb"
+ * "caller": "second_func", "connect": "g_signal_connect_data", "instance": "GApplication", "signal": "GApplication::activate", "handler": "second_activate_cb"
+ * "caller": "third_func", "connect": "g_signal_connect_data", "instance": "GApplication", "signal": "GApplication::activate", "handler": null, "handler_location": null, "after": true, "swapped": true}
+ */
+
+static void
+first_activate_cb (GApplication *app, gpointer user_data)
+{
+	/* Nothing */
+}
+
+static void
+first_func (GApplication *app)
+{
+	g_signal_connect (app, "activate", G_CALLBACK (first_activate_cb),
+	                  NULL);
+}
+
+// Enough declarations to put the next function in a different chunk.
+extern int padding_first_0, padding_first_1, padding_first_2, padding_first_3,
+	padding_first_4, padding_first_5, padding_first_6, padding_first_7,
+	padding_first_8, padding_first_9, padding_first_10, padding_first_11,
+	padding_first_12, padding_first_13, padding_first_14,
+	padding_first_15, padding_first_16, padding_first_17,
+	padding_first_18, padding_first_19, padding_first_20,
+	padding_first_21, padding_first_22, padding_first_23,
+	padding_first_24, padding_first_25, padding_first_26,
+	padding_first_27, padding_first_28, padding_first_29,
+	padding_first_30, padding_first_31, padding_first_32,
+	padding_first_33, padding_first_34, padding_first_35,
+	padding_first_36, padding_first_37, padding_first_38,
+	padding_first_39;
+
+static void
+second_activate_cb (GApplication *app, gpointer user_data)
+{
+	/* Nothing */
+}
+
+static void
+second_func (GApplication *app)
+{
+	g_signal_connect_after (app, "activate",
+	                        G_CALLBACK (second_activate_cb), NULL);
+}
+
+// Enough declarations to put the next function in a different chunk.
+extern int padding_second_0, padding_second_1, padding_second_2,
+	padding_second_3, padding_second_4, padding_second_5,
+	padding_second_6, padding_second_7, padding_second_8,
+	padding_second_9, padding_second_10, padding_second_11,
+	padding_second_12, padding_second_13, padding_second_14,
+	padding_second_15, padding_second_16, padding_second_17,
+	padding_second_18, padding_second_19, padding_second_20,
+	padding_second_21, padding_second_22, padding_second_23,
+	padding_second_24, padding_second_25, padding_second_26,
+	padding_second_27, padding_second_28, padding_second_29,
+	padding_second_30, padding_second_31, padding_second_32,
+	padding_second_33, padding_second_34, padding_second_35,
+	padding_second_36, padding_second_37, padding_second_38,
+	padding_second_39;
+
+static void
+third_func (GApplication *app, GCallback callback)
+{
+	// The handler isn’t known statically.
+	g_signal_connect_data (app, "activate", callback, NULL, NULL,
+	                       G_CONNECT_AFTER | G_CONNECT_SWAPPED);
+}
@@ -0,0 +1,137 @@
+/* Template: generic */
+
+/*
+ * No error
+ */
+{
+	GString *str = g_string_sized_new (64);
+	guint i;
+
+	for (i = 0; i < 10; i++)
+		g_string_append_printf (str, "%u,", i);
+
+	g_string_free (str, TRUE);
+}
+
+/*
+ * No error
+ */
+{
+	guint i;
+
+	for (i = 0; i < 10; i++) {
+		gchar *local = g_strdup_printf ("%u", i);
+		g_free (local);
+	}
+}
+
+/*
+ * String ‘str’ is rebuilt by g_strconcat() on every iteration of the enclosing loop
+ *                 gchar *new_str = g_strconcat (str, "x", NULL);
+ *                                  ^
+ */
+{
+	gchar *str = g_strdup ("");
+	guint i;
+
+	for (i = 0; i < 10; i++) {
+		gchar *new_str = g_strconcat (str, "x", NULL);
+		g_free (str);
+		str = new_str;
+	}
+
+	g_free (str);
+}
+
+/*
+ * String ‘str’ is rebuilt by g_strjoin() on every iteration of the enclosing loop
+ *                 str = g_strjoin (",", old_str, "x", NULL);
+ *                       ^
+ */
+{
+	gchar *str = g_strdup ("");
+	guint i;
+
+	for (i = 0; i < 10; i++) {
+		gchar *old_str = str;
+		str = g_strjoin (",", old_str, "x", NULL);
+		g_free (old_str);
+	}
+
+	g_free (str);
+}
+
+/*
+ * String ‘str’ is rebuilt by g_strdup_printf() on every iteration of the enclosing loop
+ *                 str = g_strdup_printf ("%s%u", str, i);
+ *                       ^
+ */
+{
+	gchar *str = NULL;
+	guint i;
+
+	for (i = 0; i < 10; i++)
+		str = g_strdup_printf ("%s%u", str, i);
+}
+
+/*
+ * No error
+ */
+{
+	const gchar *x = "x", *y = "y";
+	guint i;
+
+	for (i = 0; i < 10; i++) {
+		gchar *s = g_strdup (x);
+		gchar *t = s;
+		s = g_strconcat (s, y, NULL);
+		g_free (t);
+		g_free (s);
+	}
+}
+
+/*
+ * String ‘str’ is rebuilt by g_strconcat() on every iteration of the enclosing loop
+ *                         str = g_strconcat (str, "x", NULL);
+ *                               ^
+ */
+{
+	guint i, j;
+
+	for (i = 0; i < 10; i++) {
+		gchar *str = g_strdup ("");
+
+		for (j = 0; j < 10; j++)
+			str = g_strconcat (str, "x", NULL);
+
+		g_free (str);
+	}
+}
+
+/*
+ * String ‘str’ is rebuilt by g_strconcat() on every iteration of the enclosing loop
+ *                 str = g_strconcat (str, "x", NULL);
+ *                       ^
+ */
+{
+	guint i = 0;
+
+	// The initialiser only runs once, so the string persists.
+	for (gchar *str = g_strdup (""); i < 10; i++) {
+		str = g_strconcat (str, "x", NULL);
+
+		if (i == 9)
+			g_free (str);
+	}
+}
+
+/*
+ * g_string_append_printf() is called with a constant format string containing no conversions
+ *         g_string_append_printf (str, "constant");
+ *         ^
+ */
+{
+	GString *str = g_string_new (NULL);
+	g_string_append_printf (str, "constant");
+	g_string_free (str, TRUE);
+}
@@ -0,0 +1 @@
+/* End of the translation unit. */